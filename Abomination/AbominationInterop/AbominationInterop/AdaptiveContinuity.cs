@@ -0,0 +1,272 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuUtilities;
+using BepuUtilities.Collections;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Configures how adaptive continuity picks a collision detection mode for each tracked body.
+/// </summary>
+/// <remarks>All thresholds are expressed relative to the body's size, measured as the smallest extent of its shape's local bounding box.</remarks>
+[StructLayout(LayoutKind.Sequential)]
+public struct AdaptiveContinuitySettings
+{
+    /// <summary>
+    /// Distance traveled in one timestep, as a fraction of the body's size, above which the body switches from discrete to passive handling.
+    /// </summary>
+    public float PassiveTravelRatio;
+    /// <summary>
+    /// Distance traveled in one timestep, as a fraction of the body's size, above which the body is swept.
+    /// </summary>
+    public float ContinuousTravelRatio;
+    /// <summary>
+    /// Minimum sweep timestep as a fraction of the time the body takes to travel its own size. Smaller values catch briefer collisions at higher sweep cost.
+    /// </summary>
+    public float MinimumSweepTimestepScale;
+    /// <summary>
+    /// Sweep convergence threshold as a fraction of the time the body takes to travel its own size. Smaller values refine the time of impact further at higher sweep cost.
+    /// </summary>
+    public float SweepConvergenceThresholdScale;
+}
+
+/// <summary>
+/// Reports the choices made by adaptive continuity and the sweep work done in the last timestep.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct AdaptiveContinuityStatistics
+{
+    /// <summary>
+    /// Number of bodies whose continuity is chosen adaptively.
+    /// </summary>
+    public int TrackedBodyCount;
+    /// <summary>
+    /// Number of awake tracked bodies set to discrete handling in the last timestep.
+    /// </summary>
+    public int DiscreteCount;
+    /// <summary>
+    /// Number of awake tracked bodies set to passive handling in the last timestep.
+    /// </summary>
+    public int PassiveCount;
+    /// <summary>
+    /// Number of awake tracked bodies set to continuous handling in the last timestep.
+    /// </summary>
+    public int ContinuousCount;
+    /// <summary>
+    /// Number of pairs admitted to the narrow phase in the last timestep where at least one collidable used continuous handling, tracked or not.
+    /// Each such pair is eligible for a sweep test, so this is an upper bound on the sweeps run.
+    /// </summary>
+    public int SweepPairCount;
+}
+
+/// <summary>
+/// Chooses discrete, passive or continuous collision detection for tracked bodies every timestep from how far they move relative to their size.
+/// </summary>
+/// <remarks>Modes are chosen after sleeping and before bounding boxes are predicted, so the choice affects both bounding box expansion and sweeps in the same timestep.
+/// Bodies that are asleep are skipped. Removing a body through the interop layer stops tracking it immediately, so a later body that reuses the handle starts out untracked.</remarks>
+public class AdaptiveContinuityController
+{
+    Simulation? simulation;
+    DefaultTimestepper? timestepper;
+    AdaptiveContinuitySettings settings;
+    bool enabled;
+    //Maps body handle value to the body's size.
+    QuickDictionary<int, float, PrimitiveComparer<int>> trackedBodies;
+    AdaptiveContinuityStatistics statistics;
+    //One counter per worker, spaced a cache line apart.
+    Buffer<int> workerSweepPairCounts;
+    int workerCount;
+    const int CounterStride = 16;
+
+    /// <summary>
+    /// Gets whether the narrow phase should count sweep eligible pairs.
+    /// </summary>
+    public bool Enabled => enabled;
+
+    /// <summary>
+    /// Gets the choices made during the last timestep.
+    /// </summary>
+    public AdaptiveContinuityStatistics Statistics
+    {
+        get
+        {
+            var result = statistics;
+            result.TrackedBodyCount = trackedBodies.Count;
+            return result;
+        }
+    }
+
+    /// <summary>
+    /// Associates the controller with a simulation. The controller does nothing until enabled.
+    /// </summary>
+    /// <param name="simulation">Simulation whose bodies are controlled.</param>
+    public void Attach(Simulation simulation)
+    {
+        this.simulation = simulation;
+        timestepper = simulation.Timestepper as DefaultTimestepper ?? throw new InvalidOperationException("Adaptive continuity requires the default timestepper.");
+        trackedBodies = new QuickDictionary<int, float, PrimitiveComparer<int>>(16, simulation.BufferPool);
+    }
+
+    /// <summary>
+    /// Starts choosing continuity for tracked bodies and counting sweep eligible pairs. Enabling again replaces the settings.
+    /// </summary>
+    /// <param name="settings">Thresholds used to choose modes and sweep parameters.</param>
+    public void Enable(AdaptiveContinuitySettings settings)
+    {
+        if (settings.PassiveTravelRatio < 0 || settings.ContinuousTravelRatio < settings.PassiveTravelRatio)
+            throw new ArgumentException("Adaptive continuity requires 0 <= passive travel ratio <= continuous travel ratio.");
+        if (settings.MinimumSweepTimestepScale < 0 || settings.SweepConvergenceThresholdScale < 0)
+            throw new ArgumentException("Sweep scales must not be negative.");
+        this.settings = settings;
+        if (!enabled)
+        {
+            timestepper!.Slept += OnSlept;
+            timestepper.CollisionsDetected += OnCollisionsDetected;
+            enabled = true;
+        }
+    }
+
+    /// <summary>
+    /// Stops choosing continuity. Tracked bodies keep the mode they were last given.
+    /// </summary>
+    public void Disable()
+    {
+        if (!enabled)
+            return;
+        timestepper!.Slept -= OnSlept;
+        timestepper.CollisionsDetected -= OnCollisionsDetected;
+        enabled = false;
+        statistics = default;
+    }
+
+    static float GetSize(Simulation simulation, TypedIndex shape)
+    {
+        simulation.Shapes.UpdateBounds(RigidPose.Identity, ref shape, out var bounds);
+        var extent = bounds.Max - bounds.Min;
+        return MathF.Max(1e-5f, MathF.Min(extent.X, MathF.Min(extent.Y, extent.Z)));
+    }
+
+    /// <summary>
+    /// Adds bodies to or removes them from adaptive continuity.
+    /// </summary>
+    /// <param name="bodyHandles">Bodies to modify.</param>
+    /// <param name="tracked">True to choose the bodies' continuity adaptively, false to stop.</param>
+    /// <remarks>A body's size is measured from its shape when it is added; add it again after changing its shape.</remarks>
+    public void SetTracked(Buffer<BodyHandle> bodyHandles, bool tracked)
+    {
+        for (int i = 0; i < bodyHandles.Length; ++i)
+        {
+            SetTracked(bodyHandles[i], tracked);
+        }
+    }
+
+    /// <summary>
+    /// Adds a body to or removes it from adaptive continuity.
+    /// </summary>
+    /// <param name="bodyHandle">Body to modify.</param>
+    /// <param name="tracked">True to choose the body's continuity adaptively, false to stop.</param>
+    public void SetTracked(BodyHandle bodyHandle, bool tracked)
+    {
+        if (tracked)
+        {
+            var size = GetSize(simulation!, simulation.Bodies[bodyHandle].Collidable.Shape);
+            trackedBodies.AddOrUpdate(bodyHandle.Value, size, simulation.BufferPool);
+        }
+        else
+        {
+            trackedBodies.FastRemove(bodyHandle.Value);
+        }
+    }
+
+    ContinuousDetection ChooseContinuity(in BodyVelocity velocity, float size, float dt)
+    {
+        //Angular motion is bounded by treating the shape's size as its radius; conservative, but cheap and it only needs to rank bodies.
+        var speed = velocity.Linear.Length() + velocity.Angular.Length() * size;
+        var travelRatio = speed * dt / size;
+        if (travelRatio < settings.PassiveTravelRatio)
+            return ContinuousDetection.Discrete;
+        if (travelRatio < settings.ContinuousTravelRatio)
+            return ContinuousDetection.Passive;
+        //Faster bodies spend less time overlapping anything their own size, so the sweep has to resolve finer intervals to catch them.
+        var timeToTraverseSize = size / speed;
+        return ContinuousDetection.Continuous(
+            MathF.Min(dt, settings.MinimumSweepTimestepScale * timeToTraverseSize),
+            MathF.Min(dt, settings.SweepConvergenceThresholdScale * timeToTraverseSize));
+    }
+
+    void OnSlept(float dt, IThreadDispatcher threadDispatcher)
+    {
+        var bodies = simulation!.Bodies;
+        statistics = default;
+        for (int i = trackedBodies.Count - 1; i >= 0; --i)
+        {
+            var handleValue = trackedBodies.Keys[i];
+            if (!bodies.BodyExists(new BodyHandle(handleValue)))
+            {
+                trackedBodies.FastRemove(handleValue);
+                continue;
+            }
+            var location = bodies.HandleToLocation[handleValue];
+            if (location.SetIndex != 0)
+                continue;
+            ref var continuity = ref bodies.ActiveSet.Collidables[location.Index].Continuity;
+            continuity = ChooseContinuity(bodies.ActiveSet.DynamicsState[location.Index].Motion.Velocity, trackedBodies.Values[i], dt);
+            switch (continuity.Mode)
+            {
+                case ContinuousDetectionMode.Discrete: ++statistics.DiscreteCount; break;
+                case ContinuousDetectionMode.Passive: ++statistics.PassiveCount; break;
+                default: ++statistics.ContinuousCount; break;
+            }
+        }
+        workerCount = threadDispatcher == null ? 1 : threadDispatcher.ThreadCount;
+        if (workerSweepPairCounts.Length < workerCount * CounterStride)
+            simulation.BufferPool.ResizeToAtLeast(ref workerSweepPairCounts, workerCount * CounterStride, 0);
+        workerSweepPairCounts.Clear(0, workerCount * CounterStride);
+    }
+
+    bool IsContinuous(CollidableReference collidable)
+    {
+        if (collidable.Mobility == CollidableMobility.Static)
+            return simulation!.Statics.GetDirectReference(collidable.StaticHandle).Continuity.Mode == ContinuousDetectionMode.Continuous;
+        return simulation!.Bodies[collidable.BodyHandle].Collidable.Continuity.Mode == ContinuousDetectionMode.Continuous;
+    }
+
+    /// <summary>
+    /// Counts a pair admitted to the narrow phase if either collidable uses continuous handling. Called from the narrow phase callbacks on any worker.
+    /// </summary>
+    /// <param name="workerIndex">Index of the worker testing the pair.</param>
+    /// <param name="a">First collidable in the pair.</param>
+    /// <param name="b">Second collidable in the pair.</param>
+    public void CountPair(int workerIndex, CollidableReference a, CollidableReference b)
+    {
+        if (IsContinuous(a) || IsContinuous(b))
+            ++workerSweepPairCounts[workerIndex * CounterStride];
+    }
+
+    void OnCollisionsDetected(float dt, IThreadDispatcher threadDispatcher)
+    {
+        int sum = 0;
+        for (int i = 0; i < workerCount; ++i)
+            sum += workerSweepPairCounts[i * CounterStride];
+        statistics.SweepPairCount = sum;
+    }
+
+    /// <summary>
+    /// Unhooks the controller from the simulation and returns its resources.
+    /// </summary>
+    public void Dispose()
+    {
+        if (simulation == null)
+            return;
+        Disable();
+        trackedBodies.Dispose(simulation.BufferPool);
+        if (workerSweepPairCounts.Allocated)
+            simulation.BufferPool.Return(ref workerSweepPairCounts);
+        simulation = null;
+    }
+}
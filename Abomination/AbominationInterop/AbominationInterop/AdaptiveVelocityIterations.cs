@@ -0,0 +1,155 @@
+﻿using BepuPhysics;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Configures the adaptive velocity iteration scheduler.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct AdaptiveVelocityIterationSettings
+{
+    /// <summary>
+    /// Fewest velocity iterations the scheduler will choose for a substep.
+    /// </summary>
+    public int MinimumIterationCount;
+    /// <summary>
+    /// Most velocity iterations the scheduler will choose for a substep.
+    /// </summary>
+    public int MaximumIterationCount;
+    /// <summary>
+    /// Velocity change below which the constrained bodies are considered settled. The scheduler drops one iteration after a solve that stays below this.
+    /// </summary>
+    public float SettledVelocityChange;
+    /// <summary>
+    /// Velocity change above which the constrained bodies are considered under stress. The scheduler raises the iteration count after a solve that exceeds this.
+    /// </summary>
+    public float StressedVelocityChange;
+    /// <summary>
+    /// Number of iterations to add when the constrained bodies are under stress.
+    /// </summary>
+    public int IterationIncrease;
+}
+
+/// <summary>
+/// Reports the decisions made by the adaptive velocity iteration scheduler.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct AdaptiveVelocityIterationState
+{
+    /// <summary>
+    /// Velocity iteration count used by the most recent solve.
+    /// </summary>
+    public int LastIterationCount;
+    /// <summary>
+    /// Velocity iteration count that the next solve will use.
+    /// </summary>
+    public int NextIterationCount;
+    /// <summary>
+    /// Root mean square change in velocity across constrained active bodies during the most recent solve.
+    /// </summary>
+    public float LastVelocityChange;
+    /// <summary>
+    /// Number of solves observed since the scheduler was enabled.
+    /// </summary>
+    public int SolveCount;
+    /// <summary>
+    /// Sum of the iteration counts used by every observed solve. Divide by SolveCount for the average.
+    /// </summary>
+    public long TotalIterationCount;
+}
+
+/// <summary>
+/// Chooses the solver's velocity iteration count from how much the solve changed the velocities of constrained bodies.
+/// </summary>
+/// <remarks>The solver doesn't expose constraint residuals, so the velocity change across the solve stands in for them: a settled pile barely changes, while a stressed stack keeps correcting.
+/// Velocity integration runs inside the substeps, so the measured change includes gravity; for a body at rest the contacts cancel it and the net change stays near zero, which is exactly the settled signal wanted.
+/// Unconstrained bodies are excluded since gravity alone changes their velocity.</remarks>
+public class AdaptiveVelocityIterationScheduler
+{
+    Simulation simulation;
+    DefaultTimestepper timestepper;
+    AdaptiveVelocityIterationSettings settings;
+    Buffer<BodyVelocity> preSolveVelocities;
+    int preSolveCount;
+    AdaptiveVelocityIterationState state;
+
+    public AdaptiveVelocityIterationScheduler(Simulation simulation, AdaptiveVelocityIterationSettings settings)
+    {
+        if (simulation.Timestepper is not DefaultTimestepper defaultTimestepper)
+            throw new InvalidOperationException("Adaptive velocity iterations require the default timestepper.");
+        if (settings.MinimumIterationCount < 1 || settings.MaximumIterationCount < settings.MinimumIterationCount)
+            throw new ArgumentException("Adaptive velocity iterations require 1 <= minimum <= maximum.");
+        this.simulation = simulation;
+        this.settings = settings;
+        timestepper = defaultTimestepper;
+        timestepper.CollisionsDetected += OnCollisionsDetected;
+        timestepper.ConstraintsSolved += OnConstraintsSolved;
+        //The scheduler takes over the iteration count; a user scheduler would override it per substep.
+        simulation.Solver.VelocityIterationScheduler = null;
+        state.NextIterationCount = Math.Clamp(simulation.Solver.VelocityIterationCount, settings.MinimumIterationCount, settings.MaximumIterationCount);
+        simulation.Solver.VelocityIterationCount = state.NextIterationCount;
+    }
+
+    public AdaptiveVelocityIterationState State => state;
+
+    void OnCollisionsDetected(float dt, IThreadDispatcher threadDispatcher)
+    {
+        ref var activeSet = ref simulation.Bodies.ActiveSet;
+        preSolveCount = activeSet.Count;
+        if (preSolveVelocities.Length < preSolveCount)
+            simulation.BufferPool.ResizeToAtLeast(ref preSolveVelocities, preSolveCount, 0);
+        for (int i = 0; i < preSolveCount; ++i)
+        {
+            preSolveVelocities[i] = activeSet.DynamicsState[i].Motion.Velocity;
+        }
+    }
+
+    void OnConstraintsSolved(float dt, IThreadDispatcher threadDispatcher)
+    {
+        //The solve doesn't add, remove, or move bodies, so indices captured before the solve still line up.
+        ref var activeSet = ref simulation.Bodies.ActiveSet;
+        double sum = 0;
+        int constrainedCount = 0;
+        for (int i = 0; i < preSolveCount; ++i)
+        {
+            if (activeSet.Constraints[i].Count == 0)
+                continue;
+            ref var velocity = ref activeSet.DynamicsState[i].Motion.Velocity;
+            ref var previous = ref preSolveVelocities[i];
+            sum += (velocity.Linear - previous.Linear).LengthSquared() + (velocity.Angular - previous.Angular).LengthSquared();
+            ++constrainedCount;
+        }
+        var velocityChange = constrainedCount > 0 ? (float)Math.Sqrt(sum / constrainedCount) : 0;
+
+        var used = simulation.Solver.VelocityIterationCount;
+        var next = used;
+        if (velocityChange > settings.StressedVelocityChange)
+            next = used + Math.Max(1, settings.IterationIncrease);
+        else if (velocityChange < settings.SettledVelocityChange)
+            next = used - 1;
+        next = Math.Clamp(next, settings.MinimumIterationCount, settings.MaximumIterationCount);
+        simulation.Solver.VelocityIterationCount = next;
+
+        state.LastIterationCount = used;
+        state.NextIterationCount = next;
+        state.LastVelocityChange = velocityChange;
+        ++state.SolveCount;
+        state.TotalIterationCount += used;
+    }
+
+    /// <summary>
+    /// Unhooks the scheduler from the simulation and returns its resources. The solver keeps the last chosen iteration count.
+    /// </summary>
+    public void Dispose()
+    {
+        timestepper.CollisionsDetected -= OnCollisionsDetected;
+        timestepper.ConstraintsSolved -= OnConstraintsSolved;
+        if (preSolveVelocities.Allocated)
+            simulation.BufferPool.Return(ref preSolveVelocities);
+    }
+}
@@ -0,0 +1,149 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuUtilities;
+using BepuUtilities.Collections;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Forces groups of bodies to sleep or wake with one island transition batch per call.
+/// </summary>
+public static class BodyActivityControl
+{
+    /// <summary>
+    /// Collects the bodies found by a broad phase query, split into active body indices and sleeping set indices.
+    /// </summary>
+    struct RegionBodyCollector : IBreakableForEach<CollidableReference>
+    {
+        public Bodies Bodies;
+        public BufferPool Pool;
+        public QuickList<int> ActiveBodyIndices;
+        public QuickList<int> SleepingSetIndices;
+
+        public bool LoopBody(CollidableReference reference)
+        {
+            if (reference.Mobility != CollidableMobility.Static)
+            {
+                var location = Bodies.HandleToLocation[reference.BodyHandle.Value];
+                if (location.SetIndex == 0)
+                    ActiveBodyIndices.Allocate(Pool) = location.Index;
+                else
+                    SleepingSetIndices.Allocate(Pool) = location.SetIndex;
+            }
+            return true;
+        }
+    }
+
+    static void SleepActiveBodies(Simulation simulation, ref QuickList<int> activeBodyIndices, IThreadDispatcher? threadDispatcher)
+    {
+        if (activeBodyIndices.Count > 0)
+        {
+            //The sleeper traverses the constraint graph from every listed body, so a body pulls its whole island to sleep with it.
+            simulation.Sleeper.Sleep(ref activeBodyIndices, threadDispatcher, forceSleep: true);
+        }
+    }
+
+    static void WakeSets(Simulation simulation, ref QuickList<int> sleepingSetIndices, IThreadDispatcher? threadDispatcher)
+    {
+        if (sleepingSetIndices.Count > 0)
+        {
+            //Many bodies typically share a set, so collapse duplicates before handing the list to the awakener.
+            var span = new Span<int>(sleepingSetIndices.Span.Memory, sleepingSetIndices.Count);
+            span.Sort();
+            int uniqueCount = 1;
+            for (int i = 1; i < span.Length; ++i)
+            {
+                if (span[i] != span[uniqueCount - 1])
+                    span[uniqueCount++] = span[i];
+            }
+            sleepingSetIndices.Count = uniqueCount;
+            simulation.Awakener.AwakenSets(ref sleepingSetIndices, threadDispatcher);
+        }
+    }
+
+    /// <summary>
+    /// Puts the islands containing a set of bodies to sleep regardless of their velocities.
+    /// </summary>
+    /// <param name="simulation">Simulation containing the bodies.</param>
+    /// <param name="bodyHandles">Handles of the bodies to put to sleep. Bodies that are already asleep are ignored.</param>
+    /// <param name="threadDispatcher">Thread dispatcher to use for the island traversal, if any.</param>
+    public static void SleepBodies(Simulation simulation, Buffer<BodyHandle> bodyHandles, IThreadDispatcher? threadDispatcher)
+    {
+        var pool = simulation.BufferPool;
+        var activeBodyIndices = new QuickList<int>(Math.Max(1, bodyHandles.Length), pool);
+        for (int i = 0; i < bodyHandles.Length; ++i)
+        {
+            var location = simulation.Bodies.HandleToLocation[bodyHandles[i].Value];
+            if (location.SetIndex == 0)
+                activeBodyIndices.AllocateUnsafely() = location.Index;
+        }
+        SleepActiveBodies(simulation, ref activeBodyIndices, threadDispatcher);
+        activeBodyIndices.Dispose(pool);
+    }
+
+    /// <summary>
+    /// Wakes the islands containing a set of bodies.
+    /// </summary>
+    /// <param name="simulation">Simulation containing the bodies.</param>
+    /// <param name="bodyHandles">Handles of the bodies to wake. Bodies that are already awake are ignored.</param>
+    /// <param name="threadDispatcher">Thread dispatcher to use for the island transition, if any.</param>
+    public static void WakeBodies(Simulation simulation, Buffer<BodyHandle> bodyHandles, IThreadDispatcher? threadDispatcher)
+    {
+        var pool = simulation.BufferPool;
+        var sleepingSetIndices = new QuickList<int>(Math.Max(1, bodyHandles.Length), pool);
+        for (int i = 0; i < bodyHandles.Length; ++i)
+        {
+            var location = simulation.Bodies.HandleToLocation[bodyHandles[i].Value];
+            if (location.SetIndex > 0)
+                sleepingSetIndices.AllocateUnsafely() = location.SetIndex;
+        }
+        WakeSets(simulation, ref sleepingSetIndices, threadDispatcher);
+        sleepingSetIndices.Dispose(pool);
+    }
+
+    static RegionBodyCollector CollectRegion(Simulation simulation, Vector3 min, Vector3 max)
+    {
+        var collector = new RegionBodyCollector
+        {
+            Bodies = simulation.Bodies,
+            Pool = simulation.BufferPool,
+            ActiveBodyIndices = new QuickList<int>(64, simulation.BufferPool),
+            SleepingSetIndices = new QuickList<int>(64, simulation.BufferPool)
+        };
+        simulation.BroadPhase.GetOverlaps(min, max, ref collector);
+        return collector;
+    }
+
+    /// <summary>
+    /// Puts every island with a body whose bounding box overlaps a region to sleep regardless of velocity.
+    /// </summary>
+    /// <param name="simulation">Simulation to query.</param>
+    /// <param name="min">Minimum corner of the region.</param>
+    /// <param name="max">Maximum corner of the region.</param>
+    /// <param name="threadDispatcher">Thread dispatcher to use for the island traversal, if any.</param>
+    public static void SleepRegion(Simulation simulation, Vector3 min, Vector3 max, IThreadDispatcher? threadDispatcher)
+    {
+        var collector = CollectRegion(simulation, min, max);
+        SleepActiveBodies(simulation, ref collector.ActiveBodyIndices, threadDispatcher);
+        collector.ActiveBodyIndices.Dispose(simulation.BufferPool);
+        collector.SleepingSetIndices.Dispose(simulation.BufferPool);
+    }
+
+    /// <summary>
+    /// Wakes every island with a body whose bounding box overlaps a region.
+    /// </summary>
+    /// <param name="simulation">Simulation to query.</param>
+    /// <param name="min">Minimum corner of the region.</param>
+    /// <param name="max">Maximum corner of the region.</param>
+    /// <param name="threadDispatcher">Thread dispatcher to use for the island transition, if any.</param>
+    public static void WakeRegion(Simulation simulation, Vector3 min, Vector3 max, IThreadDispatcher? threadDispatcher)
+    {
+        var collector = CollectRegion(simulation, min, max);
+        WakeSets(simulation, ref collector.SleepingSetIndices, threadDispatcher);
+        collector.ActiveBodyIndices.Dispose(simulation.BufferPool);
+        collector.SleepingSetIndices.Dispose(simulation.BufferPool);
+    }
+}
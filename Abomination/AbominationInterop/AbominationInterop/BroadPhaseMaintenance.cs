@@ -0,0 +1,186 @@
+﻿using BepuPhysics;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.Trees;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Describes the shape and quality of a bounding volume tree.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct TreeStatistics
+{
+    /// <summary>
+    /// Number of nodes in the tree.
+    /// </summary>
+    public int NodeCount;
+    /// <summary>
+    /// Number of leaves in the tree.
+    /// </summary>
+    public int LeafCount;
+    /// <summary>
+    /// Number of nodes on the longest path from the root to a leaf.
+    /// </summary>
+    public int MaximumDepth;
+    /// <summary>
+    /// Surface area heuristic cost of the tree: the summed surface area of every child bounding box divided by the surface area of the root bounds.
+    /// Lower is better. Roughly proportional to the number of nodes a random query visits.
+    /// </summary>
+    public float CostMetric;
+}
+
+/// <summary>
+/// Describes the shape and quality of the broad phase's trees.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct BroadPhaseStatistics
+{
+    /// <summary>
+    /// Statistics of the tree holding active bodies.
+    /// </summary>
+    public TreeStatistics ActiveTree;
+    /// <summary>
+    /// Statistics of the tree holding statics and sleeping bodies.
+    /// </summary>
+    public TreeStatistics StaticTree;
+}
+
+/// <summary>
+/// Extra refinement applied to the broad phase's trees at the end of every timestep, on top of the engine's own incremental refinement.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct BroadPhaseRefinementBudget
+{
+    /// <summary>
+    /// Scale of the extra refinement applied to the active tree each step. 1 matches the size of the engine's own per-step refinement; 0 adds nothing.
+    /// </summary>
+    public float ActiveTreeRefinementScale;
+    /// <summary>
+    /// Scale of the extra refinement applied to the static tree each step. 1 matches the size of the engine's own per-step refinement; 0 adds nothing.
+    /// </summary>
+    public float StaticTreeRefinementScale;
+}
+
+/// <summary>
+/// Measures, refines, and rebuilds the broad phase's trees.
+/// </summary>
+public static class BroadPhaseMaintenance
+{
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    static float ComputeBoundsMetric(Vector3 min, Vector3 max)
+    {
+        var span = max - min;
+        return span.X * span.Y + span.Y * span.Z + span.Z * span.X;
+    }
+
+    /// <summary>
+    /// Measures a tree by walking all of its nodes.
+    /// </summary>
+    /// <param name="tree">Tree to measure.</param>
+    /// <param name="pool">Pool to allocate the traversal stack from.</param>
+    /// <returns>Statistics of the tree.</returns>
+    public static TreeStatistics Measure(in Tree tree, BufferPool pool)
+    {
+        var statistics = new TreeStatistics { NodeCount = tree.NodeCount, LeafCount = tree.LeafCount };
+        if (tree.LeafCount == 0)
+            return statistics;
+        if (tree.LeafCount == 1)
+        {
+            statistics.MaximumDepth = 1;
+            statistics.CostMetric = 1;
+            return statistics;
+        }
+        ref var root = ref tree.Nodes[0];
+        var rootMetric = ComputeBoundsMetric(Vector3.Min(root.A.Min, root.B.Min), Vector3.Max(root.A.Max, root.B.Max));
+        float summedMetric = 0;
+        //Each visit pops one entry and pushes at most two, so the stack never holds more than depth + 1 entries, and depth is at most the leaf count - 1.
+        pool.Take<(int NodeIndex, int Depth)>(tree.LeafCount, out var stack);
+        stack[0] = (0, 1);
+        int stackCount = 1;
+        while (stackCount > 0)
+        {
+            var entry = stack[--stackCount];
+            ref var node = ref tree.Nodes[entry.NodeIndex];
+            statistics.MaximumDepth = Math.Max(statistics.MaximumDepth, entry.Depth);
+            summedMetric += ComputeBoundsMetric(node.A.Min, node.A.Max) + ComputeBoundsMetric(node.B.Min, node.B.Max);
+            if (node.A.Index >= 0)
+                stack[stackCount++] = (node.A.Index, entry.Depth + 1);
+            if (node.B.Index >= 0)
+                stack[stackCount++] = (node.B.Index, entry.Depth + 1);
+        }
+        pool.Return(ref stack);
+        statistics.CostMetric = rootMetric > 0 ? summedMetric / rootMetric : 0;
+        return statistics;
+    }
+
+    /// <summary>
+    /// Rebuilds a tree from scratch over its current leaf bounds, keeping leaf indices unchanged.
+    /// </summary>
+    static void Rebuild(ref Tree tree, BufferPool pool, IThreadDispatcher? threadDispatcher)
+    {
+        //Trees with fewer than three leaves have only one possible topology.
+        if (tree.LeafCount < 3)
+            return;
+        pool.Take<BoundingBox>(tree.LeafCount, out var leafBounds);
+        for (int i = 0; i < tree.LeafCount; ++i)
+        {
+            var leaf = tree.Leaves[i];
+            ref var node = ref tree.Nodes[leaf.NodeIndex];
+            ref var child = ref leaf.ChildIndex == 0 ? ref node.A : ref node.B;
+            leafBounds[i] = new BoundingBox(child.Min, child.Max);
+        }
+        MeshBuilder.Rebuild(ref tree, leafBounds, pool, threadDispatcher, new MeshBuildOptions { Mode = MeshBuildMode.BinnedSAH });
+        pool.Return(ref leafBounds);
+    }
+
+    /// <summary>
+    /// Rebuilds both broad phase trees from scratch with a binned surface area heuristic build.
+    /// </summary>
+    /// <param name="broadPhase">Broad phase to rebuild.</param>
+    /// <param name="pool">Pool to allocate temporary resources from.</param>
+    /// <param name="threadDispatcher">Dispatcher to distribute the builds over, if any.</param>
+    public static void Rebuild(BroadPhase broadPhase, BufferPool pool, IThreadDispatcher? threadDispatcher)
+    {
+        Rebuild(ref broadPhase.ActiveTree, pool, threadDispatcher);
+        Rebuild(ref broadPhase.StaticTree, pool, threadDispatcher);
+    }
+}
+
+/// <summary>
+/// Applies a <see cref="BroadPhaseRefinementBudget"/> to a simulation's broad phase after each timestep.
+/// </summary>
+public class BroadPhaseRefiner
+{
+    /// <summary>
+    /// Extra refinement to apply each step.
+    /// </summary>
+    public BroadPhaseRefinementBudget Budget;
+    int frameIndex;
+
+    public BroadPhaseRefiner(BroadPhaseRefinementBudget budget)
+    {
+        Budget = budget;
+    }
+
+    /// <summary>
+    /// Runs one step's worth of extra refinement.
+    /// </summary>
+    /// <param name="simulation">Simulation whose broad phase should be refined.</param>
+    public void Refine(Simulation simulation)
+    {
+        //The engine's own refinement already ran during the step and picked its subtrees based on its frame counter; 
+        //an independent counter here spreads the extra work over different parts of the tree.
+        ++frameIndex;
+        var broadPhase = simulation.BroadPhase;
+        if (Budget.ActiveTreeRefinementScale > 0 && broadPhase.ActiveTree.LeafCount > 2)
+            broadPhase.ActiveTree.RefitAndRefine(simulation.BufferPool, frameIndex, Budget.ActiveTreeRefinementScale);
+        if (Budget.StaticTreeRefinementScale > 0 && broadPhase.StaticTree.LeafCount > 2)
+            broadPhase.StaticTree.RefitAndRefine(simulation.BufferPool, frameIndex, Budget.StaticTreeRefinementScale);
+    }
+}
@@ -0,0 +1,276 @@
+﻿using BepuUtilities.Memory;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Snapshot of a buffer pool's memory usage and allocation activity.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public unsafe struct BufferPoolStatistics
+{
+    /// <summary>
+    /// Number of power pools tracked in the per-power arrays. Index i corresponds to slots of size 2^i bytes.
+    /// </summary>
+    public const int PowerCount = 32;
+
+    /// <summary>
+    /// Total number of bytes allocated from native memory by the pool, whether or not any slot in it is currently in use.
+    /// </summary>
+    public ulong ReservedBytes;
+    /// <summary>
+    /// Highest observed value of <see cref="ReservedBytes"/> since the last reset.
+    /// </summary>
+    public ulong PeakReservedBytes;
+    /// <summary>
+    /// Number of slot bytes currently held by outstanding buffers taken through the interop allocation functions.
+    /// </summary>
+    public ulong BytesInUse;
+    /// <summary>
+    /// Highest observed value of <see cref="BytesInUse"/> since the last reset.
+    /// </summary>
+    public ulong PeakBytesInUse;
+    /// <summary>
+    /// Number of buffers taken through the interop allocation functions since the last reset.
+    /// </summary>
+    public ulong AllocationCount;
+    /// <summary>
+    /// Number of resizes requested through the interop resize functions since the last reset.
+    /// </summary>
+    public ulong ResizeCount;
+    /// <summary>
+    /// Number of buffers returned through the interop deallocation functions since the last reset.
+    /// </summary>
+    public ulong DeallocationCount;
+    /// <summary>
+    /// Minimum size of individual block allocations made by the pool.
+    /// </summary>
+    public int MinimumBlockAllocationSize;
+    /// <summary>
+    /// Number of outstanding buffers with a recorded allocation tag. Zero unless allocation tagging is enabled.
+    /// </summary>
+    public int TaggedAllocationCount;
+    /// <summary>
+    /// Number of bytes allocated from native memory for each power pool.
+    /// </summary>
+    public fixed ulong ReservedBytesPerPower[PowerCount];
+    /// <summary>
+    /// Number of outstanding slots in each power pool taken through the interop allocation functions.
+    /// </summary>
+    public fixed int SlotsInUsePerPower[PowerCount];
+}
+
+/// <summary>
+/// Describes an outstanding buffer recorded while allocation tagging is enabled.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct TaggedBufferAllocation
+{
+    /// <summary>
+    /// Id of the outstanding buffer.
+    /// </summary>
+    public int BufferId;
+    /// <summary>
+    /// Size of the slot backing the buffer in bytes.
+    /// </summary>
+    public int SlotSizeInBytes;
+    /// <summary>
+    /// Tag that was active when the buffer was allocated.
+    /// </summary>
+    public int Tag;
+    /// <summary>
+    /// Value of the pool's allocation counter when the buffer was allocated. Lower values are older.
+    /// </summary>
+    public int AllocationIndex;
+}
+
+/// <summary>
+/// Describes how a buffer pool should be created.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public unsafe struct BufferPoolOptions
+{
+    /// <summary>
+    /// Minimum size of individual block allocations. Must be a power of 2.
+    /// </summary>
+    public int MinimumBlockAllocationSize;
+    /// <summary>
+    /// Number of suballocations to preallocate reference space for.
+    /// </summary>
+    public int ExpectedUsedSlotCountPerPool;
+    /// <summary>
+    /// Maximum number of bytes the pool may reserve in response to interop allocations. Zero means unlimited.
+    /// </summary>
+    public ulong MaximumReservedBytes;
+    /// <summary>
+    /// Number of bytes to preallocate for each power pool. Index i corresponds to slots of size 2^i bytes. Powers above 30 are ignored.
+    /// </summary>
+    public fixed int PreallocatedBytesPerPower[BufferPoolStatistics.PowerCount];
+}
+
+/// <summary>
+/// Tracks allocation activity for a buffer pool. Only sees buffers that pass through the interop entrypoints; allocations made by the engine internally show up in the reserved byte counts.
+/// </summary>
+public class BufferPoolTelemetry
+{
+    //Buffer ids taken from a BufferPool pack the power pool index into the upper bits. This matches BufferPool.IdPowerShift.
+    const int IdPowerShift = 26;
+    //BufferPool doesn't create power pools beyond 2^30; a single buffer can't exceed int.MaxValue bytes.
+    public const int MaximumPower = 30;
+
+    public ulong PeakReservedBytes;
+    public long BytesInUse;
+    public long PeakBytesInUse;
+    public ulong AllocationCount;
+    public ulong ResizeCount;
+    public ulong DeallocationCount;
+    public readonly int[] SlotsInUsePerPower = new int[BufferPoolStatistics.PowerCount];
+
+    /// <summary>
+    /// Outstanding allocations recorded by the tagging mode, keyed by buffer id. Null if tagging is disabled.
+    /// </summary>
+    public Dictionary<int, TaggedBufferAllocation>? TaggedAllocations;
+    /// <summary>
+    /// Tag applied to allocations recorded while tagging is enabled.
+    /// </summary>
+    public int CurrentTag;
+    int taggedAllocationCounter;
+
+    /// <summary>
+    /// Maximum number of bytes the pool is allowed to reserve in response to interop allocations. Zero means unlimited.
+    /// </summary>
+    public ulong MaximumReservedBytes;
+
+    public static int GetPower(int bufferId) => bufferId >> IdPowerShift;
+
+    /// <summary>
+    /// Checks whether a new slot of the given power could be taken without risking growth past <see cref="MaximumReservedBytes"/>.
+    /// </summary>
+    public bool AllowsTake(BufferPool pool, int power)
+    {
+        if (MaximumReservedBytes == 0)
+            return true;
+        //BufferPool doesn't expose whether a power pool has free slots, so assume the worst: the take needs a whole new block.
+        var worstCaseGrowth = (ulong)Math.Max(pool.MinimumBlockAllocationSize, 1 << power);
+        return pool.GetTotalAllocatedByteCount() + worstCaseGrowth <= MaximumReservedBytes;
+    }
+
+    /// <summary>
+    /// Checks whether the given power pool could be grown to hold the given number of bytes without exceeding <see cref="MaximumReservedBytes"/>.
+    /// </summary>
+    public bool AllowsReservation(BufferPool pool, int power, int byteCount)
+    {
+        if (MaximumReservedBytes == 0)
+            return true;
+        var missingBytes = (long)byteCount - pool.GetCapacityForPower(power);
+        if (missingBytes <= 0)
+            return true;
+        var blockSize = (long)Math.Max(pool.MinimumBlockAllocationSize, 1 << power);
+        var growth = (ulong)((missingBytes + blockSize - 1) / blockSize * blockSize);
+        return pool.GetTotalAllocatedByteCount() + growth <= MaximumReservedBytes;
+    }
+
+    public void SampleReservedBytes(BufferPool pool)
+    {
+        var reserved = pool.GetTotalAllocatedByteCount();
+        if (reserved > PeakReservedBytes)
+            PeakReservedBytes = reserved;
+    }
+
+    public void OnTake(BufferPool pool, int bufferId)
+    {
+        ++AllocationCount;
+        var power = GetPower(bufferId);
+        ++SlotsInUsePerPower[power];
+        BytesInUse += 1L << power;
+        if (BytesInUse > PeakBytesInUse)
+            PeakBytesInUse = BytesInUse;
+        if (TaggedAllocations != null)
+        {
+            TaggedAllocations[bufferId] = new TaggedBufferAllocation { BufferId = bufferId, SlotSizeInBytes = 1 << power, Tag = CurrentTag, AllocationIndex = taggedAllocationCounter++ };
+        }
+        SampleReservedBytes(pool);
+    }
+
+    public void OnReturn(int bufferId)
+    {
+        ++DeallocationCount;
+        var power = GetPower(bufferId);
+        --SlotsInUsePerPower[power];
+        BytesInUse -= 1L << power;
+        TaggedAllocations?.Remove(bufferId);
+    }
+
+    public void OnResize(BufferPool pool, bool wasAllocated, int previousId, bool isAllocated, int newId)
+    {
+        ++ResizeCount;
+        //Resizes that stay within the same slot don't change occupancy.
+        if (wasAllocated && isAllocated && previousId == newId)
+            return;
+        if (wasAllocated)
+        {
+            //The resize's internal return and take shouldn't show up as separate allocation events.
+            OnReturn(previousId);
+            --DeallocationCount;
+        }
+        if (isAllocated)
+        {
+            OnTake(pool, newId);
+            --AllocationCount;
+        }
+        SampleReservedBytes(pool);
+    }
+
+    /// <summary>
+    /// Forgets all outstanding allocations. Used when the pool is cleared.
+    /// </summary>
+    public void OnClear()
+    {
+        Array.Clear(SlotsInUsePerPower);
+        BytesInUse = 0;
+        TaggedAllocations?.Clear();
+    }
+
+    /// <summary>
+    /// Resets counters and peaks to the current state of the pool.
+    /// </summary>
+    public void Reset(BufferPool pool)
+    {
+        AllocationCount = 0;
+        ResizeCount = 0;
+        DeallocationCount = 0;
+        PeakBytesInUse = BytesInUse;
+        PeakReservedBytes = pool.GetTotalAllocatedByteCount();
+    }
+
+    public void SetTaggingEnabled(bool enabled)
+    {
+        if (enabled)
+        {
+            TaggedAllocations ??= new Dictionary<int, TaggedBufferAllocation>();
+        }
+        else
+        {
+            TaggedAllocations = null;
+        }
+    }
+
+    public unsafe void GetStatistics(BufferPool pool, BufferPoolStatistics* statistics)
+    {
+        SampleReservedBytes(pool);
+        statistics->ReservedBytes = pool.GetTotalAllocatedByteCount();
+        statistics->PeakReservedBytes = PeakReservedBytes;
+        statistics->BytesInUse = (ulong)BytesInUse;
+        statistics->PeakBytesInUse = (ulong)PeakBytesInUse;
+        statistics->AllocationCount = AllocationCount;
+        statistics->ResizeCount = ResizeCount;
+        statistics->DeallocationCount = DeallocationCount;
+        statistics->MinimumBlockAllocationSize = pool.MinimumBlockAllocationSize;
+        statistics->TaggedAllocationCount = TaggedAllocations != null ? TaggedAllocations.Count : 0;
+        for (int power = 0; power < BufferPoolStatistics.PowerCount; ++power)
+        {
+            statistics->ReservedBytesPerPower[power] = power <= MaximumPower ? (ulong)pool.GetCapacityForPower(power) : 0;
+            statistics->SlotsInUsePerPower[power] = SlotsInUsePerPower[power];
+        }
+    }
+}
@@ -0,0 +1,493 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.CollisionDetection.CollisionTasks;
+using BepuPhysics.Trees;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Vertex position quantized to 16 bits per axis within a compressed mesh's bounds.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct QuantizedVertex
+{
+    public ushort X;
+    public ushort Y;
+    public ushort Z;
+}
+
+/// <summary>
+/// Child of a compressed mesh tree node with bounds quantized to the mesh's vertex grid.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct QuantizedNodeChild
+{
+    public QuantizedVertex Min;
+    public QuantizedVertex Max;
+    /// <summary>
+    /// Index of the child node, or -1 - triangleIndex for leaves.
+    /// </summary>
+    public int Index;
+}
+
+/// <summary>
+/// 2-wide compressed mesh tree node.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct QuantizedNode
+{
+    public QuantizedNodeChild A;
+    public QuantizedNodeChild B;
+}
+
+/// <summary>
+/// Triangle mesh storing shared vertices quantized to 16 bits per axis, 16 or 32 bit index triplets, and a tree with quantized child bounds.
+/// Triangles are decoded on demand during collision and ray tests.
+/// </summary>
+/// <remarks>Like <see cref="Mesh"/>, triangles only collide with tests which see them as wound clockwise in right handed coordinates.
+/// Vertices are quantized against the bounds of the whole mesh, so the worst case position error is half of <see cref="QuantizationStep"/> on each axis before scaling.</remarks>
+[StructLayout(LayoutKind.Sequential)]
+public unsafe struct CompressedMesh : IHomogeneousCompoundShape<Triangle, TriangleWide>
+{
+    /// <summary>
+    /// Nodes of the mesh's acceleration structure.
+    /// </summary>
+    public Buffer<QuantizedNode> Nodes;
+    /// <summary>
+    /// Quantized vertices shared by the mesh's triangles.
+    /// </summary>
+    public Buffer<QuantizedVertex> Vertices;
+    /// <summary>
+    /// Three vertex indices per triangle, each <see cref="IndexSize"/> bytes wide.
+    /// </summary>
+    public Buffer<byte> Indices;
+    /// <summary>
+    /// Number of triangles in the mesh.
+    /// </summary>
+    public int TriangleCount;
+    /// <summary>
+    /// Size of each vertex index in bytes. 2 when the mesh has at most 65536 vertices, 4 otherwise.
+    /// </summary>
+    public int IndexSize;
+    /// <summary>
+    /// Unscaled local position of the quantization grid's origin.
+    /// </summary>
+    public Vector3 Origin;
+    /// <summary>
+    /// Unscaled local size of one quantization step along each axis.
+    /// </summary>
+    public Vector3 QuantizationStep;
+    internal Vector3 scale;
+    internal Vector3 inverseScale;
+
+    /// <summary>
+    /// Gets or sets the scale of the mesh.
+    /// </summary>
+    public Vector3 Scale
+    {
+        readonly get => scale;
+        set
+        {
+            scale = value;
+            inverseScale = new Vector3(
+                value.X != 0 ? 1f / value.X : float.MaxValue,
+                value.Y != 0 ? 1f / value.Y : float.MaxValue,
+                value.Z != 0 ? 1f / value.Z : float.MaxValue);
+        }
+    }
+
+    /// <summary>
+    /// Type id of compressed mesh shapes.
+    /// </summary>
+    public const int Id = 9;
+    public static int TypeId => Id;
+
+    public static ShapeBatch CreateShapeBatch(BufferPool pool, int initialCapacity, Shapes shapeBatches)
+    {
+        return new HomogeneousCompoundShapeBatch<CompressedMesh, Triangle, TriangleWide>(pool, initialCapacity);
+    }
+
+    public readonly int ChildCount => TriangleCount;
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    readonly Vector3 Decode(in QuantizedVertex vertex)
+    {
+        return Origin + new Vector3(vertex.X, vertex.Y, vertex.Z) * QuantizationStep;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    readonly void GetUnscaledTriangle(int triangleIndex, out Vector3 a, out Vector3 b, out Vector3 c)
+    {
+        int ia, ib, ic;
+        if (IndexSize == 2)
+        {
+            var indices = (ushort*)Indices.Memory + triangleIndex * 3;
+            ia = indices[0]; ib = indices[1]; ic = indices[2];
+        }
+        else
+        {
+            var indices = (int*)Indices.Memory + triangleIndex * 3;
+            ia = indices[0]; ib = indices[1]; ic = indices[2];
+        }
+        a = Decode(Vertices[ia]);
+        b = Decode(Vertices[ib]);
+        c = Decode(Vertices[ic]);
+    }
+
+    public readonly void GetLocalChild(int triangleIndex, out Triangle target)
+    {
+        GetUnscaledTriangle(triangleIndex, out var a, out var b, out var c);
+        target.A = a * scale;
+        target.B = b * scale;
+        target.C = c * scale;
+    }
+
+    public readonly void GetPosedLocalChild(int triangleIndex, out Triangle target, out RigidPose childPose)
+    {
+        GetLocalChild(triangleIndex, out target);
+        childPose.Orientation = Quaternion.Identity;
+        childPose.Position = (target.A + target.B + target.C) * (1f / 3f);
+        target.A -= childPose.Position;
+        target.B -= childPose.Position;
+        target.C -= childPose.Position;
+    }
+
+    public readonly void GetLocalChild(int triangleIndex, ref TriangleWide target)
+    {
+        //This inserts a triangle into the first slot of the given wide instance.
+        GetLocalChild(triangleIndex, out Triangle triangle);
+        Vector3Wide.WriteFirst(triangle.A, ref target.A);
+        Vector3Wide.WriteFirst(triangle.B, ref target.B);
+        Vector3Wide.WriteFirst(triangle.C, ref target.C);
+    }
+
+    public readonly void ComputeBounds(Quaternion orientation, out Vector3 min, out Vector3 max)
+    {
+        Matrix3x3.CreateFromQuaternion(orientation, out var rotation);
+        min = new Vector3(float.MaxValue);
+        max = new Vector3(float.MinValue);
+        for (int i = 0; i < Vertices.Length; ++i)
+        {
+            Matrix3x3.Transform(Decode(Vertices[i]) * scale, rotation, out var rotated);
+            min = Vector3.Min(min, rotated);
+            max = Vector3.Max(max, rotated);
+        }
+    }
+
+    /// <summary>
+    /// Converts unscaled local bounds into the quantization grid, rounding outward.
+    /// </summary>
+    /// <returns>False if the bounds are entirely outside the grid.</returns>
+    readonly bool TryQuantizeBounds(Vector3 min, Vector3 max, out QuantizedVertex quantizedMin, out QuantizedVertex quantizedMax)
+    {
+        var inverseStep = Vector3.One / QuantizationStep;
+        var gridMin = Vector3.Max(Vector3.Zero, (min - Origin) * inverseStep);
+        var gridMax = Vector3.Min(new Vector3(ushort.MaxValue), (max - Origin) * inverseStep);
+        quantizedMin = default;
+        quantizedMax = default;
+        if (gridMin.X > gridMax.X || gridMin.Y > gridMax.Y || gridMin.Z > gridMax.Z)
+            return false;
+        quantizedMin = new QuantizedVertex { X = (ushort)MathF.Floor(gridMin.X), Y = (ushort)MathF.Floor(gridMin.Y), Z = (ushort)MathF.Floor(gridMin.Z) };
+        quantizedMax = new QuantizedVertex { X = (ushort)MathF.Ceiling(gridMax.X), Y = (ushort)MathF.Ceiling(gridMax.Y), Z = (ushort)MathF.Ceiling(gridMax.Z) };
+        return true;
+    }
+
+    const int TraversalStackCapacity = 256;
+
+    /// <summary>
+    /// Node stack for tree traversals. Starts in stack memory like the engine's traversals, but spills into the pool if a skewed tree runs deeper than that.
+    /// </summary>
+    ref struct TraversalStack
+    {
+        int* memory;
+        int capacity;
+        int count;
+        Buffer<int> spilled;
+        BufferPool pool;
+
+        public TraversalStack(int* memory, int capacity, BufferPool pool)
+        {
+            this.memory = memory;
+            this.capacity = capacity;
+            this.pool = pool;
+            count = 0;
+            spilled = default;
+        }
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        public void Push(int nodeIndex)
+        {
+            if (count == capacity)
+                Grow();
+            memory[count++] = nodeIndex;
+        }
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        public bool TryPop(out int nodeIndex)
+        {
+            if (count == 0)
+            {
+                nodeIndex = default;
+                return false;
+            }
+            nodeIndex = memory[--count];
+            return true;
+        }
+
+        void Grow()
+        {
+            pool.Take<int>(capacity * 2, out var larger);
+            System.Buffer.MemoryCopy(memory, larger.Memory, (long)larger.Length * sizeof(int), (long)count * sizeof(int));
+            if (spilled.Allocated)
+                pool.Return(ref spilled);
+            spilled = larger;
+            memory = larger.Memory;
+            capacity = larger.Length;
+        }
+
+        public void Dispose()
+        {
+            if (spilled.Allocated)
+                pool.Return(ref spilled);
+        }
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    static bool Intersects(in QuantizedNodeChild child, in QuantizedVertex min, in QuantizedVertex max)
+    {
+        return child.Min.X <= max.X && child.Max.X >= min.X &&
+               child.Min.Y <= max.Y && child.Max.Y >= min.Y &&
+               child.Min.Z <= max.Z && child.Max.Z >= min.Z;
+    }
+
+    readonly void GetOverlaps<TSubpairOverlaps>(in QuantizedVertex min, in QuantizedVertex max, BufferPool pool, ref TSubpairOverlaps overlaps) where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        var stackMemory = stackalloc int[TraversalStackCapacity];
+        var stack = new TraversalStack(stackMemory, TraversalStackCapacity, pool);
+        stack.Push(0);
+        while (stack.TryPop(out var nodeIndex))
+        {
+            ref var node = ref Nodes[nodeIndex];
+            //B is pushed first so that A's subtree is visited first.
+            //A single triangle mesh's root has no second child.
+            if (TriangleCount > 1 && Intersects(node.B, min, max))
+            {
+                if (node.B.Index < 0)
+                    overlaps.Allocate(pool) = -1 - node.B.Index;
+                else
+                    stack.Push(node.B.Index);
+            }
+            if (Intersects(node.A, min, max))
+            {
+                if (node.A.Index < 0)
+                    overlaps.Allocate(pool) = -1 - node.A.Index;
+                else
+                    stack.Push(node.A.Index);
+            }
+        }
+        stack.Dispose();
+    }
+
+    readonly void GetOverlaps<TSubpairOverlaps>(Vector3 scaledMin, Vector3 scaledMax, BufferPool pool, ref TSubpairOverlaps overlaps) where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        //Negative scales flip the bounds, so take the componentwise min and max after unscaling.
+        var a = scaledMin * inverseScale;
+        var b = scaledMax * inverseScale;
+        if (TriangleCount > 0 && TryQuantizeBounds(Vector3.Min(a, b), Vector3.Max(a, b), out var min, out var max))
+            GetOverlaps(min, max, pool, ref overlaps);
+    }
+
+    public readonly void FindLocalOverlaps<TOverlaps, TSubpairOverlaps>(ref Buffer<OverlapQueryForPair> pairs, BufferPool pool, Shapes shapes, ref TOverlaps overlaps)
+        where TOverlaps : struct, ICollisionTaskOverlaps<TSubpairOverlaps>
+        where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        for (int i = 0; i < pairs.Length; ++i)
+        {
+            ref var pair = ref pairs[i];
+            Unsafe.AsRef<CompressedMesh>(pair.Container).GetOverlaps(pair.Min, pair.Max, pool, ref overlaps.GetOverlapsForPair(i));
+        }
+    }
+
+    public readonly void FindLocalOverlaps<TOverlaps>(Vector3 min, Vector3 max, Vector3 sweep, float maximumT, BufferPool pool, Shapes shapes, void* overlaps)
+        where TOverlaps : ICollisionTaskSubpairOverlaps
+    {
+        //The quantized tree has no swept traversal; expanding the query bounds by the sweep is conservative.
+        var sweepOffset = sweep * maximumT;
+        GetOverlaps(Vector3.Min(min, min + sweepOffset), Vector3.Max(max, max + sweepOffset), pool, ref Unsafe.AsRef<TOverlaps>(overlaps));
+    }
+
+    readonly void RayTest<TRayHitHandler>(in RayData ray, Vector3 localOrigin, Vector3 localDirection, Vector3 inverseDirection, Matrix3x3 orientation, ref float maximumT, BufferPool pool, ref TRayHitHandler hitHandler)
+        where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        var stackMemory = stackalloc int[TraversalStackCapacity];
+        var stack = new TraversalStack(stackMemory, TraversalStackCapacity, pool);
+        stack.Push(0);
+        var childCount = TriangleCount > 1 ? 2 : 1;
+        while (stack.TryPop(out var nodeIndex))
+        {
+            ref var node = ref Nodes[nodeIndex];
+            //Children are walked in reverse so that A's subtree is popped first.
+            for (int childIndex = childCount - 1; childIndex >= 0; --childIndex)
+            {
+                ref var child = ref childIndex == 0 ? ref node.A : ref node.B;
+                //Slab test against the dequantized child bounds in unscaled local space.
+                var t0 = (Decode(child.Min) - localOrigin) * inverseDirection;
+                var t1 = (Decode(child.Max) - localOrigin) * inverseDirection;
+                var tMin = Vector3.Min(t0, t1);
+                var tMax = Vector3.Max(t0, t1);
+                var entry = MathF.Max(MathF.Max(tMin.X, tMin.Y), MathF.Max(tMin.Z, 0));
+                var exit = MathF.Min(MathF.Min(tMax.X, tMax.Y), MathF.Min(tMax.Z, maximumT));
+                if (entry > exit)
+                    continue;
+                if (child.Index >= 0)
+                {
+                    stack.Push(child.Index);
+                    continue;
+                }
+                var triangleIndex = -1 - child.Index;
+                if (!hitHandler.AllowTest(triangleIndex))
+                    continue;
+                GetUnscaledTriangle(triangleIndex, out var a, out var b, out var c);
+                if (Triangle.RayTest(a * scale, b * scale, c * scale, localOrigin * scale, localDirection * scale, out var t, out var normal) && t <= maximumT)
+                {
+                    Matrix3x3.Transform(normal, orientation, out normal);
+                    hitHandler.OnRayHit(ray, ref maximumT, t, normal, triangleIndex);
+                }
+            }
+        }
+        stack.Dispose();
+    }
+
+    public readonly void RayTest<TRayHitHandler>(in RigidPose pose, in RayData ray, ref float maximumT, BufferPool pool, ref TRayHitHandler hitHandler) where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        if (TriangleCount == 0)
+            return;
+        Matrix3x3.CreateFromQuaternion(pose.Orientation, out var orientation);
+        Matrix3x3.TransformTranspose(ray.Origin - pose.Position, orientation, out var localOrigin);
+        Matrix3x3.TransformTranspose(ray.Direction, orientation, out var localDirection);
+        //The tree lives in unscaled space; t values are unaffected by scaling origin and direction together.
+        localOrigin *= inverseScale;
+        localDirection *= inverseScale;
+        var inverseDirection = new Vector3(
+            localDirection.X != 0 ? 1f / localDirection.X : float.MaxValue,
+            localDirection.Y != 0 ? 1f / localDirection.Y : float.MaxValue,
+            localDirection.Z != 0 ? 1f / localDirection.Z : float.MaxValue);
+        RayTest(ray, localOrigin, localDirection, inverseDirection, orientation, ref maximumT, pool, ref hitHandler);
+    }
+
+    public readonly void RayTest<TRayHitHandler>(in RigidPose pose, ref RaySource rays, BufferPool pool, ref TRayHitHandler hitHandler) where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        for (int i = 0; i < rays.RayCount; ++i)
+        {
+            rays.GetRay(i, out var ray, out var maximumT);
+            RayTest(pose, *ray, ref *maximumT, pool, ref hitHandler);
+        }
+    }
+
+    public void Dispose(BufferPool pool)
+    {
+        pool.Return(ref Nodes);
+        pool.Return(ref Vertices);
+        pool.Return(ref Indices);
+    }
+
+    /// <summary>
+    /// Creates a compressed mesh from indexed vertices.
+    /// </summary>
+    /// <param name="vertices">Vertices referenced by the indices. Not retained by the mesh.</param>
+    /// <param name="indices">Three vertex indices per triangle. Not retained by the mesh.</param>
+    /// <param name="scale">Scale of the mesh.</param>
+    /// <param name="pool">Pool to allocate the mesh's buffers and temporary resources from.</param>
+    /// <param name="threadDispatcher">Dispatcher to distribute the tree build over, if any.</param>
+    /// <param name="options">Options for building the acceleration structure.</param>
+    /// <returns>Created mesh.</returns>
+    public static CompressedMesh Create(Buffer<Vector3> vertices, Buffer<int> indices, Vector3 scale, BufferPool pool, IThreadDispatcher? threadDispatcher, MeshBuildOptions options)
+    {
+        if (indices.Length == 0 || indices.Length % 3 != 0)
+            throw new ArgumentException("Compressed meshes require at least one triangle and an index count that is a multiple of 3.");
+        if (vertices.Length == 0)
+            throw new ArgumentException("Compressed meshes require at least one vertex.");
+        //Out of range indices would read past the decoded vertices during the build and be truncated when packed into 16 bit indices.
+        for (int i = 0; i < indices.Length; ++i)
+        {
+            if ((uint)indices[i] >= (uint)vertices.Length)
+                throw new ArgumentOutOfRangeException(nameof(indices), $"Index {indices[i]} at position {i} is outside the {vertices.Length} provided vertices.");
+        }
+        CompressedMesh mesh = default;
+        mesh.Scale = scale;
+        mesh.TriangleCount = indices.Length / 3;
+        var min = new Vector3(float.MaxValue);
+        var max = new Vector3(float.MinValue);
+        for (int i = 0; i < vertices.Length; ++i)
+        {
+            min = Vector3.Min(min, vertices[i]);
+            max = Vector3.Max(max, vertices[i]);
+        }
+        var span = max - min;
+        mesh.Origin = min;
+        //Degenerate axes still need a nonzero step so that queries can divide by it.
+        mesh.QuantizationStep = new Vector3(
+            span.X > 0 ? span.X / ushort.MaxValue : 1,
+            span.Y > 0 ? span.Y / ushort.MaxValue : 1,
+            span.Z > 0 ? span.Z / ushort.MaxValue : 1);
+
+        //Quantize the vertices, then build the tree over the quantized positions so that node bounds contain the triangles that will actually be decoded.
+        pool.Take(vertices.Length, out mesh.Vertices);
+        pool.Take<Vector3>(vertices.Length, out var decodedVertices);
+        var inverseStep = Vector3.One / mesh.QuantizationStep;
+        for (int i = 0; i < vertices.Length; ++i)
+        {
+            var grid = Vector3.Clamp((vertices[i] - min) * inverseStep + new Vector3(0.5f), Vector3.Zero, new Vector3(ushort.MaxValue));
+            ref var vertex = ref mesh.Vertices[i];
+            vertex.X = (ushort)grid.X;
+            vertex.Y = (ushort)grid.Y;
+            vertex.Z = (ushort)grid.Z;
+            decodedVertices[i] = mesh.Decode(vertex);
+        }
+        pool.Take<Triangle>(mesh.TriangleCount, out var triangles);
+        var sourceMesh = MeshBuilder.Build(triangles, decodedVertices, indices, Vector3.One, pool, threadDispatcher, options);
+        pool.Return(ref decodedVertices);
+
+        ref var tree = ref sourceMesh.Tree;
+        pool.Take(tree.NodeCount, out mesh.Nodes);
+        for (int i = 0; i < tree.NodeCount; ++i)
+        {
+            ref var source = ref tree.Nodes[i];
+            ref var target = ref mesh.Nodes[i];
+            QuantizeChild(source.A, min, inverseStep, out target.A);
+            QuantizeChild(source.B, min, inverseStep, out target.B);
+        }
+        sourceMesh.Dispose(pool);
+
+        mesh.IndexSize = vertices.Length <= ushort.MaxValue + 1 ? 2 : 4;
+        pool.Take(indices.Length * mesh.IndexSize, out mesh.Indices);
+        if (mesh.IndexSize == 2)
+        {
+            //Indices were validated against the vertex count, so they all fit.
+            var target = (ushort*)mesh.Indices.Memory;
+            for (int i = 0; i < indices.Length; ++i)
+                target[i] = (ushort)indices[i];
+        }
+        else
+        {
+            indices.CopyTo(0, new Buffer<int>(mesh.Indices.Memory, indices.Length), 0, indices.Length);
+        }
+        return mesh;
+    }
+
+    static void QuantizeChild(in NodeChild source, Vector3 origin, Vector3 inverseStep, out QuantizedNodeChild target)
+    {
+        var gridMin = Vector3.Clamp((source.Min - origin) * inverseStep, Vector3.Zero, new Vector3(ushort.MaxValue));
+        var gridMax = Vector3.Clamp((source.Max - origin) * inverseStep, Vector3.Zero, new Vector3(ushort.MaxValue));
+        target.Min = new QuantizedVertex { X = (ushort)MathF.Floor(gridMin.X), Y = (ushort)MathF.Floor(gridMin.Y), Z = (ushort)MathF.Floor(gridMin.Z) };
+        target.Max = new QuantizedVertex { X = (ushort)MathF.Ceiling(gridMax.X), Y = (ushort)MathF.Ceiling(gridMax.Y), Z = (ushort)MathF.Ceiling(gridMax.Z) };
+        target.Index = source.Index;
+    }
+}
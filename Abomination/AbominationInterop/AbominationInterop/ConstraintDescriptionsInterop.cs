@@ -0,0 +1,44 @@
+﻿using System.Numerics;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Types of constraint descriptions accepted by the batched constraint creation entrypoints.
+/// </summary>
+public enum JointType : int
+{
+    BallSocket = 0,
+    Hinge = 1,
+    SwivelHinge = 2,
+    AngularMotor = 3,
+    DistanceLimit = 4,
+    Weld = 5,
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct MotorSettingsInterop
+{
+    /// <summary>
+    /// Maximum force that the constraint can apply in a single frame.
+    /// </summary>
+    public float MaximumForce;
+    /// <summary>
+    /// Damping of the motor. Higher values make the motor approach its target velocity more softly; zero is infinitely stiff.
+    /// </summary>
+    public float Damping;
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct AngularMotorInterop
+{
+    /// <summary>
+    /// Target relative angular velocity between A and B, stored in A's local space. Target world space angular velocity of B is AngularVelocityA + TargetVelocityLocalA * OrientationA.
+    /// </summary>
+    public Vector3 TargetVelocityLocalA;
+    /// <summary>
+    /// Motor control parameters.
+    /// </summary>
+    [TypeName("MotorSettings")]
+    public MotorSettingsInterop Settings;
+}
@@ -0,0 +1,319 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.Constraints;
+using BepuPhysics.Constraints.Contact;
+using BepuUtilities;
+using BepuUtilities.Collections;
+using BepuUtilities.Memory;
+using System;
+using System.Collections.Generic;
+using System.Numerics;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Controls which contacts <see cref="ContactExporter"/> writes.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct ContactExportOptions
+{
+    /// <summary>
+    /// Contacts with an accumulated normal impulse below this value are skipped. Zero or less exports every contact.
+    /// </summary>
+    public float MinimumNormalImpulse;
+    /// <summary>
+    /// If nonzero, speculative contacts with negative depth are exported too. Otherwise only touching contacts are exported.
+    /// </summary>
+    public int IncludeSpeculativeContacts;
+}
+
+/// <summary>
+/// Solver state of a single contact, read after a timestep.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct ContactRecord
+{
+    /// <summary>
+    /// Handle of the contact constraint holding the contact.
+    /// </summary>
+    public ConstraintHandle Constraint;
+    /// <summary>
+    /// First collidable in the pair. Always a body.
+    /// </summary>
+    public CollidableReference A;
+    /// <summary>
+    /// Second collidable in the pair. Refers to the static for pairs between a body and a static.
+    /// </summary>
+    public CollidableReference B;
+    /// <summary>
+    /// Index of the contact within its constraint.
+    /// </summary>
+    public int ContactIndex;
+    /// <summary>
+    /// World space position of the contact.
+    /// </summary>
+    public Vector3 Position;
+    /// <summary>
+    /// Penetration depth of the contact. Negative values are speculative separation.
+    /// </summary>
+    public float Depth;
+    /// <summary>
+    /// World space contact normal, pointing from B toward A.
+    /// </summary>
+    public Vector3 Normal;
+    /// <summary>
+    /// Accumulated normal impulse of the contact from the last solved substep.
+    /// </summary>
+    public float NormalImpulse;
+    /// <summary>
+    /// Magnitude of the accumulated tangent friction impulse from the last solved substep.
+    /// For convex manifolds friction is shared by the whole manifold, so every contact of the manifold reports the same value.
+    /// </summary>
+    public float FrictionImpulse;
+}
+
+/// <summary>
+/// Copies the state of every active contact constraint into a flat buffer after a timestep.
+/// </summary>
+public class ContactExporter
+{
+    const int ConstraintsPerJob = 256;
+
+    struct Job
+    {
+        public int BatchIndex;
+        public int TypeBatchIndex;
+        public int Start;
+        public int Count;
+        public int WorkerIndex;
+        public QuickList<ContactRecord> Records;
+    }
+
+    /// <summary>
+    /// Receives the typed contact data of one constraint and appends its contacts to a list.
+    /// </summary>
+    struct Extractor : ISolverContactDataExtractor
+    {
+        public Bodies Bodies;
+        public BufferPool Pool;
+        public ContactExportOptions Options;
+        public ConstraintHandle Constraint;
+        public CollidablePair Pair;
+        public QuickList<ContactRecord> Records;
+
+        bool Accept(float depth, float normalImpulse)
+        {
+            return (Options.IncludeSpeculativeContacts != 0 || depth >= 0) && normalImpulse >= Options.MinimumNormalImpulse;
+        }
+
+        void Add(BodyHandle a, int contactIndex, Vector3 offsetA, float depth, Vector3 normal, float normalImpulse, float frictionImpulse)
+        {
+            ref var record = ref Records.Allocate(Pool);
+            record.Constraint = Constraint;
+            record.A = Pair.A;
+            record.B = Pair.B;
+            record.ContactIndex = contactIndex;
+            record.Position = Bodies[a].Pose.Position + offsetA;
+            record.Depth = depth;
+            record.Normal = normal;
+            record.NormalImpulse = normalImpulse;
+            record.FrictionImpulse = frictionImpulse;
+        }
+
+        void AddConvex<TPrestep, TAccumulatedImpulses>(BodyHandle a, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, IConvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, IConvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+            Vector3Wide.ReadFirst(prestep.GetNormal(ref prestep), out var normal);
+            Vector2Wide.ReadFirst(impulses.GetTangentFriction(ref impulses), out var friction);
+            var frictionImpulse = friction.Length();
+            for (int i = 0; i < prestep.ContactCount; ++i)
+            {
+                ref var contact = ref prestep.GetContact(ref prestep, i);
+                var depth = contact.Depth[0];
+                var normalImpulse = impulses.GetPenetrationImpulseForContact(ref impulses, i)[0];
+                if (Accept(depth, normalImpulse))
+                {
+                    Vector3Wide.ReadFirst(contact.OffsetA, out var offsetA);
+                    Add(a, i, offsetA, depth, normal, normalImpulse, frictionImpulse);
+                }
+            }
+        }
+
+        void AddNonconvex<TPrestep, TAccumulatedImpulses>(BodyHandle a, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, INonconvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, INonconvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+            for (int i = 0; i < prestep.ContactCount; ++i)
+            {
+                ref var contact = ref prestep.GetContact(ref prestep, i);
+                ref var contactImpulses = ref impulses.GetImpulsesForContact(ref impulses, i);
+                var depth = contact.Depth[0];
+                var normalImpulse = contactImpulses.Penetration[0];
+                if (Accept(depth, normalImpulse))
+                {
+                    Vector3Wide.ReadFirst(contact.Offset, out var offsetA);
+                    Vector3Wide.ReadFirst(contact.Normal, out var normal);
+                    Vector2Wide.ReadFirst(contactImpulses.Tangent, out var friction);
+                    Add(a, i, offsetA, depth, normal, normalImpulse, friction.Length());
+                }
+            }
+        }
+
+        public void ConvexOneBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandle, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, IConvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, IConvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+            AddConvex(bodyHandle, ref prestep, ref impulses);
+        }
+
+        public void ConvexTwoBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandleA, BodyHandle bodyHandleB, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, ITwoBodyConvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, IConvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+            AddConvex(bodyHandleA, ref prestep, ref impulses);
+        }
+
+        public void NonconvexOneBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandle, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, INonconvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, INonconvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+            AddNonconvex(bodyHandle, ref prestep, ref impulses);
+        }
+
+        public void NonconvexTwoBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandleA, BodyHandle bodyHandleB, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, ITwoBodyNonconvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, INonconvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+            AddNonconvex(bodyHandleA, ref prestep, ref impulses);
+        }
+    }
+
+    /// <summary>
+    /// Accepts contact data without reading it. Used to tell whether a type batch holds contact constraints.
+    /// </summary>
+    struct ContactTypeProbe : ISolverContactDataExtractor
+    {
+        public void ConvexOneBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandle, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, IConvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, IConvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+        }
+
+        public void ConvexTwoBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandleA, BodyHandle bodyHandleB, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, ITwoBodyConvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, IConvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+        }
+
+        public void NonconvexOneBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandle, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, INonconvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, INonconvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+        }
+
+        public void NonconvexTwoBody<TPrestep, TAccumulatedImpulses>(BodyHandle bodyHandleA, BodyHandle bodyHandleB, ref TPrestep prestep, ref TAccumulatedImpulses impulses)
+            where TPrestep : struct, ITwoBodyNonconvexContactPrestep<TPrestep>
+            where TAccumulatedImpulses : struct, INonconvexContactAccumulatedImpulses<TAccumulatedImpulses>
+        {
+        }
+    }
+
+    Simulation simulation;
+    ContactExportOptions options;
+    IThreadDispatcher? threadDispatcher;
+    List<Job> jobs = new();
+    int jobIndex;
+
+    void ExecuteJob(int index, int workerIndex, BufferPool workerPool)
+    {
+        var job = jobs[index];
+        ref var typeBatch = ref simulation.Solver.ActiveSet.Batches[job.BatchIndex].TypeBatches[job.TypeBatchIndex];
+        var extractor = new Extractor
+        {
+            Bodies = simulation.Bodies,
+            Pool = workerPool,
+            Options = options,
+            Records = new QuickList<ContactRecord>(job.Count, workerPool)
+        };
+        var constraintHandleToPair = simulation.NarrowPhase.PairCache.ConstraintHandleToPair;
+        for (int i = job.Start; i < job.Start + job.Count; ++i)
+        {
+            extractor.Constraint = typeBatch.IndexToHandle[i];
+            //The pair cache knows which collidables own each contact constraint, including the static in body-static pairs.
+            extractor.Pair = constraintHandleToPair[extractor.Constraint.Value].Pair;
+            simulation.NarrowPhase.TryExtractSolverContactData(extractor.Constraint, ref extractor);
+        }
+        job.WorkerIndex = workerIndex;
+        job.Records = extractor.Records;
+        jobs[index] = job;
+    }
+
+    void Worker(int workerIndex)
+    {
+        var workerPool = threadDispatcher!.WorkerPools[workerIndex];
+        int index;
+        while ((index = Interlocked.Increment(ref jobIndex)) < jobs.Count)
+        {
+            ExecuteJob(index, workerIndex, workerPool);
+        }
+    }
+
+    /// <summary>
+    /// Copies every active contact constraint's contacts into a flat buffer.
+    /// </summary>
+    /// <param name="simulation">Simulation to read contacts from. Should be called after a timestep and before any bodies or constraints are added or removed.</param>
+    /// <param name="options">Filters applied to the exported contacts.</param>
+    /// <param name="pool">Pool to allocate the output buffer from.</param>
+    /// <param name="threadDispatcher">Dispatcher to distribute the export over, if any.</param>
+    /// <returns>Buffer of exported contacts, sliced to the number of contacts written. Contacts appear in solver order, which is deterministic for a deterministic simulation.</returns>
+    public static Buffer<ContactRecord> Export(Simulation simulation, ContactExportOptions options, BufferPool pool, IThreadDispatcher? threadDispatcher)
+    {
+        var exporter = new ContactExporter { simulation = simulation, options = options, threadDispatcher = threadDispatcher };
+        ref var activeSet = ref simulation.Solver.ActiveSet;
+        for (int batchIndex = 0; batchIndex < activeSet.Batches.Count; ++batchIndex)
+        {
+            ref var batch = ref activeSet.Batches[batchIndex];
+            for (int typeBatchIndex = 0; typeBatchIndex < batch.TypeBatches.Count; ++typeBatchIndex)
+            {
+                ref var typeBatch = ref batch.TypeBatches[typeBatchIndex];
+                var constraintCount = typeBatch.ConstraintCount;
+                //Every constraint in a type batch shares a type, so probing one constraint tells whether the batch holds contacts. Joint batches are skipped entirely.
+                var probe = new ContactTypeProbe();
+                if (constraintCount == 0 || !simulation.NarrowPhase.TryExtractSolverContactData(typeBatch.IndexToHandle[0], ref probe))
+                    continue;
+                for (int start = 0; start < constraintCount; start += ConstraintsPerJob)
+                {
+                    exporter.jobs.Add(new Job { BatchIndex = batchIndex, TypeBatchIndex = typeBatchIndex, Start = start, Count = Math.Min(ConstraintsPerJob, constraintCount - start) });
+                }
+            }
+        }
+        if (threadDispatcher == null || exporter.jobs.Count < 2)
+        {
+            for (int i = 0; i < exporter.jobs.Count; ++i)
+                exporter.ExecuteJob(i, 0, pool);
+        }
+        else
+        {
+            exporter.jobIndex = -1;
+            threadDispatcher.DispatchWorkers(exporter.Worker, exporter.jobs.Count);
+        }
+
+        int total = 0;
+        for (int i = 0; i < exporter.jobs.Count; ++i)
+            total += exporter.jobs[i].Records.Count;
+        pool.Take<ContactRecord>(Math.Max(1, total), out var records);
+        int writeIndex = 0;
+        for (int i = 0; i < exporter.jobs.Count; ++i)
+        {
+            var job = exporter.jobs[i];
+            job.Records.Span.CopyTo(0, records, writeIndex, job.Records.Count);
+            writeIndex += job.Records.Count;
+            job.Records.Dispose(threadDispatcher == null || exporter.jobs.Count < 2 ? pool : threadDispatcher.WorkerPools[job.WorkerIndex]);
+        }
+        return records.Slice(total);
+    }
+}
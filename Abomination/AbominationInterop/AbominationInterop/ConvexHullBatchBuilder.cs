@@ -0,0 +1,126 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Range of points within a shared point buffer that defines one convex hull.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct PointSetRange
+{
+    /// <summary>
+    /// Index of the first point of the set in the shared point buffer.
+    /// </summary>
+    public int Start;
+    /// <summary>
+    /// Number of points in the set.
+    /// </summary>
+    public int Count;
+    /// <summary>
+    /// Mass used to compute the hull's inertia.
+    /// </summary>
+    public float Mass;
+}
+
+/// <summary>
+/// Creates many convex hulls at once, spreading them across the workers of a thread dispatcher.
+/// </summary>
+/// <remarks>Each worker computes hulls in its own worker pool, so hull computation and its scratch allocations never contend.
+/// Only the final copy of each hull into the caller's pool is serialized.</remarks>
+public unsafe class ConvexHullBatchBuilder
+{
+    Buffer<PointSetRange> ranges;
+    Buffer<Vector3> points;
+    Buffer<ConvexHull> hulls;
+    Buffer<Vector3> centersOfMass;
+    Buffer<BodyInertia> inertias;
+    BufferPool pool;
+    IThreadDispatcher? threadDispatcher;
+    int jobIndex;
+    SpinLock poolLock;
+
+    static void CopyToPool<T>(Buffer<T> source, BufferPool pool, out Buffer<T> target) where T : unmanaged
+    {
+        //Empty buffers still take a slot so that ConvexHull.Dispose can return every buffer unconditionally.
+        pool.Take(Math.Max(1, source.Length), out target);
+        target = target.Slice(source.Length);
+        source.CopyTo(0, target, 0, source.Length);
+    }
+
+    void CreateHull(int index, BufferPool workerPool)
+    {
+        ref var range = ref ranges[index];
+        ConvexHullHelper.CreateShape(points.Slice(range.Start, range.Count), workerPool, out centersOfMass[index], out var hull);
+        //Degenerate point sets produce a hull without faces; there is no meaningful inertia to compute for those.
+        inertias[index] = hull.FaceToVertexIndicesStart.Length > 0 ? hull.ComputeInertia(range.Mass) : default;
+        if (workerPool == pool)
+        {
+            hulls[index] = hull;
+            return;
+        }
+        ref var target = ref hulls[index];
+        bool taken = false;
+        poolLock.Enter(ref taken);
+        CopyToPool(hull.Points, pool, out target.Points);
+        CopyToPool(hull.BoundingPlanes, pool, out target.BoundingPlanes);
+        CopyToPool(hull.FaceVertexIndices, pool, out target.FaceVertexIndices);
+        CopyToPool(hull.FaceToVertexIndicesStart, pool, out target.FaceToVertexIndicesStart);
+        poolLock.Exit();
+        hull.Dispose(workerPool);
+    }
+
+    void Worker(int workerIndex)
+    {
+        var workerPool = threadDispatcher!.WorkerPools[workerIndex];
+        int index;
+        while ((index = Interlocked.Increment(ref jobIndex)) < ranges.Length)
+        {
+            CreateHull(index, workerPool);
+        }
+    }
+
+    /// <summary>
+    /// Creates a convex hull, center of mass and inertia for every point set.
+    /// </summary>
+    /// <param name="ranges">Point sets to create hulls for.</param>
+    /// <param name="points">Points referenced by the ranges.</param>
+    /// <param name="pool">Pool to allocate the hulls and output buffers from.</param>
+    /// <param name="threadDispatcher">Dispatcher to distribute hull creation over, if any.</param>
+    /// <param name="hulls">Hulls created for each point set. Points are recentered on the hull's center of mass.</param>
+    /// <param name="centersOfMass">Center of mass computed for each point set.</param>
+    /// <param name="inertias">Inertia of each hull computed with its point set's mass.</param>
+    public static void Build(Buffer<PointSetRange> ranges, Buffer<Vector3> points, BufferPool pool, IThreadDispatcher? threadDispatcher,
+        out Buffer<ConvexHull> hulls, out Buffer<Vector3> centersOfMass, out Buffer<BodyInertia> inertias)
+    {
+        for (int i = 0; i < ranges.Length; ++i)
+        {
+            ref var range = ref ranges[i];
+            if (range.Start < 0 || range.Count < 0 || range.Start + range.Count > points.Length)
+                throw new ArgumentOutOfRangeException(nameof(ranges), $"Point set {i} extends outside the point buffer.");
+        }
+        var builder = new ConvexHullBatchBuilder { ranges = ranges, points = points, pool = pool, threadDispatcher = threadDispatcher };
+        pool.Take(ranges.Length, out builder.hulls);
+        pool.Take(ranges.Length, out builder.centersOfMass);
+        pool.Take(ranges.Length, out builder.inertias);
+        if (threadDispatcher == null || ranges.Length < 2)
+        {
+            for (int i = 0; i < ranges.Length; ++i)
+                builder.CreateHull(i, pool);
+        }
+        else
+        {
+            builder.jobIndex = -1;
+            threadDispatcher.DispatchWorkers(builder.Worker, ranges.Length);
+        }
+        hulls = builder.hulls;
+        centersOfMass = builder.centersOfMass;
+        inertias = builder.inertias;
+    }
+}
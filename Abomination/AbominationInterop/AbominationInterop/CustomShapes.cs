@@ -0,0 +1,45 @@
+﻿using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.CollisionDetection.CollisionTasks;
+using BepuPhysics.CollisionDetection.SweepTasks;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Registers the collision and sweep tasks needed by shape types defined by the interop layer rather than the engine.
+/// </summary>
+public static class CustomShapes
+{
+    /// <summary>
+    /// Registers convex versus triangle compound pair handling for a shape that exposes its content as triangles, using the same tasks and internal edge reduction as <see cref="Mesh"/>.
+    /// </summary>
+    static void RegisterTriangleCompound<TCompound>(CollisionTaskRegistry collisionTasks, SweepTaskRegistry sweepTasks) where TCompound : unmanaged, IHomogeneousCompoundShape<Triangle, TriangleWide>
+    {
+        collisionTasks.Register(new ConvexCompoundCollisionTask<Sphere, TCompound, ConvexCompoundOverlapFinder<Sphere, SphereWide, TCompound>, ConvexMeshContinuations<TCompound>, MeshReduction>());
+        collisionTasks.Register(new ConvexCompoundCollisionTask<Capsule, TCompound, ConvexCompoundOverlapFinder<Capsule, CapsuleWide, TCompound>, ConvexMeshContinuations<TCompound>, MeshReduction>());
+        collisionTasks.Register(new ConvexCompoundCollisionTask<Box, TCompound, ConvexCompoundOverlapFinder<Box, BoxWide, TCompound>, ConvexMeshContinuations<TCompound>, MeshReduction>());
+        collisionTasks.Register(new ConvexCompoundCollisionTask<Triangle, TCompound, ConvexCompoundOverlapFinder<Triangle, TriangleWide, TCompound>, ConvexMeshContinuations<TCompound>, MeshReduction>());
+        collisionTasks.Register(new ConvexCompoundCollisionTask<Cylinder, TCompound, ConvexCompoundOverlapFinder<Cylinder, CylinderWide, TCompound>, ConvexMeshContinuations<TCompound>, MeshReduction>());
+        collisionTasks.Register(new ConvexCompoundCollisionTask<ConvexHull, TCompound, ConvexCompoundOverlapFinder<ConvexHull, ConvexHullWide, TCompound>, ConvexMeshContinuations<TCompound>, MeshReduction>());
+
+        sweepTasks.Register(new ConvexHomogeneousCompoundSweepTask<Sphere, SphereWide, TCompound, Triangle, TriangleWide, ConvexCompoundSweepOverlapFinder<Sphere, TCompound>>());
+        sweepTasks.Register(new ConvexHomogeneousCompoundSweepTask<Capsule, CapsuleWide, TCompound, Triangle, TriangleWide, ConvexCompoundSweepOverlapFinder<Capsule, TCompound>>());
+        sweepTasks.Register(new ConvexHomogeneousCompoundSweepTask<Box, BoxWide, TCompound, Triangle, TriangleWide, ConvexCompoundSweepOverlapFinder<Box, TCompound>>());
+        sweepTasks.Register(new ConvexHomogeneousCompoundSweepTask<Triangle, TriangleWide, TCompound, Triangle, TriangleWide, ConvexCompoundSweepOverlapFinder<Triangle, TCompound>>());
+        sweepTasks.Register(new ConvexHomogeneousCompoundSweepTask<Cylinder, CylinderWide, TCompound, Triangle, TriangleWide, ConvexCompoundSweepOverlapFinder<Cylinder, TCompound>>());
+        sweepTasks.Register(new ConvexHomogeneousCompoundSweepTask<ConvexHull, ConvexHullWide, TCompound, Triangle, TriangleWide, ConvexCompoundSweepOverlapFinder<ConvexHull, TCompound>>());
+    }
+
+    /// <summary>
+    /// Registers the pair handling for every interop defined shape type.
+    /// </summary>
+    /// <param name="collisionTasks">Collision task registry of the simulation's narrow phase.</param>
+    /// <param name="sweepTasks">Sweep task registry of the simulation's narrow phase.</param>
+    /// <remarks>Pairs between these shapes and compounds or meshes have no registered task and generate no contacts.</remarks>
+    public static void Register(CollisionTaskRegistry collisionTasks, SweepTaskRegistry sweepTasks)
+    {
+        RegisterTriangleCompound<CompressedMesh>(collisionTasks, sweepTasks);
+        RegisterTriangleCompound<Heightfield>(collisionTasks, sweepTasks);
+        RegisterTriangleCompound<VoxelGrid>(collisionTasks, sweepTasks);
+    }
+}
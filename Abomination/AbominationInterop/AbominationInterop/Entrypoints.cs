@@ -41,6 +41,13 @@ public static partial class Entrypoints
     static InstanceDirectory<BufferPool>? bufferPools;
     static InstanceDirectory<Simulation>? simulations;
     static InstanceDirectory<ThreadDispatcher>? threadDispatchers;
+    static ConditionalWeakTable<BufferPool, BufferPoolTelemetry>? bufferPoolTelemetry;
+    static ConditionalWeakTable<Simulation, SolverTelemetry>? solverTelemetry;
+    static ConditionalWeakTable<Simulation, AdaptiveVelocityIterationScheduler>? adaptiveVelocityIterationSchedulers;
+    static ConditionalWeakTable<Simulation, ShapeInterner>? shapeInterners;
+    static ConditionalWeakTable<Simulation, BroadPhaseRefiner>? broadPhaseRefiners;
+    static ConditionalWeakTable<Simulation, SensorTracker>? sensorTrackers;
+    static ConditionalWeakTable<Simulation, AdaptiveContinuityController>? adaptiveContinuityControllers;
 
     public const string FunctionNamePrefix = "";
     //These look a little odd. They're just the names of the handle types on the native side. On the C# side, they're all just InstanceHandle since we didn't want to bother doing type reinterpretation.
@@ -62,6 +69,13 @@ public static partial class Entrypoints
         bufferPools = new InstanceDirectory<BufferPool>(0);
         simulations = new InstanceDirectory<Simulation>(1);
         threadDispatchers = new InstanceDirectory<ThreadDispatcher>(2);
+        bufferPoolTelemetry = new ConditionalWeakTable<BufferPool, BufferPoolTelemetry>();
+        solverTelemetry = new ConditionalWeakTable<Simulation, SolverTelemetry>();
+        adaptiveVelocityIterationSchedulers = new ConditionalWeakTable<Simulation, AdaptiveVelocityIterationScheduler>();
+        shapeInterners = new ConditionalWeakTable<Simulation, ShapeInterner>();
+        broadPhaseRefiners = new ConditionalWeakTable<Simulation, BroadPhaseRefiner>();
+        sensorTrackers = new ConditionalWeakTable<Simulation, SensorTracker>();
+        adaptiveContinuityControllers = new ConditionalWeakTable<Simulation, AdaptiveContinuityController>();
     }
 
 
@@ -84,6 +98,13 @@ public static partial class Entrypoints
             }
         }
         bufferPools = null;
+        bufferPoolTelemetry = null;
+        solverTelemetry = null;
+        adaptiveVelocityIterationSchedulers = null;
+        shapeInterners = null;
+        broadPhaseRefiners = null;
+        sensorTrackers = null;
+        adaptiveContinuityControllers = null;
         //The only resources held by the simulations that need to be released were allocated from the buffer pools, which we just destroyed. Nothing left to do!
         simulations = null;
 
@@ -139,7 +160,9 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(ClearBufferPool))]
     public static void ClearBufferPool([TypeName(BufferPoolName)] InstanceHandle handle)
     {
-        bufferPools[handle].Clear();
+        var pool = bufferPools[handle];
+        pool.Clear();
+        GetTelemetry(pool).OnClear();
     }
 
     /// <summary>
@@ -149,21 +172,76 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DestroyBufferPool))]
     public static void DestroyBufferPool([TypeName(BufferPoolName)] InstanceHandle handle)
     {
-        bufferPools[handle].Clear();
+        var pool = bufferPools[handle];
+        pool.Clear();
+        bufferPoolTelemetry.Remove(pool);
         bufferPools.Remove(handle);
     }
 
+    static BufferPoolTelemetry GetTelemetry(BufferPool pool)
+    {
+        return bufferPoolTelemetry.GetValue(pool, static _ => new BufferPoolTelemetry());
+    }
+
+    /// <summary>
+    /// Creates a new buffer pool with preallocated capacity and an optional cap on its reserved memory.
+    /// </summary>
+    /// <param name="options">Options describing the buffer pool.</param>
+    /// <returns>Handle of the created buffer pool.</returns>
+    /// <remarks>Preallocation for a power is skipped if it would exceed the cap. The cap is enforced by the interop allocation, resize, and reservation functions; the engine's own growth during simulation is not blocked, so preallocate enough to cover steady state use.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateBufferPoolWithOptions))]
+    [return: TypeName(BufferPoolName)]
+    public unsafe static InstanceHandle CreateBufferPoolWithOptions(BufferPoolOptions options)
+    {
+        var pool = new BufferPool(options.MinimumBlockAllocationSize, options.ExpectedUsedSlotCountPerPool);
+        var telemetry = GetTelemetry(pool);
+        telemetry.MaximumReservedBytes = options.MaximumReservedBytes;
+        for (int power = 0; power <= BufferPoolTelemetry.MaximumPower; ++power)
+        {
+            var byteCount = options.PreallocatedBytesPerPower[power];
+            if (byteCount > 0 && telemetry.AllowsReservation(pool, power, byteCount))
+                pool.EnsureCapacityForPower(byteCount, power);
+        }
+        telemetry.Reset(pool);
+        return bufferPools.Add(pool);
+    }
+
+    /// <summary>
+    /// Ensures that a buffer pool has at least the given number of bytes allocated for slots of a given power.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to reserve capacity in.</param>
+    /// <param name="power">Power of the slot size to reserve capacity for. Slots in the power pool are 2^power bytes.</param>
+    /// <param name="byteCount">Number of bytes to reserve for the power pool.</param>
+    /// <returns>True if the pool has the requested capacity, false if reserving it would exceed the pool's maximum reserved bytes.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(ReserveBufferPoolCapacity))]
+    [return: TypeName("bool")]
+    public static byte ReserveBufferPoolCapacity([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, int power, int byteCount)
+    {
+        var pool = bufferPools[bufferPoolHandle];
+        var telemetry = GetTelemetry(pool);
+        if (!telemetry.AllowsReservation(pool, power, byteCount))
+            return 0;
+        pool.EnsureCapacityForPower(byteCount, power);
+        telemetry.SampleReservedBytes(pool);
+        return 1;
+    }
+
     /// <summary>
     /// Allocates a buffer from the buffer pool of the given size.
     /// </summary>
     /// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
     /// <param name="sizeInBytes">Size of the buffer to allocate in bytes.</param>
-    /// <returns>Allocated buffer.</returns>
+    /// <returns>Allocated buffer. If the allocation could push the pool beyond its maximum reserved bytes, the returned buffer is unallocated.</returns>
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(Allocate))]
     [return: TypeName("ByteBuffer")]
     public static Buffer<byte> Allocate([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, int sizeInBytes)
     {
-        bufferPools[bufferPoolHandle].Take<byte>(sizeInBytes, out var buffer);
+        var pool = bufferPools[bufferPoolHandle];
+        var telemetry = GetTelemetry(pool);
+        if (!telemetry.AllowsTake(pool, SpanHelper.GetContainingPowerOf2(sizeInBytes)))
+            return default;
+        pool.Take<byte>(sizeInBytes, out var buffer);
+        telemetry.OnTake(pool, buffer.Id);
         return buffer;
     }
 
@@ -172,12 +250,17 @@ public static partial class Entrypoints
     /// </summary>
     /// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
     /// <param name="sizeInBytes">Size of the buffer to allocate in bytes.</param>
-    /// <returns>Allocated buffer.</returns>
+    /// <returns>Allocated buffer. If the allocation could push the pool beyond its maximum reserved bytes, the returned buffer is unallocated.</returns>
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AllocateAtLeast))]
     [return: TypeName("ByteBuffer")]
     public static Buffer<byte> AllocateAtLeast([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, int sizeInBytes)
     {
-        bufferPools[bufferPoolHandle].TakeAtLeast<byte>(sizeInBytes, out var buffer);
+        var pool = bufferPools[bufferPoolHandle];
+        var telemetry = GetTelemetry(pool);
+        if (!telemetry.AllowsTake(pool, SpanHelper.GetContainingPowerOf2(sizeInBytes)))
+            return default;
+        pool.TakeAtLeast<byte>(sizeInBytes, out var buffer);
+        telemetry.OnTake(pool, buffer.Id);
         return buffer;
     }
 
@@ -185,26 +268,52 @@ public static partial class Entrypoints
     /// Resizes a buffer from the buffer pool to the given size, reallocating if necessary.
     /// </summary>
     /// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
-    /// <param name="buffer">Buffer to resize.</param>
+    /// <param name="buffer">Buffer to resize. If the resize needs a new slot that could push the pool beyond its maximum reserved bytes, the buffer is left unchanged.</param>
     /// <param name="newSizeInBytes">Target size of the buffer to allocate in bytes.</param>
     /// <param name="copyCount">Number of bytes to copy from the old buffer into the new buffer.</param>
+    /// <returns>True if the buffer was resized, false if the resize was refused because of the pool's maximum reserved bytes.</returns>
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(Resize))]
-    public static unsafe void Resize([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer*")] Buffer<byte>* buffer, int newSizeInBytes, int copyCount)
+    [return: TypeName("bool")]
+    public static unsafe byte Resize([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer*")] Buffer<byte>* buffer, int newSizeInBytes, int copyCount)
     {
-        bufferPools[bufferPoolHandle].Resize(ref *buffer, newSizeInBytes, copyCount);
+        var pool = bufferPools[bufferPoolHandle];
+        var telemetry = GetTelemetry(pool);
+        //The pool rounds the target up to its slot capacity and reallocates unless that equals the buffer's current length.
+        var targetPower = SpanHelper.GetContainingPowerOf2(newSizeInBytes);
+        var keepsSlot = buffer->Allocated && (1 << targetPower) == buffer->Length;
+        if (!keepsSlot && !telemetry.AllowsTake(pool, targetPower))
+            return 0;
+        var wasAllocated = buffer->Allocated;
+        var previousId = buffer->Id;
+        pool.Resize(ref *buffer, newSizeInBytes, copyCount);
+        telemetry.OnResize(pool, wasAllocated, previousId, buffer->Allocated, buffer->Id);
+        return 1;
     }
 
     /// <summary>
     /// Resizes a buffer from the buffer pool to at least the given size, reallocating if necessary.
     /// </summary>
     /// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
-    /// <param name="buffer">Buffer to resize.</param>
+    /// <param name="buffer">Buffer to resize. If the resize needs a new slot that could push the pool beyond its maximum reserved bytes, the buffer is left unchanged.</param>
     /// <param name="targetSizeInBytes">Target size of the buffer to allocate in bytes.</param>
     /// <param name="copyCount">Number of bytes to copy from the old buffer into the new buffer.</param>
+    /// <returns>True if the buffer holds at least the target size, false if the resize was refused because of the pool's maximum reserved bytes.</returns>
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(ResizeToAtLeast))]
-    public static unsafe void ResizeToAtLeast([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer*")] Buffer<byte>* buffer, int targetSizeInBytes, int copyCount)
+    [return: TypeName("bool")]
+    public static unsafe byte ResizeToAtLeast([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer*")] Buffer<byte>* buffer, int targetSizeInBytes, int copyCount)
     {
-        bufferPools[bufferPoolHandle].ResizeToAtLeast(ref *buffer, targetSizeInBytes, copyCount);
+        var pool = bufferPools[bufferPoolHandle];
+        var telemetry = GetTelemetry(pool);
+        //Same rounding as Resize; a buffer shorter than its slot still gets a new slot, so only an exact capacity match is free.
+        var targetPower = SpanHelper.GetContainingPowerOf2(targetSizeInBytes);
+        var keepsSlot = buffer->Allocated && (1 << targetPower) == buffer->Length;
+        if (!keepsSlot && !telemetry.AllowsTake(pool, targetPower))
+            return 0;
+        var wasAllocated = buffer->Allocated;
+        var previousId = buffer->Id;
+        pool.ResizeToAtLeast(ref *buffer, targetSizeInBytes, copyCount);
+        telemetry.OnResize(pool, wasAllocated, previousId, buffer->Allocated, buffer->Id);
+        return 1;
     }
 
     /// <summary>
@@ -215,7 +324,9 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(Deallocate))]
     public unsafe static void Deallocate([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer*")] Buffer<byte>* buffer)
     {
-        bufferPools[bufferPoolHandle].Return(ref *buffer);
+        var pool = bufferPools[bufferPoolHandle];
+        GetTelemetry(pool).OnReturn(buffer->Id);
+        pool.Return(ref *buffer);
     }
 
     /// <summary>
@@ -226,7 +337,9 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DeallocateById))]
     public unsafe static void DeallocateById([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, int bufferId)
     {
-        bufferPools[bufferPoolHandle].ReturnUnsafely(bufferId);
+        var pool = bufferPools[bufferPoolHandle];
+        GetTelemetry(pool).OnReturn(bufferId);
+        pool.ReturnUnsafely(bufferId);
     }
 
 
@@ -266,8 +379,9 @@ public static partial class Entrypoints
 
 
     //We don't want to do runtime checks in the callbacks, so we jump through some fun hoops to construct a type.
-    private static unsafe InstanceHandle CreateSimulationWithScalarIntegrationState<TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, TScalarIntegration>(
-      BufferPool pool, NarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+    private static unsafe InstanceHandle CreateSimulationWithScalarIntegrationState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, TScalarIntegration>(
+      BufferPool pool, TNarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+        where TNarrowPhaseCallbacks : struct, IInteropNarrowPhaseCallbacks
     {
         void* integrateVelocityFunction =
             poseIntegratorCallbacksInterop.UseScalarCallback != 0 ? poseIntegratorCallbacksInterop.IntegrateVelocityScalar :
@@ -280,48 +394,66 @@ public static partial class Entrypoints
             PrepareForIntegrationFunction = poseIntegratorCallbacksInterop.PrepareForIntegration,
             IntegrateVelocityFunction = integrateVelocityFunction
         };
+        //Sensor flags and continuity modes are checked by the narrow phase callbacks, so their owners have to exist before the callbacks are handed to the simulation.
+        var sensors = new SensorTracker();
+        narrowPhaseCallbacks.Sensors = sensors;
+        var continuity = new AdaptiveContinuityController();
+        narrowPhaseCallbacks.Continuity = continuity;
         //For now, the native side can't define custom timesteppers. This isn't fundamental, but exposing it would be somewhat annoying, so punted.
         var simulation = Simulation.Create(pool, narrowPhaseCallbacks, poseIntegratorCallbacks, solveDescription, initialAllocationSizes: initialAllocationSizes);
+        sensors.Attach(simulation);
+        sensorTrackers.Add(simulation, sensors);
+        continuity.Attach(simulation);
+        adaptiveContinuityControllers.Add(simulation, continuity);
+        CustomShapes.Register(simulation.NarrowPhase.CollisionTaskRegistry, simulation.NarrowPhase.SweepTaskRegistry);
         var handle = simulations.Add(simulation);
+        narrowPhaseCallbacks.ManifoldBatcher?.Attach(simulation, handle);
+        var telemetry = new SolverTelemetry();
+        telemetry.Attach(simulation);
+        solverTelemetry.Add(simulation, telemetry);
         //The usual narrow phase callbacks initialization could not be done because there was no handle available for the native side to use, so call it now.
-        ((NarrowPhase<NarrowPhaseCallbacks>)simulation.NarrowPhase).Callbacks.Initialize(handle);
+        ((NarrowPhase<TNarrowPhaseCallbacks>)simulation.NarrowPhase).Callbacks.Initialize(handle);
         //Same for pose integrator callbacks.
         ((PoseIntegrator<PoseIntegratorCallbacks<TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, TScalarIntegration>>)simulation.PoseIntegrator).Callbacks.Initialize(handle);
         return handle;
     }
-    private static InstanceHandle CreateSimulationWithKinematicIntegrationState<TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities>(
-        BufferPool pool, NarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+    private static InstanceHandle CreateSimulationWithKinematicIntegrationState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities>(
+        BufferPool pool, TNarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+        where TNarrowPhaseCallbacks : struct, IInteropNarrowPhaseCallbacks
     {
         if (poseIntegratorCallbacksInterop.UseScalarCallback != 0)
-            return CreateSimulationWithScalarIntegrationState<TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, True>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
-        return CreateSimulationWithScalarIntegrationState<TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, False>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+            return CreateSimulationWithScalarIntegrationState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, True>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+        return CreateSimulationWithScalarIntegrationState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained, TIntegrateKinematicVelocities, False>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
     }
-    private static InstanceHandle CreateSimulationWithUnconstrainedSubstepState<TConservationType, TSubstepUnconstrained>(
-        BufferPool pool, NarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+    private static InstanceHandle CreateSimulationWithUnconstrainedSubstepState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained>(
+        BufferPool pool, TNarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+        where TNarrowPhaseCallbacks : struct, IInteropNarrowPhaseCallbacks
     {
         if (poseIntegratorCallbacksInterop.IntegrateVelocityForKinematics != 0)
-            return CreateSimulationWithKinematicIntegrationState<TConservationType, TSubstepUnconstrained, True>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
-        return CreateSimulationWithKinematicIntegrationState<TConservationType, TSubstepUnconstrained, False>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+            return CreateSimulationWithKinematicIntegrationState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained, True>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+        return CreateSimulationWithKinematicIntegrationState<TNarrowPhaseCallbacks, TConservationType, TSubstepUnconstrained, False>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
     }
 
-    private static InstanceHandle CreateSimulationWithConservationType<TConservationType>(
-        BufferPool pool, NarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+    private static InstanceHandle CreateSimulationWithConservationType<TNarrowPhaseCallbacks, TConservationType>(
+        BufferPool pool, TNarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+        where TNarrowPhaseCallbacks : struct, IInteropNarrowPhaseCallbacks
     {
         if (poseIntegratorCallbacksInterop.AllowSubstepsForUnconstrainedBodies != 0)
-            return CreateSimulationWithUnconstrainedSubstepState<TConservationType, True>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
-        return CreateSimulationWithUnconstrainedSubstepState<TConservationType, False>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+            return CreateSimulationWithUnconstrainedSubstepState<TNarrowPhaseCallbacks, TConservationType, True>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+        return CreateSimulationWithUnconstrainedSubstepState<TNarrowPhaseCallbacks, TConservationType, False>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
 
     }
-    private static InstanceHandle CreateSimulation(BufferPool pool, NarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+    private static InstanceHandle CreateSimulation<TNarrowPhaseCallbacks>(BufferPool pool, TNarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacksInterop poseIntegratorCallbacksInterop, SolveDescription solveDescription, SimulationAllocationSizes initialAllocationSizes)
+        where TNarrowPhaseCallbacks : struct, IInteropNarrowPhaseCallbacks
     {
         switch (poseIntegratorCallbacksInterop.AngularIntegrationMode)
         {
             case AngularIntegrationMode.ConserveMomentumWithGyroscopicTorque:
-                return CreateSimulationWithConservationType<AngularIntegrationModeConserveWithGyroTorque>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+                return CreateSimulationWithConservationType<TNarrowPhaseCallbacks, AngularIntegrationModeConserveWithGyroTorque>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
             case AngularIntegrationMode.ConserveMomentum:
-                return CreateSimulationWithConservationType<AngularIntegrationModeConserve>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+                return CreateSimulationWithConservationType<TNarrowPhaseCallbacks, AngularIntegrationModeConserve>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
             default:
-                return CreateSimulationWithConservationType<AngularIntegrationModeNonconserving>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
+                return CreateSimulationWithConservationType<TNarrowPhaseCallbacks, AngularIntegrationModeNonconserving>(pool, narrowPhaseCallbacks, poseIntegratorCallbacksInterop, solveDescription, initialAllocationSizes);
         }
     }
 
@@ -348,9 +480,24 @@ public static partial class Entrypoints
             VelocityIterationCount = solveDescriptionInterop.VelocityIterationCount,
             SubstepCount = solveDescriptionInterop.SubstepCount,
             FallbackBatchThreshold = solveDescriptionInterop.FallbackBatchThreshold,
-            VelocityIterationScheduler = solveDescriptionInterop.VelocityIterationScheduler != null ? Marshal.GetDelegateForFunctionPointer<SubstepVelocityIterationScheduler>((IntPtr)solveDescriptionInterop.VelocityIterationScheduler) : null
+            VelocityIterationScheduler = solveDescriptionInterop.VelocityIterationScheduler != null ? CreateVelocityIterationScheduler(solveDescriptionInterop.VelocityIterationScheduler) : null
         };
-        var narrowPhaseCallbacksImpl = new NarrowPhaseCallbacks
+        var pool = bufferPools[bufferPool];
+        //Null child hooks select callbacks types where the defaults are constants, so compound pairs never pay for a transition that would just return true.
+        if (narrowPhaseCallbacks.AllowContactGenerationBetweenChildrenFunction != null)
+        {
+            if (narrowPhaseCallbacks.ConfigureChildContactManifoldFunction != null)
+                return CreateSimulation(pool, CreateNarrowPhaseCallbacks<True, True>(narrowPhaseCallbacks), poseIntegratorCallbacks, solveDescription, initialAllocationSizes);
+            return CreateSimulation(pool, CreateNarrowPhaseCallbacks<True, False>(narrowPhaseCallbacks), poseIntegratorCallbacks, solveDescription, initialAllocationSizes);
+        }
+        if (narrowPhaseCallbacks.ConfigureChildContactManifoldFunction != null)
+            return CreateSimulation(pool, CreateNarrowPhaseCallbacks<False, True>(narrowPhaseCallbacks), poseIntegratorCallbacks, solveDescription, initialAllocationSizes);
+        return CreateSimulation(pool, CreateNarrowPhaseCallbacks<False, False>(narrowPhaseCallbacks), poseIntegratorCallbacks, solveDescription, initialAllocationSizes);
+    }
+
+    static unsafe NarrowPhaseCallbacks<TAllowChildContactGeneration, TConfigureChildContactManifold> CreateNarrowPhaseCallbacks<TAllowChildContactGeneration, TConfigureChildContactManifold>(NarrowPhaseCallbacksInterop narrowPhaseCallbacks)
+    {
+        return new NarrowPhaseCallbacks<TAllowChildContactGeneration, TConfigureChildContactManifold>
         {
             InitializeFunction = narrowPhaseCallbacks.InitializeFunction,
             DisposeFunction = narrowPhaseCallbacks.DisposeFunction,
@@ -358,9 +505,17 @@ public static partial class Entrypoints
             AllowContactGenerationBetweenChildrenFunction = narrowPhaseCallbacks.AllowContactGenerationBetweenChildrenFunction,
             ConfigureConvexContactManifoldFunction = narrowPhaseCallbacks.ConfigureConvexContactManifoldFunction,
             ConfigureNonconvexContactManifoldFunction = narrowPhaseCallbacks.ConfigureNonconvexContactManifoldFunction,
-            ConfigureChildContactManifoldFunction = narrowPhaseCallbacks.ConfigureChildContactManifoldFunction
+            ConfigureChildContactManifoldFunction = narrowPhaseCallbacks.ConfigureChildContactManifoldFunction,
+            ManifoldBatcher = narrowPhaseCallbacks.ConfigureContactManifoldsFunction != null ?
+                new ManifoldConfigurationBatcher(narrowPhaseCallbacks.ConfigureContactManifoldsFunction, narrowPhaseCallbacks.ConfigureContactManifoldsBatchSize) : null
         };
-        return CreateSimulation(bufferPools[bufferPool], narrowPhaseCallbacksImpl, poseIntegratorCallbacks, solveDescription, initialAllocationSizes);
+    }
+
+    static unsafe SubstepVelocityIterationScheduler CreateVelocityIterationScheduler(delegate* unmanaged<int, int> scheduler)
+    {
+        //Calling the function pointer directly avoids the marshalling stub that GetDelegateForFunctionPointer puts in front of every call.
+        var schedulerAddress = (IntPtr)scheduler;
+        return substepIndex => ((delegate* unmanaged<int, int>)schedulerAddress)(substepIndex);
     }
 
     /// <summary>
@@ -371,10 +526,55 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DestroySimulation))]
     public static unsafe void DestroySimulation([TypeName(SimulationName)] InstanceHandle handle)
     {
-        simulations[handle].Dispose();
+        var simulation = simulations[handle];
+        solverTelemetry.Remove(simulation);
+        if (adaptiveVelocityIterationSchedulers.TryGetValue(simulation, out var scheduler))
+        {
+            scheduler.Dispose();
+            adaptiveVelocityIterationSchedulers.Remove(simulation);
+        }
+        shapeInterners.Remove(simulation);
+        broadPhaseRefiners.Remove(simulation);
+        if (sensorTrackers.TryGetValue(simulation, out var sensors))
+        {
+            sensors.Dispose();
+            sensorTrackers.Remove(simulation);
+        }
+        if (adaptiveContinuityControllers.TryGetValue(simulation, out var continuity))
+        {
+            continuity.Dispose();
+            adaptiveContinuityControllers.Remove(simulation);
+        }
+        simulation.Dispose();
         simulations.Remove(handle);
     }
 
+    /// <summary>
+    /// Grows any simulation allocations smaller than the given sizes. Existing allocations larger than the given sizes are left alone.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to grow.</param>
+    /// <param name="allocationSizes">Capacities to ensure for bodies, statics, islands, shapes per type, constraint handles, type batches, and per-body constraint lists.</param>
+    /// <remarks>Useful for avoiding resizes in the middle of a timestep when a known number of objects is about to be added.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(EnsureSimulationCapacity))]
+    public static void EnsureSimulationCapacity([TypeName(SimulationName)] InstanceHandle simulationHandle, SimulationAllocationSizes allocationSizes)
+    {
+        var simulation = simulations[simulationHandle];
+        simulation.EnsureCapacity(allocationSizes);
+        GetTelemetry(simulation.BufferPool).SampleReservedBytes(simulation.BufferPool);
+    }
+
+    /// <summary>
+    /// Shrinks simulation allocations that are larger than needed, down to whichever is larger: the given minimums or the current contents.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to compact.</param>
+    /// <param name="minimumAllocationSizes">Sizes below which allocations will not be shrunk.</param>
+    /// <remarks>Released memory is returned to the simulation's buffer pool. The pool keeps its blocks for reuse; clear or destroy the pool to release them to the operating system.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CompactSimulation))]
+    public static void CompactSimulation([TypeName(SimulationName)] InstanceHandle simulationHandle, SimulationAllocationSizes minimumAllocationSizes)
+    {
+        simulations[simulationHandle].Compact(minimumAllocationSizes);
+    }
+
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddBody))]
     public unsafe static BodyHandle AddBody([TypeName(SimulationName)] InstanceHandle simulationHandle, BodyDescription bodyDescription)
     {
@@ -383,7 +583,13 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveBody))]
     public unsafe static void RemoveBody([TypeName(SimulationName)] InstanceHandle simulationHandle, BodyHandle bodyHandle)
     {
-        simulations[simulationHandle].Bodies.Remove(bodyHandle);
+        var simulation = simulations[simulationHandle];
+        simulation.Bodies.Remove(bodyHandle);
+        //Handles are reused, so a later body must not inherit this one's sensor status or adaptive continuity tracking.
+        if (sensorTrackers.TryGetValue(simulation, out var sensors))
+            sensors.SetSensor(bodyHandle, false);
+        if (adaptiveContinuityControllers.TryGetValue(simulation, out var continuity))
+            continuity.SetTracked(bodyHandle, false);
     }
 
     /// <summary>
@@ -463,6 +669,59 @@ public static partial class Entrypoints
         simulations[simulationHandle].Bodies.ApplyDescription(bodyHandle, description);
     }
 
+    /// <summary>
+    /// Puts the islands containing a set of bodies to sleep immediately, regardless of their velocities.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation containing the bodies.</param>
+    /// <param name="bodyHandles">Handles of the bodies to put to sleep. Bodies that are already asleep are ignored.</param>
+    /// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+    /// <remarks>Every body connected to a listed body through constraints goes to sleep with it. All islands are put to sleep in one batch.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SleepBodies))]
+    public unsafe static void SleepBodies([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName("Buffer<BodyHandle>")] Buffer<BodyHandle> bodyHandles, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
+    {
+        BodyActivityControl.SleepBodies(simulations[simulationHandle], bodyHandles, threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle]);
+    }
+
+    /// <summary>
+    /// Wakes the islands containing a set of bodies.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation containing the bodies.</param>
+    /// <param name="bodyHandles">Handles of the bodies to wake. Bodies that are already awake are ignored.</param>
+    /// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+    /// <remarks>All islands are woken in one batch.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(WakeBodies))]
+    public unsafe static void WakeBodies([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName("Buffer<BodyHandle>")] Buffer<BodyHandle> bodyHandles, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
+    {
+        BodyActivityControl.WakeBodies(simulations[simulationHandle], bodyHandles, threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle]);
+    }
+
+    /// <summary>
+    /// Puts every island with a body whose broad phase bounding box overlaps a region to sleep immediately, regardless of velocity.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to query.</param>
+    /// <param name="min">Minimum corner of the region.</param>
+    /// <param name="max">Maximum corner of the region.</param>
+    /// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+    /// <remarks>Bodies outside the region that share an island with a body inside it also go to sleep.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SleepRegion))]
+    public unsafe static void SleepRegion([TypeName(SimulationName)] InstanceHandle simulationHandle, Vector3 min, Vector3 max, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
+    {
+        BodyActivityControl.SleepRegion(simulations[simulationHandle], min, max, threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle]);
+    }
+
+    /// <summary>
+    /// Wakes every island with a body whose broad phase bounding box overlaps a region.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to query.</param>
+    /// <param name="min">Minimum corner of the region.</param>
+    /// <param name="max">Maximum corner of the region.</param>
+    /// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(WakeRegion))]
+    public unsafe static void WakeRegion([TypeName(SimulationName)] InstanceHandle simulationHandle, Vector3 min, Vector3 max, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
+    {
+        BodyActivityControl.WakeRegion(simulations[simulationHandle], min, max, threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle]);
+    }
+
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddStatic))]
     public unsafe static StaticHandle AddStatic([TypeName(SimulationName)] InstanceHandle simulationHandle, StaticDescription staticDescription)
     {
@@ -471,7 +730,11 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveStatic))]
     public unsafe static void RemoveStatic([TypeName(SimulationName)] InstanceHandle simulationHandle, StaticHandle staticHandle)
     {
-        simulations[simulationHandle].Statics.Remove(staticHandle);
+        var simulation = simulations[simulationHandle];
+        simulation.Statics.Remove(staticHandle);
+        //Handles are reused, so a later static must not inherit this one's sensor status.
+        if (sensorTrackers.TryGetValue(simulation, out var sensors))
+            sensors.SetSensor(staticHandle, false);
     }
     /// <summary>
     /// Gets a pointer to data associated with a static.
@@ -509,6 +772,161 @@ public static partial class Entrypoints
         simulations[simulationHandle].Statics.ApplyDescription(staticHandle, description);
     }
 
+    /// <summary>
+    /// Builds a chunk of statics that can later be attached to the simulation in a handful of operations. Convex statics are gathered into one big compound whose acceleration structure is built here.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation owning the shapes referenced by the descriptions.</param>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate the chunk's buffers from. Must not be used by any other thread while the chunk is built.</param>
+    /// <param name="descriptions">Descriptions of the statics in the chunk.</param>
+    /// <returns>Built chunk.</returns>
+    /// <remarks>This only reads the simulation's shape data, so it can run on a worker thread while the simulation steps, provided no shapes are added to or removed from the simulation until it returns.
+    /// Statics with compound or mesh shapes cannot be compound children; they are stored in the chunk and added individually on attach.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateStaticChunk))]
+    public unsafe static StaticChunk CreateStaticChunk([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<StaticDescription>")] Buffer<StaticDescription> descriptions)
+    {
+        return StaticChunks.Create(simulations[simulationHandle], descriptions, bufferPools[bufferPoolHandle]);
+    }
+
+    /// <summary>
+    /// Adds a chunk's statics to the simulation. Convex statics enter the broad phase as a single static regardless of their number.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to attach the chunk to.</param>
+    /// <param name="chunk">Chunk to attach. Records the handles created for the chunk.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AttachStaticChunk))]
+    public unsafe static void AttachStaticChunk([TypeName(SimulationName)] InstanceHandle simulationHandle, StaticChunk* chunk)
+    {
+        StaticChunks.Attach(simulations[simulationHandle], ref *chunk);
+    }
+
+    /// <summary>
+    /// Removes a chunk's statics from the simulation. The chunk keeps its buffers and can be attached again.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to detach the chunk from.</param>
+    /// <param name="chunk">Chunk to detach.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DetachStaticChunk))]
+    public unsafe static void DetachStaticChunk([TypeName(SimulationName)] InstanceHandle simulationHandle, StaticChunk* chunk)
+    {
+        var simulation = simulations[simulationHandle];
+        //Clear sensor flags while the chunk's handles are still the ones in use; attaching again hands out fresh handles.
+        if (chunk->Attached != 0 && sensorTrackers.TryGetValue(simulation, out var sensors))
+        {
+            if (chunk->Compound.Children.Length > 0)
+                sensors.SetSensor(chunk->CompoundStatic, false);
+            for (int i = 0; i < chunk->LooseStatics.Length; ++i)
+                sensors.SetSensor(chunk->LooseStaticHandles[i], false);
+        }
+        StaticChunks.Detach(simulation, ref *chunk);
+    }
+
+    /// <summary>
+    /// Returns buffers allocated for a detached static chunk.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+    /// <param name="chunk">Chunk to destroy.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DestroyStaticChunk))]
+    public unsafe static void DestroyStaticChunk([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, StaticChunk* chunk)
+    {
+        StaticChunks.Dispose(ref *chunk, bufferPools[bufferPoolHandle]);
+    }
+
+    static SensorTracker GetSensors(InstanceHandle simulationHandle)
+    {
+        if (!sensorTrackers.TryGetValue(simulations[simulationHandle], out var sensors))
+            throw new InvalidOperationException("Simulation has no sensor tracker; was it created through the interop?");
+        return sensors;
+    }
+
+    /// <summary>
+    /// Sets whether a body acts as a sensor. Sensor pairs are tested with the shapes' own contact generation and reported through <see cref="GetSensorOverlaps"/> instead of generating contacts.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation containing the body.</param>
+    /// <param name="bodyHandle">Body to modify.</param>
+    /// <param name="isSensor">Nonzero if the body should be a sensor, zero otherwise.</param>
+    /// <remarks>Sensor pairs never reach the narrow phase callbacks. The flag is cleared when the body is removed, so a later body reusing the handle starts out as a regular body.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetBodySensor))]
+    public static void SetBodySensor([TypeName(SimulationName)] InstanceHandle simulationHandle, BodyHandle bodyHandle, int isSensor)
+    {
+        GetSensors(simulationHandle).SetSensor(bodyHandle, isSensor != 0);
+    }
+
+    /// <summary>
+    /// Sets whether a static acts as a sensor. Sensor pairs are tested with the shapes' own contact generation and reported through <see cref="GetSensorOverlaps"/> instead of generating contacts.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation containing the static.</param>
+    /// <param name="staticHandle">Static to modify.</param>
+    /// <param name="isSensor">Nonzero if the static should be a sensor, zero otherwise.</param>
+    /// <remarks>Sensor pairs never reach the narrow phase callbacks. The flag is cleared when the static is removed, including by detaching a static chunk, so a later static reusing the handle starts out as a regular static.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetStaticSensor))]
+    public static void SetStaticSensor([TypeName(SimulationName)] InstanceHandle simulationHandle, StaticHandle staticHandle, int isSensor)
+    {
+        GetSensors(simulationHandle).SetSensor(staticHandle, isSensor != 0);
+    }
+
+    /// <summary>
+    /// Gets the sensor overlaps that entered, stayed or exited during the last timestep.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to pull data from.</param>
+    /// <param name="overlaps">Overlaps reported by the last timestep.</param>
+    /// <remarks>The buffer is owned by the simulation and is overwritten by the next timestep.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetSensorOverlaps))]
+    public unsafe static void GetSensorOverlaps([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName("Buffer<SensorOverlap>*")] Buffer<SensorOverlap>* overlaps)
+    {
+        *overlaps = GetSensors(simulationHandle).Overlaps;
+    }
+
+    static AdaptiveContinuityController GetAdaptiveContinuity(InstanceHandle simulationHandle)
+    {
+        if (!adaptiveContinuityControllers.TryGetValue(simulations[simulationHandle], out var continuity))
+            throw new InvalidOperationException("Simulation has no adaptive continuity controller; was it created through the interop?");
+        return continuity;
+    }
+
+    /// <summary>
+    /// Starts choosing discrete, passive or continuous collision detection for tracked bodies each timestep from their velocity relative to their size.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to control.</param>
+    /// <param name="settings">Thresholds used to choose modes and sweep parameters.</param>
+    /// <remarks>Also starts counting sweep eligible pairs, reported by <see cref="GetAdaptiveContinuityStatistics"/>. Enabling again replaces the previous settings.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(EnableAdaptiveContinuity))]
+    public static void EnableAdaptiveContinuity([TypeName(SimulationName)] InstanceHandle simulationHandle, AdaptiveContinuitySettings settings)
+    {
+        GetAdaptiveContinuity(simulationHandle).Enable(settings);
+    }
+
+    /// <summary>
+    /// Stops choosing continuity for tracked bodies. Bodies keep the continuity they were last given, and remain tracked if adaptive continuity is enabled again.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to stop controlling.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DisableAdaptiveContinuity))]
+    public static void DisableAdaptiveContinuity([TypeName(SimulationName)] InstanceHandle simulationHandle)
+    {
+        GetAdaptiveContinuity(simulationHandle).Disable();
+    }
+
+    /// <summary>
+    /// Adds bodies to or removes them from adaptive continuity.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation containing the bodies.</param>
+    /// <param name="bodyHandles">Bodies to modify.</param>
+    /// <param name="tracked">Nonzero to choose the bodies' continuity adaptively, zero to stop. Bodies that stop being tracked keep their current continuity.</param>
+    /// <remarks>A body's size is measured from its shape when it is added; add it again after changing its shape. Removing a body stops tracking it, so a later body reusing the handle starts out untracked.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetAdaptiveContinuityBodies))]
+    public static void SetAdaptiveContinuityBodies([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName("Buffer<BodyHandle>")] Buffer<BodyHandle> bodyHandles, int tracked)
+    {
+        GetAdaptiveContinuity(simulationHandle).SetTracked(bodyHandles, tracked != 0);
+    }
+
+    /// <summary>
+    /// Gets the continuity modes chosen in the last timestep and the number of pairs that were eligible for sweep tests.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to pull statistics from.</param>
+    /// <returns>Statistics of the last timestep. Counts other than the tracked body count are zero while adaptive continuity is disabled.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetAdaptiveContinuityStatistics))]
+    public static AdaptiveContinuityStatistics GetAdaptiveContinuityStatistics([TypeName(SimulationName)] InstanceHandle simulationHandle)
+    {
+        return GetAdaptiveContinuity(simulationHandle).Statistics;
+    }
+
     /// <summary>
     /// Steps the simulation forward a single time.
     /// </summary>
@@ -519,7 +937,12 @@ public static partial class Entrypoints
     public unsafe static void Timestep([TypeName(SimulationName)] InstanceHandle simulationHandle, float dt, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
     {
         var threadDispatcher = threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle];
-        simulations[simulationHandle].Timestep(dt, threadDispatcher);
+        var simulation = simulations[simulationHandle];
+        simulation.Timestep(dt, threadDispatcher);
+        if (broadPhaseRefiners.TryGetValue(simulation, out var refiner))
+            refiner.Refine(simulation);
+        //Most simulation allocations never cross the interop boundary, so the end of a step is where reserved memory peaks get observed.
+        GetTelemetry(simulation.BufferPool).SampleReservedBytes(simulation.BufferPool);
     }
 
     /// <summary>
@@ -552,6 +975,60 @@ public static partial class Entrypoints
         *max = *maxPointer;
     }
 
+    /// <summary>
+    /// Measures the broad phase's active and static trees.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to measure.</param>
+    /// <returns>Statistics of both broad phase trees.</returns>
+    /// <remarks>Walks every node of both trees, so the cost scales with the number of collidables.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetBroadPhaseStatistics))]
+    public unsafe static BroadPhaseStatistics GetBroadPhaseStatistics([TypeName(SimulationName)] InstanceHandle simulationHandle)
+    {
+        var simulation = simulations[simulationHandle];
+        var broadPhase = simulation.BroadPhase;
+        return new BroadPhaseStatistics { ActiveTree = BroadPhaseMaintenance.Measure(broadPhase.ActiveTree, simulation.BufferPool), StaticTree = BroadPhaseMaintenance.Measure(broadPhase.StaticTree, simulation.BufferPool) };
+    }
+
+    /// <summary>
+    /// Sets how much extra refinement is applied to the broad phase's trees at the end of each timestep, on top of the engine's own incremental refinement.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to configure.</param>
+    /// <param name="budget">Extra refinement to apply each step. Scales of zero on both trees disable extra refinement.</param>
+    /// <remarks>Extra refinement runs on the calling thread after the step completes.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetBroadPhaseRefinementBudget))]
+    public unsafe static void SetBroadPhaseRefinementBudget([TypeName(SimulationName)] InstanceHandle simulationHandle, BroadPhaseRefinementBudget budget)
+    {
+        var simulation = simulations[simulationHandle];
+        if (budget.ActiveTreeRefinementScale > 0 || budget.StaticTreeRefinementScale > 0)
+            broadPhaseRefiners.AddOrUpdate(simulation, new BroadPhaseRefiner(budget));
+        else
+            broadPhaseRefiners.Remove(simulation);
+    }
+
+    /// <summary>
+    /// Gets the extra refinement applied to the broad phase's trees at the end of each timestep.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to query.</param>
+    /// <returns>Extra refinement applied each step. Zero scales if none is configured.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetBroadPhaseRefinementBudget))]
+    public unsafe static BroadPhaseRefinementBudget GetBroadPhaseRefinementBudget([TypeName(SimulationName)] InstanceHandle simulationHandle)
+    {
+        return broadPhaseRefiners.TryGetValue(simulations[simulationHandle], out var refiner) ? refiner.Budget : default;
+    }
+
+    /// <summary>
+    /// Rebuilds both broad phase trees from scratch with a binned surface area heuristic build. Useful after level transitions, mass spawns, or large teleports leave the trees in poor shape.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation whose broad phase should be rebuilt.</param>
+    /// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+    /// <remarks>Leaf indices are preserved, so collidables keep their broad phase indices. Must not be called during a timestep.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RebuildBroadPhase))]
+    public unsafe static void RebuildBroadPhase([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
+    {
+        var simulation = simulations[simulationHandle];
+        BroadPhaseMaintenance.Rebuild(simulation.BroadPhase, simulation.BufferPool, threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle]);
+    }
+
     /// <summary>
     /// Gets the mapping from body handles to the body's location in storage.
     /// </summary>
@@ -642,6 +1119,78 @@ public static partial class Entrypoints
         return (ulong)GC.GetTotalMemory(false);
     }
 
+    /// <summary>
+    /// Gathers memory usage and allocation statistics for a buffer pool.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to gather statistics for.</param>
+    /// <param name="statistics">Statistics about the buffer pool.</param>
+    /// <remarks>Reserved byte counts cover all allocations in the pool. Occupancy and allocation counts only cover buffers that were taken, resized, or returned through the interop functions.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetBufferPoolStatistics))]
+    public unsafe static void GetBufferPoolStatistics([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, BufferPoolStatistics* statistics)
+    {
+        var pool = bufferPools[bufferPoolHandle];
+        GetTelemetry(pool).GetStatistics(pool, statistics);
+    }
+
+    /// <summary>
+    /// Resets a buffer pool's allocation counters and sets its peak values to the current usage.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to reset statistics for.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(ResetBufferPoolStatistics))]
+    public unsafe static void ResetBufferPoolStatistics([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle)
+    {
+        var pool = bufferPools[bufferPoolHandle];
+        GetTelemetry(pool).Reset(pool);
+    }
+
+    /// <summary>
+    /// Enables or disables allocation tagging for a buffer pool. While enabled, every buffer taken through the interop functions records the pool's current tag until it is returned.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to configure.</param>
+    /// <param name="enabled">True if allocations should be tagged, false otherwise. Disabling tagging discards all recorded allocations.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetBufferPoolAllocationTagging))]
+    public unsafe static void SetBufferPoolAllocationTagging([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("bool")] byte enabled)
+    {
+        GetTelemetry(bufferPools[bufferPoolHandle]).SetTaggingEnabled(enabled != 0);
+    }
+
+    /// <summary>
+    /// Sets the tag recorded for subsequent allocations from a buffer pool while allocation tagging is enabled.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to set the tag for.</param>
+    /// <param name="tag">Tag to associate with subsequent allocations. Typically identifies the allocation site.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetBufferPoolAllocationTag))]
+    public unsafe static void SetBufferPoolAllocationTag([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, int tag)
+    {
+        GetTelemetry(bufferPools[bufferPoolHandle]).CurrentTag = tag;
+    }
+
+    /// <summary>
+    /// Gets the outstanding allocations recorded by a buffer pool's allocation tagging.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to pull tagged allocations from.</param>
+    /// <param name="allocations">Buffer to write tagged allocations into. If it is too small to hold all outstanding allocations, only the oldest allocations that fit are written.</param>
+    /// <param name="count">Total number of outstanding tagged allocations.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetBufferPoolTaggedAllocations))]
+    public unsafe static void GetBufferPoolTaggedAllocations([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<TaggedBufferAllocation>")] Buffer<TaggedBufferAllocation> allocations, [TypeName("int32_t*")] int* count)
+    {
+        var taggedAllocations = GetTelemetry(bufferPools[bufferPoolHandle]).TaggedAllocations;
+        if (taggedAllocations == null)
+        {
+            *count = 0;
+            return;
+        }
+        *count = taggedAllocations.Count;
+        //Leak hunting cares most about the oldest survivors, so sort by allocation order before truncating.
+        var sorted = taggedAllocations.Values.ToArray();
+        Array.Sort(sorted, static (a, b) => a.AllocationIndex.CompareTo(b.AllocationIndex));
+        var writeCount = Math.Min(sorted.Length, allocations.Length);
+        for (int i = 0; i < writeCount; ++i)
+        {
+            allocations[i] = sorted[i];
+        }
+    }
+
 
 
 
@@ -0,0 +1,213 @@
+﻿using BepuPhysics;
+using BepuPhysics.Constraints;
+using BepuUtilities.Memory;
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+public static partial class Entrypoints
+{
+    static unsafe void AddConstraints<TDescription>(Simulation simulation, Buffer<BodyHandle> bodies, Buffer<byte> descriptions, Buffer<ConstraintHandle> handles)
+        where TDescription : unmanaged, ITwoBodyConstraintDescription<TDescription>
+    {
+        var typedDescriptions = new Buffer<TDescription>(descriptions.Memory, descriptions.Length / sizeof(TDescription));
+        if (typedDescriptions.Length < handles.Length || bodies.Length < handles.Length * 2)
+            throw new ArgumentException("Constraint creation requires a description and two bodies for every output handle.");
+        for (int i = 0; i < handles.Length; ++i)
+        {
+            handles[i] = simulation.Solver.Add(bodies[i * 2], bodies[i * 2 + 1], typedDescriptions[i]);
+        }
+    }
+
+    /// <summary>
+    /// Adds a set of constraints of the same type to the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to add the constraints to.</param>
+    /// <param name="type">Type of the constraint descriptions in the descriptions buffer.</param>
+    /// <param name="bodies">Bodies connected by the constraints. Constraint i connects bodies[i * 2] and bodies[i * 2 + 1].</param>
+    /// <param name="descriptions">Descriptions of the constraints, all of the given type.</param>
+    /// <param name="handles">Buffer to fill with the handles of the created constraints. The number of constraints created is the length of this buffer.</param>
+    /// <remarks>The solver's constraint handle storage is resized at most once for the whole set, and the interop transition is paid once rather than once per constraint.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddConstraints))]
+    public unsafe static void AddConstraints([TypeName(SimulationName)] InstanceHandle simulationHandle, JointType type, [TypeName("Buffer<BodyHandle>")] Buffer<BodyHandle> bodies, [TypeName("ByteBuffer")] Buffer<byte> descriptions, [TypeName("Buffer<ConstraintHandle>*")] Buffer<ConstraintHandle>* handles)
+    {
+        var simulation = simulations[simulationHandle];
+        var solver = simulation.Solver;
+        solver.EnsureSolverCapacities(simulation.Bodies.HandlePool.HighestPossiblyClaimedId + 1, solver.HandlePool.HighestPossiblyClaimedId + 1 + handles->Length);
+        switch (type)
+        {
+            case JointType.BallSocket:
+                AddConstraints<BallSocket>(simulation, bodies, descriptions, *handles);
+                break;
+            case JointType.Hinge:
+                AddConstraints<Hinge>(simulation, bodies, descriptions, *handles);
+                break;
+            case JointType.SwivelHinge:
+                AddConstraints<SwivelHinge>(simulation, bodies, descriptions, *handles);
+                break;
+            case JointType.AngularMotor:
+                {
+                    //The native side describes motor settings with damping directly; convert into the engine's representation.
+                    var motors = new Buffer<AngularMotorInterop>(descriptions.Memory, descriptions.Length / sizeof(AngularMotorInterop));
+                    if (motors.Length < handles->Length || bodies.Length < handles->Length * 2)
+                        throw new ArgumentException("Constraint creation requires a description and two bodies for every output handle.");
+                    for (int i = 0; i < handles->Length; ++i)
+                    {
+                        ref var motor = ref motors[i];
+                        (*handles)[i] = solver.Add(bodies[i * 2], bodies[i * 2 + 1], new AngularMotor
+                        {
+                            TargetVelocityLocalA = motor.TargetVelocityLocalA,
+                            Settings = new MotorSettings(motor.Settings.MaximumForce, motor.Settings.Damping)
+                        });
+                    }
+                }
+                break;
+            case JointType.DistanceLimit:
+                AddConstraints<DistanceLimit>(simulation, bodies, descriptions, *handles);
+                break;
+            case JointType.Weld:
+                AddConstraints<Weld>(simulation, bodies, descriptions, *handles);
+                break;
+            default:
+                throw new ArgumentException($"Unknown joint type {type}.");
+        }
+    }
+
+    /// <summary>
+    /// Removes a constraint from the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to remove the constraint from.</param>
+    /// <param name="constraintHandle">Constraint to remove.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveConstraint))]
+    public unsafe static void RemoveConstraint([TypeName(SimulationName)] InstanceHandle simulationHandle, ConstraintHandle constraintHandle)
+    {
+        simulations[simulationHandle].Solver.Remove(constraintHandle);
+    }
+
+    /// <summary>
+    /// Removes a set of constraints from the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to remove the constraints from.</param>
+    /// <param name="constraintHandles">Constraints to remove.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveConstraints))]
+    public unsafe static void RemoveConstraints([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName("Buffer<ConstraintHandle>")] Buffer<ConstraintHandle> constraintHandles)
+    {
+        var solver = simulations[simulationHandle].Solver;
+        for (int i = 0; i < constraintHandles.Length; ++i)
+        {
+            solver.Remove(constraintHandles[i]);
+        }
+    }
+
+    /// <summary>
+    /// Checks whether a constraint handle refers to a constraint in the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to look in.</param>
+    /// <param name="constraintHandle">Constraint handle to check.</param>
+    /// <returns>True if the constraint exists, false otherwise.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(ConstraintExists))]
+    [return: TypeName("bool")]
+    public unsafe static byte ConstraintExists([TypeName(SimulationName)] InstanceHandle simulationHandle, ConstraintHandle constraintHandle)
+    {
+        return simulations[simulationHandle].Solver.ConstraintExists(constraintHandle) ? (byte)1 : (byte)0;
+    }
+
+    /// <summary>
+    /// Gets statistics about the solver's constraint batching and the cost of the most recent solve.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to pull statistics from.</param>
+    /// <param name="statistics">Statistics for the simulation's active constraints.</param>
+    /// <param name="constraintCountPerBatch">Buffer to fill with the number of constraints in each active batch. Entries beyond the batch count are zeroed. Can be empty.</param>
+    /// <param name="constraintCountPerType">Buffer to fill with the number of active constraints of each type id. Entries beyond the constraint type count are zeroed. Can be empty.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetSolverStatistics))]
+    public unsafe static void GetSolverStatistics([TypeName(SimulationName)] InstanceHandle simulationHandle, SolverStatistics* statistics,
+        [TypeName("Buffer<int32_t>")] Buffer<int> constraintCountPerBatch, [TypeName("Buffer<int32_t>")] Buffer<int> constraintCountPerType)
+    {
+        var simulation = simulations[simulationHandle];
+        solverTelemetry.GetValue(simulation, static _ => new SolverTelemetry()).GetStatistics(simulation, statistics);
+        ref var activeSet = ref simulation.Solver.ActiveSet;
+        if (constraintCountPerBatch.Length > 0)
+        {
+            constraintCountPerBatch.Clear(0, constraintCountPerBatch.Length);
+            var batchCount = Math.Min(constraintCountPerBatch.Length, activeSet.Batches.Count);
+            for (int batchIndex = 0; batchIndex < batchCount; ++batchIndex)
+            {
+                constraintCountPerBatch[batchIndex] = SolverTelemetry.GetConstraintCount(ref activeSet.Batches[batchIndex]);
+            }
+        }
+        if (constraintCountPerType.Length > 0)
+        {
+            constraintCountPerType.Clear(0, constraintCountPerType.Length);
+            for (int batchIndex = 0; batchIndex < activeSet.Batches.Count; ++batchIndex)
+            {
+                ref var batch = ref activeSet.Batches[batchIndex];
+                for (int typeBatchIndex = 0; typeBatchIndex < batch.TypeBatches.Count; ++typeBatchIndex)
+                {
+                    ref var typeBatch = ref batch.TypeBatches[typeBatchIndex];
+                    if (typeBatch.TypeId < constraintCountPerType.Length)
+                        constraintCountPerType[typeBatch.TypeId] += typeBatch.ConstraintCount;
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Lets the simulation choose its velocity iteration count each timestep based on how much the previous solve changed the velocities of constrained bodies.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to schedule velocity iterations for.</param>
+    /// <param name="settings">Bounds and thresholds used to choose the iteration count.</param>
+    /// <remarks>Replaces any velocity iteration scheduler given in the simulation's solve description. Enabling again replaces the previous settings.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(EnableAdaptiveVelocityIterations))]
+    public unsafe static void EnableAdaptiveVelocityIterations([TypeName(SimulationName)] InstanceHandle simulationHandle, AdaptiveVelocityIterationSettings settings)
+    {
+        var simulation = simulations[simulationHandle];
+        if (adaptiveVelocityIterationSchedulers.TryGetValue(simulation, out var previous))
+            previous.Dispose();
+        adaptiveVelocityIterationSchedulers.AddOrUpdate(simulation, new AdaptiveVelocityIterationScheduler(simulation, settings));
+    }
+
+    /// <summary>
+    /// Stops adapting the simulation's velocity iteration count. The solver keeps the last chosen count.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to stop scheduling velocity iterations for.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DisableAdaptiveVelocityIterations))]
+    public unsafe static void DisableAdaptiveVelocityIterations([TypeName(SimulationName)] InstanceHandle simulationHandle)
+    {
+        var simulation = simulations[simulationHandle];
+        if (adaptiveVelocityIterationSchedulers.TryGetValue(simulation, out var scheduler))
+        {
+            scheduler.Dispose();
+            adaptiveVelocityIterationSchedulers.Remove(simulation);
+        }
+    }
+
+    /// <summary>
+    /// Gets the iteration counts chosen by the simulation's adaptive velocity iteration scheduler.
+    /// </summary>
+    /// <param name="simulationHandle">Simulation to pull the scheduler state from.</param>
+    /// <param name="state">State of the scheduler. Zeroed if adaptive velocity iterations are not enabled.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetAdaptiveVelocityIterationState))]
+    public unsafe static void GetAdaptiveVelocityIterationState([TypeName(SimulationName)] InstanceHandle simulationHandle, AdaptiveVelocityIterationState* state)
+    {
+        *state = adaptiveVelocityIterationSchedulers.TryGetValue(simulations[simulationHandle], out var scheduler) ? scheduler.State : default;
+    }
+
+    /// <summary>
+    /// Copies the contacts of every active contact constraint into a flat buffer. Intended to be called after a timestep to read the solved contact impulses.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to read contacts from.</param>
+    /// <param name="options">Filters applied to the exported contacts.</param>
+    /// <param name="records">Receives a buffer holding one record per exported contact. The buffer is allocated from the given pool and must be deallocated by the caller, even if it is empty.</param>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate the output buffer from.</param>
+    /// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+    /// <remarks>Only awake constraints are exported. Impulses are those accumulated over the last solved substep.
+    /// Records appear in solver order, which is deterministic for a deterministic simulation.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(ExportContacts))]
+    public unsafe static void ExportContacts([TypeName(SimulationName)] InstanceHandle simulationHandle, ContactExportOptions options, [TypeName("Buffer<ContactRecord>*")] Buffer<ContactRecord>* records,
+        [TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle = new())
+    {
+        *records = ContactExporter.Export(simulations[simulationHandle], options, bufferPools[bufferPoolHandle], threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle]);
+    }
+}
@@ -2,6 +2,7 @@
 using BepuPhysics;
 using BepuPhysics.Collidables;
 using BepuUtilities.Memory;
+using System;
 using System.Numerics;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
@@ -10,6 +11,14 @@ namespace AbominationInterop;
 
 public static partial class Entrypoints
 {
+    static TypedIndex AddShape<TShape>(InstanceHandle simulationHandle, in TShape shape) where TShape : unmanaged, IShape
+    {
+        var simulation = simulations[simulationHandle];
+        if (shapeInterners.TryGetValue(simulation, out var interner))
+            return interner.Add(shape);
+        return simulation.Shapes.Add(shape);
+    }
+
     /// <summary>
     /// Adds a sphere shape to the simulation.
     /// </summary>
@@ -18,7 +27,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddSphere))]
     public unsafe static TypedIndex AddSphere([TypeName(SimulationName)] InstanceHandle simulationHandle, Sphere sphere)
     {
-        return simulations[simulationHandle].Shapes.Add(sphere);
+        return AddShape(simulationHandle, sphere);
     }
 
     /// <summary>
@@ -29,7 +38,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddCapsule))]
     public unsafe static TypedIndex AddCapsule([TypeName(SimulationName)] InstanceHandle simulationHandle, Capsule capsule)
     {
-        return simulations[simulationHandle].Shapes.Add(capsule);
+        return AddShape(simulationHandle, capsule);
     }
 
     /// <summary>
@@ -40,7 +49,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddBox))]
     public unsafe static TypedIndex AddBox([TypeName(SimulationName)] InstanceHandle simulationHandle, Box box)
     {
-        return simulations[simulationHandle].Shapes.Add(box);
+        return AddShape(simulationHandle, box);
     }
 
     /// <summary>
@@ -51,7 +60,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddTriangle))]
     public unsafe static TypedIndex AddTriangle([TypeName(SimulationName)] InstanceHandle simulationHandle, Triangle triangle)
     {
-        return simulations[simulationHandle].Shapes.Add(triangle);
+        return AddShape(simulationHandle, triangle);
     }
 
     /// <summary>
@@ -62,7 +71,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddCylinder))]
     public unsafe static TypedIndex AddCylinder([TypeName(SimulationName)] InstanceHandle simulationHandle, Cylinder cylinder)
     {
-        return simulations[simulationHandle].Shapes.Add(cylinder);
+        return AddShape(simulationHandle, cylinder);
     }
 
     /// <summary>
@@ -73,7 +82,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddConvexHull))]
     public unsafe static TypedIndex AddConvexHull([TypeName(SimulationName)] InstanceHandle simulationHandle, ConvexHull convexHull)
     {
-        return simulations[simulationHandle].Shapes.Add(convexHull);
+        return AddShape(simulationHandle, convexHull);
     }
 
     /// <summary>
@@ -84,7 +93,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddCompound))]
     public unsafe static TypedIndex AddCompound([TypeName(SimulationName)] InstanceHandle simulationHandle, Compound bigCompound)
     {
-        return simulations[simulationHandle].Shapes.Add(bigCompound);
+        return AddShape(simulationHandle, bigCompound);
     }
 
     /// <summary>
@@ -95,7 +104,7 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddBigCompound))]
     public unsafe static TypedIndex AddBigCompound([TypeName(SimulationName)] InstanceHandle simulationHandle, BigCompound bigCompound)
     {
-        return simulations[simulationHandle].Shapes.Add(bigCompound);
+        return AddShape(simulationHandle, bigCompound);
     }
 
     /// <summary>
@@ -106,22 +115,100 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddMesh))]
     public unsafe static TypedIndex AddMesh([TypeName(SimulationName)] InstanceHandle simulationHandle, Mesh mesh)
     {
-        return simulations[simulationHandle].Shapes.Add(mesh);
+        return AddShape(simulationHandle, mesh);
+    }
+
+    /// <summary>
+    /// Adds a compressed mesh shape to the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
+    /// <param name="mesh">Shape to add to the simulation.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddCompressedMesh))]
+    public unsafe static TypedIndex AddCompressedMesh([TypeName(SimulationName)] InstanceHandle simulationHandle, CompressedMesh mesh)
+    {
+        return AddShape(simulationHandle, mesh);
+    }
+
+    /// <summary>
+    /// Adds a heightfield shape to the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
+    /// <param name="heightfield">Shape to add to the simulation.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddHeightfield))]
+    public unsafe static TypedIndex AddHeightfield([TypeName(SimulationName)] InstanceHandle simulationHandle, Heightfield heightfield)
+    {
+        return AddShape(simulationHandle, heightfield);
+    }
+
+    /// <summary>
+    /// Adds a voxel grid shape to the simulation.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
+    /// <param name="voxelGrid">Shape to add to the simulation.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(AddVoxelGrid))]
+    public unsafe static TypedIndex AddVoxelGrid([TypeName(SimulationName)] InstanceHandle simulationHandle, VoxelGrid voxelGrid)
+    {
+        return AddShape(simulationHandle, voxelGrid);
+    }
+
+    /// <summary>
+    /// Makes subsequent shape additions return an existing shape when one with identical content was already added, and reference counts shape removals.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to intern shapes in.</param>
+    /// <param name="bufferPoolHandle">Buffer pool that the buffers of added shapes were allocated from. When an addition is deduplicated, the buffers of the shape passed in are returned to this pool. If null, they are left with the caller.</param>
+    /// <remarks>Only shapes added while interning is enabled are deduplicated. When an existing shape is returned for a shape with buffers, the simulation never takes ownership of the buffers in the shape passed in; they are returned to the given pool so the caller can treat every addition the same way.
+    /// Adding a shape that reuses the existing shape's own buffers leaves them alive. Enabling again replaces the pool.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(EnableShapeInterning))]
+    public unsafe static void EnableShapeInterning([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle)
+    {
+        var simulation = simulations[simulationHandle];
+        var pool = bufferPoolHandle.Null ? null : bufferPools[bufferPoolHandle];
+        if (shapeInterners.TryGetValue(simulation, out var interner))
+            interner.DuplicatePool = pool;
+        else
+            shapeInterners.Add(simulation, new ShapeInterner(simulation.Shapes, pool));
+    }
+
+    /// <summary>
+    /// Stops interning shapes. Shapes already shared remain shared, but their reference counts are discarded and the next removal of any of them removes it.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to stop interning shapes in.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DisableShapeInterning))]
+    public unsafe static void DisableShapeInterning([TypeName(SimulationName)] InstanceHandle simulationHandle)
+    {
+        shapeInterners.Remove(simulations[simulationHandle]);
+    }
+
+    /// <summary>
+    /// Gets the number of outstanding references to a shape added while shape interning was enabled.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation containing the shape.</param>
+    /// <param name="shape">Shape to look up.</param>
+    /// <returns>Number of additions that returned the shape and have not been removed yet. Shapes not tracked by interning report 1.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetShapeReferenceCount))]
+    public unsafe static int GetShapeReferenceCount([TypeName(SimulationName)] InstanceHandle simulationHandle, TypedIndex shape)
+    {
+        return shapeInterners.TryGetValue(simulations[simulationHandle], out var interner) ? interner.GetReferenceCount(shape) : 1;
     }
 
     /// <summary>
     /// Removes a shape from the simulation. Does not return any shape allocated buffers to buffer pools.
+    /// If shape interning is enabled, this releases one reference and only removes the shape once no references remain.
     /// </summary>
     /// <param name="simulationHandle">Handle of the simulation to remove the shape from.</param>
     /// <param name="shape">Shape to remove from the simulation.</param>
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveShape))]
     public unsafe static void RemoveShape([TypeName(SimulationName)] InstanceHandle simulationHandle, TypedIndex shape)
     {
-        simulations[simulationHandle].Shapes.Remove(shape);
+        var simulation = simulations[simulationHandle];
+        if (shapeInterners.TryGetValue(simulation, out var interner) && !interner.Release(shape))
+            return;
+        simulation.Shapes.Remove(shape);
     }
 
     /// <summary>
     /// Removes a shape from the simulation. If the shape has resources that were allocated from a buffer pool, they will be returned to the specified pool.
+    /// If shape interning is enabled, this releases one reference and only removes the shape once no references remain.
     /// </summary>
     /// <param name="simulationHandle">Handle of the simulation to remove the shape from.</param>
     /// <param name="bufferPoolHandle">Buffer pool to return shape resources to, if any.</param>
@@ -130,11 +217,15 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveAndDestroyShape))]
     public unsafe static void RemoveAndDestroyShape([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, TypedIndex shape)
     {
-        simulations[simulationHandle].Shapes.RemoveAndDispose(shape, bufferPools[bufferPoolHandle]);
+        var simulation = simulations[simulationHandle];
+        if (shapeInterners.TryGetValue(simulation, out var interner) && !interner.Release(shape))
+            return;
+        simulation.Shapes.RemoveAndDispose(shape, bufferPools[bufferPoolHandle]);
     }
 
     /// <summary>
     /// Removes a shape and all references child shapes from the simulation. If the shapes had resources that were allocated from a buffer pool, they will be returned to the specified pool.
+    /// If shape interning is enabled, the shape and each distinct child shape release one reference and are only removed once no references remain.
     /// </summary>
     /// <param name="simulationHandle">Handle of the simulation to remove the shape from.</param>
     /// <param name="bufferPoolHandle">Buffer pool to return shape resources to, if any.</param>
@@ -143,7 +234,11 @@ public static partial class Entrypoints
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(RemoveAndDestroyShapeRecursively))]
     public unsafe static void RemoveAndDestroyShapeRecursively([TypeName(SimulationName)] InstanceHandle simulationHandle, [TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, TypedIndex shape)
     {
-        simulations[simulationHandle].Shapes.RecursivelyRemoveAndDispose(shape, bufferPools[bufferPoolHandle]);
+        var simulation = simulations[simulationHandle];
+        if (shapeInterners.TryGetValue(simulation, out var interner))
+            interner.ReleaseAndDisposeRecursively(shape, bufferPools[bufferPoolHandle]);
+        else
+            simulation.Shapes.RecursivelyRemoveAndDispose(shape, bufferPools[bufferPoolHandle]);
     }
 
     /// <summary>
@@ -159,6 +254,25 @@ public static partial class Entrypoints
         return hull;
     }
 
+    /// <summary>
+    /// Creates convex hull shapes for many point sets at once, computing each hull's center of mass and inertia across the workers of a thread dispatcher.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate the hulls and output buffers from.</param>
+    /// <param name="pointSets">Ranges of the points buffer defining each hull, along with the mass to compute its inertia with.</param>
+    /// <param name="points">Points referenced by the point sets.</param>
+    /// <param name="hulls">Hulls created for each point set, allocated from the buffer pool. Each hull's points are recentered on its center of mass. Each hull must be destroyed with DestroyConvexHull before the buffer is deallocated.</param>
+    /// <param name="centersOfMass">Center of mass computed for each point set, allocated from the buffer pool.</param>
+    /// <param name="inertias">Inertia of each hull, allocated from the buffer pool. Degenerate point sets that produce no faces get zeroed inertia.</param>
+    /// <param name="threadDispatcherHandle">Thread dispatcher to create hulls with. If null, hulls are created on the calling thread.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateConvexHulls))]
+    public unsafe static void CreateConvexHulls([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<PointSetRange>")] Buffer<PointSetRange> pointSets, [TypeName("Buffer<Vector3>")] Buffer<Vector3> points,
+        [TypeName("Buffer<ConvexHull>*")] Buffer<ConvexHull>* hulls, [TypeName("Buffer<Vector3>*")] Buffer<Vector3>* centersOfMass, [TypeName("Buffer<BodyInertia>*")] Buffer<BodyInertia>* inertias,
+        [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle)
+    {
+        var threadDispatcher = threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle];
+        ConvexHullBatchBuilder.Build(pointSets, points, bufferPools[bufferPoolHandle], threadDispatcher, out *hulls, out *centersOfMass, out *inertias);
+    }
+
     /// <summary>
     /// Returns buffers allocated for a convex hull shape.
     /// </summary>
@@ -210,13 +324,71 @@ public static partial class Entrypoints
     /// <param name="bufferPoolHandle">Buffer pool to allocate resources from for the compound's acceleration structures.</param>
     /// <param name="triangles">Triangles composing the mesh.</param>
     /// <param name="scale">Scale of the mesh.</param>
-    /// <remarks>This uses a pretty old sweep builder. Large meshes will take a while. There are ways to do this much faster if required; see https://github.com/bepu/bepuphysics2/blob/master/Demos/DemoMeshHelper.cs#L186.</remarks>
+    /// <remarks>This uses a pretty old sweep builder. Large meshes will take a while; use CreateMeshParallel for those.</remarks>
     [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateMesh))]
     public unsafe static Mesh CreateMesh([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<Triangle>")] Buffer<Triangle> triangles, Vector3 scale)
     {
         return new Mesh(triangles, scale, bufferPools[bufferPoolHandle]);
     }
 
+    /// <summary>
+    /// Creates a mesh shape from triangles, building its acceleration structure across the workers of a thread dispatcher.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate resources from for the mesh's acceleration structures.</param>
+    /// <param name="triangles">Triangles composing the mesh. Ownership transfers to the mesh; the buffer is returned to the pool by DestroyMesh.</param>
+    /// <param name="scale">Scale of the mesh.</param>
+    /// <param name="threadDispatcherHandle">Thread dispatcher to build with. If null, the build runs on the calling thread.</param>
+    /// <param name="options">Options controlling the build.</param>
+    /// <returns>Created mesh.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateMeshParallel))]
+    public unsafe static Mesh CreateMeshParallel([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<Triangle>")] Buffer<Triangle> triangles, Vector3 scale,
+        [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle, MeshBuildOptions options)
+    {
+        var threadDispatcher = threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle];
+        return MeshBuilder.Build(triangles, default, default, scale, bufferPools[bufferPoolHandle], threadDispatcher, options);
+    }
+
+    /// <summary>
+    /// Creates a mesh shape from indexed vertices, building its acceleration structure across the workers of a thread dispatcher.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate resources from for the mesh's triangles and acceleration structures.</param>
+    /// <param name="vertices">Vertices referenced by the indices. Not retained by the mesh.</param>
+    /// <param name="indices">Three vertex indices per triangle. Not retained by the mesh.</param>
+    /// <param name="scale">Scale of the mesh.</param>
+    /// <param name="threadDispatcherHandle">Thread dispatcher to build with. If null, the build runs on the calling thread.</param>
+    /// <param name="options">Options controlling the build.</param>
+    /// <returns>Created mesh.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateIndexedMeshParallel))]
+    public unsafe static Mesh CreateIndexedMeshParallel([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<Vector3>")] Buffer<Vector3> vertices, [TypeName("Buffer<int>")] Buffer<int> indices, Vector3 scale,
+        [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle, MeshBuildOptions options)
+    {
+        if (indices.Length % 3 != 0)
+            throw new ArgumentException("Index count must be a multiple of 3.");
+        //Exceptions can't cross an unmanaged entrypoint; any that escape here terminate the process. Checking the indices up front at least fails on the calling thread
+        //with a clear message before anything is allocated, rather than reading out of bounds on a worker thread during the build.
+        for (int i = 0; i < indices.Length; ++i)
+        {
+            if ((uint)indices[i] >= (uint)vertices.Length)
+                throw new ArgumentOutOfRangeException(nameof(indices), $"Index {indices[i]} at position {i} is outside the {vertices.Length} provided vertices.");
+        }
+        var pool = bufferPools[bufferPoolHandle];
+        var threadDispatcher = threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle];
+        pool.Take<Triangle>(indices.Length / 3, out var triangles);
+        bool built = false;
+        try
+        {
+            var mesh = MeshBuilder.Build(triangles, vertices, indices, scale, pool, threadDispatcher, options);
+            built = true;
+            return mesh;
+        }
+        finally
+        {
+            //The triangles were allocated here, so they only belong to the caller once they're inside a mesh.
+            if (!built)
+                pool.Return(ref triangles);
+        }
+    }
+
     /// <summary>
     /// Returns buffers allocated for a mesh shape.
     /// </summary>
@@ -228,6 +400,108 @@ public static partial class Entrypoints
         mesh->Dispose(bufferPools[bufferPoolHandle]);
     }
 
+    /// <summary>
+    /// Creates a compressed mesh shape from indexed vertices. Vertices are quantized to 16 bits per axis within the mesh's bounds, indices are stored in 16 bits when possible, and tree bounds are quantized to the same grid.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate the mesh's buffers and temporary resources from.</param>
+    /// <param name="vertices">Vertices referenced by the indices. Not retained by the mesh.</param>
+    /// <param name="indices">Three vertex indices per triangle. Not retained by the mesh.</param>
+    /// <param name="scale">Scale of the mesh.</param>
+    /// <param name="threadDispatcherHandle">Thread dispatcher to build the acceleration structure with. If null, the build runs on the calling thread.</param>
+    /// <param name="options">Options controlling the acceleration structure build.</param>
+    /// <returns>Created mesh.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateCompressedMesh))]
+    public unsafe static CompressedMesh CreateCompressedMesh([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("Buffer<Vector3>")] Buffer<Vector3> vertices, [TypeName("Buffer<int>")] Buffer<int> indices, Vector3 scale,
+        [TypeName(ThreadDispatcherName)] InstanceHandle threadDispatcherHandle, MeshBuildOptions options)
+    {
+        var threadDispatcher = threadDispatcherHandle.Null ? null : threadDispatchers[threadDispatcherHandle];
+        return CompressedMesh.Create(vertices, indices, scale, bufferPools[bufferPoolHandle], threadDispatcher, options);
+    }
+
+    /// <summary>
+    /// Returns buffers allocated for a compressed mesh shape.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+    /// <param name="mesh">Mesh to destroy.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DestroyCompressedMesh))]
+    public unsafe static void DestroyCompressedMesh([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, CompressedMesh* mesh)
+    {
+        mesh->Dispose(bufferPools[bufferPoolHandle]);
+    }
+
+    /// <summary>
+    /// Creates a heightfield shape by copying height samples and optional per-cell flags into buffers allocated from a buffer pool.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate the heightfield's buffers from.</param>
+    /// <param name="samples">Height samples, row by row along X. Each sample is 4 bytes for Float32 samples and 2 bytes for UInt16 samples.</param>
+    /// <param name="cellFlags">One byte per cell, row by row along X, or an empty buffer if the heightfield has no holes or materials. Bit 0 marks a hole and the remaining bits hold a material index.</param>
+    /// <param name="sampleCountX">Number of samples along the local X axis.</param>
+    /// <param name="sampleCountZ">Number of samples along the local Z axis.</param>
+    /// <param name="sampleFormat">Storage format of the samples.</param>
+    /// <param name="cellSizeX">Distance between samples along the local X axis.</param>
+    /// <param name="cellSizeZ">Distance between samples along the local Z axis.</param>
+    /// <param name="heightScale">Multiplier applied to stored samples to get local heights.</param>
+    /// <param name="heightOffset">Offset added to scaled samples to get local heights.</param>
+    /// <returns>Created heightfield.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateHeightfield))]
+    public unsafe static Heightfield CreateHeightfield([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer")] Buffer<byte> samples, [TypeName("ByteBuffer")] Buffer<byte> cellFlags,
+        int sampleCountX, int sampleCountZ, HeightfieldSampleFormat sampleFormat, float cellSizeX, float cellSizeZ, float heightScale, float heightOffset)
+    {
+        return Heightfield.Create(samples, cellFlags, sampleCountX, sampleCountZ, sampleFormat, cellSizeX, cellSizeZ, heightScale, heightOffset, bufferPools[bufferPoolHandle]);
+    }
+
+    /// <summary>
+    /// Returns buffers allocated for a heightfield shape.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+    /// <param name="heightfield">Heightfield to destroy.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DestroyHeightfield))]
+    public unsafe static void DestroyHeightfield([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, Heightfield* heightfield)
+    {
+        heightfield->Dispose(bufferPools[bufferPoolHandle]);
+    }
+
+    /// <summary>
+    /// Creates a voxel grid shape. Occupancy is stored in sparse 8x8x8 bricks; only bricks containing occupied voxels take storage.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to allocate the voxel grid's buffers from.</param>
+    /// <param name="sizeX">Number of voxels along the local X axis.</param>
+    /// <param name="sizeY">Number of voxels along the local Y axis.</param>
+    /// <param name="sizeZ">Number of voxels along the local Z axis.</param>
+    /// <param name="voxelSize">Edge length of each voxel.</param>
+    /// <param name="occupiedVoxels">Coordinates of the voxels that start out occupied.</param>
+    /// <returns>Created voxel grid.</returns>
+    /// <remarks>The total number of voxels times 12 must fit in a 32 bit signed integer, since each voxel reserves 12 triangle child indices.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(CreateVoxelGrid))]
+    public unsafe static VoxelGrid CreateVoxelGrid([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, int sizeX, int sizeY, int sizeZ, float voxelSize, [TypeName("Buffer<Int3>")] Buffer<Int3> occupiedVoxels)
+    {
+        return VoxelGrid.Create(sizeX, sizeY, sizeZ, voxelSize, occupiedVoxels, bufferPools[bufferPoolHandle]);
+    }
+
+    /// <summary>
+    /// Returns buffers allocated for a voxel grid shape.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+    /// <param name="voxelGrid">Voxel grid to destroy.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(DestroyVoxelGrid))]
+    public unsafe static void DestroyVoxelGrid([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, VoxelGrid* voxelGrid)
+    {
+        voxelGrid->Dispose(bufferPools[bufferPoolHandle]);
+    }
+
+    /// <summary>
+    /// Sets the occupancy of voxels in a voxel grid that is not yet owned by a simulation.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool that the voxel grid's buffers were allocated from.</param>
+    /// <param name="voxelGrid">Voxel grid to edit.</param>
+    /// <param name="coordinates">Coordinates of the voxels to set.</param>
+    /// <param name="values">Occupancy of each voxel; nonzero values mark a voxel as occupied.</param>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetVoxelGridVoxels))]
+    public unsafe static void SetVoxelGridVoxels([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, VoxelGrid* voxelGrid, [TypeName("Buffer<Int3>")] Buffer<Int3> coordinates, [TypeName("ByteBuffer")] Buffer<byte> values)
+    {
+        voxelGrid->SetVoxels(coordinates, values, bufferPools[bufferPoolHandle]);
+    }
+
     /// <summary>
     /// Computes the inertia of a sphere.
     /// </summary>
@@ -492,4 +766,124 @@ public static partial class Entrypoints
     {
         return (Mesh*)Unsafe.AsPointer(ref simulations[simulationHandle].Shapes.GetShape<Mesh>(shape.Index));
     }
+
+    /// <summary>
+    /// Gets a pointer to a compressed mesh shape's data stored within the simulation's shapes buffers.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to pull the shape from.</param>
+    /// <param name="shape">Shape reference to request from the simulation.</param>
+    /// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetCompressedMeshShapeData))]
+    public unsafe static CompressedMesh* GetCompressedMeshShapeData([TypeName(SimulationName)] InstanceHandle simulationHandle, TypedIndex shape)
+    {
+        return (CompressedMesh*)Unsafe.AsPointer(ref simulations[simulationHandle].Shapes.GetShape<CompressedMesh>(shape.Index));
+    }
+
+    /// <summary>
+    /// Gets a pointer to a heightfield shape's data stored within the simulation's shapes buffers.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to pull the shape from.</param>
+    /// <param name="shape">Shape reference to request from the simulation.</param>
+    /// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetHeightfieldShapeData))]
+    public unsafe static Heightfield* GetHeightfieldShapeData([TypeName(SimulationName)] InstanceHandle simulationHandle, TypedIndex shape)
+    {
+        return (Heightfield*)Unsafe.AsPointer(ref simulations[simulationHandle].Shapes.GetShape<Heightfield>(shape.Index));
+    }
+
+    /// <summary>
+    /// Gets a pointer to a voxel grid shape's data stored within the simulation's shapes buffers.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation to pull the shape from.</param>
+    /// <param name="shape">Shape reference to request from the simulation.</param>
+    /// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetVoxelGridShapeData))]
+    public unsafe static VoxelGrid* GetVoxelGridShapeData([TypeName(SimulationName)] InstanceHandle simulationHandle, TypedIndex shape)
+    {
+        return (VoxelGrid*)Unsafe.AsPointer(ref simulations[simulationHandle].Shapes.GetShape<VoxelGrid>(shape.Index));
+    }
+
+    /// <summary>
+    /// Sets the occupancy of voxels in a voxel grid shape owned by a simulation. Only the bricks containing the listed voxels are touched.
+    /// </summary>
+    /// <param name="simulationHandle">Handle of the simulation owning the shape.</param>
+    /// <param name="shape">Voxel grid shape to edit.</param>
+    /// <param name="coordinates">Coordinates of the voxels to set.</param>
+    /// <param name="values">Occupancy of each voxel; nonzero values mark a voxel as occupied.</param>
+    /// <remarks>The grid's bounds cover all voxels whether occupied or not, so edits never require a bounds update. Edits do not wake sleeping bodies resting on the grid; wake them explicitly if removed voxels were supporting them. Bricks are allocated from and returned to the simulation's buffer pool, so the grid must have been created from that pool.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SetVoxels))]
+    public unsafe static void SetVoxels([TypeName(SimulationName)] InstanceHandle simulationHandle, TypedIndex shape,
+        [TypeName("Buffer<Int3>")] Buffer<Int3> coordinates, [TypeName("ByteBuffer")] Buffer<byte> values)
+    {
+        var simulation = simulations[simulationHandle];
+        if (shape.Type != VoxelGrid.Id)
+            throw new ArgumentException("Shape is not a voxel grid.");
+        simulation.Shapes.GetShape<VoxelGrid>(shape.Index).SetVoxels(coordinates, values, simulation.BufferPool);
+    }
+
+    /// <summary>
+    /// Loads a mesh, convex hull, or big compound from a shape asset file. Section contents are read straight into buffers taken from the pool with no further processing.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to take the shape's buffers from.</param>
+    /// <param name="path">Null terminated UTF8 path of the asset file.</param>
+    /// <param name="asset">Loaded shape. Zeroed if the load failed. Dispose it with the destroy function matching its shape type.</param>
+    /// <returns>True if the asset was loaded, false if the file could not be read or did not contain a valid asset for this platform.</returns>
+    /// <remarks>Big compound children are stored with the shape indices they had when saved. They must refer to the same shapes in the simulation that the compound is added to.</remarks>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(LoadShapeAsset))]
+    [return: TypeName("bool")]
+    public unsafe static byte LoadShapeAsset([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("const char*")] byte* path, ShapeAsset* asset)
+    {
+        return ShapeAssets.Read(Marshal.PtrToStringUTF8((IntPtr)path)!, bufferPools[bufferPoolHandle], out *asset) ? (byte)1 : (byte)0;
+    }
+
+    /// <summary>
+    /// Loads a mesh, convex hull, or big compound from a shape asset held in memory.
+    /// </summary>
+    /// <param name="bufferPoolHandle">Buffer pool to take the shape's buffers from.</param>
+    /// <param name="bytes">Memory containing the asset. Not retained by the loaded shape.</param>
+    /// <param name="asset">Loaded shape. Zeroed if the load failed. Dispose it with the destroy function matching its shape type.</param>
+    /// <returns>True if the asset was loaded, false if the memory did not contain a valid asset for this platform.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(LoadShapeAssetFromMemory))]
+    [return: TypeName("bool")]
+    public unsafe static byte LoadShapeAssetFromMemory([TypeName(BufferPoolName)] InstanceHandle bufferPoolHandle, [TypeName("ByteBuffer")] Buffer<byte> bytes, ShapeAsset* asset)
+    {
+        return ShapeAssets.Read(bytes, bufferPools[bufferPoolHandle], out *asset) ? (byte)1 : (byte)0;
+    }
+
+    /// <summary>
+    /// Saves a mesh, convex hull, or big compound to a shape asset file, replacing any existing file.
+    /// </summary>
+    /// <param name="asset">Shape to save. ShapeType selects which shape is read.</param>
+    /// <param name="path">Null terminated UTF8 path of the asset file.</param>
+    /// <returns>True if the asset was saved, false if the shape type is not supported or the file could not be written.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(SaveShapeAsset))]
+    [return: TypeName("bool")]
+    public unsafe static byte SaveShapeAsset(ShapeAsset* asset, [TypeName("const char*")] byte* path)
+    {
+        return ShapeAssets.Write(*asset, Marshal.PtrToStringUTF8((IntPtr)path)!) ? (byte)1 : (byte)0;
+    }
+
+    /// <summary>
+    /// Computes the number of bytes needed to store a shape as an asset.
+    /// </summary>
+    /// <param name="asset">Shape to measure. ShapeType selects which shape is read.</param>
+    /// <returns>Number of bytes needed to store the shape, or 0 if the shape type is not supported.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(GetShapeAssetByteCount))]
+    public unsafe static long GetShapeAssetByteCount(ShapeAsset* asset)
+    {
+        return ShapeAssets.GetByteCount(*asset);
+    }
+
+    /// <summary>
+    /// Writes a mesh, convex hull, or big compound into memory as a shape asset.
+    /// </summary>
+    /// <param name="asset">Shape to write. ShapeType selects which shape is read.</param>
+    /// <param name="bytes">Memory to write the asset into. Must hold at least GetShapeAssetByteCount bytes.</param>
+    /// <returns>True if the asset was written, false if the shape type is not supported or the memory is too small.</returns>
+    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) }, EntryPoint = FunctionNamePrefix + nameof(WriteShapeAsset))]
+    [return: TypeName("bool")]
+    public unsafe static byte WriteShapeAsset(ShapeAsset* asset, [TypeName("ByteBuffer")] Buffer<byte> bytes)
+    {
+        return ShapeAssets.Write(*asset, bytes) ? (byte)1 : (byte)0;
+    }
 }
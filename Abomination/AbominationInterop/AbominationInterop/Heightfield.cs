@@ -0,0 +1,393 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.CollisionDetection.CollisionTasks;
+using BepuPhysics.Trees;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Storage format of heightfield samples.
+/// </summary>
+public enum HeightfieldSampleFormat : int
+{
+    /// <summary>
+    /// 32 bit floating point samples.
+    /// </summary>
+    Float32 = 0,
+    /// <summary>
+    /// 16 bit unsigned integer samples.
+    /// </summary>
+    UInt16 = 1,
+}
+
+/// <summary>
+/// Regular grid of height samples in the local XZ plane, exposed to collision detection as two triangles per cell.
+/// </summary>
+/// <remarks>Sample (x, z) sits at local position (x * CellSizeX, HeightOffset + sample * HeightScale, z * CellSizeZ).
+/// Cell (x, z) spans samples x to x + 1 and z to z + 1, and its triangles are children 2 * (z * (SampleCountX - 1) + x) and that plus one.
+/// Overlap queries compute the touched cells directly from the query bounds; there is no acceleration structure.
+/// Triangles face +Y and, like mesh triangles, only collide from that side.</remarks>
+[StructLayout(LayoutKind.Sequential)]
+public unsafe struct Heightfield : IHomogeneousCompoundShape<Triangle, TriangleWide>
+{
+    /// <summary>
+    /// Bit set in <see cref="CellFlags"/> for cells with no surface.
+    /// </summary>
+    public const byte HoleFlag = 1;
+    /// <summary>
+    /// Number of bits that a cell's material is shifted by within <see cref="CellFlags"/>.
+    /// </summary>
+    public const int MaterialShift = 1;
+
+    /// <summary>
+    /// Height samples, row by row along X. Each sample is 4 bytes for <see cref="HeightfieldSampleFormat.Float32"/> and 2 bytes for <see cref="HeightfieldSampleFormat.UInt16"/>.
+    /// </summary>
+    public Buffer<byte> Samples;
+    /// <summary>
+    /// One byte per cell, row by row along X. Bit 0 marks a hole and the remaining bits hold a material index. Empty if the heightfield has no holes or materials.
+    /// </summary>
+    public Buffer<byte> CellFlags;
+    /// <summary>
+    /// Number of samples along the local X axis.
+    /// </summary>
+    public int SampleCountX;
+    /// <summary>
+    /// Number of samples along the local Z axis.
+    /// </summary>
+    public int SampleCountZ;
+    /// <summary>
+    /// Storage format of the samples.
+    /// </summary>
+    public HeightfieldSampleFormat SampleFormat;
+    /// <summary>
+    /// Distance between samples along the local X axis.
+    /// </summary>
+    public float CellSizeX;
+    /// <summary>
+    /// Distance between samples along the local Z axis.
+    /// </summary>
+    public float CellSizeZ;
+    /// <summary>
+    /// Multiplier applied to stored samples to get local heights.
+    /// </summary>
+    public float HeightScale;
+    /// <summary>
+    /// Offset added to scaled samples to get local heights.
+    /// </summary>
+    public float HeightOffset;
+    /// <summary>
+    /// Lowest local height of any sample.
+    /// </summary>
+    public float MinimumHeight;
+    /// <summary>
+    /// Highest local height of any sample.
+    /// </summary>
+    public float MaximumHeight;
+
+    /// <summary>
+    /// Type id of heightfield shapes.
+    /// </summary>
+    public const int Id = 10;
+    public static int TypeId => Id;
+
+    public static ShapeBatch CreateShapeBatch(BufferPool pool, int initialCapacity, Shapes shapeBatches)
+    {
+        return new HomogeneousCompoundShapeBatch<Heightfield, Triangle, TriangleWide>(pool, initialCapacity);
+    }
+
+    public readonly int CellCountX => SampleCountX - 1;
+    public readonly int CellCountZ => SampleCountZ - 1;
+    public readonly int ChildCount => CellCountX * CellCountZ * 2;
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public readonly float GetHeight(int x, int z)
+    {
+        var sampleIndex = z * SampleCountX + x;
+        var sample = SampleFormat == HeightfieldSampleFormat.Float32 ? ((float*)Samples.Memory)[sampleIndex] : ((ushort*)Samples.Memory)[sampleIndex];
+        return HeightOffset + sample * HeightScale;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public readonly bool IsHole(int cellIndex)
+    {
+        return CellFlags.Length > 0 && (CellFlags[cellIndex] & HoleFlag) != 0;
+    }
+
+    /// <summary>
+    /// Gets the material index of the cell containing a child triangle.
+    /// </summary>
+    /// <param name="childIndex">Index of the child triangle.</param>
+    /// <returns>Material index of the triangle's cell, or 0 if the heightfield has no cell flags.</returns>
+    public readonly int GetMaterial(int childIndex)
+    {
+        return CellFlags.Length > 0 ? CellFlags[childIndex >> 1] >> MaterialShift : 0;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    readonly Vector3 GetVertex(int x, int z)
+    {
+        return new Vector3(x * CellSizeX, GetHeight(x, z), z * CellSizeZ);
+    }
+
+    public readonly void GetLocalChild(int childIndex, out Triangle target)
+    {
+        var cellIndex = childIndex >> 1;
+        var cellCountX = CellCountX;
+        var z = cellIndex / cellCountX;
+        var x = cellIndex - z * cellCountX;
+        //The triangle normal is cross(C - A, B - A), so stepping +X for B and +Z for C makes both triangles face +Y.
+        if ((childIndex & 1) == 0)
+        {
+            target.A = GetVertex(x, z);
+            target.B = GetVertex(x + 1, z);
+            target.C = GetVertex(x, z + 1);
+        }
+        else
+        {
+            target.A = GetVertex(x + 1, z);
+            target.B = GetVertex(x + 1, z + 1);
+            target.C = GetVertex(x, z + 1);
+        }
+    }
+
+    public readonly void GetPosedLocalChild(int childIndex, out Triangle target, out RigidPose childPose)
+    {
+        GetLocalChild(childIndex, out target);
+        childPose.Orientation = Quaternion.Identity;
+        childPose.Position = (target.A + target.B + target.C) * (1f / 3f);
+        target.A -= childPose.Position;
+        target.B -= childPose.Position;
+        target.C -= childPose.Position;
+    }
+
+    public readonly void GetLocalChild(int childIndex, ref TriangleWide target)
+    {
+        //This inserts a triangle into the first slot of the given wide instance.
+        GetLocalChild(childIndex, out Triangle triangle);
+        Vector3Wide.WriteFirst(triangle.A, ref target.A);
+        Vector3Wide.WriteFirst(triangle.B, ref target.B);
+        Vector3Wide.WriteFirst(triangle.C, ref target.C);
+    }
+
+    public readonly void ComputeBounds(Quaternion orientation, out Vector3 min, out Vector3 max)
+    {
+        Matrix3x3.CreateFromQuaternion(orientation, out var rotation);
+        var extentX = CellCountX * CellSizeX;
+        var extentZ = CellCountZ * CellSizeZ;
+        min = new Vector3(float.MaxValue);
+        max = new Vector3(float.MinValue);
+        for (int i = 0; i < 8; ++i)
+        {
+            var corner = new Vector3((i & 1) == 0 ? 0 : extentX, (i & 2) == 0 ? MinimumHeight : MaximumHeight, (i & 4) == 0 ? 0 : extentZ);
+            Matrix3x3.Transform(corner, rotation, out var rotated);
+            min = Vector3.Min(min, rotated);
+            max = Vector3.Max(max, rotated);
+        }
+    }
+
+    readonly void GetOverlaps<TSubpairOverlaps>(Vector3 min, Vector3 max, BufferPool pool, ref TSubpairOverlaps overlaps) where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        if (max.Y < MinimumHeight || min.Y > MaximumHeight)
+            return;
+        var cellCountX = CellCountX;
+        var cellCountZ = CellCountZ;
+        //Clamp while still in float; huge or swept bounds would overflow the int conversion and skip every cell.
+        var minCellX = MathF.Floor(min.X / CellSizeX);
+        var minCellZ = MathF.Floor(min.Z / CellSizeZ);
+        var maxCellX = MathF.Floor(max.X / CellSizeX);
+        var maxCellZ = MathF.Floor(max.Z / CellSizeZ);
+        if (maxCellX < 0 || maxCellZ < 0 || minCellX > cellCountX - 1 || minCellZ > cellCountZ - 1)
+            return;
+        var minX = (int)MathF.Max(0, minCellX);
+        var minZ = (int)MathF.Max(0, minCellZ);
+        var maxX = (int)MathF.Min(cellCountX - 1, maxCellX);
+        var maxZ = (int)MathF.Min(cellCountZ - 1, maxCellZ);
+        for (int z = minZ; z <= maxZ; ++z)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                var cellIndex = z * cellCountX + x;
+                if (IsHole(cellIndex))
+                    continue;
+                var h00 = GetHeight(x, z);
+                var h01 = GetHeight(x, z + 1);
+                var h10 = GetHeight(x + 1, z);
+                var h11 = GetHeight(x + 1, z + 1);
+                if (MathF.Max(MathF.Max(h00, h01), MathF.Max(h10, h11)) < min.Y || MathF.Min(MathF.Min(h00, h01), MathF.Min(h10, h11)) > max.Y)
+                    continue;
+                overlaps.Allocate(pool) = cellIndex * 2;
+                overlaps.Allocate(pool) = cellIndex * 2 + 1;
+            }
+        }
+    }
+
+    public readonly void FindLocalOverlaps<TOverlaps, TSubpairOverlaps>(ref Buffer<OverlapQueryForPair> pairs, BufferPool pool, Shapes shapes, ref TOverlaps overlaps)
+        where TOverlaps : struct, ICollisionTaskOverlaps<TSubpairOverlaps>
+        where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        for (int i = 0; i < pairs.Length; ++i)
+        {
+            ref var pair = ref pairs[i];
+            Unsafe.AsRef<Heightfield>(pair.Container).GetOverlaps(pair.Min, pair.Max, pool, ref overlaps.GetOverlapsForPair(i));
+        }
+    }
+
+    public readonly void FindLocalOverlaps<TOverlaps>(Vector3 min, Vector3 max, Vector3 sweep, float maximumT, BufferPool pool, Shapes shapes, void* overlaps)
+        where TOverlaps : ICollisionTaskSubpairOverlaps
+    {
+        var sweepOffset = sweep * maximumT;
+        GetOverlaps(Vector3.Min(min, min + sweepOffset), Vector3.Max(max, max + sweepOffset), pool, ref Unsafe.AsRef<TOverlaps>(overlaps));
+    }
+
+    public readonly void RayTest<TRayHitHandler>(in RigidPose pose, in RayData ray, ref float maximumT, BufferPool pool, ref TRayHitHandler hitHandler) where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        var cellCountX = CellCountX;
+        var cellCountZ = CellCountZ;
+        if (cellCountX <= 0 || cellCountZ <= 0)
+            return;
+        Matrix3x3.CreateFromQuaternion(pose.Orientation, out var orientation);
+        Matrix3x3.TransformTranspose(ray.Origin - pose.Position, orientation, out var origin);
+        Matrix3x3.TransformTranspose(ray.Direction, orientation, out var direction);
+
+        //Clip the ray against the heightfield's local bounds, then walk the cells it crosses in the XZ plane in order of increasing t.
+        var boundsMax = new Vector3(cellCountX * CellSizeX, MaximumHeight, cellCountZ * CellSizeZ);
+        var inverseDirection = new Vector3(
+            direction.X != 0 ? 1f / direction.X : float.MaxValue,
+            direction.Y != 0 ? 1f / direction.Y : float.MaxValue,
+            direction.Z != 0 ? 1f / direction.Z : float.MaxValue);
+        var t0 = (new Vector3(0, MinimumHeight, 0) - origin) * inverseDirection;
+        var t1 = (boundsMax - origin) * inverseDirection;
+        var tMin = Vector3.Min(t0, t1);
+        var tMax = Vector3.Max(t0, t1);
+        var tEntry = MathF.Max(MathF.Max(tMin.X, tMin.Y), MathF.Max(tMin.Z, 0));
+        var tExit = MathF.Min(MathF.Min(tMax.X, tMax.Y), MathF.Min(tMax.Z, maximumT));
+        if (tEntry > tExit)
+            return;
+        var entry = origin + direction * tEntry;
+        var x = Math.Clamp((int)MathF.Floor(entry.X / CellSizeX), 0, cellCountX - 1);
+        var z = Math.Clamp((int)MathF.Floor(entry.Z / CellSizeZ), 0, cellCountZ - 1);
+        var stepX = direction.X > 0 ? 1 : -1;
+        var stepZ = direction.Z > 0 ? 1 : -1;
+        var tDeltaX = MathF.Abs(CellSizeX * inverseDirection.X);
+        var tDeltaZ = MathF.Abs(CellSizeZ * inverseDirection.Z);
+        var tNextX = direction.X != 0 ? ((x + (stepX > 0 ? 1 : 0)) * CellSizeX - origin.X) * inverseDirection.X : float.MaxValue;
+        var tNextZ = direction.Z != 0 ? ((z + (stepZ > 0 ? 1 : 0)) * CellSizeZ - origin.Z) * inverseDirection.Z : float.MaxValue;
+        while (true)
+        {
+            var cellIndex = z * cellCountX + x;
+            if (!IsHole(cellIndex))
+            {
+                for (int i = 0; i < 2; ++i)
+                {
+                    var childIndex = cellIndex * 2 + i;
+                    if (!hitHandler.AllowTest(childIndex))
+                        continue;
+                    GetLocalChild(childIndex, out Triangle triangle);
+                    if (Triangle.RayTest(triangle.A, triangle.B, triangle.C, origin, direction, out var t, out var normal) && t <= maximumT)
+                    {
+                        Matrix3x3.Transform(normal, orientation, out normal);
+                        hitHandler.OnRayHit(ray, ref maximumT, t, normal, childIndex);
+                    }
+                }
+            }
+            //Cells are visited in order, so nothing further along can beat a hit within the current cell.
+            var tCellExit = MathF.Min(tNextX, tNextZ);
+            if (tCellExit >= MathF.Min(tExit, maximumT))
+                break;
+            if (tNextX < tNextZ)
+            {
+                x += stepX;
+                tNextX += tDeltaX;
+                if (x < 0 || x >= cellCountX)
+                    break;
+            }
+            else
+            {
+                z += stepZ;
+                tNextZ += tDeltaZ;
+                if (z < 0 || z >= cellCountZ)
+                    break;
+            }
+        }
+    }
+
+    public readonly void RayTest<TRayHitHandler>(in RigidPose pose, ref RaySource rays, BufferPool pool, ref TRayHitHandler hitHandler) where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        for (int i = 0; i < rays.RayCount; ++i)
+        {
+            rays.GetRay(i, out var ray, out var maximumT);
+            RayTest(pose, *ray, ref *maximumT, pool, ref hitHandler);
+        }
+    }
+
+    public void Dispose(BufferPool pool)
+    {
+        pool.Return(ref Samples);
+        if (CellFlags.Allocated)
+            pool.Return(ref CellFlags);
+    }
+
+    /// <summary>
+    /// Creates a heightfield by copying samples and optional cell flags into buffers taken from a pool.
+    /// </summary>
+    /// <param name="samples">Height samples, row by row along X.</param>
+    /// <param name="cellFlags">One byte per cell, row by row along X, or an empty buffer if the heightfield has no holes or materials.</param>
+    /// <param name="sampleCountX">Number of samples along the local X axis.</param>
+    /// <param name="sampleCountZ">Number of samples along the local Z axis.</param>
+    /// <param name="sampleFormat">Storage format of the samples.</param>
+    /// <param name="cellSizeX">Distance between samples along the local X axis.</param>
+    /// <param name="cellSizeZ">Distance between samples along the local Z axis.</param>
+    /// <param name="heightScale">Multiplier applied to stored samples to get local heights.</param>
+    /// <param name="heightOffset">Offset added to scaled samples to get local heights.</param>
+    /// <param name="pool">Pool to allocate the heightfield's buffers from.</param>
+    /// <returns>Created heightfield.</returns>
+    public static Heightfield Create(Buffer<byte> samples, Buffer<byte> cellFlags, int sampleCountX, int sampleCountZ, HeightfieldSampleFormat sampleFormat,
+        float cellSizeX, float cellSizeZ, float heightScale, float heightOffset, BufferPool pool)
+    {
+        if (sampleCountX < 2 || sampleCountZ < 2)
+            throw new ArgumentException("Heightfields require at least two samples along each axis.");
+        if (!(cellSizeX > 0) || !(cellSizeZ > 0))
+            throw new ArgumentException("Heightfield cell sizes must be positive.");
+        var sampleSize = sampleFormat == HeightfieldSampleFormat.Float32 ? 4 : 2;
+        var sampleByteCount = sampleCountX * sampleCountZ * sampleSize;
+        if (samples.Length < sampleByteCount)
+            throw new ArgumentException($"Heightfield requires {sampleByteCount} bytes of samples, but only {samples.Length} were provided.");
+        var cellCount = (sampleCountX - 1) * (sampleCountZ - 1);
+        if (cellFlags.Length != 0 && cellFlags.Length < cellCount)
+            throw new ArgumentException($"Heightfield cell flags must be empty or hold one byte for each of the {cellCount} cells.");
+        Heightfield heightfield = default;
+        heightfield.SampleCountX = sampleCountX;
+        heightfield.SampleCountZ = sampleCountZ;
+        heightfield.SampleFormat = sampleFormat;
+        heightfield.CellSizeX = cellSizeX;
+        heightfield.CellSizeZ = cellSizeZ;
+        heightfield.HeightScale = heightScale;
+        heightfield.HeightOffset = heightOffset;
+        pool.Take(sampleByteCount, out heightfield.Samples);
+        samples.CopyTo(0, heightfield.Samples, 0, sampleByteCount);
+        if (cellFlags.Length > 0)
+        {
+            pool.Take(cellCount, out heightfield.CellFlags);
+            cellFlags.CopyTo(0, heightfield.CellFlags, 0, cellCount);
+        }
+        heightfield.MinimumHeight = float.MaxValue;
+        heightfield.MaximumHeight = float.MinValue;
+        for (int z = 0; z < sampleCountZ; ++z)
+        {
+            for (int x = 0; x < sampleCountX; ++x)
+            {
+                var height = heightfield.GetHeight(x, z);
+                heightfield.MinimumHeight = MathF.Min(heightfield.MinimumHeight, height);
+                heightfield.MaximumHeight = MathF.Max(heightfield.MaximumHeight, height);
+            }
+        }
+        return heightfield;
+    }
+}
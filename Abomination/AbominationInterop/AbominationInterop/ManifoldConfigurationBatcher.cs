@@ -0,0 +1,249 @@
+﻿using BepuPhysics;
+using BepuPhysics.CollisionDetection;
+using BepuUtilities;
+using BepuUtilities.Collections;
+using BepuUtilities.Memory;
+using System;
+using System.Runtime.CompilerServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Replaces per pair manifold configuration calls with chunked calls into a native batched configuration function.
+/// </summary>
+/// <remarks>The engine creates a pair's constraint as soon as its configuration callback returns, so a pair's answer can't wait for a chunk to fill.
+/// Pairs seen for the first time are configured immediately in a batch of one, which costs one interop call per new pair. Pairs that persisted from the previous step reuse that step's answer,
+/// and their manifolds are collected per worker and handed to the native side in chunks once collision detection completes.
+/// A persistent pair's accept flag and material therefore take effect one step late: rejecting it still leaves this step's constraint in place.
+/// Manifolds are read only to the native side. Persistent pairs can only be sent copies taken after their constraints were built, so edits could never apply to them; contact edits need the per pair callbacks instead.</remarks>
+public unsafe class ManifoldConfigurationBatcher
+{
+    struct PairDecision
+    {
+        public PairMaterialProperties Material;
+        public byte Accept;
+    }
+
+    struct PendingPair
+    {
+        public CollidablePair Pair;
+        public PairDecision Decision;
+        public int ManifoldIndex;
+        public byte Convex;
+    }
+
+    struct DecidedPair
+    {
+        public CollidablePair Pair;
+        public PairDecision Decision;
+    }
+
+    struct WorkerPairs
+    {
+        //Persistent pairs waiting to be sent in chunks.
+        public QuickList<PendingPair> Pairs;
+        //New pairs that were already configured during the narrow phase; they're only kept so next step can reuse their answers.
+        public QuickList<DecidedPair> DecidedPairs;
+        public QuickList<ConvexContactManifold> ConvexManifolds;
+        public QuickList<NonconvexContactManifold> NonconvexManifolds;
+    }
+
+    delegate* unmanaged<InstanceHandle, int, int, CollidablePair*, ConvexContactManifold**, NonconvexContactManifold**, PairMaterialProperties*, byte*, void> configureFunction;
+    int batchSize;
+    InstanceHandle simulationHandle;
+    Simulation? simulation;
+    DefaultTimestepper? timestepper;
+    QuickDictionary<CollidablePair, PairDecision, CollidablePairComparer> decisions;
+    BufferPool?[] workerPools = Array.Empty<BufferPool>();
+    Buffer<WorkerPairs> workers;
+    int workerCount;
+
+    /// <summary>
+    /// Number of pairs the native side receives per call when none is specified.
+    /// </summary>
+    public const int DefaultBatchSize = 64;
+
+    public ManifoldConfigurationBatcher(delegate* unmanaged<InstanceHandle, int, int, CollidablePair*, ConvexContactManifold**, NonconvexContactManifold**, PairMaterialProperties*, byte*, void> configureFunction, int batchSize)
+    {
+        if (configureFunction == null)
+            throw new ArgumentNullException(nameof(configureFunction));
+        this.configureFunction = configureFunction;
+        this.batchSize = batchSize > 0 ? batchSize : DefaultBatchSize;
+    }
+
+    /// <summary>
+    /// Hooks the batcher into the simulation's timestepper.
+    /// </summary>
+    /// <param name="simulation">Simulation whose manifolds are configured.</param>
+    /// <param name="simulationHandle">Handle passed to the native configuration function.</param>
+    public void Attach(Simulation simulation, InstanceHandle simulationHandle)
+    {
+        this.simulation = simulation;
+        this.simulationHandle = simulationHandle;
+        timestepper = simulation.Timestepper as DefaultTimestepper ?? throw new InvalidOperationException("Batched manifold configuration requires the default timestepper.");
+        timestepper.BeforeCollisionDetection += OnBeforeCollisionDetection;
+        timestepper.CollisionsDetected += OnCollisionsDetected;
+        decisions = new QuickDictionary<CollidablePair, PairDecision, CollidablePairComparer>(64, simulation.BufferPool);
+    }
+
+    /// <summary>
+    /// Configures a pair's manifold from the last known answer for the pair, or asks the native side immediately if the pair is new. Called from the narrow phase callbacks on any worker.
+    /// </summary>
+    public bool Configure<TManifold>(int workerIndex, CollidablePair pair, ref TManifold manifold, out PairMaterialProperties pairMaterial) where TManifold : unmanaged, IContactManifold<TManifold>
+    {
+        var convex = typeof(TManifold) == typeof(ConvexContactManifold);
+        ref var worker = ref workers[workerIndex];
+        var pool = workerPools[workerIndex]!;
+        if (decisions.TryGetValue(ref pair, out var decision))
+        {
+            ref var pending = ref worker.Pairs.Allocate(pool);
+            pending.Pair = pair;
+            pending.Decision = decision;
+            pending.Convex = convex ? (byte)1 : (byte)0;
+            //The manifold only lives until this returns, so the chunk sent later gets a copy.
+            if (convex)
+            {
+                pending.ManifoldIndex = worker.ConvexManifolds.Count;
+                worker.ConvexManifolds.Allocate(pool) = Unsafe.As<TManifold, ConvexContactManifold>(ref manifold);
+            }
+            else
+            {
+                pending.ManifoldIndex = worker.NonconvexManifolds.Count;
+                worker.NonconvexManifolds.Allocate(pool) = Unsafe.As<TManifold, NonconvexContactManifold>(ref manifold);
+            }
+        }
+        else
+        {
+            //No previous answer exists; the pair's constraint is about to be created, so it has to be asked now.
+            //Note that the manifold reference is safe to convert; it originates on the stack or in pinned memory.
+            var manifoldPointer = Unsafe.AsPointer(ref manifold);
+            var convexPointer = convex ? (ConvexContactManifold*)manifoldPointer : null;
+            var nonconvexPointer = convex ? null : (NonconvexContactManifold*)manifoldPointer;
+            decision.Material = default;
+            decision.Accept = 0;
+            configureFunction(simulationHandle, workerIndex, 1, &pair, &convexPointer, &nonconvexPointer, &decision.Material, &decision.Accept);
+            ref var decided = ref worker.DecidedPairs.Allocate(pool);
+            decided.Pair = pair;
+            decided.Decision = decision;
+        }
+        pairMaterial = decision.Material;
+        return decision.Accept != 0;
+    }
+
+    void OnBeforeCollisionDetection(float dt, IThreadDispatcher threadDispatcher)
+    {
+        var pool = simulation!.BufferPool;
+        workerCount = threadDispatcher == null ? 1 : threadDispatcher.ThreadCount;
+        if (workerPools.Length < workerCount)
+            workerPools = new BufferPool[workerCount];
+        if (workers.Length < workerCount)
+            pool.ResizeToAtLeast(ref workers, workerCount, 0);
+        for (int i = 0; i < workerCount; ++i)
+        {
+            var workerPool = threadDispatcher == null ? pool : threadDispatcher.WorkerPools[i];
+            workerPools[i] = workerPool;
+            ref var worker = ref workers[i];
+            worker.Pairs = new QuickList<PendingPair>(batchSize, workerPool);
+            worker.DecidedPairs = new QuickList<DecidedPair>(16, workerPool);
+            worker.ConvexManifolds = new QuickList<ConvexContactManifold>(batchSize, workerPool);
+            worker.NonconvexManifolds = new QuickList<NonconvexContactManifold>(16, workerPool);
+        }
+    }
+
+    void ConfigureWorkerPairs(int workerIndex)
+    {
+        ref var worker = ref workers[workerIndex];
+        var pool = workerPools[workerIndex]!;
+        pool.Take<CollidablePair>(batchSize, out var pairs);
+        pool.Take<IntPtr>(batchSize, out var convexManifolds);
+        pool.Take<IntPtr>(batchSize, out var nonconvexManifolds);
+        pool.Take<PairMaterialProperties>(batchSize, out var materials);
+        pool.Take<byte>(batchSize, out var accepts);
+        pool.Take<int>(batchSize, out var pendingIndices);
+        int count = 0;
+        for (int i = 0; i <= worker.Pairs.Count; ++i)
+        {
+            if (count == batchSize || (i == worker.Pairs.Count && count > 0))
+            {
+                configureFunction(simulationHandle, workerIndex, count, pairs.Memory, (ConvexContactManifold**)convexManifolds.Memory, (NonconvexContactManifold**)nonconvexManifolds.Memory, materials.Memory, accepts.Memory);
+                for (int j = 0; j < count; ++j)
+                {
+                    ref var decision = ref worker.Pairs[pendingIndices[j]].Decision;
+                    decision.Material = materials[j];
+                    decision.Accept = accepts[j];
+                }
+                count = 0;
+            }
+            if (i == worker.Pairs.Count)
+                break;
+            ref var pending = ref worker.Pairs[i];
+            pairs[count] = pending.Pair;
+            convexManifolds[count] = pending.Convex != 0 ? (IntPtr)Unsafe.AsPointer(ref worker.ConvexManifolds[pending.ManifoldIndex]) : IntPtr.Zero;
+            nonconvexManifolds[count] = pending.Convex != 0 ? IntPtr.Zero : (IntPtr)Unsafe.AsPointer(ref worker.NonconvexManifolds[pending.ManifoldIndex]);
+            //The native side overwrites these; seed them with the answers already in use so a function that only inspects some pairs leaves the rest alone.
+            materials[count] = pending.Decision.Material;
+            accepts[count] = pending.Decision.Accept;
+            pendingIndices[count] = i;
+            ++count;
+        }
+        pool.Return(ref pairs);
+        pool.Return(ref convexManifolds);
+        pool.Return(ref nonconvexManifolds);
+        pool.Return(ref materials);
+        pool.Return(ref accepts);
+        pool.Return(ref pendingIndices);
+    }
+
+    void OnCollisionsDetected(float dt, IThreadDispatcher threadDispatcher)
+    {
+        //Each worker's pairs live in that worker's pool, so the chunks are configured on the worker that collected them.
+        if (threadDispatcher == null || workerCount == 1)
+            ConfigureWorkerPairs(0);
+        else
+            threadDispatcher.DispatchWorkers(ConfigureWorkerPairs, workerCount);
+
+        //Pairs that weren't seen this step no longer have manifolds; rebuilding the table from this step's pairs drops them.
+        var pool = simulation!.BufferPool;
+        int pairCount = 0;
+        for (int i = 0; i < workerCount; ++i)
+            pairCount += workers[i].Pairs.Count + workers[i].DecidedPairs.Count;
+        var nextDecisions = new QuickDictionary<CollidablePair, PairDecision, CollidablePairComparer>(Math.Max(64, pairCount), pool);
+        for (int i = 0; i < workerCount; ++i)
+        {
+            ref var worker = ref workers[i];
+            for (int j = 0; j < worker.Pairs.Count; ++j)
+            {
+                ref var pending = ref worker.Pairs[j];
+                nextDecisions.AddOrUpdate(ref pending.Pair, pending.Decision, pool);
+            }
+            for (int j = 0; j < worker.DecidedPairs.Count; ++j)
+            {
+                ref var decided = ref worker.DecidedPairs[j];
+                nextDecisions.AddOrUpdate(ref decided.Pair, decided.Decision, pool);
+            }
+            var workerPool = workerPools[i]!;
+            worker.Pairs.Dispose(workerPool);
+            worker.DecidedPairs.Dispose(workerPool);
+            worker.ConvexManifolds.Dispose(workerPool);
+            worker.NonconvexManifolds.Dispose(workerPool);
+            workerPools[i] = null;
+        }
+        decisions.Dispose(pool);
+        decisions = nextDecisions;
+    }
+
+    /// <summary>
+    /// Unhooks the batcher from the simulation and returns its resources.
+    /// </summary>
+    public void Dispose()
+    {
+        if (simulation == null)
+            return;
+        timestepper!.BeforeCollisionDetection -= OnBeforeCollisionDetection;
+        timestepper.CollisionsDetected -= OnCollisionsDetected;
+        decisions.Dispose(simulation.BufferPool);
+        if (workers.Allocated)
+            simulation.BufferPool.Return(ref workers);
+        simulation = null;
+    }
+}
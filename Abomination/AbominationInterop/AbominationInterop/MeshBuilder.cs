@@ -0,0 +1,480 @@
+﻿using BepuPhysics.Collidables;
+using BepuPhysics.Trees;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Collections.Generic;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Strategy used to build a mesh's acceleration structure.
+/// </summary>
+public enum MeshBuildMode : int
+{
+    /// <summary>
+    /// Top-down build choosing splits with a binned surface area heuristic. Slower to build, faster to query.
+    /// </summary>
+    BinnedSAH = 0,
+    /// <summary>
+    /// Builds the tree by splitting triangles sorted along a Morton curve. Much faster to build, somewhat slower to query.
+    /// </summary>
+    Morton = 1,
+}
+
+/// <summary>
+/// Options for building a mesh's acceleration structure.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct MeshBuildOptions
+{
+    /// <summary>
+    /// Strategy used to build the tree.
+    /// </summary>
+    public MeshBuildMode Mode;
+    /// <summary>
+    /// Number of bins considered per node by the binned SAH build. Values below 2 use the default of 16. Ignored by Morton builds.
+    /// </summary>
+    public int BinCount;
+}
+
+/// <summary>
+/// Builds mesh acceleration structures, or rebuilds other trees over leaf bounds, using the workers of a thread dispatcher.
+/// </summary>
+/// <remarks>A subtree with n leaves always occupies n - 1 consecutive nodes, so every subtree's node range is known as soon as its leaf count is chosen.
+/// That lets independent subtrees be built on different workers without any synchronization beyond handing out jobs.</remarks>
+public unsafe class MeshBuilder
+{
+    const int DefaultBinCount = 16;
+    const int MaximumBinCount = 64;
+    const int PrepassChunkSize = 16384;
+
+    struct BuildJob
+    {
+        public int Start;
+        public int Count;
+        public int NodeIndex;
+    }
+
+    Buffer<Triangle> triangles;
+    //Bounds of each leaf when building over arbitrary bounding boxes rather than triangles.
+    Buffer<BoundingBox> leafBounds;
+    int leafCount;
+    Tree tree;
+    Buffer<int> leafIndices;
+    //Morton codes of the leaves, in the same order as leafIndices. Only used by Morton builds.
+    Buffer<uint> mortonCodes;
+    Buffer<ulong> mortonKeys;
+    MeshBuildMode mode;
+    int binCount;
+
+    Buffer<Vector3> sourceVertices;
+    Buffer<int> sourceIndices;
+    Vector3 centroidMin, centroidMax;
+    SpinLock centroidBoundsLock;
+    int prepassChunkIndex;
+
+    List<BuildJob> pendingJobs = new();
+    int pendingJobIndex;
+
+    static void Dispatch(IThreadDispatcher? threadDispatcher, Action<int> workerBody)
+    {
+        if (threadDispatcher == null)
+            workerBody(0);
+        else
+            threadDispatcher.DispatchWorkers(workerBody);
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    void GetBounds(int leafIndex, out Vector3 min, out Vector3 max)
+    {
+        if (leafBounds.Allocated)
+        {
+            ref var bounds = ref leafBounds[leafIndex];
+            min = bounds.Min;
+            max = bounds.Max;
+            return;
+        }
+        ref var triangle = ref triangles[leafIndex];
+        min = Vector3.Min(triangle.A, Vector3.Min(triangle.B, triangle.C));
+        max = Vector3.Max(triangle.A, Vector3.Max(triangle.B, triangle.C));
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    static float ComputeBoundsMetric(Vector3 min, Vector3 max)
+    {
+        var span = max - min;
+        return span.X * span.Y + span.Y * span.Z + span.Z * span.X;
+    }
+
+    void ComputeBounds(int start, int count, out Vector3 min, out Vector3 max)
+    {
+        min = new Vector3(float.MaxValue);
+        max = new Vector3(float.MinValue);
+        for (int i = start; i < start + count; ++i)
+        {
+            GetBounds(leafIndices[i], out var leafMin, out var leafMax);
+            min = Vector3.Min(min, leafMin);
+            max = Vector3.Max(max, leafMax);
+        }
+    }
+
+    void PrepassWorker(int workerIndex)
+    {
+        var localMin = new Vector3(float.MaxValue);
+        var localMax = new Vector3(float.MinValue);
+        int chunkIndex;
+        while ((chunkIndex = Interlocked.Increment(ref prepassChunkIndex)) * PrepassChunkSize < leafCount)
+        {
+            var start = chunkIndex * PrepassChunkSize;
+            var end = Math.Min(start + PrepassChunkSize, leafCount);
+            for (int i = start; i < end; ++i)
+            {
+                if (sourceIndices.Allocated)
+                {
+                    ref var triangle = ref triangles[i];
+                    triangle.A = sourceVertices[sourceIndices[i * 3]];
+                    triangle.B = sourceVertices[sourceIndices[i * 3 + 1]];
+                    triangle.C = sourceVertices[sourceIndices[i * 3 + 2]];
+                }
+                leafIndices[i] = i;
+                GetBounds(i, out var min, out var max);
+                var centroid = (min + max) * 0.5f;
+                localMin = Vector3.Min(localMin, centroid);
+                localMax = Vector3.Max(localMax, centroid);
+            }
+        }
+        bool taken = false;
+        centroidBoundsLock.Enter(ref taken);
+        centroidMin = Vector3.Min(centroidMin, localMin);
+        centroidMax = Vector3.Max(centroidMax, localMax);
+        centroidBoundsLock.Exit();
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    static uint SpreadBits(uint value)
+    {
+        //Spaces the low 10 bits of the value out so that two zero bits separate each one.
+        value = (value | (value << 16)) & 0x030000FF;
+        value = (value | (value << 8)) & 0x0300F00F;
+        value = (value | (value << 4)) & 0x030C30C3;
+        value = (value | (value << 2)) & 0x09249249;
+        return value;
+    }
+
+    void MortonCodeWorker(int workerIndex)
+    {
+        var span = centroidMax - centroidMin;
+        var scale = new Vector3(
+            span.X > 0 ? 1023f / span.X : 0,
+            span.Y > 0 ? 1023f / span.Y : 0,
+            span.Z > 0 ? 1023f / span.Z : 0);
+        int chunkIndex;
+        while ((chunkIndex = Interlocked.Increment(ref prepassChunkIndex)) * PrepassChunkSize < leafCount)
+        {
+            var start = chunkIndex * PrepassChunkSize;
+            var end = Math.Min(start + PrepassChunkSize, leafCount);
+            for (int i = start; i < end; ++i)
+            {
+                GetBounds(i, out var min, out var max);
+                var quantized = ((min + max) * 0.5f - centroidMin) * scale;
+                var code = (SpreadBits((uint)quantized.X) << 2) | (SpreadBits((uint)quantized.Y) << 1) | SpreadBits((uint)quantized.Z);
+                mortonKeys[i] = ((ulong)code << 32) | (uint)i;
+            }
+        }
+    }
+
+    void WriteChild(int nodeIndex, int childIndex, int start, int count, Vector3 min, Vector3 max)
+    {
+        ref var node = ref tree.Nodes[nodeIndex];
+        ref var child = ref childIndex == 0 ? ref node.A : ref node.B;
+        child.Min = min;
+        child.Max = max;
+        child.LeafCount = count;
+        if (count == 1)
+        {
+            //Leaves are encoded as -1 - leafIndex in the child index. Internal children are pointed at by SplitJob once their node index is known.
+            var leafIndex = leafIndices[start];
+            child.Index = -1 - leafIndex;
+            tree.Leaves[leafIndex] = new Leaf(nodeIndex, childIndex);
+        }
+    }
+
+    int SplitMorton(int start, int count)
+    {
+        var firstCode = mortonCodes[start];
+        var lastCode = mortonCodes[start + count - 1];
+        if (firstCode == lastCode)
+            return count / 2;
+        //Split where the highest bit that differs across the range flips. Codes are sorted, so that's a single transition found by binary search.
+        var bit = 1u << (31 - BitOperations.LeadingZeroCount(firstCode ^ lastCode));
+        int low = start, high = start + count - 1;
+        while (low < high)
+        {
+            var mid = (low + high) >> 1;
+            if ((mortonCodes[mid] & bit) != 0)
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        return low - start;
+    }
+
+    int SplitBinned(int start, int count)
+    {
+        var centroidBoundsMin = new Vector3(float.MaxValue);
+        var centroidBoundsMax = new Vector3(float.MinValue);
+        for (int i = start; i < start + count; ++i)
+        {
+            GetBounds(leafIndices[i], out var min, out var max);
+            var centroid = (min + max) * 0.5f;
+            centroidBoundsMin = Vector3.Min(centroidBoundsMin, centroid);
+            centroidBoundsMax = Vector3.Max(centroidBoundsMax, centroid);
+        }
+        var span = centroidBoundsMax - centroidBoundsMin;
+        int axis = span.X > span.Y ? (span.X > span.Z ? 0 : 2) : (span.Y > span.Z ? 1 : 2);
+        var axisMin = axis == 0 ? centroidBoundsMin.X : axis == 1 ? centroidBoundsMin.Y : centroidBoundsMin.Z;
+        var axisSpan = axis == 0 ? span.X : axis == 1 ? span.Y : span.Z;
+        if (!(axisSpan > 0))
+            return count / 2;
+
+        var bins = Math.Min(binCount, count);
+        var binMins = stackalloc Vector3[bins];
+        var binMaxes = stackalloc Vector3[bins];
+        var binCounts = stackalloc int[bins];
+        var rightMetrics = stackalloc float[bins];
+        for (int i = 0; i < bins; ++i)
+        {
+            binMins[i] = new Vector3(float.MaxValue);
+            binMaxes[i] = new Vector3(float.MinValue);
+            binCounts[i] = 0;
+        }
+        var binScale = bins / axisSpan;
+        for (int i = start; i < start + count; ++i)
+        {
+            GetBounds(leafIndices[i], out var min, out var max);
+            var centroid = (min + max) * 0.5f;
+            var binIndex = Math.Min(bins - 1, (int)(((axis == 0 ? centroid.X : axis == 1 ? centroid.Y : centroid.Z) - axisMin) * binScale));
+            binMins[binIndex] = Vector3.Min(binMins[binIndex], min);
+            binMaxes[binIndex] = Vector3.Max(binMaxes[binIndex], max);
+            ++binCounts[binIndex];
+        }
+
+        //Sweep from the right to get the cost of every right side, then from the left to pick the cheapest split.
+        var accumulatedMin = new Vector3(float.MaxValue);
+        var accumulatedMax = new Vector3(float.MinValue);
+        int accumulatedCount = 0;
+        for (int i = bins - 1; i > 0; --i)
+        {
+            accumulatedMin = Vector3.Min(accumulatedMin, binMins[i]);
+            accumulatedMax = Vector3.Max(accumulatedMax, binMaxes[i]);
+            accumulatedCount += binCounts[i];
+            rightMetrics[i] = accumulatedCount > 0 ? ComputeBoundsMetric(accumulatedMin, accumulatedMax) * accumulatedCount : 0;
+        }
+        accumulatedMin = new Vector3(float.MaxValue);
+        accumulatedMax = new Vector3(float.MinValue);
+        accumulatedCount = 0;
+        var bestCost = float.MaxValue;
+        var bestSplit = bins / 2;
+        for (int split = 1; split < bins; ++split)
+        {
+            accumulatedMin = Vector3.Min(accumulatedMin, binMins[split - 1]);
+            accumulatedMax = Vector3.Max(accumulatedMax, binMaxes[split - 1]);
+            accumulatedCount += binCounts[split - 1];
+            if (accumulatedCount == 0 || accumulatedCount == count)
+                continue;
+            var cost = ComputeBoundsMetric(accumulatedMin, accumulatedMax) * accumulatedCount + rightMetrics[split];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = split;
+            }
+        }
+
+        //Partition the leaves in place so that bins below the split come first.
+        int low = start, high = start + count - 1;
+        while (low <= high)
+        {
+            GetBounds(leafIndices[low], out var min, out var max);
+            var centroid = (min + max) * 0.5f;
+            var binIndex = Math.Min(bins - 1, (int)(((axis == 0 ? centroid.X : axis == 1 ? centroid.Y : centroid.Z) - axisMin) * binScale));
+            if (binIndex < bestSplit)
+            {
+                ++low;
+            }
+            else
+            {
+                (leafIndices[low], leafIndices[high]) = (leafIndices[high], leafIndices[low]);
+                --high;
+            }
+        }
+        var leftCount = low - start;
+        return leftCount == 0 || leftCount == count ? count / 2 : leftCount;
+    }
+
+    void SplitJob(in BuildJob job, out BuildJob left, out BuildJob right)
+    {
+        var leftCount = mode == MeshBuildMode.Morton ? SplitMorton(job.Start, job.Count) : SplitBinned(job.Start, job.Count);
+        var rightCount = job.Count - leftCount;
+        left = new BuildJob { Start = job.Start, Count = leftCount, NodeIndex = job.NodeIndex + 1 };
+        right = new BuildJob { Start = job.Start + leftCount, Count = rightCount, NodeIndex = job.NodeIndex + leftCount };
+        ComputeBounds(left.Start, left.Count, out var leftMin, out var leftMax);
+        ComputeBounds(right.Start, right.Count, out var rightMin, out var rightMax);
+        WriteChild(job.NodeIndex, 0, left.Start, left.Count, leftMin, leftMax);
+        WriteChild(job.NodeIndex, 1, right.Start, right.Count, rightMin, rightMax);
+        ref var node = ref tree.Nodes[job.NodeIndex];
+        if (leftCount > 1)
+        {
+            node.A.Index = left.NodeIndex;
+            ref var metanode = ref tree.Metanodes[left.NodeIndex];
+            metanode.Parent = job.NodeIndex;
+            metanode.IndexInParent = 0;
+        }
+        if (rightCount > 1)
+        {
+            node.B.Index = right.NodeIndex;
+            ref var metanode = ref tree.Metanodes[right.NodeIndex];
+            metanode.Parent = job.NodeIndex;
+            metanode.IndexInParent = 1;
+        }
+    }
+
+    void BuildWorker(int workerIndex)
+    {
+        var stack = new Stack<BuildJob>();
+        int jobIndex;
+        while ((jobIndex = Interlocked.Increment(ref pendingJobIndex)) < pendingJobs.Count)
+        {
+            stack.Push(pendingJobs[jobIndex]);
+            while (stack.TryPop(out var job))
+            {
+                SplitJob(job, out var left, out var right);
+                if (left.Count > 1)
+                    stack.Push(left);
+                if (right.Count > 1)
+                    stack.Push(right);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Builds a mesh over the given triangles.
+    /// </summary>
+    /// <param name="triangles">Triangles of the mesh. If vertices and indices are provided, this buffer is filled from them. Ownership transfers to the mesh.</param>
+    /// <param name="vertices">Vertices referenced by the indices, or an empty buffer if the triangles are already filled.</param>
+    /// <param name="indices">Three vertex indices per triangle, or an empty buffer if the triangles are already filled.</param>
+    /// <param name="scale">Scale of the mesh.</param>
+    /// <param name="pool">Pool to allocate the tree and temporary resources from.</param>
+    /// <param name="threadDispatcher">Dispatcher to distribute the build over, if any.</param>
+    /// <param name="options">Build options.</param>
+    /// <returns>Constructed mesh.</returns>
+    public static Mesh Build(Buffer<Triangle> triangles, Buffer<Vector3> vertices, Buffer<int> indices, Vector3 scale, BufferPool pool, IThreadDispatcher? threadDispatcher, MeshBuildOptions options)
+    {
+        if (triangles.Length <= 0)
+            throw new ArgumentException("Meshes require at least one triangle.");
+        var builder = new MeshBuilder
+        {
+            triangles = triangles,
+            sourceVertices = vertices,
+            sourceIndices = indices,
+            mode = options.Mode,
+            binCount = options.BinCount < 2 ? DefaultBinCount : Math.Min(options.BinCount, MaximumBinCount),
+            centroidMin = new Vector3(float.MaxValue),
+            centroidMax = new Vector3(float.MinValue),
+            leafCount = triangles.Length,
+            tree = new Tree(pool, triangles.Length),
+        };
+        builder.BuildNodes(pool, threadDispatcher);
+        return new Mesh { Triangles = triangles, Tree = builder.tree, Scale = scale };
+    }
+
+    /// <summary>
+    /// Rebuilds the nodes of an existing tree over the given leaf bounds. Leaf indices are preserved, so anything mapping leaves to external data stays valid.
+    /// </summary>
+    /// <param name="tree">Tree to rebuild. Its leaf count must match the number of leaf bounds, and its node buffers must already hold enough capacity for that many leaves.</param>
+    /// <param name="leafBounds">Bounds of each leaf, indexed by leaf index.</param>
+    /// <param name="pool">Pool to allocate temporary resources from.</param>
+    /// <param name="threadDispatcher">Dispatcher to distribute the build over, if any.</param>
+    /// <param name="options">Build options.</param>
+    public static void Rebuild(ref Tree tree, Buffer<BoundingBox> leafBounds, BufferPool pool, IThreadDispatcher? threadDispatcher, MeshBuildOptions options)
+    {
+        if (leafBounds.Length <= 0 || leafBounds.Length != tree.LeafCount)
+            throw new ArgumentException("Leaf bounds must be provided for every leaf of the tree.");
+        var builder = new MeshBuilder
+        {
+            leafBounds = leafBounds,
+            leafCount = leafBounds.Length,
+            mode = options.Mode,
+            binCount = options.BinCount < 2 ? DefaultBinCount : Math.Min(options.BinCount, MaximumBinCount),
+            centroidMin = new Vector3(float.MaxValue),
+            centroidMax = new Vector3(float.MinValue),
+            tree = tree,
+        };
+        //Metanodes carry refinement state that only makes sense for the old topology.
+        tree.Metanodes.Clear(0, Math.Max(1, leafBounds.Length - 1));
+        builder.BuildNodes(pool, threadDispatcher);
+        tree.NodeCount = builder.tree.NodeCount;
+    }
+
+    void BuildNodes(BufferPool pool, IThreadDispatcher? threadDispatcher)
+    {
+        pool.Take(leafCount, out leafIndices);
+
+        prepassChunkIndex = -1;
+        Dispatch(threadDispatcher, PrepassWorker);
+        if (mode == MeshBuildMode.Morton)
+        {
+            pool.Take(leafCount, out mortonKeys);
+            prepassChunkIndex = -1;
+            Dispatch(threadDispatcher, MortonCodeWorker);
+            new Span<ulong>(mortonKeys.Memory, leafCount).Sort();
+            pool.Take(leafCount, out mortonCodes);
+            for (int i = 0; i < leafCount; ++i)
+            {
+                var key = mortonKeys[i];
+                leafIndices[i] = (int)(uint)key;
+                mortonCodes[i] = (uint)(key >> 32);
+            }
+            pool.Return(ref mortonKeys);
+        }
+
+        ref var rootMetanode = ref tree.Metanodes[0];
+        rootMetanode.Parent = -1;
+        rootMetanode.IndexInParent = -1;
+        if (leafCount == 1)
+        {
+            GetBounds(0, out var min, out var max);
+            tree.Nodes[0] = default;
+            WriteChild(0, 0, 0, 1, min, max);
+        }
+        else
+        {
+            //Split the top of the tree on this thread until there are enough independent subtrees to keep every worker busy.
+            var targetJobCount = threadDispatcher == null ? 1 : threadDispatcher.ThreadCount * 8;
+            var frontier = new Queue<BuildJob>();
+            frontier.Enqueue(new BuildJob { Start = 0, Count = leafCount, NodeIndex = 0 });
+            while (frontier.Count > 0 && frontier.Count + pendingJobs.Count < targetJobCount)
+            {
+                var job = frontier.Dequeue();
+                SplitJob(job, out var left, out var right);
+                if (left.Count > 1)
+                    frontier.Enqueue(left);
+                if (right.Count > 1)
+                    frontier.Enqueue(right);
+            }
+            pendingJobs.AddRange(frontier);
+            pendingJobIndex = -1;
+            Dispatch(threadDispatcher, BuildWorker);
+        }
+        tree.NodeCount = Math.Max(1, leafCount - 1);
+        tree.LeafCount = leafCount;
+
+        pool.Return(ref leafIndices);
+        if (mortonCodes.Allocated)
+            pool.Return(ref mortonCodes);
+    }
+}
@@ -1,6 +1,7 @@
 ﻿using BepuPhysics;
 using BepuPhysics.Collidables;
 using BepuPhysics.CollisionDetection;
+using BepuPhysics.Constraints;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 
@@ -16,9 +17,25 @@ public unsafe struct NarrowPhaseCallbacksInterop
     public delegate* unmanaged<InstanceHandle, int, CollidablePair, ConvexContactManifold*, PairMaterialProperties*, byte> ConfigureConvexContactManifoldFunction;
     public delegate* unmanaged<InstanceHandle, int, CollidablePair, NonconvexContactManifold*, PairMaterialProperties*, byte> ConfigureNonconvexContactManifoldFunction;
     public delegate* unmanaged<InstanceHandle, int, CollidablePair, int, int, ConvexContactManifold*, byte> ConfigureChildContactManifoldFunction;
+    //The manifolds passed to ConfigureContactManifoldsFunction are read only; the native declaration takes them as const.
+    public delegate* unmanaged<InstanceHandle, int, int, CollidablePair*, ConvexContactManifold**, NonconvexContactManifold**, PairMaterialProperties*, byte*, void> ConfigureContactManifoldsFunction;
+    public int ConfigureContactManifoldsBatchSize;
 }
 
-public unsafe struct NarrowPhaseCallbacks : INarrowPhaseCallbacks
+/// <summary>
+/// Narrow phase callbacks that can only forward to the native side once the simulation has a handle.
+/// </summary>
+public interface IInteropNarrowPhaseCallbacks : INarrowPhaseCallbacks
+{
+    SensorTracker? Sensors { get; set; }
+    AdaptiveContinuityController? Continuity { get; set; }
+    ManifoldConfigurationBatcher? ManifoldBatcher { get; }
+    void Initialize(InstanceHandle simulation);
+}
+
+//Null function pointers select default behavior. The child hooks run for every child pair of compound pairs, so whether they exist is baked into the type parameters like the pose integrator's
+//state; the defaults then compile away entirely. The top level hooks run once per pair and just check for null. Specializing on those too would multiply narrow phase instantiations for little gain.
+public unsafe struct NarrowPhaseCallbacks<TAllowChildContactGeneration, TConfigureChildContactManifold> : IInteropNarrowPhaseCallbacks
 {
     public delegate* unmanaged<InstanceHandle, void> InitializeFunction;
     public delegate* unmanaged<InstanceHandle, void> DisposeFunction;
@@ -29,6 +46,17 @@ public unsafe struct NarrowPhaseCallbacks : INarrowPhaseCallbacks
     public delegate* unmanaged<InstanceHandle, int, CollidablePair, int, int, ConvexContactManifold*, byte> ConfigureChildContactManifoldFunction;
 
     public InstanceHandle Simulation;
+    //Pairs involving a sensor are resolved on this side and never cross the interop boundary.
+    public SensorTracker? Sensors { get; set; }
+    //Counts sweep eligible pairs while adaptive continuity is enabled.
+    public AdaptiveContinuityController? Continuity { get; set; }
+    //Takes over manifold configuration when the native side provides a batched configuration function.
+    public ManifoldConfigurationBatcher? ManifoldBatcher { get; set; }
+
+    /// <summary>
+    /// Material used for pairs when the native side doesn't provide a manifold configuration callback.
+    /// </summary>
+    public static PairMaterialProperties DefaultMaterial => new PairMaterialProperties(1, 2, new SpringSettings(30, 1));
 
     public void Initialize(Simulation simulation)
     {
@@ -44,16 +72,37 @@ public unsafe struct NarrowPhaseCallbacks : INarrowPhaseCallbacks
     {
         if (DisposeFunction != null)
             DisposeFunction(Simulation);
+        ManifoldBatcher?.Dispose();
     }
 
     //Note that a number of these convert refs into pointers. These are safe; all such references originate on the stack or pinned memory.
     public bool AllowContactGeneration(int workerIndex, CollidableReference a, CollidableReference b, ref float speculativeMargin)
     {
-        return AllowContactGenerationFunction(Simulation, workerIndex, a, b, (float*)Unsafe.AsPointer(ref speculativeMargin)) != 0;
+        if (Sensors != null && Sensors.IsSensorPair(a, b))
+        {
+            //Sensors only care about touching shapes, so speculative contacts would be wasted work.
+            speculativeMargin = 0;
+            return true;
+        }
+        bool allow;
+        if (AllowContactGenerationFunction == null)
+        {
+            //Kinematic-kinematic pairs can't produce constraints, so by default at least one side has to be dynamic.
+            allow = a.Mobility == CollidableMobility.Dynamic || b.Mobility == CollidableMobility.Dynamic;
+        }
+        else
+        {
+            allow = AllowContactGenerationFunction(Simulation, workerIndex, a, b, (float*)Unsafe.AsPointer(ref speculativeMargin)) != 0;
+        }
+        if (allow && Continuity != null && Continuity.Enabled)
+            Continuity.CountPair(workerIndex, a, b);
+        return allow;
     }
 
     public bool AllowContactGeneration(int workerIndex, CollidablePair pair, int childIndexA, int childIndexB)
     {
+        if (typeof(TAllowChildContactGeneration) == typeof(False) || (Sensors != null && Sensors.IsSensorPair(pair.A, pair.B)))
+            return true;
         return AllowContactGenerationBetweenChildrenFunction(Simulation, workerIndex, pair, childIndexA, childIndexB) != 0;
     }
 
@@ -62,6 +111,19 @@ public unsafe struct NarrowPhaseCallbacks : INarrowPhaseCallbacks
         //Can't directly expose the generic type across interop boundary, so we need two typed handlers.
         //We could use one function and pass an untyped pointer + type indicator, but that doesn't seem like a significant improvement.
         //This version can be recombined into a single template function on the other end if so desired.
+        if (Sensors != null && Sensors.IsSensorPair(pair.A, pair.B))
+        {
+            Sensors.RecordOverlap(workerIndex, pair, ref manifold);
+            pairMaterial = default;
+            return false;
+        }
+        if (ManifoldBatcher != null)
+            return ManifoldBatcher.Configure(workerIndex, pair, ref manifold, out pairMaterial);
+        if (typeof(TManifold) == typeof(ConvexContactManifold) ? ConfigureConvexContactManifoldFunction == null : ConfigureNonconvexContactManifoldFunction == null)
+        {
+            pairMaterial = DefaultMaterial;
+            return true;
+        }
         Unsafe.SkipInit(out pairMaterial);
         var pairMaterialPointer = (PairMaterialProperties*)Unsafe.AsPointer(ref pairMaterial);
         if (typeof(TManifold) == typeof(ConvexContactManifold))
@@ -76,6 +138,8 @@ public unsafe struct NarrowPhaseCallbacks : INarrowPhaseCallbacks
 
     public bool ConfigureContactManifold(int workerIndex, CollidablePair pair, int childIndexA, int childIndexB, ref ConvexContactManifold manifold)
     {
+        if (typeof(TConfigureChildContactManifold) == typeof(False) || (Sensors != null && Sensors.IsSensorPair(pair.A, pair.B)))
+            return true;
         return ConfigureChildContactManifoldFunction(Simulation, workerIndex, pair, childIndexA, childIndexB, (ConvexContactManifold*)Unsafe.AsPointer(ref manifold)) != 0;
     }
 }
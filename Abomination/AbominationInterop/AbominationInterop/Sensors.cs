@@ -0,0 +1,261 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuUtilities;
+using BepuUtilities.Collections;
+using BepuUtilities.Memory;
+using System;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Change in a sensor overlap since the previous timestep.
+/// </summary>
+public enum SensorOverlapState
+{
+    /// <summary>
+    /// The pair started overlapping during the last timestep.
+    /// </summary>
+    Entered = 0,
+    /// <summary>
+    /// The pair overlapped during the previous timestep and still overlaps.
+    /// </summary>
+    Stayed = 1,
+    /// <summary>
+    /// The pair overlapped during the previous timestep but no longer does, or one of its collidables was removed.
+    /// </summary>
+    Exited = 2
+}
+
+/// <summary>
+/// Overlap between a sensor and another collidable, reported by the last timestep.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct SensorOverlap
+{
+    /// <summary>
+    /// Sensor collidable in the pair. If both collidables are sensors, this is the one with the lower packed reference.
+    /// </summary>
+    public CollidableReference Sensor;
+    /// <summary>
+    /// Collidable overlapping the sensor.
+    /// </summary>
+    public CollidableReference Other;
+    /// <summary>
+    /// Whether the overlap began, continued or ended.
+    /// </summary>
+    public SensorOverlapState State;
+}
+
+/// <summary>
+/// Tracks which collidables are sensors and turns their narrow phase pairs into enter, stay and exit events.
+/// </summary>
+/// <remarks>Sensor pairs go through the engine's contact generation with no speculative margin, so overlap is decided by the actual shapes rather than their bounds.
+/// The narrow phase callbacks record the pair if its manifold has any contact with nonnegative depth and then reject it, so no constraint is ever created.
+/// Pairs where neither collidable is an awake body aren't tested by the narrow phase, so they are kept as staying until one side wakes or is removed.</remarks>
+public class SensorTracker
+{
+    Simulation? simulation;
+    DefaultTimestepper? timestepper;
+    Buffer<ulong> bodySensorFlags;
+    Buffer<ulong> staticSensorFlags;
+    int sensorCount;
+    //Indexed by worker; each list lives in its worker's pool and only exists during collision detection.
+    BufferPool?[] workerPools = Array.Empty<BufferPool>();
+    Buffer<QuickList<CollidablePair>> workerOverlaps;
+    int workerCount;
+    QuickSet<CollidablePair, CollidablePairComparer> previousOverlaps;
+    QuickList<SensorOverlap> overlaps;
+
+    /// <summary>
+    /// Gets whether any collidable in the simulation is currently flagged as a sensor.
+    /// </summary>
+    public bool HasSensors => sensorCount > 0;
+
+    /// <summary>
+    /// Gets the overlaps reported by the last timestep. The buffer is reused by the next timestep.
+    /// </summary>
+    public Buffer<SensorOverlap> Overlaps => overlaps.Span.Slice(overlaps.Count);
+
+    /// <summary>
+    /// Hooks the tracker into the simulation's timestepper.
+    /// </summary>
+    /// <param name="simulation">Simulation to track sensors in.</param>
+    public void Attach(Simulation simulation)
+    {
+        this.simulation = simulation;
+        //Custom timesteppers can't be defined from the native side, but guard anyway; without the stage events there is nowhere to build the overlap lists.
+        timestepper = simulation.Timestepper as DefaultTimestepper ?? throw new InvalidOperationException("Sensors require the default timestepper.");
+        timestepper.BeforeCollisionDetection += OnBeforeCollisionDetection;
+        timestepper.CollisionsDetected += OnCollisionsDetected;
+        previousOverlaps = new QuickSet<CollidablePair, CollidablePairComparer>(16, simulation.BufferPool);
+        overlaps = new QuickList<SensorOverlap>(16, simulation.BufferPool);
+    }
+
+    static bool GetFlag(ref Buffer<ulong> flags, int handle)
+    {
+        var bundleIndex = handle >> 6;
+        return bundleIndex < flags.Length && (flags[bundleIndex] & (1ul << (handle & 63))) != 0;
+    }
+
+    void SetFlag(ref Buffer<ulong> flags, int handle, bool isSensor)
+    {
+        var bundleIndex = handle >> 6;
+        if (bundleIndex >= flags.Length)
+        {
+            if (!isSensor)
+                return;
+            var previousLength = flags.Length;
+            simulation!.BufferPool.ResizeToAtLeast(ref flags, bundleIndex + 1, previousLength);
+            flags.Clear(previousLength, flags.Length - previousLength);
+        }
+        var mask = 1ul << (handle & 63);
+        var wasSensor = (flags[bundleIndex] & mask) != 0;
+        if (wasSensor == isSensor)
+            return;
+        if (isSensor)
+        {
+            flags[bundleIndex] |= mask;
+            ++sensorCount;
+        }
+        else
+        {
+            flags[bundleIndex] &= ~mask;
+            --sensorCount;
+        }
+    }
+
+    /// <summary>
+    /// Sets whether a body's collidable acts as a sensor.
+    /// </summary>
+    /// <param name="handle">Body to modify.</param>
+    /// <param name="isSensor">True if the body should report overlaps instead of generating contacts.</param>
+    public void SetSensor(BodyHandle handle, bool isSensor) => SetFlag(ref bodySensorFlags, handle.Value, isSensor);
+
+    /// <summary>
+    /// Sets whether a static acts as a sensor.
+    /// </summary>
+    /// <param name="handle">Static to modify.</param>
+    /// <param name="isSensor">True if the static should report overlaps instead of generating contacts.</param>
+    public void SetSensor(StaticHandle handle, bool isSensor) => SetFlag(ref staticSensorFlags, handle.Value, isSensor);
+
+    /// <summary>
+    /// Checks whether a collidable is flagged as a sensor.
+    /// </summary>
+    /// <param name="collidable">Collidable to check.</param>
+    /// <returns>True if the collidable is a sensor, false otherwise.</returns>
+    public bool IsSensor(CollidableReference collidable)
+    {
+        return collidable.Mobility == CollidableMobility.Static ?
+            GetFlag(ref staticSensorFlags, collidable.StaticHandle.Value) :
+            GetFlag(ref bodySensorFlags, collidable.BodyHandle.Value);
+    }
+
+    /// <summary>
+    /// Checks whether either collidable in a pair is flagged as a sensor.
+    /// </summary>
+    /// <param name="a">First collidable in the pair.</param>
+    /// <param name="b">Second collidable in the pair.</param>
+    /// <returns>True if the pair should be handled as a sensor pair, false otherwise.</returns>
+    public bool IsSensorPair(CollidableReference a, CollidableReference b) => sensorCount > 0 && (IsSensor(a) || IsSensor(b));
+
+    /// <summary>
+    /// Records a sensor pair if its manifold shows the shapes touching. Called from the narrow phase callbacks on any worker.
+    /// </summary>
+    /// <param name="workerIndex">Index of the worker that generated the manifold.</param>
+    /// <param name="pair">Pair that the manifold was generated for.</param>
+    /// <param name="manifold">Contacts generated for the pair.</param>
+    public void RecordOverlap<TManifold>(int workerIndex, CollidablePair pair, ref TManifold manifold) where TManifold : unmanaged, IContactManifold<TManifold>
+    {
+        //Contacts with negative depth are speculative; the shapes are separated there.
+        int contactIndex = 0;
+        while (contactIndex < manifold.Count && manifold.GetDepth(contactIndex) < 0)
+            ++contactIndex;
+        if (contactIndex == manifold.Count)
+            return;
+        //Keep the sensor first so that a pair maps to the same key regardless of the order the broad phase found it in.
+        var sensorIsA = IsSensor(pair.A) && (!IsSensor(pair.B) || pair.A.Packed < pair.B.Packed);
+        workerOverlaps[workerIndex].Add(sensorIsA ? pair : new CollidablePair(pair.B, pair.A), workerPools[workerIndex]!);
+    }
+
+    void OnBeforeCollisionDetection(float dt, IThreadDispatcher threadDispatcher)
+    {
+        var pool = simulation!.BufferPool;
+        workerCount = threadDispatcher == null ? 1 : threadDispatcher.ThreadCount;
+        if (workerPools.Length < workerCount)
+            workerPools = new BufferPool[workerCount];
+        if (workerOverlaps.Length < workerCount)
+            pool.ResizeToAtLeast(ref workerOverlaps, workerCount, 0);
+        for (int i = 0; i < workerCount; ++i)
+        {
+            workerPools[i] = threadDispatcher == null ? pool : threadDispatcher.WorkerPools[i];
+            workerOverlaps[i] = new QuickList<CollidablePair>(sensorCount > 0 ? 64 : 1, workerPools[i]!);
+        }
+    }
+
+    bool Exists(CollidableReference collidable)
+    {
+        return collidable.Mobility == CollidableMobility.Static ?
+            simulation!.Statics.StaticExists(collidable.StaticHandle) :
+            simulation!.Bodies.BodyExists(collidable.BodyHandle);
+    }
+
+    bool IsAwakeBody(CollidableReference collidable)
+    {
+        return collidable.Mobility != CollidableMobility.Static && simulation!.Bodies.HandleToLocation[collidable.BodyHandle.Value].SetIndex == 0;
+    }
+
+    void OnCollisionsDetected(float dt, IThreadDispatcher threadDispatcher)
+    {
+        var pool = simulation!.BufferPool;
+        overlaps.Count = 0;
+        var currentOverlaps = new QuickSet<CollidablePair, CollidablePairComparer>(Math.Max(16, previousOverlaps.Count), pool);
+        for (int i = 0; i < workerCount; ++i)
+        {
+            ref var workerList = ref workerOverlaps[i];
+            for (int j = 0; j < workerList.Count; ++j)
+            {
+                ref var pair = ref workerList[j];
+                if (!currentOverlaps.Add(pair, pool))
+                    continue;
+                overlaps.Add(new SensorOverlap { Sensor = pair.A, Other = pair.B, State = previousOverlaps.Contains(pair) ? SensorOverlapState.Stayed : SensorOverlapState.Entered }, pool);
+            }
+            workerList.Dispose(workerPools[i]!);
+            workerPools[i] = null;
+        }
+        for (int i = 0; i < previousOverlaps.Count; ++i)
+        {
+            ref var pair = ref previousOverlaps[i];
+            if (currentOverlaps.Contains(pair))
+                continue;
+            var stillTracked = Exists(pair.A) && Exists(pair.B) && IsSensor(pair.A) && !IsAwakeBody(pair.A) && !IsAwakeBody(pair.B);
+            if (stillTracked)
+                currentOverlaps.Add(pair, pool);
+            overlaps.Add(new SensorOverlap { Sensor = pair.A, Other = pair.B, State = stillTracked ? SensorOverlapState.Stayed : SensorOverlapState.Exited }, pool);
+        }
+        previousOverlaps.Dispose(pool);
+        previousOverlaps = currentOverlaps;
+    }
+
+    /// <summary>
+    /// Unhooks the tracker from the simulation and returns its resources.
+    /// </summary>
+    public void Dispose()
+    {
+        if (simulation == null)
+            return;
+        timestepper!.BeforeCollisionDetection -= OnBeforeCollisionDetection;
+        timestepper.CollisionsDetected -= OnCollisionsDetected;
+        var pool = simulation.BufferPool;
+        if (bodySensorFlags.Allocated)
+            pool.Return(ref bodySensorFlags);
+        if (staticSensorFlags.Allocated)
+            pool.Return(ref staticSensorFlags);
+        if (workerOverlaps.Allocated)
+            pool.Return(ref workerOverlaps);
+        previousOverlaps.Dispose(pool);
+        overlaps.Dispose(pool);
+        simulation = null;
+    }
+}
@@ -0,0 +1,453 @@
+﻿using BepuPhysics.Collidables;
+using BepuPhysics.Trees;
+using BepuUtilities.Memory;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.IO;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Shape stored in or loaded from a shape asset. Which field is valid depends on <see cref="ShapeType"/>.
+/// </summary>
+[StructLayout(LayoutKind.Explicit)]
+public struct ShapeAsset
+{
+    /// <summary>
+    /// Type id of the shape held by the asset. One of <see cref="Mesh.Id"/>, <see cref="ConvexHull.Id"/> or <see cref="BigCompound.Id"/>.
+    /// </summary>
+    [FieldOffset(0)]
+    public int ShapeType;
+    /// <summary>
+    /// Mesh held by the asset if <see cref="ShapeType"/> is <see cref="Mesh.Id"/>.
+    /// </summary>
+    [FieldOffset(8)]
+    public Mesh Mesh;
+    /// <summary>
+    /// Convex hull held by the asset if <see cref="ShapeType"/> is <see cref="ConvexHull.Id"/>.
+    /// </summary>
+    [FieldOffset(8)]
+    public ConvexHull ConvexHull;
+    /// <summary>
+    /// Big compound held by the asset if <see cref="ShapeType"/> is <see cref="BigCompound.Id"/>.
+    /// </summary>
+    [FieldOffset(8)]
+    public BigCompound BigCompound;
+}
+
+/// <summary>
+/// Reads and writes shapes in a binary format that stores their buffers exactly as they are laid out in memory.
+/// </summary>
+/// <remarks>
+/// An asset is a <see cref="ShapeAssetHeader"/>, followed by one <see cref="ShapeAssetSection"/> per buffer, followed by the raw contents of each buffer aligned to <see cref="SectionAlignment"/> bytes.
+/// Loading does no processing beyond validating the header and copying each section into a buffer taken from the pool.
+/// Sections record their element size, so assets baked on a machine with a different SIMD width (which changes the size of convex hull point and plane bundles) are rejected rather than misread.
+/// </remarks>
+public static unsafe class ShapeAssets
+{
+    /// <summary>
+    /// Identifies a shape asset. Reads as "BSHA" in little endian.
+    /// </summary>
+    public const uint Magic = 0x41485342;
+    /// <summary>
+    /// Current version of the shape asset format.
+    /// </summary>
+    public const int Version = 1;
+    /// <summary>
+    /// Alignment of section contents within an asset.
+    /// </summary>
+    public const int SectionAlignment = 64;
+    /// <summary>
+    /// Number of buffer sections stored by every supported shape type.
+    /// </summary>
+    public const int SectionCount = 4;
+
+    /// <summary>
+    /// Fixed header at the start of every shape asset.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ShapeAssetHeader
+    {
+        public uint Magic;
+        public int Version;
+        public int ShapeType;
+        public int SectionCount;
+        /// <summary>
+        /// Number of nodes in the shape's tree, if it has one.
+        /// </summary>
+        public int NodeCount;
+        /// <summary>
+        /// Number of leaves in the shape's tree, if it has one.
+        /// </summary>
+        public int LeafCount;
+        /// <summary>
+        /// Scale of the shape, if it has one.
+        /// </summary>
+        public Vector3 Scale;
+        public int Reserved;
+    }
+
+    /// <summary>
+    /// Location and layout of one buffer within a shape asset.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ShapeAssetSection
+    {
+        /// <summary>
+        /// Offset of the section's contents from the start of the asset in bytes.
+        /// </summary>
+        public long Offset;
+        /// <summary>
+        /// Size of each element in the section in bytes.
+        /// </summary>
+        public int ElementSize;
+        /// <summary>
+        /// Number of elements in the section.
+        /// </summary>
+        public int ElementCount;
+    }
+
+    interface IAssetSource
+    {
+        long Length { get; }
+        void Read(long offset, Span<byte> target);
+    }
+
+    interface IAssetTarget
+    {
+        void Write(long offset, ReadOnlySpan<byte> source);
+    }
+
+    struct MemorySource : IAssetSource
+    {
+        public Buffer<byte> Bytes;
+        public long Length => Bytes.Length;
+        public void Read(long offset, Span<byte> target) => new Span<byte>(Bytes.Memory + offset, target.Length).CopyTo(target);
+    }
+
+    struct MemoryTarget : IAssetTarget
+    {
+        public Buffer<byte> Bytes;
+        public void Write(long offset, ReadOnlySpan<byte> source) => source.CopyTo(new Span<byte>(Bytes.Memory + offset, source.Length));
+    }
+
+    struct FileSource : IAssetSource
+    {
+        public SafeFileHandle Handle;
+        public long Length { get; init; }
+        public void Read(long offset, Span<byte> target)
+        {
+            while (target.Length > 0)
+            {
+                var readCount = RandomAccess.Read(Handle, target, offset);
+                if (readCount <= 0)
+                    throw new EndOfStreamException();
+                target = target.Slice(readCount);
+                offset += readCount;
+            }
+        }
+    }
+
+    struct FileTarget : IAssetTarget
+    {
+        public SafeFileHandle Handle;
+        public void Write(long offset, ReadOnlySpan<byte> source) => RandomAccess.Write(Handle, source, offset);
+    }
+
+    static long GetSectionsStart() => (sizeof(ShapeAssetHeader) + SectionCount * sizeof(ShapeAssetSection) + SectionAlignment - 1) & ~(long)(SectionAlignment - 1);
+
+    static void AddSection<T>(ref ShapeAssetSection section, ref long offset, int count) where T : unmanaged
+    {
+        section.Offset = offset;
+        section.ElementSize = sizeof(T);
+        section.ElementCount = count;
+        offset = (offset + (long)count * sizeof(T) + SectionAlignment - 1) & ~(long)(SectionAlignment - 1);
+    }
+
+    static bool TryGetLayout(in ShapeAsset asset, out ShapeAssetHeader header, out ShapeAssetSection* sections, ShapeAssetSection* sectionsMemory, out long byteCount)
+    {
+        header = default;
+        header.Magic = Magic;
+        header.Version = Version;
+        header.ShapeType = asset.ShapeType;
+        header.SectionCount = SectionCount;
+        sections = sectionsMemory;
+        var offset = GetSectionsStart();
+        switch (asset.ShapeType)
+        {
+            case Mesh.Id:
+                header.NodeCount = asset.Mesh.Tree.NodeCount;
+                header.LeafCount = asset.Mesh.Tree.LeafCount;
+                header.Scale = asset.Mesh.Scale;
+                AddSection<Triangle>(ref sections[0], ref offset, asset.Mesh.Triangles.Length);
+                AddSection<Node>(ref sections[1], ref offset, header.NodeCount);
+                AddSection<Metanode>(ref sections[2], ref offset, header.NodeCount);
+                AddSection<Leaf>(ref sections[3], ref offset, header.LeafCount);
+                break;
+            case ConvexHull.Id:
+                AddSection<Vector3Wide>(ref sections[0], ref offset, asset.ConvexHull.Points.Length);
+                AddSection<HullBoundingPlanes>(ref sections[1], ref offset, asset.ConvexHull.BoundingPlanes.Length);
+                AddSection<HullVertexIndex>(ref sections[2], ref offset, asset.ConvexHull.FaceVertexIndices.Length);
+                AddSection<int>(ref sections[3], ref offset, asset.ConvexHull.FaceToVertexIndicesStart.Length);
+                break;
+            case BigCompound.Id:
+                header.NodeCount = asset.BigCompound.Tree.NodeCount;
+                header.LeafCount = asset.BigCompound.Tree.LeafCount;
+                AddSection<CompoundChild>(ref sections[0], ref offset, asset.BigCompound.Children.Length);
+                AddSection<Node>(ref sections[1], ref offset, header.NodeCount);
+                AddSection<Metanode>(ref sections[2], ref offset, header.NodeCount);
+                AddSection<Leaf>(ref sections[3], ref offset, header.LeafCount);
+                break;
+            default:
+                byteCount = 0;
+                return false;
+        }
+        byteCount = offset;
+        return true;
+    }
+
+    static void WriteSection<T, TTarget>(ref TTarget target, in ShapeAssetSection section, Buffer<T> buffer) where T : unmanaged where TTarget : struct, IAssetTarget
+    {
+        target.Write(section.Offset, new ReadOnlySpan<byte>(buffer.Memory, section.ElementCount * section.ElementSize));
+    }
+
+    static bool Write<TTarget>(in ShapeAsset asset, ref TTarget target) where TTarget : struct, IAssetTarget
+    {
+        var sectionsMemory = stackalloc ShapeAssetSection[SectionCount];
+        if (!TryGetLayout(asset, out var header, out var sections, sectionsMemory, out _))
+            return false;
+        target.Write(0, new ReadOnlySpan<byte>(&header, sizeof(ShapeAssetHeader)));
+        target.Write(sizeof(ShapeAssetHeader), new ReadOnlySpan<byte>(sections, SectionCount * sizeof(ShapeAssetSection)));
+        switch (asset.ShapeType)
+        {
+            case Mesh.Id:
+                WriteSection(ref target, sections[0], asset.Mesh.Triangles);
+                WriteSection(ref target, sections[1], asset.Mesh.Tree.Nodes);
+                WriteSection(ref target, sections[2], asset.Mesh.Tree.Metanodes);
+                WriteSection(ref target, sections[3], asset.Mesh.Tree.Leaves);
+                break;
+            case ConvexHull.Id:
+                WriteSection(ref target, sections[0], asset.ConvexHull.Points);
+                WriteSection(ref target, sections[1], asset.ConvexHull.BoundingPlanes);
+                WriteSection(ref target, sections[2], asset.ConvexHull.FaceVertexIndices);
+                WriteSection(ref target, sections[3], asset.ConvexHull.FaceToVertexIndicesStart);
+                break;
+            case BigCompound.Id:
+                WriteSection(ref target, sections[0], asset.BigCompound.Children);
+                WriteSection(ref target, sections[1], asset.BigCompound.Tree.Nodes);
+                WriteSection(ref target, sections[2], asset.BigCompound.Tree.Metanodes);
+                WriteSection(ref target, sections[3], asset.BigCompound.Tree.Leaves);
+                break;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Computes the number of bytes required to store a shape as an asset.
+    /// </summary>
+    /// <param name="asset">Shape to measure.</param>
+    /// <returns>Number of bytes required to store the shape, or 0 if the shape type is not supported by the asset format.</returns>
+    public static long GetByteCount(in ShapeAsset asset)
+    {
+        var sectionsMemory = stackalloc ShapeAssetSection[SectionCount];
+        TryGetLayout(asset, out _, out _, sectionsMemory, out var byteCount);
+        return byteCount;
+    }
+
+    /// <summary>
+    /// Writes a shape asset into memory.
+    /// </summary>
+    /// <param name="asset">Shape to write.</param>
+    /// <param name="bytes">Memory to write the asset into. Must be at least <see cref="GetByteCount"/> bytes long.</param>
+    /// <returns>True if the asset was written, false if the shape type is not supported or the target is too small.</returns>
+    public static bool Write(in ShapeAsset asset, Buffer<byte> bytes)
+    {
+        var byteCount = GetByteCount(asset);
+        if (byteCount == 0 || byteCount > bytes.Length)
+            return false;
+        var target = new MemoryTarget { Bytes = bytes };
+        return Write(asset, ref target);
+    }
+
+    /// <summary>
+    /// Writes a shape asset to a file, replacing any existing file at the path.
+    /// </summary>
+    /// <param name="asset">Shape to write.</param>
+    /// <param name="path">Path of the file to write.</param>
+    /// <returns>True if the asset was written, false if the shape type is not supported or the file could not be written.</returns>
+    public static bool Write(in ShapeAsset asset, string path)
+    {
+        var byteCount = GetByteCount(asset);
+        if (byteCount == 0)
+            return false;
+        try
+        {
+            using var handle = File.OpenHandle(path, FileMode.Create, FileAccess.Write, FileShare.None, FileOptions.None, byteCount);
+            var target = new FileTarget { Handle = handle };
+            return Write(asset, ref target);
+        }
+        catch (IOException) { return false; }
+        catch (UnauthorizedAccessException) { return false; }
+    }
+
+    static bool TryReadSection<T, TSource>(ref TSource source, in ShapeAssetSection section, BufferPool pool, out Buffer<T> buffer) where T : unmanaged where TSource : struct, IAssetSource
+    {
+        if (section.ElementSize != sizeof(T) || section.ElementCount < 0 || section.Offset < 0 || section.Offset + (long)section.ElementCount * sizeof(T) > source.Length)
+        {
+            buffer = default;
+            return false;
+        }
+        //Empty sections still take a buffer so that the shape's Dispose can return every buffer unconditionally.
+        pool.Take(Math.Max(1, section.ElementCount), out buffer);
+        buffer = buffer.Slice(section.ElementCount);
+        source.Read(section.Offset, new Span<byte>(buffer.Memory, section.ElementCount * sizeof(T)));
+        return true;
+    }
+
+    //Sections are read straight into the caller's fields, so a buffer is visible to the caller as soon as it's taken, even if filling it throws.
+    static bool TryReadTree<TSource>(ref TSource source, in ShapeAssetHeader header, ShapeAssetSection* sections, BufferPool pool, out Tree tree) where TSource : struct, IAssetSource
+    {
+        tree = default;
+        if (header.NodeCount < 1 || header.LeafCount < 1 || sections[1].ElementCount != header.NodeCount || sections[2].ElementCount != header.NodeCount || sections[3].ElementCount != header.LeafCount)
+            return false;
+        if (!TryReadSection(ref source, sections[1], pool, out tree.Nodes) ||
+            !TryReadSection(ref source, sections[2], pool, out tree.Metanodes) ||
+            !TryReadSection(ref source, sections[3], pool, out tree.Leaves))
+            return false;
+        tree.NodeCount = header.NodeCount;
+        tree.LeafCount = header.LeafCount;
+        return true;
+    }
+
+    static void ReturnIfAllocated<T>(BufferPool pool, ref Buffer<T> buffer) where T : unmanaged
+    {
+        if (buffer.Allocated)
+            pool.Return(ref buffer);
+    }
+
+    static void ReturnTree(BufferPool pool, ref Tree tree)
+    {
+        ReturnIfAllocated(pool, ref tree.Nodes);
+        ReturnIfAllocated(pool, ref tree.Metanodes);
+        ReturnIfAllocated(pool, ref tree.Leaves);
+    }
+
+    /// <summary>
+    /// Returns whichever of a partially read asset's buffers were taken.
+    /// </summary>
+    static void ReturnPartialAsset(BufferPool pool, int shapeType, ref ShapeAsset asset)
+    {
+        switch (shapeType)
+        {
+            case Mesh.Id:
+                ReturnIfAllocated(pool, ref asset.Mesh.Triangles);
+                ReturnTree(pool, ref asset.Mesh.Tree);
+                break;
+            case ConvexHull.Id:
+                ReturnIfAllocated(pool, ref asset.ConvexHull.Points);
+                ReturnIfAllocated(pool, ref asset.ConvexHull.BoundingPlanes);
+                ReturnIfAllocated(pool, ref asset.ConvexHull.FaceVertexIndices);
+                ReturnIfAllocated(pool, ref asset.ConvexHull.FaceToVertexIndicesStart);
+                break;
+            case BigCompound.Id:
+                ReturnIfAllocated(pool, ref asset.BigCompound.Children);
+                ReturnTree(pool, ref asset.BigCompound.Tree);
+                break;
+        }
+        asset = default;
+    }
+
+    static bool TryReadShape<TSource>(ref TSource source, in ShapeAssetHeader header, ShapeAssetSection* sections, BufferPool pool, ref ShapeAsset asset) where TSource : struct, IAssetSource
+    {
+        switch (header.ShapeType)
+        {
+            case Mesh.Id:
+                if (!TryReadSection(ref source, sections[0], pool, out asset.Mesh.Triangles) ||
+                    !TryReadTree(ref source, header, sections, pool, out asset.Mesh.Tree))
+                    return false;
+                asset.Mesh.Scale = header.Scale;
+                return true;
+            case ConvexHull.Id:
+                {
+                    ref var hull = ref asset.ConvexHull;
+                    return TryReadSection(ref source, sections[0], pool, out hull.Points) &&
+                        TryReadSection(ref source, sections[1], pool, out hull.BoundingPlanes) &&
+                        TryReadSection(ref source, sections[2], pool, out hull.FaceVertexIndices) &&
+                        TryReadSection(ref source, sections[3], pool, out hull.FaceToVertexIndicesStart);
+                }
+            case BigCompound.Id:
+                return TryReadSection(ref source, sections[0], pool, out asset.BigCompound.Children) &&
+                    TryReadTree(ref source, header, sections, pool, out asset.BigCompound.Tree);
+            default:
+                return false;
+        }
+    }
+
+    static bool Read<TSource>(ref TSource source, BufferPool pool, out ShapeAsset asset) where TSource : struct, IAssetSource
+    {
+        asset = default;
+        ShapeAssetHeader header;
+        var sections = stackalloc ShapeAssetSection[SectionCount];
+        if (source.Length < GetSectionsStart())
+            return false;
+        source.Read(0, new Span<byte>(&header, sizeof(ShapeAssetHeader)));
+        if (header.Magic != Magic || header.Version != Version || header.SectionCount != SectionCount)
+            return false;
+        source.Read(sizeof(ShapeAssetHeader), new Span<byte>(sections, SectionCount * sizeof(ShapeAssetSection)));
+        bool succeeded;
+        try
+        {
+            succeeded = TryReadShape(ref source, header, sections, pool, ref asset);
+        }
+        catch
+        {
+            //A file that shrinks or fails mid-read throws out of a section read; don't leak the sections already taken.
+            ReturnPartialAsset(pool, header.ShapeType, ref asset);
+            throw;
+        }
+        if (!succeeded)
+        {
+            ReturnPartialAsset(pool, header.ShapeType, ref asset);
+            return false;
+        }
+        asset.ShapeType = header.ShapeType;
+        return true;
+    }
+
+    /// <summary>
+    /// Loads a shape asset from memory.
+    /// </summary>
+    /// <param name="bytes">Memory containing the asset.</param>
+    /// <param name="pool">Pool to take the shape's buffers from.</param>
+    /// <param name="asset">Loaded shape. Zeroed if the load failed.</param>
+    /// <returns>True if the asset was loaded, false if the memory did not contain a valid asset.</returns>
+    public static bool Read(Buffer<byte> bytes, BufferPool pool, out ShapeAsset asset)
+    {
+        var source = new MemorySource { Bytes = bytes };
+        return Read(ref source, pool, out asset);
+    }
+
+    /// <summary>
+    /// Loads a shape asset from a file, reading each section directly into a buffer taken from the pool.
+    /// </summary>
+    /// <param name="path">Path of the file to load.</param>
+    /// <param name="pool">Pool to take the shape's buffers from.</param>
+    /// <param name="asset">Loaded shape. Zeroed if the load failed.</param>
+    /// <returns>True if the asset was loaded, false if the file could not be read or did not contain a valid asset.</returns>
+    public static bool Read(string path, BufferPool pool, out ShapeAsset asset)
+    {
+        try
+        {
+            using var handle = File.OpenHandle(path, FileMode.Open, FileAccess.Read, FileShare.Read, FileOptions.SequentialScan);
+            var source = new FileSource { Handle = handle, Length = RandomAccess.GetLength(handle) };
+            return Read(ref source, pool, out asset);
+        }
+        catch (IOException) { }
+        catch (UnauthorizedAccessException) { }
+        asset = default;
+        return false;
+    }
+}
@@ -0,0 +1,257 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuUtilities.Memory;
+using System;
+using System.Collections.Generic;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Deduplicates shapes added to a simulation by their content and reference counts the shared entries.
+/// </summary>
+/// <remarks>Content covers the full shape data, including the buffers of convex hulls, compounds and meshes. Tree acceleration structures are derived from that content and are not compared.
+/// Hash matches are always confirmed with a full content comparison against the stored shape, so collisions never merge different shapes.</remarks>
+public unsafe class ShapeInterner
+{
+    /// <summary>
+    /// Bytes describing a shape. Buffer backed shapes span several regions of memory.
+    /// </summary>
+    ref struct ShapeContent
+    {
+        public ReadOnlySpan<byte> A;
+        public ReadOnlySpan<byte> B;
+        public ReadOnlySpan<byte> C;
+        public ReadOnlySpan<byte> D;
+        public Vector3 Scale;
+    }
+
+    struct Entry
+    {
+        public int ReferenceCount;
+        public int Hash;
+    }
+
+    Shapes shapes;
+    Dictionary<(int Type, int Index), Entry> entries = new();
+    Dictionary<(int Type, int Hash), List<int>> candidates = new();
+
+    /// <summary>
+    /// Pool that buffers of deduplicated shapes are returned to. If null, those buffers are left with the caller.
+    /// </summary>
+    public BufferPool? DuplicatePool;
+
+    public ShapeInterner(Shapes shapes, BufferPool? duplicatePool)
+    {
+        this.shapes = shapes;
+        DuplicatePool = duplicatePool;
+    }
+
+    static ReadOnlySpan<byte> AsBytes<T>(Buffer<T> buffer) where T : unmanaged
+    {
+        return new ReadOnlySpan<byte>(buffer.Memory, buffer.Length * sizeof(T));
+    }
+
+    static ShapeContent GetContent(int type, void* shapeData, int shapeSize)
+    {
+        ShapeContent content = default;
+        switch (type)
+        {
+            case ConvexHull.Id:
+                {
+                    ref var hull = ref *(ConvexHull*)shapeData;
+                    content.A = AsBytes(hull.Points);
+                    content.B = AsBytes(hull.BoundingPlanes);
+                    content.C = AsBytes(hull.FaceVertexIndices);
+                    content.D = AsBytes(hull.FaceToVertexIndicesStart);
+                }
+                break;
+            case Compound.Id:
+                content.A = AsBytes(((Compound*)shapeData)->Children);
+                break;
+            case BigCompound.Id:
+                content.A = AsBytes(((BigCompound*)shapeData)->Children);
+                break;
+            case Mesh.Id:
+                {
+                    ref var mesh = ref *(Mesh*)shapeData;
+                    content.A = AsBytes(mesh.Triangles);
+                    content.Scale = mesh.Scale;
+                }
+                break;
+            case CompressedMesh.Id:
+                {
+                    var mesh = (CompressedMesh*)shapeData;
+                    content.A = AsBytes(mesh->Vertices);
+                    content.B = AsBytes(mesh->Indices);
+                    //The quantization grid determines what the vertices decode to.
+                    content.C = new ReadOnlySpan<byte>(&mesh->Origin, 2 * sizeof(Vector3));
+                    content.Scale = mesh->Scale;
+                }
+                break;
+            case Heightfield.Id:
+                {
+                    var heightfield = (Heightfield*)shapeData;
+                    content.A = AsBytes(heightfield->Samples);
+                    content.B = AsBytes(heightfield->CellFlags);
+                    //The nine 4 byte fields after the buffers describe the grid layout. Trailing padding is excluded since it isn't guaranteed to be zeroed.
+                    content.C = new ReadOnlySpan<byte>(&heightfield->SampleCountX, 9 * sizeof(int));
+                }
+                break;
+            //Voxel grids are edited in place, so sharing one between unrelated additions would leak edits across them.
+            //Hashing the raw struct includes the buffer pointers, so only the exact same grid is ever deduplicated.
+            case VoxelGrid.Id:
+            default:
+                content.A = new ReadOnlySpan<byte>(shapeData, shapeSize);
+                break;
+        }
+        return content;
+    }
+
+    static int ComputeHash(int type, in ShapeContent content)
+    {
+        var hash = new HashCode();
+        hash.Add(type);
+        hash.AddBytes(content.A);
+        hash.AddBytes(content.B);
+        hash.AddBytes(content.C);
+        hash.AddBytes(content.D);
+        hash.Add(content.Scale);
+        return hash.ToHashCode();
+    }
+
+    static bool ContentEquals(in ShapeContent a, in ShapeContent b)
+    {
+        return a.Scale == b.Scale && a.A.SequenceEqual(b.A) && a.B.SequenceEqual(b.B) && a.C.SequenceEqual(b.C) && a.D.SequenceEqual(b.D);
+    }
+
+    ShapeContent GetStoredContent(TypedIndex shape)
+    {
+        shapes[shape.Type].GetShapeData(shape.Index, out var shapeData, out var shapeSize);
+        return GetContent(shape.Type, shapeData, shapeSize);
+    }
+
+    void DisposeDuplicate(int type, void* shapeData, in ShapeContent content, in ShapeContent storedContent)
+    {
+        //Adding the same shape twice passes the stored shape's own buffers back in; those must stay alive.
+        if (DuplicatePool == null || content.A.Length == 0 || Unsafe.AreSame(ref MemoryMarshal.GetReference(content.A), ref MemoryMarshal.GetReference(storedContent.A)))
+            return;
+        switch (type)
+        {
+            case ConvexHull.Id:
+                (*(ConvexHull*)shapeData).Dispose(DuplicatePool);
+                break;
+            case Compound.Id:
+                (*(Compound*)shapeData).Dispose(DuplicatePool);
+                break;
+            case BigCompound.Id:
+                (*(BigCompound*)shapeData).Dispose(DuplicatePool);
+                break;
+            case Mesh.Id:
+                (*(Mesh*)shapeData).Dispose(DuplicatePool);
+                break;
+            case CompressedMesh.Id:
+                (*(CompressedMesh*)shapeData).Dispose(DuplicatePool);
+                break;
+            case Heightfield.Id:
+                (*(Heightfield*)shapeData).Dispose(DuplicatePool);
+                break;
+        }
+    }
+
+    /// <summary>
+    /// Adds a shape to the simulation unless a shape with identical content was already added through the interner.
+    /// </summary>
+    /// <param name="shape">Shape to add.</param>
+    /// <returns>Index of the newly added shape, or of the existing shape with identical content.</returns>
+    /// <remarks>When an existing shape is returned, buffers referenced by the given shape are returned to <see cref="DuplicatePool"/> unless they are the existing shape's own buffers. With no duplicate pool, they still belong to the caller.</remarks>
+    public TypedIndex Add<TShape>(in TShape shape) where TShape : unmanaged, IShape
+    {
+        var type = TShape.TypeId;
+        var shapeData = Unsafe.AsPointer(ref Unsafe.AsRef(in shape));
+        var content = GetContent(type, shapeData, sizeof(TShape));
+        var hash = ComputeHash(type, content);
+        if (candidates.TryGetValue((type, hash), out var indices))
+        {
+            for (int i = 0; i < indices.Count; ++i)
+            {
+                var existing = new TypedIndex(type, indices[i]);
+                var storedContent = GetStoredContent(existing);
+                if (ContentEquals(content, storedContent))
+                {
+                    ref var entry = ref CollectionsMarshal.GetValueRefOrNullRef(entries, (type, indices[i]));
+                    ++entry.ReferenceCount;
+                    DisposeDuplicate(type, shapeData, content, storedContent);
+                    return existing;
+                }
+            }
+        }
+        else
+        {
+            indices = new List<int>(1);
+            candidates.Add((type, hash), indices);
+        }
+        var index = shapes.Add(shape);
+        indices.Add(index.Index);
+        entries.Add((type, index.Index), new Entry { ReferenceCount = 1, Hash = hash });
+        return index;
+    }
+
+    /// <summary>
+    /// Gets the number of outstanding references to a shape.
+    /// </summary>
+    /// <param name="shape">Shape to look up.</param>
+    /// <returns>Number of times the shape was returned by <see cref="Add"/> without being released, or 1 if the shape was not added through the interner.</returns>
+    public int GetReferenceCount(TypedIndex shape)
+    {
+        return entries.TryGetValue((shape.Type, shape.Index), out var entry) ? entry.ReferenceCount : 1;
+    }
+
+    /// <summary>
+    /// Releases one reference to a shape.
+    /// </summary>
+    /// <param name="shape">Shape to release.</param>
+    /// <returns>True if no references remain and the shape should be removed from the simulation, false if it is still in use.</returns>
+    public bool Release(TypedIndex shape)
+    {
+        ref var entry = ref CollectionsMarshal.GetValueRefOrNullRef(entries, (shape.Type, shape.Index));
+        if (Unsafe.IsNullRef(ref entry))
+            return true;
+        if (--entry.ReferenceCount > 0)
+            return false;
+        var indices = candidates[(shape.Type, entry.Hash)];
+        indices.Remove(shape.Index);
+        if (indices.Count == 0)
+            candidates.Remove((shape.Type, entry.Hash));
+        entries.Remove((shape.Type, shape.Index));
+        return true;
+    }
+
+    /// <summary>
+    /// Releases a reference to a shape, and if it was the last reference, removes it from the simulation and returns its buffers to a pool.
+    /// Compound children are released the same way, once per distinct child shape.
+    /// </summary>
+    /// <param name="shape">Shape to release.</param>
+    /// <param name="pool">Pool to return shape buffers to.</param>
+    public void ReleaseAndDisposeRecursively(TypedIndex shape, BufferPool pool)
+    {
+        if (!Release(shape))
+            return;
+        if (shape.Type == Compound.Id || shape.Type == BigCompound.Id)
+        {
+            var children = shape.Type == Compound.Id ? shapes.GetShape<Compound>(shape.Index).Children : shapes.GetShape<BigCompound>(shape.Index).Children;
+            var childShapes = new HashSet<TypedIndex>();
+            for (int i = 0; i < children.Length; ++i)
+                childShapes.Add(children[i].ShapeIndex);
+            shapes.RemoveAndDispose(shape, pool);
+            foreach (var childShape in childShapes)
+                ReleaseAndDisposeRecursively(childShape, pool);
+        }
+        else
+        {
+            shapes.RemoveAndDispose(shape, pool);
+        }
+    }
+}
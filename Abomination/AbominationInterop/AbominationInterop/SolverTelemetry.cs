@@ -0,0 +1,168 @@
+﻿using BepuPhysics;
+using BepuPhysics.Constraints;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Snapshot of the active constraint set's batching and the cost of the most recent solve.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct SolverStatistics
+{
+    /// <summary>
+    /// Number of constraints in the active set.
+    /// </summary>
+    public int ConstraintCount;
+    /// <summary>
+    /// Number of constraint batches in the active set, including the fallback batch if it exists.
+    /// </summary>
+    public int BatchCount;
+    /// <summary>
+    /// Number of synchronized batches in the active set. Constraints in these batches are solved in parallel without conflicts.
+    /// </summary>
+    public int SynchronizedBatchCount;
+    /// <summary>
+    /// Number of synchronized batches the solver creates before putting constraints in the fallback batch.
+    /// </summary>
+    public int FallbackBatchThreshold;
+    /// <summary>
+    /// Number of constraints in the fallback batch.
+    /// </summary>
+    public int FallbackConstraintCount;
+    /// <summary>
+    /// Number of bodies referenced by constraints in the fallback batch.
+    /// </summary>
+    public int FallbackBodyCount;
+    /// <summary>
+    /// Number of constraint types the solver knows about. Sizes the per-type constraint count buffer.
+    /// </summary>
+    public int ConstraintTypeCount;
+    /// <summary>
+    /// Number of substeps used by the most recent solve.
+    /// </summary>
+    public int SubstepCount;
+    /// <summary>
+    /// Number of velocity iterations the solver uses per substep when no scheduler overrides it.
+    /// </summary>
+    public int VelocityIterationCount;
+    /// <summary>
+    /// Total number of velocity iterations run across all substeps of the most recent solve.
+    /// </summary>
+    public int SolveIterationCount;
+    /// <summary>
+    /// Duration of the most recent solve in seconds, including the pose and velocity integration interleaved with substeps.
+    /// </summary>
+    public double SolveTime;
+    /// <summary>
+    /// Average duration of a substep in the most recent solve in seconds.
+    /// </summary>
+    public double SubstepTime;
+    /// <summary>
+    /// Average duration of a velocity iteration in the most recent solve in seconds.
+    /// </summary>
+    public double IterationTime;
+}
+
+/// <summary>
+/// Times the solve stage of a simulation's timesteps.
+/// </summary>
+public class SolverTelemetry
+{
+    long solveStartTimestamp;
+    int pendingSubstepCount;
+    int pendingIterationCount;
+    SubstepVelocityIterationScheduler? wrappedScheduler;
+    SubstepVelocityIterationScheduler? countingScheduler;
+    public long LastSolveTicks;
+    public int LastSubstepCount;
+    public int LastIterationCount;
+
+    /// <summary>
+    /// Hooks the simulation's timestepper stage events so that solves are timed.
+    /// </summary>
+    /// <remarks>The interop layer always creates simulations with the default timestepper; other timesteppers are left untimed.
+    /// A velocity iteration scheduler is wrapped for the duration of each solve so the counts it returns are recorded as the solver receives them; it is never called an extra time.</remarks>
+    public void Attach(Simulation simulation)
+    {
+        if (simulation.Timestepper is DefaultTimestepper timestepper)
+        {
+            var solver = simulation.Solver;
+            countingScheduler = substepIndex =>
+            {
+                var iterationCount = wrappedScheduler!(substepIndex);
+                //Matches the solver: a non-positive count falls back to the solver's default.
+                pendingIterationCount += iterationCount > 0 ? iterationCount : Math.Max(1, solver.VelocityIterationCount);
+                return iterationCount;
+            };
+            timestepper.CollisionsDetected += (dt, threadDispatcher) =>
+            {
+                //Iteration counts can change between solves (e.g. the adaptive scheduler picks the next count once a solve ends), so capture what this solve will use.
+                pendingSubstepCount = solver.SubstepCount;
+                //A solve that threw never reached ConstraintsSolved and left the wrapper installed; keep wrapping the original rather than the wrapper itself.
+                if (solver.VelocityIterationScheduler != countingScheduler)
+                    wrappedScheduler = solver.VelocityIterationScheduler;
+                if (wrappedScheduler == null)
+                {
+                    pendingIterationCount = pendingSubstepCount * Math.Max(1, solver.VelocityIterationCount);
+                }
+                else
+                {
+                    pendingIterationCount = 0;
+                    solver.VelocityIterationScheduler = countingScheduler;
+                }
+                solveStartTimestamp = Stopwatch.GetTimestamp();
+            };
+            timestepper.ConstraintsSolved += (dt, threadDispatcher) =>
+            {
+                LastSolveTicks = Stopwatch.GetTimestamp() - solveStartTimestamp;
+                if (wrappedScheduler != null)
+                {
+                    solver.VelocityIterationScheduler = wrappedScheduler;
+                    wrappedScheduler = null;
+                }
+                LastSubstepCount = pendingSubstepCount;
+                LastIterationCount = pendingIterationCount;
+            };
+        }
+    }
+
+    public unsafe void GetStatistics(Simulation simulation, SolverStatistics* statistics)
+    {
+        var solver = simulation.Solver;
+        ref var activeSet = ref solver.ActiveSet;
+        *statistics = default;
+        statistics->BatchCount = activeSet.Batches.Count;
+        statistics->FallbackBatchThreshold = solver.FallbackBatchThreshold;
+        statistics->SynchronizedBatchCount = activeSet.Batches.Count > solver.FallbackBatchThreshold ? solver.FallbackBatchThreshold : activeSet.Batches.Count;
+        statistics->ConstraintTypeCount = solver.TypeProcessors.Length;
+        for (int batchIndex = 0; batchIndex < activeSet.Batches.Count; ++batchIndex)
+        {
+            var batchConstraintCount = GetConstraintCount(ref activeSet.Batches[batchIndex]);
+            statistics->ConstraintCount += batchConstraintCount;
+            if (batchIndex == solver.FallbackBatchThreshold)
+                statistics->FallbackConstraintCount = batchConstraintCount;
+        }
+        if (statistics->FallbackConstraintCount > 0)
+            statistics->FallbackBodyCount = activeSet.SequentialFallback.BodyCount;
+        statistics->SubstepCount = LastSubstepCount;
+        statistics->VelocityIterationCount = solver.VelocityIterationCount;
+        statistics->SolveIterationCount = LastIterationCount;
+        statistics->SolveTime = (double)LastSolveTicks / Stopwatch.Frequency;
+        if (LastSubstepCount > 0)
+            statistics->SubstepTime = statistics->SolveTime / LastSubstepCount;
+        if (LastIterationCount > 0)
+            statistics->IterationTime = statistics->SolveTime / LastIterationCount;
+    }
+
+    public static int GetConstraintCount(ref ConstraintBatch batch)
+    {
+        int count = 0;
+        for (int typeBatchIndex = 0; typeBatchIndex < batch.TypeBatches.Count; ++typeBatchIndex)
+        {
+            count += batch.TypeBatches[typeBatchIndex].ConstraintCount;
+        }
+        return count;
+    }
+}
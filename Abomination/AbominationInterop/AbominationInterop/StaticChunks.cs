@@ -0,0 +1,164 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Group of statics prepared ahead of time so that it can be attached to or detached from a simulation in a handful of operations.
+/// </summary>
+/// <remarks>Statics with convex shapes become children of a single big compound whose acceleration structure is built when the chunk is created, so attaching them costs one broad phase insertion regardless of their number.
+/// Compound children keep the relative order of the convex descriptions that produced them, so contact callbacks can map a child index back to its source description.
+/// Statics with nonconvex shapes cannot be compound children and are added individually on attach.</remarks>
+[StructLayout(LayoutKind.Sequential)]
+public struct StaticChunk
+{
+    /// <summary>
+    /// Compound holding every convex static in the chunk, posed in world space. Has no children if the chunk has no convex statics.
+    /// </summary>
+    public BigCompound Compound;
+    /// <summary>
+    /// Statics with nonconvex shapes, added individually on attach.
+    /// </summary>
+    public Buffer<StaticDescription> LooseStatics;
+    /// <summary>
+    /// Handles of the loose statics while the chunk is attached.
+    /// </summary>
+    public Buffer<StaticHandle> LooseStaticHandles;
+    /// <summary>
+    /// Shape index of the chunk's compound while the chunk is attached.
+    /// </summary>
+    public TypedIndex CompoundShape;
+    /// <summary>
+    /// Handle of the static holding the chunk's compound while the chunk is attached.
+    /// </summary>
+    public StaticHandle CompoundStatic;
+    /// <summary>
+    /// Nonzero while the chunk is attached to a simulation.
+    /// </summary>
+    public int Attached;
+}
+
+/// <summary>
+/// Builds, attaches, and detaches <see cref="StaticChunk"/> instances.
+/// </summary>
+public static class StaticChunks
+{
+    /// <summary>
+    /// Builds a static chunk. Only reads the simulation's shape data, so it can run off the simulation thread as long as no shapes are added or removed while it runs.
+    /// </summary>
+    /// <param name="simulation">Simulation owning the shapes referenced by the descriptions.</param>
+    /// <param name="descriptions">Descriptions of the statics in the chunk.</param>
+    /// <param name="pool">Pool to allocate the chunk's buffers from. Must not be used by any other thread while the chunk is built.</param>
+    /// <returns>Built chunk.</returns>
+    public static StaticChunk Create(Simulation simulation, Buffer<StaticDescription> descriptions, BufferPool pool)
+    {
+        var shapes = simulation.Shapes;
+        int looseCount = 0;
+        for (int i = 0; i < descriptions.Length; ++i)
+        {
+            if (shapes[descriptions[i].Shape.Type].Compound)
+                ++looseCount;
+        }
+        var convexCount = descriptions.Length - looseCount;
+        StaticChunk chunk = default;
+        if (looseCount > 0)
+        {
+            pool.Take(looseCount, out chunk.LooseStatics);
+            pool.Take(looseCount, out chunk.LooseStaticHandles);
+        }
+        if (convexCount > 0)
+        {
+            pool.Take<CompoundChild>(convexCount, out var children);
+            int childIndex = 0;
+            int looseIndex = 0;
+            for (int i = 0; i < descriptions.Length; ++i)
+            {
+                ref var description = ref descriptions[i];
+                if (shapes[description.Shape.Type].Compound)
+                {
+                    chunk.LooseStatics[looseIndex++] = description;
+                }
+                else
+                {
+                    ref var child = ref children[childIndex++];
+                    child.LocalPosition = description.Pose.Position;
+                    child.LocalOrientation = description.Pose.Orientation;
+                    child.ShapeIndex = description.Shape;
+                }
+            }
+            //The compound's tree is the chunk's prebuilt broad phase subtree; building it here keeps that cost off the simulation thread.
+            chunk.Compound = new BigCompound(children, shapes, pool);
+        }
+        else if (looseCount > 0)
+        {
+            descriptions.CopyTo(0, chunk.LooseStatics, 0, looseCount);
+        }
+        return chunk;
+    }
+
+    /// <summary>
+    /// Adds a chunk's statics to a simulation.
+    /// </summary>
+    /// <param name="simulation">Simulation to attach the chunk to.</param>
+    /// <param name="chunk">Chunk to attach.</param>
+    public static void Attach(Simulation simulation, ref StaticChunk chunk)
+    {
+        if (chunk.Attached != 0)
+            throw new InvalidOperationException("Static chunk is already attached.");
+        if (chunk.Compound.Children.Length > 0)
+        {
+            //The simulation stores a copy of the compound that shares the chunk's buffers, so detaching must not dispose it.
+            chunk.CompoundShape = simulation.Shapes.Add(chunk.Compound);
+            chunk.CompoundStatic = simulation.Statics.Add(new StaticDescription(Vector3.Zero, chunk.CompoundShape));
+        }
+        for (int i = 0; i < chunk.LooseStatics.Length; ++i)
+        {
+            chunk.LooseStaticHandles[i] = simulation.Statics.Add(chunk.LooseStatics[i]);
+        }
+        chunk.Attached = 1;
+    }
+
+    /// <summary>
+    /// Removes a chunk's statics from a simulation. The chunk keeps its buffers and can be attached again.
+    /// </summary>
+    /// <param name="simulation">Simulation to detach the chunk from.</param>
+    /// <param name="chunk">Chunk to detach.</param>
+    public static void Detach(Simulation simulation, ref StaticChunk chunk)
+    {
+        if (chunk.Attached == 0)
+            throw new InvalidOperationException("Static chunk is not attached.");
+        if (chunk.Compound.Children.Length > 0)
+        {
+            simulation.Statics.Remove(chunk.CompoundStatic);
+            simulation.Shapes.Remove(chunk.CompoundShape);
+        }
+        for (int i = 0; i < chunk.LooseStatics.Length; ++i)
+        {
+            simulation.Statics.Remove(chunk.LooseStaticHandles[i]);
+        }
+        chunk.Attached = 0;
+    }
+
+    /// <summary>
+    /// Returns a detached chunk's buffers to the pool they were allocated from.
+    /// </summary>
+    /// <param name="chunk">Chunk to dispose.</param>
+    /// <param name="pool">Pool the chunk was created with.</param>
+    public static void Dispose(ref StaticChunk chunk, BufferPool pool)
+    {
+        if (chunk.Attached != 0)
+            throw new InvalidOperationException("Static chunks must be detached before they are destroyed.");
+        if (chunk.Compound.Children.Allocated)
+            chunk.Compound.Dispose(pool);
+        if (chunk.LooseStatics.Allocated)
+        {
+            pool.Return(ref chunk.LooseStatics);
+            pool.Return(ref chunk.LooseStaticHandles);
+        }
+        chunk = default;
+    }
+}
@@ -0,0 +1,507 @@
+﻿using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.CollisionDetection.CollisionTasks;
+using BepuPhysics.Trees;
+using BepuUtilities;
+using BepuUtilities.Memory;
+using System;
+using System.Numerics;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace AbominationInterop;
+
+/// <summary>
+/// Integer coordinate of a cell in a grid.
+/// </summary>
+public struct Int3
+{
+    public int X;
+    public int Y;
+    public int Z;
+}
+
+/// <summary>
+/// Occupancy of an 8x8x8 block of voxels within a <see cref="VoxelGrid"/>.
+/// </summary>
+/// <remarks>Voxel (x, y, z) within the brick is bit y * 8 + x of <see cref="Occupancy"/>[z].</remarks>
+[StructLayout(LayoutKind.Sequential)]
+public unsafe struct VoxelBrick
+{
+    /// <summary>
+    /// One 64 bit slice of occupancy bits per local Z coordinate.
+    /// </summary>
+    public fixed ulong Occupancy[8];
+    /// <summary>
+    /// Index of the brick cell in <see cref="VoxelGrid.BrickIndices"/> that refers to this brick.
+    /// </summary>
+    public int BrickCellIndex;
+}
+
+/// <summary>
+/// Sparse grid of uniformly sized cubic voxels, exposed to collision detection as the triangles of the faces between occupied and empty voxels.
+/// </summary>
+/// <remarks>Voxel (x, y, z) spans local positions (x, y, z) * VoxelSize to (x + 1, y + 1, z + 1) * VoxelSize.
+/// Occupancy is stored in 8x8x8 bricks; a dense grid of brick indices gives constant time lookup of any voxel, and bricks with no occupied voxels take no storage.
+/// Face f of voxel v is made of children v * 12 + f * 2 and that plus one, where v = (z * SizeY + y) * SizeX + x and faces are ordered -X, +X, -Y, +Y, -Z, +Z.
+/// Faces shared by two occupied voxels are never reported, so contact generation sees one closed surface with no internal edges.
+/// Triangles face out of the occupied volume and, like mesh triangles, only collide from that side.</remarks>
+[StructLayout(LayoutKind.Sequential)]
+public unsafe struct VoxelGrid : IHomogeneousCompoundShape<Triangle, TriangleWide>
+{
+    /// <summary>
+    /// Number of voxels along each axis of a brick.
+    /// </summary>
+    public const int BrickSize = 8;
+    /// <summary>
+    /// Number of triangle children reserved for each voxel.
+    /// </summary>
+    public const int ChildrenPerVoxel = 12;
+
+    /// <summary>
+    /// Index into <see cref="Bricks"/> for each brick cell of the grid, row by row along X and then Y, or -1 for brick cells with no occupied voxels.
+    /// </summary>
+    public Buffer<int> BrickIndices;
+    /// <summary>
+    /// Storage for bricks with at least one occupied voxel. Only the first <see cref="BrickCount"/> slots are in use.
+    /// </summary>
+    public Buffer<VoxelBrick> Bricks;
+    /// <summary>
+    /// Number of bricks in use.
+    /// </summary>
+    public int BrickCount;
+    /// <summary>
+    /// Number of voxels along the local X axis.
+    /// </summary>
+    public int SizeX;
+    /// <summary>
+    /// Number of voxels along the local Y axis.
+    /// </summary>
+    public int SizeY;
+    /// <summary>
+    /// Number of voxels along the local Z axis.
+    /// </summary>
+    public int SizeZ;
+    /// <summary>
+    /// Number of brick cells along the local X axis.
+    /// </summary>
+    public int BrickCountX;
+    /// <summary>
+    /// Number of brick cells along the local Y axis.
+    /// </summary>
+    public int BrickCountY;
+    /// <summary>
+    /// Number of brick cells along the local Z axis.
+    /// </summary>
+    public int BrickCountZ;
+    /// <summary>
+    /// Edge length of each voxel.
+    /// </summary>
+    public float VoxelSize;
+
+    /// <summary>
+    /// Type id of voxel grid shapes.
+    /// </summary>
+    public const int Id = 11;
+    public static int TypeId => Id;
+
+    public static ShapeBatch CreateShapeBatch(BufferPool pool, int initialCapacity, Shapes shapeBatches)
+    {
+        return new HomogeneousCompoundShapeBatch<VoxelGrid, Triangle, TriangleWide>(pool, initialCapacity);
+    }
+
+    public readonly int ChildCount => SizeX * SizeY * SizeZ * ChildrenPerVoxel;
+
+    //Cube corners for each face, with bit 0 selecting +X, bit 1 selecting +Y, and bit 2 selecting +Z. 
+    //Each face's triangles are corners (0, 1, 2) and (0, 2, 3). The triangle normal is cross(C - A, B - A), so corners run clockwise when viewed from outside the voxel.
+    static ReadOnlySpan<byte> FaceCorners => new byte[]
+    {
+        2, 6, 4, 0,
+        5, 7, 3, 1,
+        4, 5, 1, 0,
+        3, 7, 6, 2,
+        1, 3, 2, 0,
+        6, 7, 5, 4,
+    };
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    readonly int GetBrickCellIndex(int x, int y, int z)
+    {
+        return ((z >> 3) * BrickCountY + (y >> 3)) * BrickCountX + (x >> 3);
+    }
+
+    /// <summary>
+    /// Checks whether a voxel is occupied. Coordinates outside the grid are treated as empty.
+    /// </summary>
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    public readonly bool IsOccupied(int x, int y, int z)
+    {
+        if ((uint)x >= (uint)SizeX || (uint)y >= (uint)SizeY || (uint)z >= (uint)SizeZ)
+            return false;
+        var brickIndex = BrickIndices[GetBrickCellIndex(x, y, z)];
+        if (brickIndex < 0)
+            return false;
+        return ((Bricks[brickIndex].Occupancy[z & 7] >> (((y & 7) << 3) | (x & 7))) & 1) != 0;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    readonly bool IsFaceExposed(int x, int y, int z, int face)
+    {
+        var offset = (face & 1) == 0 ? -1 : 1;
+        return (face >> 1) switch
+        {
+            0 => !IsOccupied(x + offset, y, z),
+            1 => !IsOccupied(x, y + offset, z),
+            _ => !IsOccupied(x, y, z + offset),
+        };
+    }
+
+    public readonly void GetLocalChild(int childIndex, out Triangle target)
+    {
+        var voxelIndex = childIndex / ChildrenPerVoxel;
+        var faceTriangle = childIndex - voxelIndex * ChildrenPerVoxel;
+        var face = faceTriangle >> 1;
+        var yz = voxelIndex / SizeX;
+        var x = voxelIndex - yz * SizeX;
+        var z = yz / SizeY;
+        var y = yz - z * SizeY;
+        var corners = FaceCorners.Slice(face * 4, 4);
+        var secondCorner = (faceTriangle & 1) == 0 ? 1 : 2;
+        var origin = new Vector3(x, y, z);
+        target.A = (origin + GetCornerOffset(corners[0])) * VoxelSize;
+        target.B = (origin + GetCornerOffset(corners[secondCorner])) * VoxelSize;
+        target.C = (origin + GetCornerOffset(corners[secondCorner + 1])) * VoxelSize;
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    static Vector3 GetCornerOffset(int corner)
+    {
+        return new Vector3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1);
+    }
+
+    public readonly void GetPosedLocalChild(int childIndex, out Triangle target, out RigidPose childPose)
+    {
+        GetLocalChild(childIndex, out target);
+        childPose.Orientation = Quaternion.Identity;
+        childPose.Position = (target.A + target.B + target.C) * (1f / 3f);
+        target.A -= childPose.Position;
+        target.B -= childPose.Position;
+        target.C -= childPose.Position;
+    }
+
+    public readonly void GetLocalChild(int childIndex, ref TriangleWide target)
+    {
+        //This inserts a triangle into the first slot of the given wide instance.
+        GetLocalChild(childIndex, out Triangle triangle);
+        Vector3Wide.WriteFirst(triangle.A, ref target.A);
+        Vector3Wide.WriteFirst(triangle.B, ref target.B);
+        Vector3Wide.WriteFirst(triangle.C, ref target.C);
+    }
+
+    public readonly void ComputeBounds(Quaternion orientation, out Vector3 min, out Vector3 max)
+    {
+        //Bounds cover the whole grid rather than the occupied voxels so that edits never need to update them.
+        Matrix3x3.CreateFromQuaternion(orientation, out var rotation);
+        var extent = new Vector3(SizeX, SizeY, SizeZ) * VoxelSize;
+        min = new Vector3(float.MaxValue);
+        max = new Vector3(float.MinValue);
+        for (int i = 0; i < 8; ++i)
+        {
+            Matrix3x3.Transform(GetCornerOffset(i) * extent, rotation, out var rotated);
+            min = Vector3.Min(min, rotated);
+            max = Vector3.Max(max, rotated);
+        }
+    }
+
+    [MethodImpl(MethodImplOptions.AggressiveInlining)]
+    readonly void AddExposedFaces<TSubpairOverlaps>(int x, int y, int z, BufferPool pool, ref TSubpairOverlaps overlaps) where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        var baseChildIndex = ((z * SizeY + y) * SizeX + x) * ChildrenPerVoxel;
+        for (int face = 0; face < 6; ++face)
+        {
+            if (IsFaceExposed(x, y, z, face))
+            {
+                overlaps.Allocate(pool) = baseChildIndex + face * 2;
+                overlaps.Allocate(pool) = baseChildIndex + face * 2 + 1;
+            }
+        }
+    }
+
+    readonly void GetOverlaps<TSubpairOverlaps>(Vector3 min, Vector3 max, BufferPool pool, ref TSubpairOverlaps overlaps) where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        var inverseVoxelSize = 1f / VoxelSize;
+        //Clamp while still in float; huge or swept bounds would overflow the int conversion and skip every voxel.
+        var minVoxel = Vector3.Max(Vector3.Zero, new Vector3(MathF.Floor(min.X * inverseVoxelSize), MathF.Floor(min.Y * inverseVoxelSize), MathF.Floor(min.Z * inverseVoxelSize)));
+        var maxVoxel = Vector3.Min(new Vector3(SizeX - 1, SizeY - 1, SizeZ - 1), new Vector3(MathF.Floor(max.X * inverseVoxelSize), MathF.Floor(max.Y * inverseVoxelSize), MathF.Floor(max.Z * inverseVoxelSize)));
+        if (!(minVoxel.X <= maxVoxel.X && minVoxel.Y <= maxVoxel.Y && minVoxel.Z <= maxVoxel.Z))
+            return;
+        var minX = (int)minVoxel.X;
+        var minY = (int)minVoxel.Y;
+        var minZ = (int)minVoxel.Z;
+        var maxX = (int)maxVoxel.X;
+        var maxY = (int)maxVoxel.Y;
+        var maxZ = (int)maxVoxel.Z;
+        //Walk the touched bricks first so that empty bricks are skipped with a single lookup.
+        for (int brickZ = minZ >> 3; brickZ <= maxZ >> 3; ++brickZ)
+        {
+            for (int brickY = minY >> 3; brickY <= maxY >> 3; ++brickY)
+            {
+                for (int brickX = minX >> 3; brickX <= maxX >> 3; ++brickX)
+                {
+                    var brickIndex = BrickIndices[(brickZ * BrickCountY + brickY) * BrickCountX + brickX];
+                    if (brickIndex < 0)
+                        continue;
+                    ref var brick = ref Bricks[brickIndex];
+                    var startX = Math.Max(minX, brickX << 3);
+                    var startY = Math.Max(minY, brickY << 3);
+                    var startZ = Math.Max(minZ, brickZ << 3);
+                    var endX = Math.Min(maxX, (brickX << 3) + 7);
+                    var endY = Math.Min(maxY, (brickY << 3) + 7);
+                    var endZ = Math.Min(maxZ, (brickZ << 3) + 7);
+                    for (int z = startZ; z <= endZ; ++z)
+                    {
+                        var slice = brick.Occupancy[z & 7];
+                        if (slice == 0)
+                            continue;
+                        for (int y = startY; y <= endY; ++y)
+                        {
+                            var row = (slice >> ((y & 7) << 3)) & 0xFF;
+                            if (row == 0)
+                                continue;
+                            for (int x = startX; x <= endX; ++x)
+                            {
+                                if (((row >> (x & 7)) & 1) != 0)
+                                    AddExposedFaces(x, y, z, pool, ref overlaps);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    public readonly void FindLocalOverlaps<TOverlaps, TSubpairOverlaps>(ref Buffer<OverlapQueryForPair> pairs, BufferPool pool, Shapes shapes, ref TOverlaps overlaps)
+        where TOverlaps : struct, ICollisionTaskOverlaps<TSubpairOverlaps>
+        where TSubpairOverlaps : struct, ICollisionTaskSubpairOverlaps
+    {
+        for (int i = 0; i < pairs.Length; ++i)
+        {
+            ref var pair = ref pairs[i];
+            Unsafe.AsRef<VoxelGrid>(pair.Container).GetOverlaps(pair.Min, pair.Max, pool, ref overlaps.GetOverlapsForPair(i));
+        }
+    }
+
+    public readonly void FindLocalOverlaps<TOverlaps>(Vector3 min, Vector3 max, Vector3 sweep, float maximumT, BufferPool pool, Shapes shapes, void* overlaps)
+        where TOverlaps : ICollisionTaskSubpairOverlaps
+    {
+        var sweepOffset = sweep * maximumT;
+        GetOverlaps(Vector3.Min(min, min + sweepOffset), Vector3.Max(max, max + sweepOffset), pool, ref Unsafe.AsRef<TOverlaps>(overlaps));
+    }
+
+    public readonly void RayTest<TRayHitHandler>(in RigidPose pose, in RayData ray, ref float maximumT, BufferPool pool, ref TRayHitHandler hitHandler) where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        if (SizeX <= 0 || SizeY <= 0 || SizeZ <= 0)
+            return;
+        Matrix3x3.CreateFromQuaternion(pose.Orientation, out var orientation);
+        Matrix3x3.TransformTranspose(ray.Origin - pose.Position, orientation, out var origin);
+        Matrix3x3.TransformTranspose(ray.Direction, orientation, out var direction);
+
+        //Clip the ray against the grid's local bounds, then walk the voxels it crosses in order of increasing t.
+        var boundsMax = new Vector3(SizeX, SizeY, SizeZ) * VoxelSize;
+        var inverseDirection = new Vector3(
+            direction.X != 0 ? 1f / direction.X : float.MaxValue,
+            direction.Y != 0 ? 1f / direction.Y : float.MaxValue,
+            direction.Z != 0 ? 1f / direction.Z : float.MaxValue);
+        var t0 = -origin * inverseDirection;
+        var t1 = (boundsMax - origin) * inverseDirection;
+        var tMin = Vector3.Min(t0, t1);
+        var tMax = Vector3.Max(t0, t1);
+        var tEntry = MathF.Max(MathF.Max(tMin.X, tMin.Y), MathF.Max(tMin.Z, 0));
+        var tExit = MathF.Min(MathF.Min(tMax.X, tMax.Y), MathF.Min(tMax.Z, maximumT));
+        if (tEntry > tExit)
+            return;
+        var entry = (origin + direction * tEntry) / VoxelSize;
+        var x = Math.Clamp((int)MathF.Floor(entry.X), 0, SizeX - 1);
+        var y = Math.Clamp((int)MathF.Floor(entry.Y), 0, SizeY - 1);
+        var z = Math.Clamp((int)MathF.Floor(entry.Z), 0, SizeZ - 1);
+        var stepX = direction.X > 0 ? 1 : -1;
+        var stepY = direction.Y > 0 ? 1 : -1;
+        var stepZ = direction.Z > 0 ? 1 : -1;
+        var tDeltaX = MathF.Abs(VoxelSize * inverseDirection.X);
+        var tDeltaY = MathF.Abs(VoxelSize * inverseDirection.Y);
+        var tDeltaZ = MathF.Abs(VoxelSize * inverseDirection.Z);
+        var tNextX = direction.X != 0 ? ((x + (stepX > 0 ? 1 : 0)) * VoxelSize - origin.X) * inverseDirection.X : float.MaxValue;
+        var tNextY = direction.Y != 0 ? ((y + (stepY > 0 ? 1 : 0)) * VoxelSize - origin.Y) * inverseDirection.Y : float.MaxValue;
+        var tNextZ = direction.Z != 0 ? ((z + (stepZ > 0 ? 1 : 0)) * VoxelSize - origin.Z) * inverseDirection.Z : float.MaxValue;
+        while (true)
+        {
+            if (IsOccupied(x, y, z))
+            {
+                var baseChildIndex = ((z * SizeY + y) * SizeX + x) * ChildrenPerVoxel;
+                for (int face = 0; face < 6; ++face)
+                {
+                    if (!IsFaceExposed(x, y, z, face))
+                        continue;
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        var childIndex = baseChildIndex + face * 2 + i;
+                        if (!hitHandler.AllowTest(childIndex))
+                            continue;
+                        GetLocalChild(childIndex, out Triangle triangle);
+                        if (Triangle.RayTest(triangle.A, triangle.B, triangle.C, origin, direction, out var t, out var normal) && t <= maximumT)
+                        {
+                            Matrix3x3.Transform(normal, orientation, out normal);
+                            hitHandler.OnRayHit(ray, ref maximumT, t, normal, childIndex);
+                        }
+                    }
+                }
+            }
+            //Voxels are visited in order, so nothing further along can beat a hit on the current voxel's faces.
+            var tVoxelExit = MathF.Min(tNextX, MathF.Min(tNextY, tNextZ));
+            if (tVoxelExit >= MathF.Min(tExit, maximumT))
+                break;
+            if (tNextX <= tNextY && tNextX <= tNextZ)
+            {
+                x += stepX;
+                tNextX += tDeltaX;
+                if (x < 0 || x >= SizeX)
+                    break;
+            }
+            else if (tNextY <= tNextZ)
+            {
+                y += stepY;
+                tNextY += tDeltaY;
+                if (y < 0 || y >= SizeY)
+                    break;
+            }
+            else
+            {
+                z += stepZ;
+                tNextZ += tDeltaZ;
+                if (z < 0 || z >= SizeZ)
+                    break;
+            }
+        }
+    }
+
+    public readonly void RayTest<TRayHitHandler>(in RigidPose pose, ref RaySource rays, BufferPool pool, ref TRayHitHandler hitHandler) where TRayHitHandler : struct, IShapeRayHitHandler
+    {
+        for (int i = 0; i < rays.RayCount; ++i)
+        {
+            rays.GetRay(i, out var ray, out var maximumT);
+            RayTest(pose, *ray, ref *maximumT, pool, ref hitHandler);
+        }
+    }
+
+    /// <summary>
+    /// Sets the occupancy of a single voxel. Only the brick containing the voxel is touched; a brick is allocated when its first voxel is set and released when its last voxel is cleared.
+    /// </summary>
+    /// <param name="x">X coordinate of the voxel.</param>
+    /// <param name="y">Y coordinate of the voxel.</param>
+    /// <param name="z">Z coordinate of the voxel.</param>
+    /// <param name="occupied">Whether the voxel should be occupied.</param>
+    /// <param name="pool">Pool that the grid's buffers were allocated from.</param>
+    public void SetVoxel(int x, int y, int z, bool occupied, BufferPool pool)
+    {
+        if ((uint)x >= (uint)SizeX || (uint)y >= (uint)SizeY || (uint)z >= (uint)SizeZ)
+            throw new ArgumentOutOfRangeException(nameof(x), $"Voxel ({x}, {y}, {z}) is outside of the {SizeX}x{SizeY}x{SizeZ} grid.");
+        var brickCellIndex = GetBrickCellIndex(x, y, z);
+        var brickIndex = BrickIndices[brickCellIndex];
+        var bit = 1UL << (((y & 7) << 3) | (x & 7));
+        if (occupied)
+        {
+            if (brickIndex < 0)
+            {
+                if (BrickCount == Bricks.Length)
+                    pool.ResizeToAtLeast(ref Bricks, Math.Max(16, BrickCount * 2), BrickCount);
+                brickIndex = BrickCount++;
+                ref var newBrick = ref Bricks[brickIndex];
+                newBrick = default;
+                newBrick.BrickCellIndex = brickCellIndex;
+                BrickIndices[brickCellIndex] = brickIndex;
+            }
+            Bricks[brickIndex].Occupancy[z & 7] |= bit;
+        }
+        else if (brickIndex >= 0)
+        {
+            ref var brick = ref Bricks[brickIndex];
+            brick.Occupancy[z & 7] &= ~bit;
+            ulong any = 0;
+            for (int i = 0; i < BrickSize; ++i)
+                any |= brick.Occupancy[i];
+            if (any == 0)
+            {
+                //Keep the used bricks contiguous by moving the last brick into the emptied slot.
+                BrickIndices[brickCellIndex] = -1;
+                --BrickCount;
+                if (brickIndex != BrickCount)
+                {
+                    brick = Bricks[BrickCount];
+                    BrickIndices[brick.BrickCellIndex] = brickIndex;
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Sets the occupancy of a set of voxels.
+    /// </summary>
+    /// <param name="coordinates">Coordinates of the voxels to set.</param>
+    /// <param name="values">Occupancy of each voxel; nonzero values mark a voxel as occupied. Must be at least as long as <paramref name="coordinates"/>.</param>
+    /// <param name="pool">Pool that the grid's buffers were allocated from.</param>
+    public void SetVoxels(Buffer<Int3> coordinates, Buffer<byte> values, BufferPool pool)
+    {
+        if (values.Length < coordinates.Length)
+            throw new ArgumentException($"Setting {coordinates.Length} voxels requires as many values, but only {values.Length} were provided.");
+        for (int i = 0; i < coordinates.Length; ++i)
+        {
+            ref var coordinate = ref coordinates[i];
+            SetVoxel(coordinate.X, coordinate.Y, coordinate.Z, values[i] != 0, pool);
+        }
+    }
+
+    public void Dispose(BufferPool pool)
+    {
+        pool.Return(ref BrickIndices);
+        pool.Return(ref Bricks);
+        BrickCount = 0;
+    }
+
+    /// <summary>
+    /// Creates a voxel grid with buffers taken from a pool.
+    /// </summary>
+    /// <param name="sizeX">Number of voxels along the local X axis.</param>
+    /// <param name="sizeY">Number of voxels along the local Y axis.</param>
+    /// <param name="sizeZ">Number of voxels along the local Z axis.</param>
+    /// <param name="voxelSize">Edge length of each voxel.</param>
+    /// <param name="occupiedVoxels">Coordinates of the voxels that start out occupied.</param>
+    /// <param name="pool">Pool to allocate the grid's buffers from.</param>
+    /// <returns>Created voxel grid.</returns>
+    public static VoxelGrid Create(int sizeX, int sizeY, int sizeZ, float voxelSize, Buffer<Int3> occupiedVoxels, BufferPool pool)
+    {
+        if (sizeX <= 0 || sizeY <= 0 || sizeZ <= 0)
+            throw new ArgumentException("Voxel grids require at least one voxel along each axis.");
+        if (!(voxelSize > 0))
+            throw new ArgumentException("Voxel size must be positive.");
+        if ((long)sizeX * sizeY * sizeZ * ChildrenPerVoxel > int.MaxValue)
+            throw new ArgumentException($"A {sizeX}x{sizeY}x{sizeZ} voxel grid has too many voxels to index its faces with 32 bit child indices.");
+        VoxelGrid grid = default;
+        grid.SizeX = sizeX;
+        grid.SizeY = sizeY;
+        grid.SizeZ = sizeZ;
+        grid.BrickCountX = (sizeX + BrickSize - 1) / BrickSize;
+        grid.BrickCountY = (sizeY + BrickSize - 1) / BrickSize;
+        grid.BrickCountZ = (sizeZ + BrickSize - 1) / BrickSize;
+        grid.VoxelSize = voxelSize;
+        pool.Take(grid.BrickCountX * grid.BrickCountY * grid.BrickCountZ, out grid.BrickIndices);
+        new Span<int>(grid.BrickIndices.Memory, grid.BrickIndices.Length).Fill(-1);
+        pool.Take(16, out grid.Bricks);
+        for (int i = 0; i < occupiedVoxels.Length; ++i)
+        {
+            ref var voxel = ref occupiedVoxels[i];
+            grid.SetVoxel(voxel.X, voxel.Y, voxel.Z, true, pool);
+        }
+        return grid;
+    }
+}
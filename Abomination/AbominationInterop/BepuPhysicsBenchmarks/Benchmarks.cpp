@@ -0,0 +1,649 @@
+#include "BepuPhysics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace Bepu;
+
+//Runs a set of standard scenes for a fixed number of steps at several thread counts and writes the timings as JSON.
+//Usage: BepuPhysicsBenchmarks [--steps N] [--warmup N] [--threads 1,2,4] [--scenario name] [--allow-sleep] [--output path]
+//By default every scenario runs at 1 thread, then doubling up to the platform's thread count.
+
+//Every narrow phase hook is left null, so collision filtering and materials use the defaults and no pair crosses the interop boundary.
+//That keeps the numbers about the engine and the stepping entrypoints rather than about a particular set of callbacks.
+struct BenchmarkNarrowPhaseCallbacks : NarrowPhaseCallbacksBase<BenchmarkNarrowPhaseCallbacks>
+{
+};
+
+struct PoseIntegrationSettings
+{
+	Vector3 GravityDt;
+	float DampingDt;
+};
+
+PoseIntegrationSettings poseIntegrationSettings;
+
+void PrepareForIntegration(SimulationHandle simulation, float dt)
+{
+	poseIntegrationSettings.GravityDt = Vector3(0, -10.0f * dt, 0);
+	poseIntegrationSettings.DampingDt = std::pow(0.99f, dt);
+}
+
+void IntegrateVelocityScalar(SimulationHandle simulation, int32_t bodyIndex, Vector3 position, Quaternion orientation, BodyInertia localInertia, int32_t workerIndex, float dt, BodyVelocity* velocity)
+{
+	//Kinematics aren't integrated (IntegrateVelocityForKinematics is false), so every body seen here is dynamic.
+	velocity->Linear.X = (velocity->Linear.X + poseIntegrationSettings.GravityDt.X) * poseIntegrationSettings.DampingDt;
+	velocity->Linear.Y = (velocity->Linear.Y + poseIntegrationSettings.GravityDt.Y) * poseIntegrationSettings.DampingDt;
+	velocity->Linear.Z = (velocity->Linear.Z + poseIntegrationSettings.GravityDt.Z) * poseIntegrationSettings.DampingDt;
+	velocity->Angular.X *= poseIntegrationSettings.DampingDt;
+	velocity->Angular.Y *= poseIntegrationSettings.DampingDt;
+	velocity->Angular.Z *= poseIntegrationSettings.DampingDt;
+}
+
+Vector3 Add(Vector3 a, Vector3 b) { return Vector3(a.X + b.X, a.Y + b.Y, a.Z + b.Z); }
+Vector3 Subtract(Vector3 a, Vector3 b) { return Vector3(a.X - b.X, a.Y - b.Y, a.Z - b.Z); }
+
+template<typename T>
+Buffer<T> AsBuffer(std::vector<T>& values)
+{
+	return Buffer<T>{ values.data(), (int32_t)values.size(), -1 };
+}
+
+/// <summary>
+/// Collects constraints of one type so a scenario can add them all with a single AddConstraints call.
+/// </summary>
+template<typename TDescription>
+struct ConstraintBatch
+{
+	std::vector<BodyHandle> Bodies;
+	std::vector<TDescription> Descriptions;
+
+	void Add(BodyHandle a, BodyHandle b, const TDescription& description)
+	{
+		Bodies.push_back(a);
+		Bodies.push_back(b);
+		Descriptions.push_back(description);
+	}
+
+	int32_t Flush(SimulationHandle simulation)
+	{
+		auto count = (int32_t)Descriptions.size();
+		if (count == 0)
+			return 0;
+		std::vector<ConstraintHandle> handles(count);
+		auto handleBuffer = AsBuffer(handles);
+		auto bodies = AsBuffer(Bodies);
+		auto descriptions = AsBuffer(Descriptions);
+		AddConstraints(simulation, TDescription::Type, bodies, descriptions, &handleBuffer);
+		Bodies.clear();
+		Descriptions.clear();
+		return count;
+	}
+};
+
+/// <summary>
+/// Object counts of a populated scenario, reported next to its timings.
+/// </summary>
+struct ScenarioCounts
+{
+	int32_t Bodies = 0;
+	int32_t Statics = 0;
+	int32_t Joints = 0;
+};
+
+struct ScenarioContext
+{
+	SimulationHandle Simulation;
+	BufferPoolHandle Pool;
+	ThreadDispatcherHandle Dispatcher;
+	float SleepThreshold;
+	ScenarioCounts Counts;
+	//Optional sanity check: bodies listed here should still be above GroundHeight once warmup is done. A scene whose bodies fall through its ground isn't measuring what it claims to.
+	float (*GroundHeight)(float x, float z) = nullptr;
+	std::vector<BodyHandle> GroundedBodies;
+
+	BodyHandle AddDynamic(Vector3 position, BodyInertia inertia, TypedIndex shape, Quaternion orientation = Quaternion::GetIdentity(), BodyVelocity velocity = BodyVelocity())
+	{
+		++Counts.Bodies;
+		return AddBody(Simulation, BodyDescription::CreateDynamic(RigidPose(position, orientation), velocity, inertia, CollidableDescription(shape, 0.1f), BodyActivityDescription(SleepThreshold)));
+	}
+
+	StaticHandle AddFixed(Vector3 position, TypedIndex shape)
+	{
+		++Counts.Statics;
+		return AddStatic(Simulation, StaticDescription::Create(RigidPose(position), shape));
+	}
+
+	void AddGround(float width)
+	{
+		AddFixed(Vector3(0, -0.5f, 0), AddBox(Simulation, Box(width, 1, width)));
+	}
+};
+
+/// <summary>
+/// Describes a benchmark scene: how to create its simulation and what to put in it.
+/// </summary>
+struct Scenario
+{
+	const char* Name;
+	SolveDescription Solve;
+	SimulationAllocationSizes AllocationSizes;
+	void (*Populate)(ScenarioContext& context);
+};
+
+//Sixteen pyramids of 20 rows; tall stacks stress solver convergence and constraint batching.
+void PopulateBoxPyramids(ScenarioContext& context)
+{
+	context.AddGround(500);
+	Box box(1, 1, 1);
+	auto shape = AddBox(context.Simulation, box);
+	auto inertia = ComputeBoxInertia(box, 1);
+	const int pyramidCount = 16;
+	const int rowCount = 20;
+	for (int pyramidIndex = 0; pyramidIndex < pyramidCount; ++pyramidIndex)
+	{
+		float z = (pyramidIndex - (pyramidCount - 1) * 0.5f) * 4;
+		for (int rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+		{
+			int columnCount = rowCount - rowIndex;
+			for (int columnIndex = 0; columnIndex < columnCount; ++columnIndex)
+			{
+				context.AddDynamic(Vector3((columnIndex - (columnCount - 1) * 0.5f) * 1.0f, 0.5f + rowIndex, z), inertia, shape);
+			}
+		}
+	}
+}
+
+//Ten thousand mixed convexes dropped into a walled pit; measures broad phase churn and contact generation while the pile forms.
+void PopulatePile(ScenarioContext& context)
+{
+	context.AddGround(200);
+	auto wall = AddBox(context.Simulation, Box(1, 20, 36));
+	auto wallRotated = AddBox(context.Simulation, Box(36, 20, 1));
+	context.AddFixed(Vector3(-18, 10, 0), wall);
+	context.AddFixed(Vector3(18, 10, 0), wall);
+	context.AddFixed(Vector3(0, 10, -18), wallRotated);
+	context.AddFixed(Vector3(0, 10, 18), wallRotated);
+
+	Box box(1, 1, 1);
+	Sphere sphere{ 0.5f };
+	Capsule capsule{ 0.3f, 0.4f };
+	TypedIndex shapes[] = { AddBox(context.Simulation, box), AddSphere(context.Simulation, sphere), AddCapsule(context.Simulation, capsule) };
+	BodyInertia inertias[] = { ComputeBoxInertia(box, 1), ComputeSphereInertia(sphere, 1), ComputeCapsuleInertia(capsule, 1) };
+	const int width = 20;
+	const int height = 25;
+	int index = 0;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int z = 0; z < width; ++z)
+			{
+				auto type = index++ % 3;
+				//Alternate the layers' offsets slightly so columns don't land perfectly stacked.
+				float offset = (y & 1) * 0.3f;
+				context.AddDynamic(Vector3((x - (width - 1) * 0.5f) * 1.5f + offset, 2 + y * 1.5f, (z - (width - 1) * 0.5f) * 1.5f + offset), inertias[type], shapes[type]);
+			}
+		}
+	}
+}
+
+//A grid of jointed ragdolls running into each other; constraint heavy with many small islands.
+void PopulateRagdollCrowd(ScenarioContext& context)
+{
+	context.AddGround(500);
+	Box pelvisBox(0.35f, 0.2f, 0.2f);
+	Box torsoBox(0.4f, 0.5f, 0.25f);
+	Sphere headSphere{ 0.13f };
+	Capsule armCapsule{ 0.06f, 0.12f };
+	Capsule legCapsule{ 0.08f, 0.14f };
+	auto pelvisShape = AddBox(context.Simulation, pelvisBox);
+	auto torsoShape = AddBox(context.Simulation, torsoBox);
+	auto headShape = AddSphere(context.Simulation, headSphere);
+	auto armShape = AddCapsule(context.Simulation, armCapsule);
+	auto legShape = AddCapsule(context.Simulation, legCapsule);
+	auto pelvisInertia = ComputeBoxInertia(pelvisBox, 1);
+	auto torsoInertia = ComputeBoxInertia(torsoBox, 1.5f);
+	auto headInertia = ComputeSphereInertia(headSphere, 0.5f);
+	auto armInertia = ComputeCapsuleInertia(armCapsule, 0.3f);
+	auto legInertia = ComputeCapsuleInertia(legCapsule, 0.6f);
+
+	ConstraintBatch<BallSocket> ballSockets;
+	ConstraintBatch<Hinge> hinges;
+	//Parts are laid out with small gaps so adjacent parts don't start in contact; joints sit in the middle of each gap.
+	auto connectBallSocket = [&](BodyHandle a, Vector3 centerA, BodyHandle b, Vector3 centerB, Vector3 anchor)
+	{
+		BallSocket description;
+		description.LocalOffsetA = Subtract(anchor, centerA);
+		description.LocalOffsetB = Subtract(anchor, centerB);
+		description.SpringSettings = SpringSettings(30, 1);
+		ballSockets.Add(a, b, description);
+	};
+	auto connectHinge = [&](BodyHandle a, Vector3 centerA, BodyHandle b, Vector3 centerB, Vector3 anchor)
+	{
+		Hinge description;
+		description.LocalOffsetA = Subtract(anchor, centerA);
+		description.LocalHingeAxisA = Vector3(1, 0, 0);
+		description.LocalOffsetB = Subtract(anchor, centerB);
+		description.LocalHingeAxisB = Vector3(1, 0, 0);
+		description.SpringSettings = SpringSettings(30, 1);
+		hinges.Add(a, b, description);
+	};
+
+	const int crowdWidth = 16;
+	for (int i = 0; i < crowdWidth; ++i)
+	{
+		for (int j = 0; j < crowdWidth; ++j)
+		{
+			Vector3 origin((i - (crowdWidth - 1) * 0.5f) * 1.5f, 0.5f, (j - (crowdWidth - 1) * 0.5f) * 1.5f);
+			//Everyone walks toward the middle of the crowd so the ragdolls collide and tangle.
+			BodyVelocity velocity(Vector3(-origin.X * 0.2f, 0, -origin.Z * 0.2f), Vector3());
+			auto pelvisCenter = Add(origin, Vector3(0, 1.0f, 0));
+			auto torsoCenter = Add(origin, Vector3(0, 1.4f, 0));
+			auto headCenter = Add(origin, Vector3(0, 1.83f, 0));
+			auto pelvis = context.AddDynamic(pelvisCenter, pelvisInertia, pelvisShape, Quaternion::GetIdentity(), velocity);
+			auto torso = context.AddDynamic(torsoCenter, torsoInertia, torsoShape, Quaternion::GetIdentity(), velocity);
+			auto head = context.AddDynamic(headCenter, headInertia, headShape, Quaternion::GetIdentity(), velocity);
+			connectBallSocket(pelvis, pelvisCenter, torso, torsoCenter, Add(origin, Vector3(0, 1.125f, 0)));
+			connectBallSocket(torso, torsoCenter, head, headCenter, Add(origin, Vector3(0, 1.675f, 0)));
+			for (int side = -1; side <= 1; side += 2)
+			{
+				auto upperArmCenter = Add(origin, Vector3(side * 0.29f, 1.44f, 0));
+				auto lowerArmCenter = Add(origin, Vector3(side * 0.29f, 1.05f, 0));
+				auto upperArm = context.AddDynamic(upperArmCenter, armInertia, armShape, Quaternion::GetIdentity(), velocity);
+				auto lowerArm = context.AddDynamic(lowerArmCenter, armInertia, armShape, Quaternion::GetIdentity(), velocity);
+				connectBallSocket(torso, torsoCenter, upperArm, upperArmCenter, Add(origin, Vector3(side * 0.29f, 1.62f, 0)));
+				connectHinge(upperArm, upperArmCenter, lowerArm, lowerArmCenter, Add(origin, Vector3(side * 0.29f, 1.245f, 0)));
+
+				auto upperLegCenter = Add(origin, Vector3(side * 0.1f, 0.655f, 0));
+				auto lowerLegCenter = Add(origin, Vector3(side * 0.1f, 0.19f, 0));
+				auto upperLeg = context.AddDynamic(upperLegCenter, legInertia, legShape, Quaternion::GetIdentity(), velocity);
+				auto lowerLeg = context.AddDynamic(lowerLegCenter, legInertia, legShape, Quaternion::GetIdentity(), velocity);
+				connectBallSocket(pelvis, pelvisCenter, upperLeg, upperLegCenter, Add(origin, Vector3(side * 0.1f, 0.8875f, 0)));
+				connectHinge(upperLeg, upperLegCenter, lowerLeg, lowerLegCenter, Add(origin, Vector3(side * 0.1f, 0.4225f, 0)));
+			}
+		}
+	}
+	context.Counts.Joints += ballSockets.Flush(context.Simulation);
+	context.Counts.Joints += hinges.Flush(context.Simulation);
+}
+
+float GetTerrainHeight(float x, float z)
+{
+	return 3 * std::sin(x * 0.05f) * std::cos(z * 0.07f) + std::sin(x * 0.3f + z * 0.2f) * 0.3f;
+}
+
+//Motorized four wheeled vehicles driving over a rolling triangle mesh; exercises mesh-convex pairs and hinge/motor constraints.
+void PopulateTerrainVehicles(ScenarioContext& context)
+{
+	const int cellsPerAxis = 128;
+	const float cellSize = 2;
+	const float terrainOffset = -cellsPerAxis * cellSize * 0.5f;
+	auto vertex = [&](int x, int z)
+	{
+		float worldX = terrainOffset + x * cellSize;
+		float worldZ = terrainOffset + z * cellSize;
+		return Vector3(worldX, GetTerrainHeight(worldX, worldZ), worldZ);
+	};
+	//The mesh takes ownership of the triangles; they're returned to the pool when the pool is destroyed.
+	auto triangleCount = cellsPerAxis * cellsPerAxis * 2;
+	auto triangleBytes = Allocate(context.Pool, triangleCount * (int32_t)sizeof(Triangle));
+	Buffer<Triangle> triangles{ (Triangle*)triangleBytes.Memory, triangleCount, triangleBytes.Id };
+	for (int x = 0; x < cellsPerAxis; ++x)
+	{
+		for (int z = 0; z < cellsPerAxis; ++z)
+		{
+			auto v00 = vertex(x, z);
+			auto v01 = vertex(x, z + 1);
+			auto v10 = vertex(x + 1, z);
+			auto v11 = vertex(x + 1, z + 1);
+			auto triangleIndex = (x * cellsPerAxis + z) * 2;
+			//Mesh triangles are one sided with normal cross(C - A, B - A); stepping +X for B and +Z for C faces them up.
+			triangles[triangleIndex] = Triangle{ v00, v10, v01 };
+			triangles[triangleIndex + 1] = Triangle{ v10, v11, v01 };
+		}
+	}
+	auto mesh = CreateMesh(context.Pool, triangles, Vector3(1, 1, 1));
+	context.AddFixed(Vector3(), AddMesh(context.Simulation, mesh));
+
+	Box chassisBox(1.8f, 0.5f, 4);
+	Cylinder wheelCylinder{ 0.45f, 0.15f };
+	auto chassisShape = AddBox(context.Simulation, chassisBox);
+	auto wheelShape = AddCylinder(context.Simulation, wheelCylinder);
+	auto chassisInertia = ComputeBoxInertia(chassisBox, 10);
+	auto wheelInertia = ComputeCylinderInertia(wheelCylinder, 0.5f);
+	//Cylinders are aligned with local Y; rotate the wheels so they roll around X. The rotation maps local Y to world -X, hence the hinge's negated axis on B.
+	const float halfSqrt2 = 0.70710678f;
+	Quaternion wheelOrientation(0, 0, halfSqrt2, halfSqrt2);
+
+	ConstraintBatch<Hinge> hinges;
+	ConstraintBatch<AngularMotor> motors;
+	const int vehiclesPerAxis = 10;
+	for (int i = 0; i < vehiclesPerAxis; ++i)
+	{
+		for (int j = 0; j < vehiclesPerAxis; ++j)
+		{
+			float x = (i - (vehiclesPerAxis - 1) * 0.5f) * 12;
+			float z = (j - (vehiclesPerAxis - 1) * 0.5f) * 12;
+			Vector3 chassisCenter(x, GetTerrainHeight(x, z) + 2, z);
+			auto chassis = context.AddDynamic(chassisCenter, chassisInertia, chassisShape);
+			context.GroundedBodies.push_back(chassis);
+			Vector3 wheelOffsets[] = { Vector3(-1.1f, -0.3f, -1.4f), Vector3(1.1f, -0.3f, -1.4f), Vector3(-1.1f, -0.3f, 1.4f), Vector3(1.1f, -0.3f, 1.4f) };
+			//Alternate directions so vehicles drive into each other.
+			float wheelSpeed = ((i + j) & 1) ? 6.0f : -6.0f;
+			for (auto& wheelOffset : wheelOffsets)
+			{
+				auto wheel = context.AddDynamic(Add(chassisCenter, wheelOffset), wheelInertia, wheelShape, wheelOrientation);
+				Hinge hinge;
+				hinge.LocalOffsetA = wheelOffset;
+				hinge.LocalHingeAxisA = Vector3(1, 0, 0);
+				hinge.LocalOffsetB = Vector3();
+				hinge.LocalHingeAxisB = Vector3(0, -1, 0);
+				hinge.SpringSettings = SpringSettings(30, 1);
+				hinges.Add(chassis, wheel, hinge);
+				AngularMotor motor;
+				motor.TargetVelocityLocalA = Vector3(wheelSpeed, 0, 0);
+				motor.Settings.MaximumForce = 100;
+				motor.Settings.Damping = 0.001f;
+				motors.Add(chassis, wheel, motor);
+			}
+		}
+	}
+	context.Counts.Joints += hinges.Flush(context.Simulation);
+	context.Counts.Joints += motors.Flush(context.Simulation);
+	context.GroundHeight = &GetTerrainHeight;
+}
+
+//Ten thousand static buildings with balls rolling down the streets; most of the scene is idle, so this measures how well statics stay out of the way.
+void PopulateCity(ScenarioContext& context)
+{
+	const int blocksPerAxis = 100;
+	const float blockSpacing = 10;
+	context.AddGround(blocksPerAxis * blockSpacing + 20);
+	const int heightVariantCount = 8;
+	TypedIndex buildingShapes[heightVariantCount];
+	float buildingHeights[heightVariantCount];
+	for (int i = 0; i < heightVariantCount; ++i)
+	{
+		buildingHeights[i] = 5.0f + i * 5;
+		buildingShapes[i] = AddBox(context.Simulation, Box(6, buildingHeights[i], 6));
+	}
+	const float cityOffset = -(blocksPerAxis - 1) * blockSpacing * 0.5f;
+	for (int i = 0; i < blocksPerAxis; ++i)
+	{
+		for (int j = 0; j < blocksPerAxis; ++j)
+		{
+			//Cheap integer hash so building heights look varied but are identical between runs.
+			auto variant = ((uint32_t)i * 73856093u ^ (uint32_t)j * 19349663u) % heightVariantCount;
+			context.AddFixed(Vector3(cityOffset + i * blockSpacing, buildingHeights[variant] * 0.5f, cityOffset + j * blockSpacing), buildingShapes[variant]);
+		}
+	}
+
+	Sphere ball{ 0.5f };
+	auto ballShape = AddSphere(context.Simulation, ball);
+	auto ballInertia = ComputeSphereInertia(ball, 1);
+	const int ballsPerAxis = 45;
+	for (int i = 0; i < ballsPerAxis; ++i)
+	{
+		for (int j = 0; j < ballsPerAxis; ++j)
+		{
+			//Balls start at intersections, which sit halfway between buildings.
+			float x = cityOffset + (i * 2 + 1) * blockSpacing + blockSpacing * 0.5f;
+			float z = cityOffset + (j * 2 + 1) * blockSpacing + blockSpacing * 0.5f;
+			auto alongX = ((i + j) & 1) != 0;
+			BodyVelocity velocity(alongX ? Vector3(8, 0, 0) : Vector3(0, 0, 8), Vector3());
+			context.AddDynamic(Vector3(x, 0.5f, z), ballInertia, ballShape, Quaternion::GetIdentity(), velocity);
+		}
+	}
+}
+
+const Scenario scenarios[] =
+{
+	{ "boxPyramids", SolveDescription(8, 1), SimulationAllocationSizes(4096, 16), &PopulateBoxPyramids },
+	{ "pile", SolveDescription(4, 1), SimulationAllocationSizes(10240, 16), &PopulatePile },
+	{ "ragdollCrowd", SolveDescription(2, 4), SimulationAllocationSizes(4096, 16, 512, 16, 4096), &PopulateRagdollCrowd },
+	{ "terrainVehicles", SolveDescription(2, 4), SimulationAllocationSizes(1024, 16, 128, 16, 2048), &PopulateTerrainVehicles },
+	{ "city", SolveDescription(4, 1), SimulationAllocationSizes(4096, 10240), &PopulateCity },
+};
+
+/// <summary>
+/// Timings and memory measurements for one scenario at one thread count.
+/// </summary>
+struct BenchmarkResult
+{
+	const char* Scenario;
+	int32_t ThreadCount;
+	ScenarioCounts Counts;
+	double SetupMilliseconds;
+	double StepsPerSecond;
+	double MeanMilliseconds;
+	double P50Milliseconds;
+	double P95Milliseconds;
+	double P99Milliseconds;
+	double MaxMilliseconds;
+	uint64_t PeakPoolBytes;
+	uint64_t PeakThreadDispatcherBytes;
+	uint64_t GCBytesBefore;
+	uint64_t GCBytesAfter;
+	uint64_t PeakGCBytes;
+};
+
+struct BenchmarkOptions
+{
+	int32_t StepCount = 512;
+	int32_t WarmupStepCount = 32;
+	float Dt = 1.0f / 60.0f;
+	bool AllowSleep = false;
+	std::vector<int32_t> ThreadCounts;
+	std::string ScenarioFilter;
+	std::string OutputPath;
+};
+
+double GetPercentile(const std::vector<double>& sortedValues, double percentile)
+{
+	//Nearest rank.
+	auto rank = (size_t)std::ceil(percentile * sortedValues.size());
+	return sortedValues[rank > 0 ? rank - 1 : 0];
+}
+
+BenchmarkResult RunScenario(const Scenario& scenario, int32_t threadCount, const BenchmarkOptions& options)
+{
+	using Clock = std::chrono::steady_clock;
+	BenchmarkResult result = {};
+	result.Scenario = scenario.Name;
+	result.ThreadCount = threadCount;
+
+	auto pool = CreateBufferPool();
+	auto dispatcher = CreateThreadDispatcher(threadCount);
+	PoseIntegratorCallbacks poseIntegratorCallbacks = {};
+	poseIntegratorCallbacks.AngularIntegrationMode = AngularIntegrationMode::Nonconserving;
+	poseIntegratorCallbacks.AllowSubstepsForUnconstrainedBodies = false;
+	poseIntegratorCallbacks.IntegrateVelocityForKinematics = false;
+	poseIntegratorCallbacks.UseScalarCallback = true;
+	poseIntegratorCallbacks.PrepareForIntegration = &PrepareForIntegration;
+	poseIntegratorCallbacks.IntegrateVelocityScalar = &IntegrateVelocityScalar;
+
+	auto setupStart = Clock::now();
+	ScenarioContext context;
+	context.Pool = pool;
+	context.Dispatcher = dispatcher;
+	//A negative threshold keeps everything awake, so late steps cost the same as early ones and runs stay comparable.
+	context.SleepThreshold = options.AllowSleep ? 0.01f : -1.0f;
+	context.Simulation = CreateSimulation(pool, BenchmarkNarrowPhaseCallbacks::Create(), poseIntegratorCallbacks, scenario.Solve, scenario.AllocationSizes);
+	scenario.Populate(context);
+	result.Counts = context.Counts;
+	result.SetupMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - setupStart).count();
+
+	for (int i = 0; i < options.WarmupStepCount; ++i)
+		Timestep(context.Simulation, options.Dt, dispatcher);
+	if (context.GroundHeight)
+	{
+		int32_t belowGroundCount = 0;
+		for (auto body : context.GroundedBodies)
+		{
+			auto& position = GetBodyDynamics(context.Simulation, body)->Motion.Pose.Position;
+			if (position.Y < context.GroundHeight(position.X, position.Z))
+				++belowGroundCount;
+		}
+		if (belowGroundCount > 0)
+			std::cerr << "Warning: " << belowGroundCount << " of " << context.GroundedBodies.size() << " " << scenario.Name << " bodies fell below the ground during warmup.\n";
+	}
+
+	std::vector<double> stepMilliseconds(options.StepCount);
+	result.GCBytesBefore = GetGCAllocatedMemorySize();
+	result.PeakGCBytes = result.GCBytesBefore;
+	result.PeakPoolBytes = GetAllocatedMemorySizeInPool(pool);
+	result.PeakThreadDispatcherBytes = GetAllocatedMemorySizeInThreadDispatcher(dispatcher);
+	double totalMilliseconds = 0;
+	for (int i = 0; i < options.StepCount; ++i)
+	{
+		auto stepStart = Clock::now();
+		Timestep(context.Simulation, options.Dt, dispatcher);
+		auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - stepStart).count();
+		stepMilliseconds[i] = elapsed;
+		totalMilliseconds += elapsed;
+		//Sampled outside the timed region; the pool and the GC can both grow mid-run as the scene changes.
+		result.PeakPoolBytes = std::max(result.PeakPoolBytes, GetAllocatedMemorySizeInPool(pool));
+		result.PeakThreadDispatcherBytes = std::max(result.PeakThreadDispatcherBytes, GetAllocatedMemorySizeInThreadDispatcher(dispatcher));
+		result.PeakGCBytes = std::max(result.PeakGCBytes, GetGCAllocatedMemorySize());
+	}
+	result.GCBytesAfter = GetGCAllocatedMemorySize();
+
+	std::sort(stepMilliseconds.begin(), stepMilliseconds.end());
+	result.StepsPerSecond = totalMilliseconds > 0 ? options.StepCount * 1000.0 / totalMilliseconds : 0;
+	result.MeanMilliseconds = totalMilliseconds / options.StepCount;
+	result.P50Milliseconds = GetPercentile(stepMilliseconds, 0.50);
+	result.P95Milliseconds = GetPercentile(stepMilliseconds, 0.95);
+	result.P99Milliseconds = GetPercentile(stepMilliseconds, 0.99);
+	result.MaxMilliseconds = stepMilliseconds.back();
+
+	DestroySimulation(context.Simulation);
+	DestroyThreadDispatcher(dispatcher);
+	//Shapes and the terrain mesh all live in this pool, so destroying it cleans them up too.
+	DestroyBufferPool(pool);
+	return result;
+}
+
+void WriteJson(std::ostream& stream, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results)
+{
+	const char* simdWidths[] = { "SIMD128", "SIMD256", "SIMD512" };
+	stream.precision(6);
+	stream << std::fixed;
+	stream << "{\n";
+	stream << "\t\"simdWidth\": \"" << simdWidths[GetSIMDWidth()] << "\",\n";
+	stream << "\t\"platformThreadCount\": " << GetPlatformThreadCount() << ",\n";
+	stream << "\t\"stepCount\": " << options.StepCount << ",\n";
+	stream << "\t\"warmupStepCount\": " << options.WarmupStepCount << ",\n";
+	stream << "\t\"dt\": " << options.Dt << ",\n";
+	stream << "\t\"allowSleep\": " << (options.AllowSleep ? "true" : "false") << ",\n";
+	stream << "\t\"results\": [";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		auto& result = results[i];
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "\t\t{\n";
+		stream << "\t\t\t\"scenario\": \"" << result.Scenario << "\",\n";
+		stream << "\t\t\t\"threadCount\": " << result.ThreadCount << ",\n";
+		stream << "\t\t\t\"bodyCount\": " << result.Counts.Bodies << ",\n";
+		stream << "\t\t\t\"staticCount\": " << result.Counts.Statics << ",\n";
+		stream << "\t\t\t\"jointCount\": " << result.Counts.Joints << ",\n";
+		stream << "\t\t\t\"setupMilliseconds\": " << result.SetupMilliseconds << ",\n";
+		stream << "\t\t\t\"stepsPerSecond\": " << result.StepsPerSecond << ",\n";
+		stream << "\t\t\t\"stepMilliseconds\": { \"mean\": " << result.MeanMilliseconds << ", \"p50\": " << result.P50Milliseconds << ", \"p95\": " << result.P95Milliseconds <<
+			", \"p99\": " << result.P99Milliseconds << ", \"max\": " << result.MaxMilliseconds << " },\n";
+		stream << "\t\t\t\"peakPoolBytes\": " << result.PeakPoolBytes << ",\n";
+		stream << "\t\t\t\"peakThreadDispatcherBytes\": " << result.PeakThreadDispatcherBytes << ",\n";
+		stream << "\t\t\t\"gcBytes\": { \"before\": " << result.GCBytesBefore << ", \"after\": " << result.GCBytesAfter << ", \"peak\": " << result.PeakGCBytes << " }\n";
+		stream << "\t\t}";
+	}
+	stream << "\n\t]\n}\n";
+}
+
+bool ParseArguments(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (argument == "--steps" && hasValue)
+			options.StepCount = std::atoi(argv[++i]);
+		else if (argument == "--warmup" && hasValue)
+			options.WarmupStepCount = std::atoi(argv[++i]);
+		else if (argument == "--scenario" && hasValue)
+			options.ScenarioFilter = argv[++i];
+		else if (argument == "--output" && hasValue)
+			options.OutputPath = argv[++i];
+		else if (argument == "--allow-sleep")
+			options.AllowSleep = true;
+		else if (argument == "--threads" && hasValue)
+		{
+			std::string list = argv[++i];
+			size_t start = 0;
+			while (start < list.size())
+			{
+				auto end = list.find(',', start);
+				if (end == std::string::npos)
+					end = list.size();
+				auto threadCount = std::atoi(list.substr(start, end - start).c_str());
+				if (threadCount > 0)
+					options.ThreadCounts.push_back(threadCount);
+				start = end + 1;
+			}
+		}
+		else
+		{
+			std::cerr << "Unrecognized argument: " << argument << "\n";
+			return false;
+		}
+	}
+	return options.StepCount > 0 && options.WarmupStepCount >= 0;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		std::cerr << "Usage: BepuPhysicsBenchmarks [--steps N] [--warmup N] [--threads 1,2,4] [--scenario name] [--allow-sleep] [--output path]\n";
+		return 1;
+	}
+
+	Initialize();
+	if (options.ThreadCounts.empty())
+	{
+		auto platformThreadCount = GetPlatformThreadCount();
+		for (int threadCount = 1; threadCount < platformThreadCount; threadCount *= 2)
+			options.ThreadCounts.push_back(threadCount);
+		options.ThreadCounts.push_back(platformThreadCount);
+	}
+
+	std::vector<BenchmarkResult> results;
+	for (auto& scenario : scenarios)
+	{
+		if (!options.ScenarioFilter.empty() && options.ScenarioFilter != scenario.Name)
+			continue;
+		for (auto threadCount : options.ThreadCounts)
+		{
+			//Progress goes to stderr so stdout stays valid JSON.
+			std::cerr << scenario.Name << " @ " << threadCount << " threads\n";
+			results.push_back(RunScenario(scenario, threadCount, options));
+		}
+	}
+
+	if (options.OutputPath.empty())
+	{
+		WriteJson(std::cout, options, results);
+	}
+	else
+	{
+		std::ofstream file(options.OutputPath);
+		WriteJson(file, options, results);
+	}
+	Destroy();
+	return results.empty() ? 1 : 0;
+}
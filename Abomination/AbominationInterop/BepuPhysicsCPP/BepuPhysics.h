@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <assert.h>
 #include "InteropMath.h"
 #include "Bodies.h"
@@ -9,6 +10,7 @@
 #include "Collisions.h"
 #include "PoseIntegration.h"
 #include "Shapes.h"
+#include "Constraints.h"
 
 namespace Bepu
 {
@@ -205,35 +207,52 @@ namespace Bepu
 	/// <param name="handle">Buffer pool to destroy.</param>
 	extern "C" void DestroyBufferPool(BufferPoolHandle handle);
 	/// <summary>
+	/// Creates a new buffer pool with preallocated capacity and an optional cap on its reserved memory.
+	/// </summary>
+	/// <param name="options">Options describing the buffer pool.</param>
+	/// <returns>Handle of the created buffer pool.</returns>
+	/// <remarks>Preallocation for a power is skipped if it would exceed the cap. The cap is enforced by the interop allocation, resize, and reservation functions; the engine's own growth during simulation is not blocked, so preallocate enough to cover steady state use.</remarks>
+	extern "C" BufferPoolHandle CreateBufferPoolWithOptions(BufferPoolOptions options);
+	/// <summary>
+	/// Ensures that a buffer pool has at least the given number of bytes allocated for slots of a given power.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to reserve capacity in.</param>
+	/// <param name="power">Power of the slot size to reserve capacity for. Slots in the power pool are 2^power bytes.</param>
+	/// <param name="byteCount">Number of bytes to reserve for the power pool.</param>
+	/// <returns>True if the pool has the requested capacity, false if reserving it would exceed the pool's maximum reserved bytes.</returns>
+	extern "C" bool ReserveBufferPoolCapacity(BufferPoolHandle bufferPoolHandle, int32_t power, int32_t byteCount);
+	/// <summary>
 	/// Allocates a buffer from the buffer pool of the given size.
 	/// </summary>
 	/// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
 	/// <param name="sizeInBytes">Size of the buffer to allocate in bytes.</param>
-	/// <returns>Allocated buffer.</returns>
+	/// <returns>Allocated buffer. If the allocation could push the pool beyond its maximum reserved bytes, the returned buffer is unallocated.</returns>
 	extern "C" ByteBuffer Allocate(BufferPoolHandle bufferPoolHandle, int32_t sizeInBytes);
 	/// <summary>
 	/// Allocates a buffer from the buffer pool with at least the given size.
 	/// </summary>
 	/// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
 	/// <param name="sizeInBytes">Size of the buffer to allocate in bytes.</param>
-	/// <returns>Allocated buffer.</returns>
+	/// <returns>Allocated buffer. If the allocation could push the pool beyond its maximum reserved bytes, the returned buffer is unallocated.</returns>
 	extern "C" ByteBuffer AllocateAtLeast(BufferPoolHandle bufferPoolHandle, int32_t sizeInBytes);
 	/// <summary>
 	/// Resizes a buffer from the buffer pool to the given size, reallocating if necessary.
 	/// </summary>
 	/// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
-	/// <param name="buffer">Buffer to resize.</param>
+	/// <param name="buffer">Buffer to resize. If the resize needs a new slot that could push the pool beyond its maximum reserved bytes, the buffer is left unchanged.</param>
 	/// <param name="newSizeInBytes">Target size of the buffer to allocate in bytes.</param>
 	/// <param name="copyCount">Number of bytes to copy from the old buffer into the new buffer.</param>
-	extern "C" void Resize(BufferPoolHandle bufferPoolHandle, ByteBuffer * buffer, int32_t newSizeInBytes, int32_t copyCount);
+	/// <returns>True if the buffer was resized, false if the resize was refused because of the pool's maximum reserved bytes.</returns>
+	extern "C" bool Resize(BufferPoolHandle bufferPoolHandle, ByteBuffer * buffer, int32_t newSizeInBytes, int32_t copyCount);
 	/// <summary>
 	/// Resizes a buffer from the buffer pool to at least the given size, reallocating if necessary.
 	/// </summary>
 	/// <param name="bufferPoolHandle">Buffer pool to allocate from.</param>
-	/// <param name="buffer">Buffer to resize.</param>
+	/// <param name="buffer">Buffer to resize. If the resize needs a new slot that could push the pool beyond its maximum reserved bytes, the buffer is left unchanged.</param>
 	/// <param name="targetSizeInBytes">Target size of the buffer to allocate in bytes.</param>
 	/// <param name="copyCount">Number of bytes to copy from the old buffer into the new buffer.</param>
-	extern "C" void ResizeToAtLeast(BufferPoolHandle bufferPoolHandle, ByteBuffer * buffer, int32_t targetSizeInBytes, int32_t copyCount);
+	/// <returns>True if the buffer holds at least the target size, false if the resize was refused because of the pool's maximum reserved bytes.</returns>
+	extern "C" bool ResizeToAtLeast(BufferPoolHandle bufferPoolHandle, ByteBuffer * buffer, int32_t targetSizeInBytes, int32_t copyCount);
 	/// <summary>
 	/// Returns a buffer to the buffer pool.
 	/// </summary>
@@ -273,6 +292,20 @@ namespace Bepu
 	/// <returns></returns>
 	extern "C" SimulationHandle CreateSimulation(BufferPoolHandle bufferPool, NarrowPhaseCallbacks narrowPhaseCallbacks, PoseIntegratorCallbacks poseIntegratorCallbacks, SolveDescription solveDescriptionInterop, SimulationAllocationSizes initialAllocationSizes);
 	extern "C" void DestroySimulation(SimulationHandle handle);
+	/// <summary>
+	/// Grows any simulation allocations smaller than the given sizes. Existing allocations larger than the given sizes are left alone.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to grow.</param>
+	/// <param name="allocationSizes">Capacities to ensure for bodies, statics, islands, shapes per type, constraint handles, type batches, and per-body constraint lists.</param>
+	/// <remarks>Useful for avoiding resizes in the middle of a timestep when a known number of objects is about to be added.</remarks>
+	extern "C" void EnsureSimulationCapacity(SimulationHandle simulationHandle, SimulationAllocationSizes allocationSizes);
+	/// <summary>
+	/// Shrinks simulation allocations that are larger than needed, down to whichever is larger: the given minimums or the current contents.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to compact.</param>
+	/// <param name="minimumAllocationSizes">Sizes below which allocations will not be shrunk.</param>
+	/// <remarks>Released memory is returned to the simulation's buffer pool. The pool keeps its blocks for reuse; clear or destroy the pool to release them to the operating system.</remarks>
+	extern "C" void CompactSimulation(SimulationHandle simulationHandle, SimulationAllocationSizes minimumAllocationSizes);
 	extern "C" BodyHandle AddBody(SimulationHandle simulationHandle, BodyDescription bodyDescription);
 	extern "C" void RemoveBody(SimulationHandle simulationHandle, BodyHandle bodyHandle);
 	/// <summary>
@@ -321,6 +354,39 @@ namespace Bepu
 	/// <param name="bodyHandle">Body handle to pull data about.</param>
 	/// <param name="description">Description to apply to the body.</param>
 	extern "C" void ApplyBodyDescription(SimulationHandle simulationHandle, BodyHandle bodyHandle, BodyDescription description);
+	/// <summary>
+	/// Puts the islands containing a set of bodies to sleep immediately, regardless of their velocities.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation containing the bodies.</param>
+	/// <param name="bodyHandles">Handles of the bodies to put to sleep. Bodies that are already asleep are ignored.</param>
+	/// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+	/// <remarks>Every body connected to a listed body through constraints goes to sleep with it. All islands are put to sleep in one batch.</remarks>
+	extern "C" void SleepBodies(SimulationHandle simulationHandle, Buffer<BodyHandle> bodyHandles, ThreadDispatcherHandle threadDispatcherHandle);
+	/// <summary>
+	/// Wakes the islands containing a set of bodies.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation containing the bodies.</param>
+	/// <param name="bodyHandles">Handles of the bodies to wake. Bodies that are already awake are ignored.</param>
+	/// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+	/// <remarks>All islands are woken in one batch.</remarks>
+	extern "C" void WakeBodies(SimulationHandle simulationHandle, Buffer<BodyHandle> bodyHandles, ThreadDispatcherHandle threadDispatcherHandle);
+	/// <summary>
+	/// Puts every island with a body whose broad phase bounding box overlaps a region to sleep immediately, regardless of velocity.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to query.</param>
+	/// <param name="min">Minimum corner of the region.</param>
+	/// <param name="max">Maximum corner of the region.</param>
+	/// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+	/// <remarks>Bodies outside the region that share an island with a body inside it also go to sleep.</remarks>
+	extern "C" void SleepRegion(SimulationHandle simulationHandle, Vector3 min, Vector3 max, ThreadDispatcherHandle threadDispatcherHandle);
+	/// <summary>
+	/// Wakes every island with a body whose broad phase bounding box overlaps a region.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to query.</param>
+	/// <param name="min">Minimum corner of the region.</param>
+	/// <param name="max">Maximum corner of the region.</param>
+	/// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+	extern "C" void WakeRegion(SimulationHandle simulationHandle, Vector3 min, Vector3 max, ThreadDispatcherHandle threadDispatcherHandle);
 	extern "C" StaticHandle AddStatic(SimulationHandle simulationHandle, StaticDescription staticDescription);
 	extern "C" void RemoveStatic(SimulationHandle simulationHandle, StaticHandle staticHandle);
 	/// <summary>
@@ -345,6 +411,83 @@ namespace Bepu
 	/// <param name="staticHandle">Static handle to pull data about.</param>
 	extern "C" void ApplyStaticDescription(SimulationHandle simulationHandle, StaticHandle staticHandle, StaticDescription description);
 	/// <summary>
+	/// Builds a chunk of statics that can later be attached to the simulation in a handful of operations. Convex statics are gathered into one big compound whose acceleration structure is built here.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation owning the shapes referenced by the descriptions.</param>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate the chunk's buffers from. Must not be used by any other thread while the chunk is built.</param>
+	/// <param name="descriptions">Descriptions of the statics in the chunk.</param>
+	/// <returns>Built chunk.</returns>
+	/// <remarks>This only reads the simulation's shape data, so it can run on a worker thread while the simulation steps, provided no shapes are added to or removed from the simulation until it returns.
+	/// Statics with compound or mesh shapes cannot be compound children; they are stored in the chunk and added individually on attach.</remarks>
+	extern "C" StaticChunk CreateStaticChunk(SimulationHandle simulationHandle, BufferPoolHandle bufferPoolHandle, Buffer<StaticDescription> descriptions);
+	/// <summary>
+	/// Adds a chunk's statics to the simulation. Convex statics enter the broad phase as a single static regardless of their number.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to attach the chunk to.</param>
+	/// <param name="chunk">Chunk to attach. Records the handles created for the chunk.</param>
+	extern "C" void AttachStaticChunk(SimulationHandle simulationHandle, StaticChunk * chunk);
+	/// <summary>
+	/// Removes a chunk's statics from the simulation. The chunk keeps its buffers and can be attached again.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to detach the chunk from.</param>
+	/// <param name="chunk">Chunk to detach.</param>
+	extern "C" void DetachStaticChunk(SimulationHandle simulationHandle, StaticChunk * chunk);
+	/// <summary>
+	/// Returns buffers allocated for a detached static chunk.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+	/// <param name="chunk">Chunk to destroy.</param>
+	extern "C" void DestroyStaticChunk(BufferPoolHandle bufferPoolHandle, StaticChunk * chunk);
+	/// <summary>
+	/// Sets whether a body acts as a sensor. Sensor pairs are tested with the shapes' own contact generation and reported through GetSensorOverlaps instead of generating contacts.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation containing the body.</param>
+	/// <param name="bodyHandle">Body to modify.</param>
+	/// <param name="isSensor">Nonzero if the body should be a sensor, zero otherwise.</param>
+	/// <remarks>Sensor pairs never reach the narrow phase callbacks. The flag is cleared when the body is removed, so a later body reusing the handle starts out as a regular body.</remarks>
+	extern "C" void SetBodySensor(SimulationHandle simulationHandle, BodyHandle bodyHandle, int32_t isSensor);
+	/// <summary>
+	/// Sets whether a static acts as a sensor. Sensor pairs are tested with the shapes' own contact generation and reported through GetSensorOverlaps instead of generating contacts.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation containing the static.</param>
+	/// <param name="staticHandle">Static to modify.</param>
+	/// <param name="isSensor">Nonzero if the static should be a sensor, zero otherwise.</param>
+	/// <remarks>Sensor pairs never reach the narrow phase callbacks. The flag is cleared when the static is removed, including by detaching a static chunk, so a later static reusing the handle starts out as a regular static.</remarks>
+	extern "C" void SetStaticSensor(SimulationHandle simulationHandle, StaticHandle staticHandle, int32_t isSensor);
+	/// <summary>
+	/// Gets the sensor overlaps that entered, stayed or exited during the last timestep.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to pull data from.</param>
+	/// <param name="overlaps">Overlaps reported by the last timestep.</param>
+	/// <remarks>The buffer is owned by the simulation and is overwritten by the next timestep.</remarks>
+	extern "C" void GetSensorOverlaps(SimulationHandle simulationHandle, Buffer<SensorOverlap>* overlaps);
+	/// <summary>
+	/// Starts choosing discrete, passive or continuous collision detection for tracked bodies each timestep from their velocity relative to their size.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to control.</param>
+	/// <param name="settings">Thresholds used to choose modes and sweep parameters.</param>
+	/// <remarks>Also starts counting sweep eligible pairs, reported by GetAdaptiveContinuityStatistics. Enabling again replaces the previous settings.</remarks>
+	extern "C" void EnableAdaptiveContinuity(SimulationHandle simulationHandle, AdaptiveContinuitySettings settings);
+	/// <summary>
+	/// Stops choosing continuity for tracked bodies. Bodies keep the continuity they were last given, and remain tracked if adaptive continuity is enabled again.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to stop controlling.</param>
+	extern "C" void DisableAdaptiveContinuity(SimulationHandle simulationHandle);
+	/// <summary>
+	/// Adds bodies to or removes them from adaptive continuity.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation containing the bodies.</param>
+	/// <param name="bodyHandles">Bodies to modify.</param>
+	/// <param name="tracked">Nonzero to choose the bodies' continuity adaptively, zero to stop. Bodies that stop being tracked keep their current continuity.</param>
+	/// <remarks>A body's size is measured from its shape when it is added; add it again after changing its shape. Removing a body stops tracking it, so a later body reusing the handle starts out untracked.</remarks>
+	extern "C" void SetAdaptiveContinuityBodies(SimulationHandle simulationHandle, Buffer<BodyHandle> bodyHandles, int32_t tracked);
+	/// <summary>
+	/// Gets the continuity modes chosen in the last timestep and the number of pairs that were eligible for sweep tests.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to pull statistics from.</param>
+	/// <returns>Statistics of the last timestep. Counts other than the tracked body count are zero while adaptive continuity is disabled.</returns>
+	extern "C" AdaptiveContinuityStatistics GetAdaptiveContinuityStatistics(SimulationHandle simulationHandle);
+	/// <summary>
 	/// Steps the simulation forward a single time.
 	/// </summary>
 	/// <param name="simulationHandle">Handle of the simulation to step.</param>
@@ -368,6 +511,33 @@ namespace Bepu
 	/// <param name="max">Maximum bounds of the collidable's bounding box.</param>
 	extern "C" void GetStaticBoundingBoxInBroadPhase(SimulationHandle simulationHandle, StaticHandle staticHandle, Vector3 * min, Vector3 * max);
 	/// <summary>
+	/// Measures the broad phase's active and static trees.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to measure.</param>
+	/// <returns>Statistics of both broad phase trees.</returns>
+	/// <remarks>Walks every node of both trees, so the cost scales with the number of collidables.</remarks>
+	extern "C" BroadPhaseStatistics GetBroadPhaseStatistics(SimulationHandle simulationHandle);
+	/// <summary>
+	/// Sets how much extra refinement is applied to the broad phase's trees at the end of each timestep, on top of the engine's own incremental refinement.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to configure.</param>
+	/// <param name="budget">Extra refinement to apply each step. Scales of zero on both trees disable extra refinement.</param>
+	/// <remarks>Extra refinement runs on the calling thread after the step completes.</remarks>
+	extern "C" void SetBroadPhaseRefinementBudget(SimulationHandle simulationHandle, BroadPhaseRefinementBudget budget);
+	/// <summary>
+	/// Gets the extra refinement applied to the broad phase's trees at the end of each timestep.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to query.</param>
+	/// <returns>Extra refinement applied each step. Zero scales if none is configured.</returns>
+	extern "C" BroadPhaseRefinementBudget GetBroadPhaseRefinementBudget(SimulationHandle simulationHandle);
+	/// <summary>
+	/// Rebuilds both broad phase trees from scratch with a binned surface area heuristic build. Useful after level transitions, mass spawns, or large teleports leave the trees in poor shape.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation whose broad phase should be rebuilt.</param>
+	/// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+	/// <remarks>Leaf indices are preserved, so collidables keep their broad phase indices. Must not be called during a timestep.</remarks>
+	extern "C" void RebuildBroadPhase(SimulationHandle simulationHandle, ThreadDispatcherHandle threadDispatcherHandle);
+	/// <summary>
 	/// Gets the mapping from body handles to the body's location in storage.
 	/// </summary>
 	/// <param name="simulationHandle">Handle of the simulation to pull data from.</param>
@@ -416,6 +586,37 @@ namespace Bepu
 	/// <returns>Estimated number of bytes allocated from managed memory.</returns>
 	extern "C" uint64_t GetGCAllocatedMemorySize();
 	/// <summary>
+	/// Gathers memory usage and allocation statistics for a buffer pool.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to gather statistics for.</param>
+	/// <param name="statistics">Statistics about the buffer pool.</param>
+	/// <remarks>Reserved byte counts cover all allocations in the pool. Occupancy and allocation counts only cover buffers that were taken, resized, or returned through the interop functions.</remarks>
+	extern "C" void GetBufferPoolStatistics(BufferPoolHandle bufferPoolHandle, BufferPoolStatistics * statistics);
+	/// <summary>
+	/// Resets a buffer pool's allocation counters and sets its peak values to the current usage.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to reset statistics for.</param>
+	extern "C" void ResetBufferPoolStatistics(BufferPoolHandle bufferPoolHandle);
+	/// <summary>
+	/// Enables or disables allocation tagging for a buffer pool. While enabled, every buffer taken through the interop functions records the pool's current tag until it is returned.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to configure.</param>
+	/// <param name="enabled">True if allocations should be tagged, false otherwise. Disabling tagging discards all recorded allocations.</param>
+	extern "C" void SetBufferPoolAllocationTagging(BufferPoolHandle bufferPoolHandle, bool enabled);
+	/// <summary>
+	/// Sets the tag recorded for subsequent allocations from a buffer pool while allocation tagging is enabled.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to set the tag for.</param>
+	/// <param name="tag">Tag to associate with subsequent allocations. Typically identifies the allocation site.</param>
+	extern "C" void SetBufferPoolAllocationTag(BufferPoolHandle bufferPoolHandle, int32_t tag);
+	/// <summary>
+	/// Gets the outstanding allocations recorded by a buffer pool's allocation tagging.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to pull tagged allocations from.</param>
+	/// <param name="allocations">Buffer to write tagged allocations into. If it is too small to hold all outstanding allocations, only the oldest allocations that fit are written.</param>
+	/// <param name="count">Total number of outstanding tagged allocations.</param>
+	extern "C" void GetBufferPoolTaggedAllocations(BufferPoolHandle bufferPoolHandle, Buffer<TaggedBufferAllocation> allocations, int32_t * count);
+	/// <summary>
 	/// Adds a sphere shape to the simulation.
 	/// </summary>
 	/// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
@@ -470,13 +671,53 @@ namespace Bepu
 	/// <param name="mesh">Shape to add to the simulation.</param>
 	extern "C" TypedIndex AddMesh(SimulationHandle simulationHandle, Mesh mesh);
 	/// <summary>
+	/// Adds a compressed mesh shape to the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
+	/// <param name="mesh">Shape to add to the simulation.</param>
+	extern "C" TypedIndex AddCompressedMesh(SimulationHandle simulationHandle, CompressedMesh mesh);
+	/// <summary>
+	/// Adds a heightfield shape to the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
+	/// <param name="heightfield">Shape to add to the simulation.</param>
+	extern "C" TypedIndex AddHeightfield(SimulationHandle simulationHandle, Heightfield heightfield);
+	/// <summary>
+	/// Adds a voxel grid shape to the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to add the shape to.</param>
+	/// <param name="voxelGrid">Shape to add to the simulation.</param>
+	extern "C" TypedIndex AddVoxelGrid(SimulationHandle simulationHandle, VoxelGrid voxelGrid);
+	/// <summary>
+	/// Makes subsequent shape additions return an existing shape when one with identical content was already added, and reference counts shape removals.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to intern shapes in.</param>
+	/// <param name="bufferPoolHandle">Buffer pool that the buffers of added shapes were allocated from. When an addition is deduplicated, the buffers of the shape passed in are returned to this pool. If null, they are left with the caller.</param>
+	/// <remarks>Only shapes added while interning is enabled are deduplicated. When an existing shape is returned for a shape with buffers, the simulation never takes ownership of the buffers in the shape passed in; they are returned to the given pool so the caller can treat every addition the same way.
+	/// Adding a shape that reuses the existing shape's own buffers leaves them alive. Enabling again replaces the pool.</remarks>
+	extern "C" void EnableShapeInterning(SimulationHandle simulationHandle, BufferPoolHandle bufferPoolHandle);
+	/// <summary>
+	/// Stops interning shapes. Shapes already shared remain shared, but their reference counts are discarded and the next removal of any of them removes it.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to stop interning shapes in.</param>
+	extern "C" void DisableShapeInterning(SimulationHandle simulationHandle);
+	/// <summary>
+	/// Gets the number of outstanding references to a shape added while shape interning was enabled.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation containing the shape.</param>
+	/// <param name="shape">Shape to look up.</param>
+	/// <returns>Number of additions that returned the shape and have not been removed yet. Shapes not tracked by interning report 1.</returns>
+	extern "C" int32_t GetShapeReferenceCount(SimulationHandle simulationHandle, TypedIndex shape);
+	/// <summary>
 	/// Removes a shape from the simulation. Does not return any shape allocated buffers to buffer pools.
+	/// If shape interning is enabled, this releases one reference and only removes the shape once no references remain.
 	/// </summary>
 	/// <param name="simulationHandle">Handle of the simulation to remove the shape from.</param>
 	/// <param name="shape">Shape to remove from the simulation.</param>
 	extern "C" void RemoveShape(SimulationHandle simulationHandle, TypedIndex shape);
 	/// <summary>
 	/// Removes a shape from the simulation. If the shape has resources that were allocated from a buffer pool, they will be returned to the specified pool.
+	/// If shape interning is enabled, this releases one reference and only removes the shape once no references remain.
 	/// </summary>
 	/// <param name="simulationHandle">Handle of the simulation to remove the shape from.</param>
 	/// <param name="bufferPoolHandle">Buffer pool to return shape resources to, if any.</param>
@@ -485,6 +726,7 @@ namespace Bepu
 	extern "C" void RemoveAndDestroyShape(SimulationHandle simulationHandle, BufferPoolHandle bufferPoolHandle, TypedIndex shape);
 	/// <summary>
 	/// Removes a shape and all references child shapes from the simulation. If the shapes had resources that were allocated from a buffer pool, they will be returned to the specified pool.
+	/// If shape interning is enabled, the shape and each distinct child shape release one reference and are only removed once no references remain.
 	/// </summary>
 	/// <param name="simulationHandle">Handle of the simulation to remove the shape from.</param>
 	/// <param name="bufferPoolHandle">Buffer pool to return shape resources to, if any.</param>
@@ -499,6 +741,17 @@ namespace Bepu
 	/// <param name="centerOfMass">Center of mass computed for the hull and subtracted from all the points in the points used for the final shape.</param>
 	extern "C" ConvexHull CreateConvexHull(BufferPoolHandle bufferPoolHandle, Buffer<Vector3> points, Vector3 * centerOfMass);
 	/// <summary>
+	/// Creates convex hull shapes for many point sets at once, computing each hull's center of mass and inertia across the workers of a thread dispatcher.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate the hulls and output buffers from.</param>
+	/// <param name="pointSets">Ranges of the points buffer defining each hull, along with the mass to compute its inertia with.</param>
+	/// <param name="points">Points referenced by the point sets.</param>
+	/// <param name="hulls">Hulls created for each point set, allocated from the buffer pool. Each hull's points are recentered on its center of mass. Each hull must be destroyed with DestroyConvexHull before the buffer is deallocated.</param>
+	/// <param name="centersOfMass">Center of mass computed for each point set, allocated from the buffer pool.</param>
+	/// <param name="inertias">Inertia of each hull, allocated from the buffer pool. Degenerate point sets that produce no faces get zeroed inertia.</param>
+	/// <param name="threadDispatcherHandle">Thread dispatcher to create hulls with. If null, hulls are created on the calling thread.</param>
+	extern "C" void CreateConvexHulls(BufferPoolHandle bufferPoolHandle, Buffer<PointSetRange> pointSets, Buffer<Vector3> points, Buffer<ConvexHull>* hulls, Buffer<Vector3>* centersOfMass, Buffer<BodyInertia>* inertias, ThreadDispatcherHandle threadDispatcherHandle);
+	/// <summary>
 	/// Returns buffers allocated for a convex hull shape.
 	/// </summary>
 	/// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
@@ -529,15 +782,100 @@ namespace Bepu
 	/// <param name="bufferPoolHandle">Buffer pool to allocate resources from for the compound's acceleration structures.</param>
 	/// <param name="triangles">Triangles composing the mesh.</param>
 	/// <param name="scale">Scale of the mesh.</param>
-	/// <remarks>This uses a pretty old sweep builder. Large meshes will take a while. There are ways to do this much faster if required; see https://github.com/bepu/bepuphysics2/blob/master/Demos/DemoMeshHelper.cs#L186.</remarks>
+	/// <remarks>This uses a pretty old sweep builder. Large meshes will take a while; use CreateMeshParallel for those.</remarks>
 	extern "C" Mesh CreateMesh(BufferPoolHandle bufferPoolHandle, Buffer<Triangle> triangles, Vector3 scale);
 	/// <summary>
+	/// Creates a mesh shape from triangles, building its acceleration structure across the workers of a thread dispatcher.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate resources from for the mesh's acceleration structures.</param>
+	/// <param name="triangles">Triangles composing the mesh. Ownership transfers to the mesh; the buffer is returned to the pool by DestroyMesh.</param>
+	/// <param name="scale">Scale of the mesh.</param>
+	/// <param name="threadDispatcherHandle">Thread dispatcher to build with. If null, the build runs on the calling thread.</param>
+	/// <param name="options">Options controlling the build.</param>
+	/// <returns>Created mesh.</returns>
+	extern "C" Mesh CreateMeshParallel(BufferPoolHandle bufferPoolHandle, Buffer<Triangle> triangles, Vector3 scale, ThreadDispatcherHandle threadDispatcherHandle, MeshBuildOptions options);
+	/// <summary>
+	/// Creates a mesh shape from indexed vertices, building its acceleration structure across the workers of a thread dispatcher.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate resources from for the mesh's triangles and acceleration structures.</param>
+	/// <param name="vertices">Vertices referenced by the indices. Not retained by the mesh.</param>
+	/// <param name="indices">Three vertex indices per triangle. Not retained by the mesh.</param>
+	/// <param name="scale">Scale of the mesh.</param>
+	/// <param name="threadDispatcherHandle">Thread dispatcher to build with. If null, the build runs on the calling thread.</param>
+	/// <param name="options">Options controlling the build.</param>
+	/// <returns>Created mesh.</returns>
+	extern "C" Mesh CreateIndexedMeshParallel(BufferPoolHandle bufferPoolHandle, Buffer<Vector3> vertices, Buffer<int32_t> indices, Vector3 scale, ThreadDispatcherHandle threadDispatcherHandle, MeshBuildOptions options);
+	/// <summary>
 	/// Returns buffers allocated for a mesh shape.
 	/// </summary>
 	/// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
 	/// <param name="mesh">Mesh to destroy.</param>
 	extern "C" void DestroyMesh(BufferPoolHandle bufferPoolHandle, Mesh * mesh);
 	/// <summary>
+	/// Creates a compressed mesh shape from indexed vertices. Vertices are quantized to 16 bits per axis within the mesh's bounds, indices are stored in 16 bits when possible, and tree bounds are quantized to the same grid.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate the mesh's buffers and temporary resources from.</param>
+	/// <param name="vertices">Vertices referenced by the indices. Not retained by the mesh.</param>
+	/// <param name="indices">Three vertex indices per triangle. Not retained by the mesh.</param>
+	/// <param name="scale">Scale of the mesh.</param>
+	/// <param name="threadDispatcherHandle">Thread dispatcher to build the acceleration structure with. If null, the build runs on the calling thread.</param>
+	/// <param name="options">Options controlling the acceleration structure build.</param>
+	/// <returns>Created mesh.</returns>
+	extern "C" CompressedMesh CreateCompressedMesh(BufferPoolHandle bufferPoolHandle, Buffer<Vector3> vertices, Buffer<int32_t> indices, Vector3 scale, ThreadDispatcherHandle threadDispatcherHandle, MeshBuildOptions options);
+	/// <summary>
+	/// Returns buffers allocated for a compressed mesh shape.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+	/// <param name="mesh">Mesh to destroy.</param>
+	extern "C" void DestroyCompressedMesh(BufferPoolHandle bufferPoolHandle, CompressedMesh * mesh);
+	/// <summary>
+	/// Creates a heightfield shape by copying height samples and optional per-cell flags into buffers allocated from a buffer pool.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate the heightfield's buffers from.</param>
+	/// <param name="samples">Height samples, row by row along X. Each sample is 4 bytes for Float32 samples and 2 bytes for UInt16 samples.</param>
+	/// <param name="cellFlags">One byte per cell, row by row along X, or an empty buffer if the heightfield has no holes or materials. Bit 0 marks a hole and the remaining bits hold a material index.</param>
+	/// <param name="sampleCountX">Number of samples along the local X axis.</param>
+	/// <param name="sampleCountZ">Number of samples along the local Z axis.</param>
+	/// <param name="sampleFormat">Storage format of the samples.</param>
+	/// <param name="cellSizeX">Distance between samples along the local X axis.</param>
+	/// <param name="cellSizeZ">Distance between samples along the local Z axis.</param>
+	/// <param name="heightScale">Multiplier applied to stored samples to get local heights.</param>
+	/// <param name="heightOffset">Offset added to scaled samples to get local heights.</param>
+	/// <returns>Created heightfield.</returns>
+	extern "C" Heightfield CreateHeightfield(BufferPoolHandle bufferPoolHandle, ByteBuffer samples, ByteBuffer cellFlags, int32_t sampleCountX, int32_t sampleCountZ, HeightfieldSampleFormat sampleFormat, float cellSizeX, float cellSizeZ, float heightScale, float heightOffset);
+	/// <summary>
+	/// Returns buffers allocated for a heightfield shape.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+	/// <param name="heightfield">Heightfield to destroy.</param>
+	extern "C" void DestroyHeightfield(BufferPoolHandle bufferPoolHandle, Heightfield * heightfield);
+	/// <summary>
+	/// Creates a voxel grid shape. Occupancy is stored in sparse 8x8x8 bricks; only bricks containing occupied voxels take storage.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate the voxel grid's buffers from.</param>
+	/// <param name="sizeX">Number of voxels along the local X axis.</param>
+	/// <param name="sizeY">Number of voxels along the local Y axis.</param>
+	/// <param name="sizeZ">Number of voxels along the local Z axis.</param>
+	/// <param name="voxelSize">Edge length of each voxel.</param>
+	/// <param name="occupiedVoxels">Coordinates of the voxels that start out occupied.</param>
+	/// <returns>Created voxel grid.</returns>
+	/// <remarks>The total number of voxels times 12 must fit in a 32 bit signed integer, since each voxel reserves 12 triangle child indices.</remarks>
+	extern "C" VoxelGrid CreateVoxelGrid(BufferPoolHandle bufferPoolHandle, int32_t sizeX, int32_t sizeY, int32_t sizeZ, float voxelSize, Buffer<Int3> occupiedVoxels);
+	/// <summary>
+	/// Returns buffers allocated for a voxel grid shape.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to return resources to. Must be the same pool that resources were allocated from.</param>
+	/// <param name="voxelGrid">Voxel grid to destroy.</param>
+	extern "C" void DestroyVoxelGrid(BufferPoolHandle bufferPoolHandle, VoxelGrid * voxelGrid);
+	/// <summary>
+	/// Sets the occupancy of voxels in a voxel grid that is not yet owned by a simulation.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool that the voxel grid's buffers were allocated from.</param>
+	/// <param name="voxelGrid">Voxel grid to edit.</param>
+	/// <param name="coordinates">Coordinates of the voxels to set.</param>
+	/// <param name="values">Occupancy of each voxel; nonzero values mark a voxel as occupied.</param>
+	extern "C" void SetVoxelGridVoxels(BufferPoolHandle bufferPoolHandle, VoxelGrid * voxelGrid, Buffer<Int3> coordinates, ByteBuffer values);
+	/// <summary>
 	/// Computes the inertia of a sphere.
 	/// </summary>
 	/// <param name="sphere">Shape to compute the inertia of.</param>
@@ -688,5 +1026,138 @@ namespace Bepu
 	/// <param name="shape">Shape reference to request from the simulation.</param>
 	/// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
 	extern "C" Mesh * GetMeshShapeData(SimulationHandle simulationHandle, TypedIndex shape);
+	/// <summary>
+	/// Gets a pointer to a compressed mesh shape's data stored within the simulation's shapes buffers.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to pull the shape from.</param>
+	/// <param name="shape">Shape reference to request from the simulation.</param>
+	/// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
+	extern "C" CompressedMesh * GetCompressedMeshShapeData(SimulationHandle simulationHandle, TypedIndex shape);
+	/// <summary>
+	/// Gets a pointer to a heightfield shape's data stored within the simulation's shapes buffers.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to pull the shape from.</param>
+	/// <param name="shape">Shape reference to request from the simulation.</param>
+	/// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
+	extern "C" Heightfield * GetHeightfieldShapeData(SimulationHandle simulationHandle, TypedIndex shape);
+	/// <summary>
+	/// Gets a pointer to a voxel grid shape's data stored within the simulation's shapes buffers.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to pull the shape from.</param>
+	/// <param name="shape">Shape reference to request from the simulation.</param>
+	/// <returns>Pointer to the shape's data in the simulation's shapes buffers.</returns>
+	extern "C" VoxelGrid * GetVoxelGridShapeData(SimulationHandle simulationHandle, TypedIndex shape);
+	/// <summary>
+	/// Sets the occupancy of voxels in a voxel grid shape owned by a simulation. Only the bricks containing the listed voxels are touched.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation owning the shape.</param>
+	/// <param name="shape">Voxel grid shape to edit.</param>
+	/// <param name="coordinates">Coordinates of the voxels to set.</param>
+	/// <param name="values">Occupancy of each voxel; nonzero values mark a voxel as occupied.</param>
+	/// <remarks>The grid's bounds cover all voxels whether occupied or not, so edits never require a bounds update. Edits do not wake sleeping bodies resting on the grid; wake them explicitly if removed voxels were supporting them. Bricks are allocated from and returned to the simulation's buffer pool, so the grid must have been created from that pool.</remarks>
+	extern "C" void SetVoxels(SimulationHandle simulationHandle, TypedIndex shape, Buffer<Int3> coordinates, ByteBuffer values);
+	/// <summary>
+	/// Loads a mesh, convex hull, or big compound from a shape asset file. Section contents are read straight into buffers taken from the pool with no further processing.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to take the shape's buffers from.</param>
+	/// <param name="path">Null terminated UTF8 path of the asset file.</param>
+	/// <param name="asset">Loaded shape. Zeroed if the load failed. Dispose it with the destroy function matching its shape type.</param>
+	/// <returns>True if the asset was loaded, false if the file could not be read or did not contain a valid asset for this platform.</returns>
+	/// <remarks>Big compound children are stored with the shape indices they had when saved. They must refer to the same shapes in the simulation that the compound is added to.</remarks>
+	extern "C" bool LoadShapeAsset(BufferPoolHandle bufferPoolHandle, const char* path, ShapeAsset * asset);
+	/// <summary>
+	/// Loads a mesh, convex hull, or big compound from a shape asset held in memory.
+	/// </summary>
+	/// <param name="bufferPoolHandle">Buffer pool to take the shape's buffers from.</param>
+	/// <param name="bytes">Memory containing the asset. Not retained by the loaded shape.</param>
+	/// <param name="asset">Loaded shape. Zeroed if the load failed. Dispose it with the destroy function matching its shape type.</param>
+	/// <returns>True if the asset was loaded, false if the memory did not contain a valid asset for this platform.</returns>
+	extern "C" bool LoadShapeAssetFromMemory(BufferPoolHandle bufferPoolHandle, ByteBuffer bytes, ShapeAsset * asset);
+	/// <summary>
+	/// Saves a mesh, convex hull, or big compound to a shape asset file, replacing any existing file.
+	/// </summary>
+	/// <param name="asset">Shape to save. ShapeType selects which shape is read.</param>
+	/// <param name="path">Null terminated UTF8 path of the asset file.</param>
+	/// <returns>True if the asset was saved, false if the shape type is not supported or the file could not be written.</returns>
+	extern "C" bool SaveShapeAsset(ShapeAsset * asset, const char* path);
+	/// <summary>
+	/// Computes the number of bytes needed to store a shape as an asset.
+	/// </summary>
+	/// <param name="asset">Shape to measure. ShapeType selects which shape is read.</param>
+	/// <returns>Number of bytes needed to store the shape, or 0 if the shape type is not supported.</returns>
+	extern "C" int64_t GetShapeAssetByteCount(ShapeAsset * asset);
+	/// <summary>
+	/// Writes a mesh, convex hull, or big compound into memory as a shape asset.
+	/// </summary>
+	/// <param name="asset">Shape to write. ShapeType selects which shape is read.</param>
+	/// <param name="bytes">Memory to write the asset into. Must hold at least GetShapeAssetByteCount bytes.</param>
+	/// <returns>True if the asset was written, false if the shape type is not supported or the memory is too small.</returns>
+	extern "C" bool WriteShapeAsset(ShapeAsset * asset, ByteBuffer bytes);
+	/// <summary>
+	/// Adds a set of constraints of the same type to the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to add the constraints to.</param>
+	/// <param name="type">Type of the constraint descriptions in the descriptions buffer.</param>
+	/// <param name="bodies">Bodies connected by the constraints. Constraint i connects bodies[i * 2] and bodies[i * 2 + 1].</param>
+	/// <param name="descriptions">Descriptions of the constraints, all of the given type.</param>
+	/// <param name="handles">Buffer to fill with the handles of the created constraints. The number of constraints created is the length of this buffer.</param>
+	/// <remarks>The solver's constraint handle storage is resized at most once for the whole set, and the interop transition is paid once rather than once per constraint.</remarks>
+	extern "C" void AddConstraints(SimulationHandle simulationHandle, JointType type, Buffer<BodyHandle> bodies, ByteBuffer descriptions, Buffer<ConstraintHandle>*handles);
+	/// <summary>
+	/// Removes a constraint from the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to remove the constraint from.</param>
+	/// <param name="constraintHandle">Constraint to remove.</param>
+	extern "C" void RemoveConstraint(SimulationHandle simulationHandle, ConstraintHandle constraintHandle);
+	/// <summary>
+	/// Removes a set of constraints from the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to remove the constraints from.</param>
+	/// <param name="constraintHandles">Constraints to remove.</param>
+	extern "C" void RemoveConstraints(SimulationHandle simulationHandle, Buffer<ConstraintHandle> constraintHandles);
+	/// <summary>
+	/// Checks whether a constraint handle refers to a constraint in the simulation.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to look in.</param>
+	/// <param name="constraintHandle">Constraint handle to check.</param>
+	/// <returns>True if the constraint exists, false otherwise.</returns>
+	extern "C" bool ConstraintExists(SimulationHandle simulationHandle, ConstraintHandle constraintHandle);
+	/// <summary>
+	/// Gets statistics about the solver's constraint batching and the cost of the most recent solve.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to pull statistics from.</param>
+	/// <param name="statistics">Statistics for the simulation's active constraints.</param>
+	/// <param name="constraintCountPerBatch">Buffer to fill with the number of constraints in each active batch. Entries beyond the batch count are zeroed. Can be empty.</param>
+	/// <param name="constraintCountPerType">Buffer to fill with the number of active constraints of each type id. Entries beyond the constraint type count are zeroed. Can be empty.</param>
+	extern "C" void GetSolverStatistics(SimulationHandle simulationHandle, SolverStatistics * statistics, Buffer<int32_t> constraintCountPerBatch, Buffer<int32_t> constraintCountPerType);
+	/// <summary>
+	/// Lets the simulation choose its velocity iteration count each timestep based on how much the previous solve changed the velocities of constrained bodies.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to schedule velocity iterations for.</param>
+	/// <param name="settings">Bounds and thresholds used to choose the iteration count.</param>
+	/// <remarks>Replaces any velocity iteration scheduler given in the simulation's solve description. Enabling again replaces the previous settings.</remarks>
+	extern "C" void EnableAdaptiveVelocityIterations(SimulationHandle simulationHandle, AdaptiveVelocityIterationSettings settings);
+	/// <summary>
+	/// Stops adapting the simulation's velocity iteration count. The solver keeps the last chosen count.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to stop scheduling velocity iterations for.</param>
+	extern "C" void DisableAdaptiveVelocityIterations(SimulationHandle simulationHandle);
+	/// <summary>
+	/// Gets the iteration counts chosen by the simulation's adaptive velocity iteration scheduler.
+	/// </summary>
+	/// <param name="simulationHandle">Simulation to pull the scheduler state from.</param>
+	/// <param name="state">State of the scheduler. Zeroed if adaptive velocity iterations are not enabled.</param>
+	extern "C" void GetAdaptiveVelocityIterationState(SimulationHandle simulationHandle, AdaptiveVelocityIterationState * state);
+	/// <summary>
+	/// Copies the contacts of every active contact constraint into a flat buffer. Intended to be called after a timestep to read the solved contact impulses.
+	/// </summary>
+	/// <param name="simulationHandle">Handle of the simulation to read contacts from.</param>
+	/// <param name="options">Filters applied to the exported contacts.</param>
+	/// <param name="records">Receives a buffer holding one record per exported contact. The buffer is allocated from the given pool and must be deallocated by the caller, even if it is empty.</param>
+	/// <param name="bufferPoolHandle">Buffer pool to allocate the output buffer from.</param>
+	/// <param name="threadDispatcherHandle">Handle of the thread dispatcher to use, if any. Can be a null reference.</param>
+	/// <remarks>Only awake constraints are exported. Impulses are those accumulated over the last solved substep.
+	/// Records appear in solver order, which is deterministic for a deterministic simulation.</remarks>
+	extern "C" void ExportContacts(SimulationHandle simulationHandle, ContactExportOptions options, Buffer<ContactRecord>* records, BufferPoolHandle bufferPoolHandle, ThreadDispatcherHandle threadDispatcherHandle);
 
 }
\ No newline at end of file
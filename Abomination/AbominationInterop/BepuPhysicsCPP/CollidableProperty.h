@@ -1,6 +1,10 @@
 #pragma once
 
 #include "BepuPhysics.h"
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
 
 namespace Bepu
 {
@@ -47,20 +51,20 @@ namespace Bepu
 		T& operator[](BodyHandle bodyHandle)
 		{
 			assert(bodyHandle.Value >= 0 && bodyHandle.Value < bodyData.Length);
-			return bodyData[bodyHandle];
+			return bodyData[bodyHandle.Value];
 		}
 
 		T& operator[](StaticHandle staticHandle)
 		{
 			assert(staticHandle.Value >= 0 && staticHandle.Value < staticData.Length);
-			return staticData[staticHandle];
+			return staticData[staticHandle.Value];
 		}
 
 		T& operator[](CollidableReference collidable)
 		{
 			if (collidable.GetMobility() == CollidableMobility::Static)
-				return this[collidable.GetStaticHandle()];
-			return this[collidable.GetBodyHandle()];
+				return (*this)[collidable.GetStaticHandle()];
+			return (*this)[collidable.GetBodyHandle()];
 		}
 
 		/// <summary>
@@ -75,7 +79,9 @@ namespace Bepu
 				auto copyCountInBytes = sizeof(T) * bodyData.Length;
 				auto targetCapacityInBytes = sizeof(T) * (bodyHandle.Value + 1);
 				ByteBuffer byteBuffer = bodyData;
-				Bepu::ResizeToAtLeast(Pool, &byteBuffer, targetCapacityInBytes, copyCountInBytes);
+				//There's no way to report failure through the returned reference; a pool with a reservation limit has to leave room for property growth.
+				[[maybe_unused]] auto resized = Bepu::ResizeToAtLeast(Pool, &byteBuffer, targetCapacityInBytes, copyCountInBytes);
+				assert(resized);
 				bodyData = byteBuffer;
 			}
 			return bodyData[bodyHandle.Value];
@@ -93,7 +99,8 @@ namespace Bepu
 				auto copyCountInBytes = sizeof(T) * staticData.Length;
 				auto targetCapacityInBytes = sizeof(T) * (staticHandle.Value + 1);
 				ByteBuffer byteBuffer = staticData;
-				Bepu::ResizeToAtLeast(Pool, &byteBuffer, targetCapacityInBytes, copyCountInBytes);
+				[[maybe_unused]] auto resized = Bepu::ResizeToAtLeast(Pool, &byteBuffer, targetCapacityInBytes, copyCountInBytes);
+				assert(resized);
 				staticData = byteBuffer;
 			}
 			return staticData[staticHandle.Value];
@@ -118,38 +125,731 @@ namespace Bepu
 		/// Ensures that the internal structures have at least the given capacity for bodies.
 		/// </summary>
 		/// <param name="capacity">Capacity to ensure.</param>
-		void EnsureBodyCapacity(int32_t capacity)
+		/// <returns>True if the capacity is available, false if the pool refused the allocation. The storage is left unchanged on failure.</returns>
+		bool EnsureBodyCapacity(int32_t capacity)
+		{
+			return capacity <= bodyData.Length || ResizeData(bodyData, capacity);
+		}
+		/// <summary>
+		/// Ensures that the internal structures have at least the given capacity for statics.
+		/// </summary>
+		/// <param name="capacity">Capacity to ensure.</param>
+		/// <returns>True if the capacity is available, false if the pool refused the allocation. The storage is left unchanged on failure.</returns>
+		bool EnsureStaticCapacity(int32_t capacity)
+		{
+			return capacity <= staticData.Length || ResizeData(staticData, capacity);
+		}
+
+		/// <summary>
+		/// Ensures that the internal structures have enough capacity for every body and static handle the simulation currently has space for.
+		/// </summary>
+		/// <returns>True if both handle spaces are covered, false if the pool refused an allocation.</returns>
+		bool EnsureCapacity()
+		{
+			Buffer<BodyMemoryLocation> bodyHandleToLocationMapping;
+			Bepu::GetBodyHandleToLocationMapping(Simulation, &bodyHandleToLocationMapping);
+			Buffer<int32_t> staticHandleToIndexMapping;
+			Bepu::GetStaticHandleToLocationMapping(Simulation, &staticHandleToIndexMapping);
+			//Both are attempted either way so a refusal in one handle space doesn't hold back the other.
+			auto bodiesCovered = EnsureBodyCapacity(bodyHandleToLocationMapping.Length);
+			auto staticsCovered = EnsureStaticCapacity(staticHandleToIndexMapping.Length);
+			return bodiesCovered && staticsCovered;
+		}
+
+		/// <summary>
+		/// Shrinks the internal structures to the smallest size that still covers the highest body and static handles in use.
+		/// </summary>
+		/// <param name="minimumBodyCapacity">Number of body slots to keep regardless of handle usage.</param>
+		/// <param name="minimumStaticCapacity">Number of static slots to keep regardless of handle usage.</param>
+		/// <remarks>Shrinking is best effort: if the pool refuses the smaller allocation, the existing storage is kept.</remarks>
+		void Compact(int32_t minimumBodyCapacity = 0, int32_t minimumStaticCapacity = 0)
 		{
-			if (capacity > bodyData.Length)
+			//Removed handles have negative locations in the simulation's mappings, so the highest live handle is the last nonnegative entry.
+			Buffer<BodyMemoryLocation> bodyHandleToLocationMapping;
+			Bepu::GetBodyHandleToLocationMapping(Simulation, &bodyHandleToLocationMapping);
+			auto bodyCapacity = std::min(bodyHandleToLocationMapping.Length, bodyData.Length);
+			while (bodyCapacity > 0 && bodyHandleToLocationMapping[bodyCapacity - 1].SetIndex < 0)
+				--bodyCapacity;
+			bodyCapacity = std::max(bodyCapacity, minimumBodyCapacity);
+			if (bodyCapacity < bodyData.Length)
+				ResizeData(bodyData, bodyCapacity);
+
+			Buffer<int32_t> staticHandleToIndexMapping;
+			Bepu::GetStaticHandleToLocationMapping(Simulation, &staticHandleToIndexMapping);
+			auto staticCapacity = std::min(staticHandleToIndexMapping.Length, staticData.Length);
+			while (staticCapacity > 0 && staticHandleToIndexMapping[staticCapacity - 1] < 0)
+				--staticCapacity;
+			staticCapacity = std::max(staticCapacity, minimumStaticCapacity);
+			if (staticCapacity < staticData.Length)
+				ResizeData(staticData, staticCapacity);
+		}
+
+		/// <summary>
+		/// Returns all held resources.
+		/// </summary>
+		void Dispose()
+		{
+			if (bodyData.Memory != nullptr)
+				Bepu::DeallocateById(Pool, bodyData.Id);
+			if (staticData.Memory != nullptr)
+				Bepu::DeallocateById(Pool, staticData.Id);
+			bodyData = Buffer<T>();
+			staticData = Buffer<T>();
+		}
+
+	private:
+		bool ResizeData(Buffer<T>& data, int32_t capacity)
+		{
+			ByteBuffer byteBuffer = data;
+			if (!Bepu::ResizeToAtLeast(Pool, &byteBuffer, capacity * sizeof(T), std::min(data.Length, capacity) * sizeof(T)))
+				return false;
+			data = byteBuffer;
+			return true;
+		}
+	};
+
+	/// <summary>
+	/// Set of typed columns sharing one pool allocation and one capacity. Column i holds elements of the ith type.
+	/// </summary>
+	/// <typeparam name="Ts">Types of the columns. Columns are moved with memcpy, so the types must be trivially copyable.</typeparam>
+	template<typename... Ts>
+	struct PropertyColumns
+	{
+		static_assert(sizeof...(Ts) > 0, "At least one column type is required.");
+		static_assert(std::conjunction<std::is_trivially_copyable<Ts>...>::value, "Column types must be trivially copyable.");
+
+		/// <summary>
+		/// Number of columns in the set.
+		/// </summary>
+		static constexpr int32_t ColumnCount = sizeof...(Ts);
+		/// <summary>
+		/// Size in bytes of a single element of each column.
+		/// </summary>
+		static constexpr int32_t ElementSizes[ColumnCount] = { (int32_t)sizeof(Ts)... };
+		/// <summary>
+		/// Alignment of the start of each column relative to the start of the allocation.
+		/// </summary>
+		static constexpr int32_t ColumnAlignment = std::max({ 16, (int32_t)alignof(Ts)... });
+
+		/// <summary>
+		/// Type of the elements in a column.
+		/// </summary>
+		template<int32_t ColumnIndex>
+		using ColumnType = typename std::tuple_element<ColumnIndex, std::tuple<Ts...>>::type;
+
+		/// <summary>
+		/// Allocation backing all columns.
+		/// </summary>
+		ByteBuffer Storage;
+		/// <summary>
+		/// Number of elements each column can hold.
+		/// </summary>
+		int32_t Capacity;
+		/// <summary>
+		/// Start of each column within the storage.
+		/// </summary>
+		uint8_t* ColumnStarts[ColumnCount];
+
+		PropertyColumns()
+		{
+			Storage = ByteBuffer{};
+			Capacity = 0;
+			for (int32_t i = 0; i < ColumnCount; ++i)
+				ColumnStarts[i] = nullptr;
+		}
+
+		/// <summary>
+		/// Gets the byte offset of a column within an allocation holding the given capacity.
+		/// </summary>
+		static int32_t GetColumnOffset(int32_t columnIndex, int32_t capacity)
+		{
+			int32_t offset = 0;
+			for (int32_t i = 0; i < columnIndex; ++i)
+				offset = (offset + ElementSizes[i] * capacity + ColumnAlignment - 1) & ~(ColumnAlignment - 1);
+			return offset;
+		}
+
+		/// <summary>
+		/// Gets the number of bytes required to hold all columns at the given capacity.
+		/// </summary>
+		static int32_t GetByteCount(int32_t capacity)
+		{
+			return GetColumnOffset(ColumnCount, capacity);
+		}
+
+		/// <summary>
+		/// Gets whether the columns are backed by allocated memory.
+		/// </summary>
+		bool IsAllocated() const { return Storage.Memory != nullptr; }
+
+		/// <summary>
+		/// Gets a column spanning the full capacity.
+		/// </summary>
+		template<int32_t ColumnIndex>
+		Buffer<ColumnType<ColumnIndex>> GetColumn()
+		{
+			return Buffer<ColumnType<ColumnIndex>>((ColumnType<ColumnIndex>*)ColumnStarts[ColumnIndex], Capacity);
+		}
+
+		/// <summary>
+		/// Changes the capacity of every column with a single pool allocation.
+		/// </summary>
+		/// <param name="pool">Pool to allocate from and return the previous allocation to.</param>
+		/// <param name="capacity">New capacity of the columns.</param>
+		/// <param name="copyCount">Number of leading elements in each column to preserve.</param>
+		/// <returns>True if the columns were resized, false if the pool refused the allocation. The columns are left unchanged on failure.</returns>
+		bool Resize(BufferPoolHandle pool, int32_t capacity, int32_t copyCount)
+		{
+			assert(copyCount <= capacity && copyCount <= Capacity);
+			ByteBuffer resized = {};
+			if (capacity > 0)
 			{
-				ByteBuffer byteBuffer = bodyData;
-				Bepu::ResizeToAtLeast(Pool, bodyData, capacity * sizeof(T), byteBuffer.Length);
-				bodyData = byteBuffer;
+				resized = Bepu::AllocateAtLeast(pool, GetByteCount(capacity));
+				if (resized.Memory == nullptr)
+					return false;
 			}
+			for (int32_t i = 0; i < ColumnCount; ++i)
+			{
+				auto start = capacity > 0 ? resized.Memory + GetColumnOffset(i, capacity) : nullptr;
+				if (copyCount > 0)
+					memcpy(start, ColumnStarts[i], (size_t)copyCount * ElementSizes[i]);
+				ColumnStarts[i] = start;
+			}
+			if (IsAllocated())
+				Bepu::DeallocateById(pool, Storage.Id);
+			Storage = resized;
+			Capacity = capacity;
+			return true;
 		}
+
 		/// <summary>
-		/// Ensures that the internal structures have at least the given capacity for statics.
+		/// Copies an element of every column into another set of columns.
+		/// </summary>
+		void CopyElement(int32_t sourceIndex, PropertyColumns& target, int32_t targetIndex) const
+		{
+			assert(sourceIndex >= 0 && sourceIndex < Capacity && targetIndex >= 0 && targetIndex < target.Capacity);
+			for (int32_t i = 0; i < ColumnCount; ++i)
+				memcpy(target.ColumnStarts[i] + (size_t)targetIndex * ElementSizes[i], ColumnStarts[i] + (size_t)sourceIndex * ElementSizes[i], ElementSizes[i]);
+		}
+
+		/// <summary>
+		/// Zeroes an element of every column.
+		/// </summary>
+		void ClearElement(int32_t index)
+		{
+			assert(index >= 0 && index < Capacity);
+			for (int32_t i = 0; i < ColumnCount; ++i)
+				memset(ColumnStarts[i] + (size_t)index * ElementSizes[i], 0, ElementSizes[i]);
+		}
+
+		/// <summary>
+		/// Returns the columns' allocation to the pool.
+		/// </summary>
+		void Dispose(BufferPoolHandle pool)
+		{
+			if (IsAllocated())
+				Bepu::DeallocateById(pool, Storage.Id);
+			*this = PropertyColumns();
+		}
+	};
+
+	/// <summary>
+	/// Stores extra properties about bodies aligned with the simulation's body sets: element i of set s belongs to the body at index i in body set s.
+	/// </summary>
+	/// <typeparam name="Ts">Types of the properties to store. Each type is stored in its own column; pass one type for array-of-structures storage, or split a structure's fields across several types for structure-of-arrays storage.</typeparam>
+	/// <remarks>Bodies move between indices and sets when other bodies are removed or when islands go to sleep or wake up. Call Synchronize after changing the simulation and before reading the columns.
+	/// Synchronization only moves the elements of bodies that changed location; bodies new to the container start zeroed.
+	/// A body handle that is removed and then reused between two synchronizations inherits the previous owner's data.</remarks>
+	template<typename... Ts>
+	struct IndexAlignedBodyProperty
+	{
+		/// <summary>
+		/// Type of the elements in a property column.
+		/// </summary>
+		template<int32_t ColumnIndex>
+		using ColumnType = typename std::tuple_element<ColumnIndex, std::tuple<Ts...>>::type;
+
+		SimulationHandle Simulation;
+		BufferPoolHandle Pool;
+
+	private:
+		struct SetProperties
+		{
+			//Column 0 stores the handle of the body that owned each slot at the last synchronization; that's how moved bodies are detected.
+			PropertyColumns<BodyHandle, Ts...> Columns;
+			int32_t Count;
+		};
+		Buffer<SetProperties> sets;
+		//Location of each body's data as of the last synchronization, indexed by body handle.
+		Buffer<BodyMemoryLocation> handleToLocation;
+
+	public:
+		IndexAlignedBodyProperty()
+		{
+			Simulation = SimulationHandle();
+			Pool = BufferPoolHandle();
+			sets = Buffer<SetProperties>();
+			handleToLocation = Buffer<BodyMemoryLocation>();
+		}
+
+		/// <summary>
+		/// Constructs a new collection to store index-aligned body properties and synchronizes it with the simulation's current bodies.
+		/// </summary>
+		/// <param name="simulation">Simulation to track.</param>
+		/// <param name="pool">Pool from which to pull internal resources.</param>
+		/// <remarks>If the pool refuses the initial allocations, the container starts out empty; call Synchronize and check its result before reading columns.</remarks>
+		IndexAlignedBodyProperty(SimulationHandle simulation, BufferPoolHandle pool) : IndexAlignedBodyProperty()
+		{
+			Simulation = simulation;
+			Pool = pool;
+			Synchronize();
+		}
+
+		/// <summary>
+		/// Gets the number of bodies stored for a body set as of the last synchronization.
+		/// </summary>
+		int32_t GetCount(int32_t setIndex)
+		{
+			return setIndex < sets.Length ? sets[setIndex].Count : 0;
+		}
+
+		/// <summary>
+		/// Gets a property column for a body set. Element i belongs to the body at index i in the set.
+		/// </summary>
+		/// <param name="setIndex">Index of the body set. Set 0 holds the active bodies.</param>
+		/// <returns>Column spanning the bodies in the set as of the last synchronization.</returns>
+		template<int32_t ColumnIndex = 0>
+		Buffer<ColumnType<ColumnIndex>> GetColumn(int32_t setIndex)
+		{
+			assert(setIndex >= 0 && setIndex < sets.Length);
+			auto& set = sets[setIndex];
+			return Buffer<ColumnType<ColumnIndex>>(set.Columns.template GetColumn<ColumnIndex + 1>().Memory, set.Count);
+		}
+
+		/// <summary>
+		/// Gets the body handles owning each element of a body set as of the last synchronization.
+		/// </summary>
+		Buffer<BodyHandle> GetHandles(int32_t setIndex)
+		{
+			assert(setIndex >= 0 && setIndex < sets.Length);
+			auto& set = sets[setIndex];
+			return Buffer<BodyHandle>(set.Columns.template GetColumn<0>().Memory, set.Count);
+		}
+
+		/// <summary>
+		/// Gets a body's property by handle. The container must be synchronized with the simulation.
+		/// </summary>
+		template<int32_t ColumnIndex = 0>
+		ColumnType<ColumnIndex>& Get(BodyHandle bodyHandle)
+		{
+			assert(bodyHandle.Value >= 0 && bodyHandle.Value < handleToLocation.Length);
+			auto location = handleToLocation[bodyHandle.Value];
+			return sets[location.SetIndex].Columns.template GetColumn<ColumnIndex + 1>()[location.Index];
+		}
+
+		/// <summary>
+		/// Updates the container to match the simulation's current body sets. Elements of bodies that moved are carried to their new locations.
+		/// </summary>
+		/// <returns>True if the container matches the simulation, false if the pool refused an allocation. On failure the container keeps its previous contents and locations; it may have gained capacity.</returns>
+		bool Synchronize()
+		{
+			Buffer<BodySet> bodySets;
+			Bepu::GetBodySets(Simulation, &bodySets);
+			Buffer<BodyMemoryLocation> bodyHandleToLocationMapping;
+			Bepu::GetBodyHandleToLocationMapping(Simulation, &bodyHandleToLocationMapping);
+			if (!EnsureSetSlots(bodySets.Length) || !EnsureHandleCapacity(bodyHandleToLocationMapping.Length))
+				return false;
+
+			int32_t moveCount = 0;
+			for (int32_t setIndex = 0; setIndex < bodySets.Length; ++setIndex)
+			{
+				auto& bodySet = bodySets[setIndex];
+				if (!bodySet.IsAllocated())
+					continue;
+				for (int32_t i = 0; i < bodySet.Count; ++i)
+				{
+					if (!SlotHoldsBody(setIndex, i, bodySet.IndexToHandle[i]))
+						++moveCount;
+				}
+			}
+
+			//Everything that can be refused is allocated before any element moves, so a failure leaves the previous state intact.
+			PropertyColumns<BodyHandle, Ts...> moved;
+			Buffer<BodyMemoryLocation> moveTargets;
+			if (moveCount > 0)
+			{
+				if (!moved.Resize(Pool, moveCount, 0))
+					return false;
+				moveTargets = Bepu::AllocateAtLeast(Pool, moveCount * sizeof(BodyMemoryLocation));
+				if (moveTargets.Memory == nullptr)
+				{
+					moved.Dispose(Pool);
+					return false;
+				}
+			}
+			//Growing a set keeps all of its current elements, so sets grown before a refusal are still consistent.
+			for (int32_t setIndex = 0; setIndex < sets.Length && setIndex < bodySets.Length; ++setIndex)
+			{
+				auto& set = sets[setIndex];
+				if (!bodySets[setIndex].IsAllocated())
+					continue;
+				auto count = bodySets[setIndex].Count;
+				if (count > set.Columns.Capacity)
+				{
+					//The active set grows incrementally as bodies are added, so give it room to avoid a resize on every synchronization.
+					auto capacity = setIndex == 0 ? std::max(count, set.Columns.Capacity * 2) : count;
+					if (!set.Columns.Resize(Pool, capacity, set.Count))
+					{
+						if (moveCount > 0)
+						{
+							moved.Dispose(Pool);
+							Bepu::DeallocateById(Pool, moveTargets.Id);
+						}
+						return false;
+					}
+				}
+			}
+
+			//Gather the elements of every body that changed location before any storage is overwritten; a body's new slot may still hold another body's old data.
+			int32_t moveIndex = 0;
+			for (int32_t setIndex = 0; setIndex < bodySets.Length && moveIndex < moveCount; ++setIndex)
+			{
+				auto& bodySet = bodySets[setIndex];
+				if (!bodySet.IsAllocated())
+					continue;
+				for (int32_t i = 0; i < bodySet.Count; ++i)
+				{
+					auto bodyHandle = bodySet.IndexToHandle[i];
+					if (SlotHoldsBody(setIndex, i, bodyHandle))
+						continue;
+					BodyMemoryLocation previousLocation;
+					if (TryGetPreviousLocation(bodyHandle, &previousLocation))
+						sets[previousLocation.SetIndex].Columns.CopyElement(previousLocation.Index, moved, moveIndex);
+					else
+						moved.ClearElement(moveIndex);
+					moved.template GetColumn<0>()[moveIndex] = bodyHandle;
+					moveTargets[moveIndex] = BodyMemoryLocation{ setIndex, i };
+					++moveIndex;
+				}
+			}
+
+			//Sets that no longer exist in the simulation give their memory back.
+			for (int32_t setIndex = 0; setIndex < sets.Length; ++setIndex)
+			{
+				auto& set = sets[setIndex];
+				if (setIndex >= bodySets.Length || !bodySets[setIndex].IsAllocated())
+				{
+					set.Columns.Dispose(Pool);
+					set.Count = 0;
+					continue;
+				}
+				set.Count = bodySets[setIndex].Count;
+			}
+
+			for (int32_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+			{
+				auto target = moveTargets[moveIndex];
+				moved.CopyElement(moveIndex, sets[target.SetIndex].Columns, target.Index);
+				handleToLocation[moved.template GetColumn<0>()[moveIndex].Value] = target;
+			}
+			if (moveCount > 0)
+			{
+				moved.Dispose(Pool);
+				Bepu::DeallocateById(Pool, moveTargets.Id);
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Ensures that the active set storage can hold at least the given number of bodies.
 		/// </summary>
 		/// <param name="capacity">Capacity to ensure.</param>
-		void EnsureStaticCapacity(int32_t capacity)
+		/// <returns>True if the capacity is available, false if the pool refused the allocation. The storage is left unchanged on failure.</returns>
+		bool EnsureActiveCapacity(int32_t capacity)
+		{
+			if (!EnsureSetSlots(1))
+				return false;
+			auto& set = sets[0];
+			return capacity <= set.Columns.Capacity || set.Columns.Resize(Pool, capacity, set.Count);
+		}
+
+		/// <summary>
+		/// Shrinks every set's storage to fit its current body count.
+		/// </summary>
+		/// <param name="minimumActiveCapacity">Number of active set slots to keep regardless of the active body count.</param>
+		/// <remarks>Shrinking is best effort: if the pool refuses a smaller allocation, that storage is kept as is.</remarks>
+		void Compact(int32_t minimumActiveCapacity = 0)
 		{
-			if (capacity > staticData.Length)
+			for (int32_t setIndex = 0; setIndex < sets.Length; ++setIndex)
 			{
-				ByteBuffer byteBuffer = staticData;
-				Bepu::ResizeToAtLeast(Pool, staticData, capacity * sizeof(T), byteBuffer.Length);
-				staticData = byteBuffer;
+				auto& set = sets[setIndex];
+				auto capacity = setIndex == 0 ? std::max(set.Count, minimumActiveCapacity) : set.Count;
+				if (capacity < set.Columns.Capacity)
+					set.Columns.Resize(Pool, capacity, set.Count);
 			}
+			Buffer<BodyMemoryLocation> bodyHandleToLocationMapping;
+			Bepu::GetBodyHandleToLocationMapping(Simulation, &bodyHandleToLocationMapping);
+			auto handleCapacity = std::min(bodyHandleToLocationMapping.Length, handleToLocation.Length);
+			while (handleCapacity > 0 && bodyHandleToLocationMapping[handleCapacity - 1].SetIndex < 0)
+				--handleCapacity;
+			if (handleCapacity < handleToLocation.Length)
+			{
+				ByteBuffer byteBuffer = handleToLocation;
+				if (Bepu::ResizeToAtLeast(Pool, &byteBuffer, handleCapacity * sizeof(BodyMemoryLocation), handleCapacity * sizeof(BodyMemoryLocation)))
+					handleToLocation = byteBuffer;
+			}
+		}
+
+		/// <summary>
+		/// Returns all held resources.
+		/// </summary>
+		void Dispose()
+		{
+			for (int32_t setIndex = 0; setIndex < sets.Length; ++setIndex)
+				sets[setIndex].Columns.Dispose(Pool);
+			if (sets.Memory != nullptr)
+				Bepu::DeallocateById(Pool, sets.Id);
+			if (handleToLocation.Memory != nullptr)
+				Bepu::DeallocateById(Pool, handleToLocation.Id);
+			sets = Buffer<SetProperties>();
+			handleToLocation = Buffer<BodyMemoryLocation>();
+		}
+
+	private:
+		bool SlotHoldsBody(int32_t setIndex, int32_t index, BodyHandle bodyHandle)
+		{
+			auto& set = sets[setIndex];
+			return index < set.Count && set.Columns.template GetColumn<0>()[index].Value == bodyHandle.Value;
+		}
+
+		bool TryGetPreviousLocation(BodyHandle bodyHandle, BodyMemoryLocation* location)
+		{
+			if (bodyHandle.Value >= handleToLocation.Length)
+				return false;
+			*location = handleToLocation[bodyHandle.Value];
+			return location->SetIndex >= 0 && location->SetIndex < sets.Length && SlotHoldsBody(location->SetIndex, location->Index, bodyHandle);
+		}
+
+		bool EnsureSetSlots(int32_t setCount)
+		{
+			if (setCount <= sets.Length)
+				return true;
+			auto previousLength = sets.Length;
+			ByteBuffer byteBuffer = sets;
+			if (!Bepu::ResizeToAtLeast(Pool, &byteBuffer, setCount * sizeof(SetProperties), previousLength * sizeof(SetProperties)))
+				return false;
+			sets = byteBuffer;
+			for (int32_t i = previousLength; i < sets.Length; ++i)
+				sets[i] = SetProperties{ PropertyColumns<BodyHandle, Ts...>(), 0 };
+			return true;
+		}
+
+		bool EnsureHandleCapacity(int32_t handleCapacity)
+		{
+			if (handleCapacity <= handleToLocation.Length)
+				return true;
+			auto previousLength = handleToLocation.Length;
+			ByteBuffer byteBuffer = handleToLocation;
+			if (!Bepu::ResizeToAtLeast(Pool, &byteBuffer, handleCapacity * sizeof(BodyMemoryLocation), previousLength * sizeof(BodyMemoryLocation)))
+				return false;
+			handleToLocation = byteBuffer;
+			for (int32_t i = previousLength; i < handleToLocation.Length; ++i)
+				handleToLocation[i] = BodyMemoryLocation{ -1, -1 };
+			return true;
+		}
+	};
+
+	/// <summary>
+	/// Stores several extra properties about bodies and statics as separate columns, indexed by the body or static handle.
+	/// </summary>
+	/// <typeparam name="Ts">Types of the properties to store. Each type gets its own column.</typeparam>
+	/// <remarks>All columns share one capacity and one pool allocation per handle space, so growing the collection is a single resize no matter how many properties are stored.
+	/// Column spans are raw pointers into the allocation and can be swept directly.</remarks>
+	template<typename... Ts>
+	struct CollidableProperties
+	{
+		/// <summary>
+		/// Type of the elements in a property column.
+		/// </summary>
+		template<int32_t ColumnIndex>
+		using ColumnType = typename std::tuple_element<ColumnIndex, std::tuple<Ts...>>::type;
+
+		SimulationHandle Simulation;
+		BufferPoolHandle Pool;
+		PropertyColumns<Ts...> bodyData;
+		PropertyColumns<Ts...> staticData;
+
+		CollidableProperties()
+		{
+			Simulation = SimulationHandle();
+			Pool = BufferPoolHandle();
+		}
+
+		/// <summary>
+		/// Constructs a new collection to store handle-aligned body and static properties.
+		/// </summary>
+		/// <param name="simulation">Simulation to track.</param>
+		/// <param name="pool">Pool from which to pull internal resources.</param>
+		/// <remarks>If the pool refuses the initial allocations, the columns start out empty; call EnsureCapacity and check its result before using them.</remarks>
+		CollidableProperties(SimulationHandle simulation, BufferPoolHandle pool)
+		{
+			Simulation = simulation;
+			Pool = pool;
+			EnsureCapacity();
+		}
+
+		/// <summary>
+		/// Gets a property column for bodies, indexed by body handle.
+		/// </summary>
+		template<int32_t ColumnIndex>
+		Buffer<ColumnType<ColumnIndex>> GetBodyColumn()
+		{
+			return bodyData.template GetColumn<ColumnIndex>();
+		}
+
+		/// <summary>
+		/// Gets a property column for statics, indexed by static handle.
+		/// </summary>
+		template<int32_t ColumnIndex>
+		Buffer<ColumnType<ColumnIndex>> GetStaticColumn()
+		{
+			return staticData.template GetColumn<ColumnIndex>();
+		}
+
+		template<int32_t ColumnIndex>
+		ColumnType<ColumnIndex>& Get(BodyHandle bodyHandle)
+		{
+			assert(bodyHandle.Value >= 0 && bodyHandle.Value < bodyData.Capacity);
+			return ((ColumnType<ColumnIndex>*)bodyData.ColumnStarts[ColumnIndex])[bodyHandle.Value];
+		}
+
+		template<int32_t ColumnIndex>
+		ColumnType<ColumnIndex>& Get(StaticHandle staticHandle)
+		{
+			assert(staticHandle.Value >= 0 && staticHandle.Value < staticData.Capacity);
+			return ((ColumnType<ColumnIndex>*)staticData.ColumnStarts[ColumnIndex])[staticHandle.Value];
+		}
+
+		template<int32_t ColumnIndex>
+		ColumnType<ColumnIndex>& Get(CollidableReference collidable)
+		{
+			if (collidable.GetMobility() == CollidableMobility::Static)
+				return Get<ColumnIndex>(collidable.GetStaticHandle());
+			return Get<ColumnIndex>(collidable.GetBodyHandle());
+		}
+
+		/// <summary>
+		/// Ensures there is space for a given body handle in every column. New slots are zeroed.
+		/// </summary>
+		/// <param name="bodyHandle">Body handle to allocate for.</param>
+		/// <returns>True if the handle has a slot, false if the pool refused the allocation. The columns are left unchanged on failure.</returns>
+		bool Allocate(BodyHandle bodyHandle)
+		{
+			return bodyHandle.Value < bodyData.Capacity || Grow(bodyData, std::max(bodyHandle.Value + 1, bodyData.Capacity * 2));
+		}
+
+		/// <summary>
+		/// Ensures there is space for a given static handle in every column. New slots are zeroed.
+		/// </summary>
+		/// <param name="staticHandle">Static handle to allocate for.</param>
+		/// <returns>True if the handle has a slot, false if the pool refused the allocation. The columns are left unchanged on failure.</returns>
+		bool Allocate(StaticHandle staticHandle)
+		{
+			return staticHandle.Value < staticData.Capacity || Grow(staticData, std::max(staticHandle.Value + 1, staticData.Capacity * 2));
 		}
 
-		//TODO: We just left out the compaction bits, but they're not too hard!
+		/// <summary>
+		/// Ensures there is space for a given collidable reference in every column. New slots are zeroed.
+		/// </summary>
+		/// <param name="collidableReference">Collidable reference to allocate for.</param>
+		/// <returns>True if the collidable has a slot, false if the pool refused the allocation. The columns are left unchanged on failure.</returns>
+		bool Allocate(CollidableReference collidableReference)
+		{
+			if (collidableReference.GetMobility() == CollidableMobility::Static)
+				return Allocate(collidableReference.GetStaticHandle());
+			return Allocate(collidableReference.GetBodyHandle());
+		}
+
+		/// <summary>
+		/// Ensures that every body column has at least the given capacity.
+		/// </summary>
+		/// <param name="capacity">Capacity to ensure.</param>
+		/// <returns>True if the capacity is available, false if the pool refused the allocation. The columns are left unchanged on failure.</returns>
+		bool EnsureBodyCapacity(int32_t capacity)
+		{
+			return capacity <= bodyData.Capacity || Grow(bodyData, capacity);
+		}
+
+		/// <summary>
+		/// Ensures that every static column has at least the given capacity.
+		/// </summary>
+		/// <param name="capacity">Capacity to ensure.</param>
+		/// <returns>True if the capacity is available, false if the pool refused the allocation. The columns are left unchanged on failure.</returns>
+		bool EnsureStaticCapacity(int32_t capacity)
+		{
+			return capacity <= staticData.Capacity || Grow(staticData, capacity);
+		}
+
+		/// <summary>
+		/// Ensures that the columns have enough capacity for every body and static handle the simulation currently has space for.
+		/// </summary>
+		/// <returns>True if both handle spaces are covered, false if the pool refused an allocation.</returns>
+		bool EnsureCapacity()
+		{
+			Buffer<BodyMemoryLocation> bodyHandleToLocationMapping;
+			Bepu::GetBodyHandleToLocationMapping(Simulation, &bodyHandleToLocationMapping);
+			Buffer<int32_t> staticHandleToIndexMapping;
+			Bepu::GetStaticHandleToLocationMapping(Simulation, &staticHandleToIndexMapping);
+			auto bodiesCovered = EnsureBodyCapacity(bodyHandleToLocationMapping.Length);
+			auto staticsCovered = EnsureStaticCapacity(staticHandleToIndexMapping.Length);
+			return bodiesCovered && staticsCovered;
+		}
+
+		/// <summary>
+		/// Shrinks the columns to the smallest size that still covers the highest body and static handles in use.
+		/// </summary>
+		/// <param name="minimumBodyCapacity">Number of body slots to keep regardless of handle usage.</param>
+		/// <param name="minimumStaticCapacity">Number of static slots to keep regardless of handle usage.</param>
+		/// <remarks>Shrinking is best effort: if the pool refuses a smaller allocation, those columns are kept as they are.</remarks>
+		void Compact(int32_t minimumBodyCapacity = 0, int32_t minimumStaticCapacity = 0)
+		{
+			Buffer<BodyMemoryLocation> bodyHandleToLocationMapping;
+			Bepu::GetBodyHandleToLocationMapping(Simulation, &bodyHandleToLocationMapping);
+			auto bodyCapacity = std::min(bodyHandleToLocationMapping.Length, bodyData.Capacity);
+			while (bodyCapacity > 0 && bodyHandleToLocationMapping[bodyCapacity - 1].SetIndex < 0)
+				--bodyCapacity;
+			bodyCapacity = std::max(bodyCapacity, minimumBodyCapacity);
+			if (bodyCapacity < bodyData.Capacity)
+				bodyData.Resize(Pool, bodyCapacity, bodyCapacity);
+
+			Buffer<int32_t> staticHandleToIndexMapping;
+			Bepu::GetStaticHandleToLocationMapping(Simulation, &staticHandleToIndexMapping);
+			auto staticCapacity = std::min(staticHandleToIndexMapping.Length, staticData.Capacity);
+			while (staticCapacity > 0 && staticHandleToIndexMapping[staticCapacity - 1] < 0)
+				--staticCapacity;
+			staticCapacity = std::max(staticCapacity, minimumStaticCapacity);
+			if (staticCapacity < staticData.Capacity)
+				staticData.Resize(Pool, staticCapacity, staticCapacity);
+		}
 
 		/// <summary>
 		/// Returns all held resources.
 		/// </summary>
 		void Dispose()
 		{
-			Bepu::DeallocateById(Pool, bodyData.Id);
-			Bepu::DeallocateById(Pool, staticData.Id);
+			bodyData.Dispose(Pool);
+			staticData.Dispose(Pool);
+		}
+
+	private:
+		bool Grow(PropertyColumns<Ts...>& columns, int32_t capacity)
+		{
+			auto previousCapacity = columns.Capacity;
+			if (!columns.Resize(Pool, capacity, previousCapacity))
+				return false;
+			for (int32_t i = 0; i < PropertyColumns<Ts...>::ColumnCount; ++i)
+				memset(columns.ColumnStarts[i] + (size_t)previousCapacity * PropertyColumns<Ts...>::ElementSizes[i], 0, (size_t)(capacity - previousCapacity) * PropertyColumns<Ts...>::ElementSizes[i]);
+			return true;
 		}
 	};
 }
@@ -92,6 +92,44 @@ namespace Bepu
 		CollidableReference B;
 	};
 
+	/// <summary>
+	/// Change in a sensor overlap since the previous timestep.
+	/// </summary>
+	enum struct SensorOverlapState : int32_t
+	{
+		/// <summary>
+		/// The pair started overlapping during the last timestep.
+		/// </summary>
+		Entered = 0,
+		/// <summary>
+		/// The pair overlapped during the previous timestep and still overlaps.
+		/// </summary>
+		Stayed = 1,
+		/// <summary>
+		/// The pair overlapped during the previous timestep but no longer does, or one of its collidables was removed.
+		/// </summary>
+		Exited = 2
+	};
+
+	/// <summary>
+	/// Overlap between a sensor and another collidable, reported by the last timestep.
+	/// </summary>
+	struct SensorOverlap
+	{
+		/// <summary>
+		/// Sensor collidable in the pair. If both collidables are sensors, this is the one with the lower packed reference.
+		/// </summary>
+		CollidableReference Sensor;
+		/// <summary>
+		/// Collidable overlapping the sensor.
+		/// </summary>
+		CollidableReference Other;
+		/// <summary>
+		/// Whether the overlap began, continued or ended.
+		/// </summary>
+		SensorOverlapState State;
+	};
+
 	/// <summary>
 	/// Information about a single contact in a convex collidable pair. Convex collidable pairs share one surface basis across the manifold, since the contact surface is guaranteed to be a plane.
 	/// </summary>    
@@ -175,6 +213,65 @@ namespace Bepu
 		NonconvexContact Contacts[4];
 	};
 
+	/// <summary>
+	/// Controls which contacts ExportContacts writes.
+	/// </summary>
+	struct ContactExportOptions
+	{
+		/// <summary>
+		/// Contacts with an accumulated normal impulse below this value are skipped. Zero or less exports every contact.
+		/// </summary>
+		float MinimumNormalImpulse;
+		/// <summary>
+		/// If nonzero, speculative contacts with negative depth are exported too. Otherwise only touching contacts are exported.
+		/// </summary>
+		int32_t IncludeSpeculativeContacts;
+	};
+
+	/// <summary>
+	/// Solver state of a single contact, read after a timestep.
+	/// </summary>
+	struct ContactRecord
+	{
+		/// <summary>
+		/// Handle of the contact constraint holding the contact.
+		/// </summary>
+		ConstraintHandle Constraint;
+		/// <summary>
+		/// First collidable in the pair. Always a body.
+		/// </summary>
+		CollidableReference A;
+		/// <summary>
+		/// Second collidable in the pair. Refers to the static for pairs between a body and a static.
+		/// </summary>
+		CollidableReference B;
+		/// <summary>
+		/// Index of the contact within its constraint.
+		/// </summary>
+		int32_t ContactIndex;
+		/// <summary>
+		/// World space position of the contact.
+		/// </summary>
+		Vector3 Position;
+		/// <summary>
+		/// Penetration depth of the contact. Negative values are speculative separation.
+		/// </summary>
+		float Depth;
+		/// <summary>
+		/// World space contact normal, pointing from B toward A.
+		/// </summary>
+		Vector3 Normal;
+		/// <summary>
+		/// Accumulated normal impulse of the contact from the last solved substep.
+		/// </summary>
+		float NormalImpulse;
+		/// <summary>
+		/// Magnitude of the accumulated tangent friction impulse from the last solved substep.
+		/// For convex manifolds friction is shared by the whole manifold, so every contact of the manifold reports the same value.
+		/// </summary>
+		float FrictionImpulse;
+	};
+
 	/// <summary>
 	/// Material properties governing the interaction between colliding bodies. Used by the narrow phase to create constraints of the appropriate configuration.
 	/// </summary>
@@ -225,7 +322,7 @@ namespace Bepu
 		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
 		void (*DisposeFunction)(SimulationHandle simulationHandle);
 		/// <summary>
-		/// Called for each pair of collidables with overlapping bounding boxes found by the broad phase.
+		/// Called for each pair of collidables with overlapping bounding boxes found by the broad phase. Can be null; the default allows pairs where at least one collidable is dynamic.
 		/// </summary>
 		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
 		/// <param name="workerIndex">Index of the worker within the thread dispatcher that's running this callback.</param>
@@ -236,6 +333,7 @@ namespace Bepu
 		bool (*AllowContactGenerationFunction)(SimulationHandle simulationHandle, int32_t workerIndex, CollidableReference a, CollidableReference b, float* speculativeMargin);
 		/// <summary>
 		/// For pairs involving compound collidables (any type that has children, e.g. Compound, BigCompound, and Mesh), this is invoked for each pair of children with overlapping bounds.
+		/// Can be null; the default allows every child pair without crossing the interop boundary.
 		/// </summary>
 		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
 		/// <param name="workerIndex">Index of the worker within the thread dispatcher that's running this callback.</param>
@@ -246,6 +344,7 @@ namespace Bepu
 		bool (*AllowContactGenerationBetweenChildrenFunction)(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB);
 		/// <summary>
 		/// Called after contacts have been found for a collidable pair that resulted in a convex manifold.
+		/// Can be null; the default accepts the manifold with a friction of 1, maximum recovery velocity of 2 and a 30hz critically damped spring.
 		/// </summary>
 		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
 		/// <param name="workerIndex">Index of the worker within the thread dispatcher that's running this callback.</param>
@@ -256,6 +355,7 @@ namespace Bepu
 		bool (*ConfigureConvexContactManifoldFunction)(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, ConvexContactManifold* contactManifold, PairMaterialProperties* materialProperties);
 		/// <summary>
 		/// Called after contacts have been found for a collidable pair that resulted in a nonconvex manifold.
+		/// Can be null; the default accepts the manifold with a friction of 1, maximum recovery velocity of 2 and a 30hz critically damped spring.
 		/// </summary>
 		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
 		/// <param name="workerIndex">Index of the worker within the thread dispatcher that's running this callback.</param>
@@ -266,6 +366,7 @@ namespace Bepu
 		bool (*ConfigureNonconvexContactManifoldFunction)(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, NonconvexContactManifold* contactManifold, PairMaterialProperties* materialProperties);
 		/// <summary>
 		/// Called for contacts identified between children in a compound-involving pair prior to being processed into the top level contact manifold.
+		/// Can be null; the default accepts every child manifold without crossing the interop boundary.
 		/// </summary>
 		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
 		/// <param name="workerIndex">Index of the worker within the thread dispatcher that's running this callback.</param>
@@ -276,6 +377,79 @@ namespace Bepu
 		/// <returns>True if the contacts in this child pair should be considered for constraint generation, false otherwise.</returns>
 		/// <remarks>Note that all children are required to be convex, so there is no nonconvex version of this callback.</remarks>
 		bool (*ConfigureChildContactManifoldFunction)(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB, ConvexContactManifold* contactManifold);
+		/// <summary>
+		/// Configures many collidable pairs' manifolds in one call. If provided, replaces ConfigureConvexContactManifoldFunction and ConfigureNonconvexContactManifoldFunction;
+		/// answers for pairs that persist from the previous step take effect one step late. Can be null.
+		/// </summary>
+		/// <param name="simulationHandle">Handle of the simulation owning these callbacks.</param>
+		/// <param name="workerIndex">Index of the worker within the thread dispatcher that's running this callback.</param>
+		/// <param name="count">Number of pairs in the chunk.</param>
+		/// <param name="collidablePairs">References to the collidables of each pair.</param>
+		/// <param name="convexManifolds">Convex manifold of each pair, or null if the pair's manifold is nonconvex. Read only.</param>
+		/// <param name="nonconvexManifolds">Nonconvex manifold of each pair, or null if the pair's manifold is convex. Read only.</param>
+		/// <param name="materialProperties">Contact constraint material properties to use for each pair. Holds the pair's previous material on entry.</param>
+		/// <param name="accept">Nonzero for each pair that should have a contact constraint. Holds the pair's previous answer on entry.</param>
+		/// <remarks>The engine creates a pair's constraint as soon as it is configured, so pairs can't wait for a chunk to fill during collision detection.
+		/// A pair seen for the first time is configured immediately in a chunk of one, costing one call per new pair. Pairs that persist from the previous step reuse that step's answer and are sent in full chunks
+		/// after collision detection finishes; their new accept flags and materials apply from the next step, so rejecting a persistent pair still leaves its constraint in place for the current step.
+		/// A persistent pair's constraint is already built when its chunk is sent, so manifolds can't be modified here. Use ConfigureConvexContactManifoldFunction and ConfigureNonconvexContactManifoldFunction without this function to edit contacts.</remarks>
+		void (*ConfigureContactManifoldsFunction)(SimulationHandle simulationHandle, int32_t workerIndex, int32_t count, CollidablePair* collidablePairs, const ConvexContactManifold* const* convexManifolds, const NonconvexContactManifold* const* nonconvexManifolds, PairMaterialProperties* materialProperties, uint8_t* accept);
+		/// <summary>
+		/// Maximum number of pairs passed to ConfigureContactManifoldsFunction per call. Zero or less uses a default of 64.
+		/// </summary>
+		int32_t ConfigureContactManifoldsBatchSize;
+	};
+
+	/// <summary>
+	/// Builds NarrowPhaseCallbacks from the static hooks declared by Derived. Only hooks that Derived declares itself are filled in; the rest are left null so that the simulation uses its built in defaults
+	/// and never crosses the interop boundary for them.
+	/// </summary>
+	/// <typeparam name="Derived">Type declaring any of the static hooks Initialize, Dispose, AllowContactGeneration, AllowContactGenerationBetweenChildren,
+	/// ConfigureConvexContactManifold, ConfigureNonconvexContactManifold, ConfigureChildContactManifold and ConfigureContactManifolds with the signatures of the matching NarrowPhaseCallbacks function pointers.</typeparam>
+	/// <remarks>Usage: struct MyCallbacks : NarrowPhaseCallbacksBase&lt;MyCallbacks&gt; { static bool ConfigureConvexContactManifold(...); }; then pass MyCallbacks::Create() to CreateSimulation.</remarks>
+	template<typename Derived>
+	struct NarrowPhaseCallbacksBase
+	{
+		//These are never installed; they only exist so that the member lookups in Create resolve here when Derived doesn't hide them.
+		static void Initialize(SimulationHandle simulationHandle) {}
+		static void Dispose(SimulationHandle simulationHandle) {}
+		static bool AllowContactGeneration(SimulationHandle simulationHandle, int32_t workerIndex, CollidableReference a, CollidableReference b, float* speculativeMargin) { return true; }
+		static bool AllowContactGenerationBetweenChildren(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB) { return true; }
+		static bool ConfigureConvexContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, ConvexContactManifold* contactManifold, PairMaterialProperties* materialProperties) { return true; }
+		static bool ConfigureNonconvexContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, NonconvexContactManifold* contactManifold, PairMaterialProperties* materialProperties) { return true; }
+		static bool ConfigureChildContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB, ConvexContactManifold* contactManifold) { return true; }
+		static void ConfigureContactManifolds(SimulationHandle simulationHandle, int32_t workerIndex, int32_t count, CollidablePair* collidablePairs, const ConvexContactManifold* const* convexManifolds, const NonconvexContactManifold* const* nonconvexManifolds, PairMaterialProperties* materialProperties, uint8_t* accept) {}
+		/// <summary>
+		/// Chunk size used for ConfigureContactManifolds. Derived can hide this to pick its own size; zero uses the default.
+		/// </summary>
+		static constexpr int32_t ConfigureContactManifoldsBatchSize = 0;
+
+		/// <summary>
+		/// Creates narrow phase callbacks pointing at the hooks Derived declares.
+		/// </summary>
+		/// <returns>Callbacks to pass to CreateSimulation.</returns>
+		static NarrowPhaseCallbacks Create()
+		{
+			NarrowPhaseCallbacks callbacks = {};
+			if constexpr (&Derived::Initialize != &NarrowPhaseCallbacksBase::Initialize)
+				callbacks.InitializeFunction = &Derived::Initialize;
+			if constexpr (&Derived::Dispose != &NarrowPhaseCallbacksBase::Dispose)
+				callbacks.DisposeFunction = &Derived::Dispose;
+			if constexpr (&Derived::AllowContactGeneration != &NarrowPhaseCallbacksBase::AllowContactGeneration)
+				callbacks.AllowContactGenerationFunction = &Derived::AllowContactGeneration;
+			if constexpr (&Derived::AllowContactGenerationBetweenChildren != &NarrowPhaseCallbacksBase::AllowContactGenerationBetweenChildren)
+				callbacks.AllowContactGenerationBetweenChildrenFunction = &Derived::AllowContactGenerationBetweenChildren;
+			if constexpr (&Derived::ConfigureConvexContactManifold != &NarrowPhaseCallbacksBase::ConfigureConvexContactManifold)
+				callbacks.ConfigureConvexContactManifoldFunction = &Derived::ConfigureConvexContactManifold;
+			if constexpr (&Derived::ConfigureNonconvexContactManifold != &NarrowPhaseCallbacksBase::ConfigureNonconvexContactManifold)
+				callbacks.ConfigureNonconvexContactManifoldFunction = &Derived::ConfigureNonconvexContactManifold;
+			if constexpr (&Derived::ConfigureChildContactManifold != &NarrowPhaseCallbacksBase::ConfigureChildContactManifold)
+				callbacks.ConfigureChildContactManifoldFunction = &Derived::ConfigureChildContactManifold;
+			if constexpr (&Derived::ConfigureContactManifolds != &NarrowPhaseCallbacksBase::ConfigureContactManifolds)
+				callbacks.ConfigureContactManifoldsFunction = &Derived::ConfigureContactManifolds;
+			callbacks.ConfigureContactManifoldsBatchSize = Derived::ConfigureContactManifoldsBatchSize;
+			return callbacks;
+		}
 	};
 
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "InteropMath.h"
+
 namespace Bepu
 {
 	const float BPI = 3.14159265359f; //shrug!
@@ -39,4 +41,302 @@ namespace Bepu
 			TwiceDampingRatio = dampingRatio * 2;
 		}
 	};
+
+	/// <summary>
+	/// Types of constraint descriptions accepted by the batched constraint creation functions.
+	/// </summary>
+	enum struct JointType : int32_t
+	{
+		BallSocket = 0,
+		Hinge = 1,
+		SwivelHinge = 2,
+		AngularMotor = 3,
+		DistanceLimit = 4,
+		Weld = 5,
+	};
+
+	/// <summary>
+	/// Constrains points on two bodies to be coincident.
+	/// </summary>
+	struct BallSocket
+	{
+		static const JointType Type = JointType::BallSocket;
+		/// <summary>
+		/// Local offset from the center of body A to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetA;
+		/// <summary>
+		/// Local offset from the center of body B to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetB;
+		/// <summary>
+		/// Spring frequency and damping parameters.
+		/// </summary>
+		Bepu::SpringSettings SpringSettings;
+	};
+
+	/// <summary>
+	/// Constrains two bodies with the degrees of freedom of a hinge: a shared anchor point and a shared axis of rotation.
+	/// </summary>
+	struct Hinge
+	{
+		static const JointType Type = JointType::Hinge;
+		/// <summary>
+		/// Local offset from the center of body A to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetA;
+		/// <summary>
+		/// Hinge axis in the local space of A.
+		/// </summary>
+		Vector3 LocalHingeAxisA;
+		/// <summary>
+		/// Local offset from the center of body B to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetB;
+		/// <summary>
+		/// Hinge axis in the local space of B.
+		/// </summary>
+		Vector3 LocalHingeAxisB;
+		/// <summary>
+		/// Spring frequency and damping parameters.
+		/// </summary>
+		Bepu::SpringSettings SpringSettings;
+	};
+
+	/// <summary>
+	/// Constrains two bodies with a shared anchor point, a swivel axis attached to A, and a hinge axis attached to B that stays perpendicular to the swivel axis.
+	/// </summary>
+	struct SwivelHinge
+	{
+		static const JointType Type = JointType::SwivelHinge;
+		/// <summary>
+		/// Local offset from the center of body A to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetA;
+		/// <summary>
+		/// Swivel axis in the local space of body A.
+		/// </summary>
+		Vector3 LocalSwivelAxisA;
+		/// <summary>
+		/// Local offset from the center of body B to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetB;
+		/// <summary>
+		/// Hinge axis in the local space of body B.
+		/// </summary>
+		Vector3 LocalHingeAxisB;
+		/// <summary>
+		/// Spring frequency and damping parameters.
+		/// </summary>
+		Bepu::SpringSettings SpringSettings;
+	};
+
+	/// <summary>
+	/// Describes how a motor constraint pursues its target.
+	/// </summary>
+	struct MotorSettings
+	{
+		/// <summary>
+		/// Maximum force that the constraint can apply in a single frame.
+		/// </summary>
+		float MaximumForce;
+		/// <summary>
+		/// Damping of the motor. Higher values make the motor approach its target velocity more softly; zero is infinitely stiff.
+		/// </summary>
+		float Damping;
+	};
+
+	/// <summary>
+	/// Drives the relative angular velocity between two bodies toward a target.
+	/// </summary>
+	struct AngularMotor
+	{
+		static const JointType Type = JointType::AngularMotor;
+		/// <summary>
+		/// Target relative angular velocity between A and B, stored in A's local space.
+		/// </summary>
+		Vector3 TargetVelocityLocalA;
+		/// <summary>
+		/// Motor control parameters.
+		/// </summary>
+		MotorSettings Settings;
+	};
+
+	/// <summary>
+	/// Constrains the distance between points on two bodies to a range.
+	/// </summary>
+	struct DistanceLimit
+	{
+		static const JointType Type = JointType::DistanceLimit;
+		/// <summary>
+		/// Local offset from the center of body A to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetA;
+		/// <summary>
+		/// Local offset from the center of body B to its attachment point.
+		/// </summary>
+		Vector3 LocalOffsetB;
+		/// <summary>
+		/// Minimum distance permitted between the point on A and the point on B.
+		/// </summary>
+		float MinimumDistance;
+		/// <summary>
+		/// Maximum distance permitted between the point on A and the point on B.
+		/// </summary>
+		float MaximumDistance;
+		/// <summary>
+		/// Spring frequency and damping parameters.
+		/// </summary>
+		Bepu::SpringSettings SpringSettings;
+	};
+
+	/// <summary>
+	/// Constrains two bodies to maintain a relative position and orientation.
+	/// </summary>
+	struct Weld
+	{
+		static const JointType Type = JointType::Weld;
+		/// <summary>
+		/// Offset from body A to body B in the local space of A.
+		/// </summary>
+		Vector3 LocalOffset;
+		/// <summary>
+		/// Target orientation of body B in body A's local space.
+		/// </summary>
+		Quaternion LocalOrientation;
+		/// <summary>
+		/// Spring frequency and damping parameters.
+		/// </summary>
+		Bepu::SpringSettings SpringSettings;
+	};
+
+	/// <summary>
+	/// Snapshot of the active constraint set's batching and the cost of the most recent solve.
+	/// </summary>
+	struct SolverStatistics
+	{
+		/// <summary>
+		/// Number of constraints in the active set.
+		/// </summary>
+		int32_t ConstraintCount;
+		/// <summary>
+		/// Number of constraint batches in the active set, including the fallback batch if it exists.
+		/// </summary>
+		int32_t BatchCount;
+		/// <summary>
+		/// Number of synchronized batches in the active set. Constraints in these batches are solved in parallel without conflicts.
+		/// </summary>
+		int32_t SynchronizedBatchCount;
+		/// <summary>
+		/// Number of synchronized batches the solver creates before putting constraints in the fallback batch.
+		/// </summary>
+		int32_t FallbackBatchThreshold;
+		/// <summary>
+		/// Number of constraints in the fallback batch.
+		/// </summary>
+		int32_t FallbackConstraintCount;
+		/// <summary>
+		/// Number of bodies referenced by constraints in the fallback batch.
+		/// </summary>
+		int32_t FallbackBodyCount;
+		/// <summary>
+		/// Number of constraint types the solver knows about. Sizes the per-type constraint count buffer.
+		/// </summary>
+		int32_t ConstraintTypeCount;
+		/// <summary>
+		/// Number of substeps used by the most recent solve.
+		/// </summary>
+		int32_t SubstepCount;
+		/// <summary>
+		/// Number of velocity iterations the solver uses per substep when no scheduler overrides it.
+		/// </summary>
+		int32_t VelocityIterationCount;
+		/// <summary>
+		/// Total number of velocity iterations run across all substeps of the most recent solve.
+		/// </summary>
+		int32_t SolveIterationCount;
+		/// <summary>
+		/// Duration of the most recent solve in seconds, including the pose and velocity integration interleaved with substeps.
+		/// </summary>
+		double SolveTime;
+		/// <summary>
+		/// Average duration of a substep in the most recent solve in seconds.
+		/// </summary>
+		double SubstepTime;
+		/// <summary>
+		/// Average duration of a velocity iteration in the most recent solve in seconds.
+		/// </summary>
+		double IterationTime;
+	};
+
+	/// <summary>
+	/// Configures the adaptive velocity iteration scheduler.
+	/// </summary>
+	struct AdaptiveVelocityIterationSettings
+	{
+		/// <summary>
+		/// Fewest velocity iterations the scheduler will choose for a substep.
+		/// </summary>
+		int32_t MinimumIterationCount;
+		/// <summary>
+		/// Most velocity iterations the scheduler will choose for a substep.
+		/// </summary>
+		int32_t MaximumIterationCount;
+		/// <summary>
+		/// Velocity change below which the constrained bodies are considered settled. The scheduler drops one iteration after a solve that stays below this.
+		/// </summary>
+		float SettledVelocityChange;
+		/// <summary>
+		/// Velocity change above which the constrained bodies are considered under stress. The scheduler raises the iteration count after a solve that exceeds this.
+		/// </summary>
+		float StressedVelocityChange;
+		/// <summary>
+		/// Number of iterations to add when the constrained bodies are under stress.
+		/// </summary>
+		int32_t IterationIncrease;
+
+		/// <summary>
+		/// Creates adaptive velocity iteration settings.
+		/// </summary>
+		/// <param name="minimumIterationCount">Fewest velocity iterations the scheduler will choose for a substep.</param>
+		/// <param name="maximumIterationCount">Most velocity iterations the scheduler will choose for a substep.</param>
+		/// <param name="settledVelocityChange">Velocity change below which the constrained bodies are considered settled.</param>
+		/// <param name="stressedVelocityChange">Velocity change above which the constrained bodies are considered under stress.</param>
+		/// <param name="iterationIncrease">Number of iterations to add when the constrained bodies are under stress.</param>
+		AdaptiveVelocityIterationSettings(int32_t minimumIterationCount = 1, int32_t maximumIterationCount = 8, float settledVelocityChange = 0.01f, float stressedVelocityChange = 0.1f, int32_t iterationIncrease = 2)
+		{
+			MinimumIterationCount = minimumIterationCount;
+			MaximumIterationCount = maximumIterationCount;
+			SettledVelocityChange = settledVelocityChange;
+			StressedVelocityChange = stressedVelocityChange;
+			IterationIncrease = iterationIncrease;
+		}
+	};
+
+	/// <summary>
+	/// Reports the decisions made by the adaptive velocity iteration scheduler.
+	/// </summary>
+	struct AdaptiveVelocityIterationState
+	{
+		/// <summary>
+		/// Velocity iteration count used by the most recent solve.
+		/// </summary>
+		int32_t LastIterationCount;
+		/// <summary>
+		/// Velocity iteration count that the next solve will use.
+		/// </summary>
+		int32_t NextIterationCount;
+		/// <summary>
+		/// Root mean square change in velocity across constrained active bodies during the most recent solve.
+		/// </summary>
+		float LastVelocityChange;
+		/// <summary>
+		/// Number of solves observed since the scheduler was enabled.
+		/// </summary>
+		int32_t SolveCount;
+		/// <summary>
+		/// Sum of the iteration counts used by every observed solve. Divide by SolveCount for the average.
+		/// </summary>
+		int64_t TotalIterationCount;
+	};
 }
\ No newline at end of file
@@ -110,4 +110,56 @@ namespace Bepu
 			return detection;
 		}
 	};
+
+	/// <summary>
+	/// Configures how adaptive continuity picks a collision detection mode for each tracked body.
+	/// </summary>
+	/// <remarks>All thresholds are expressed relative to the body's size, measured as the smallest extent of its shape's local bounding box.</remarks>
+	struct AdaptiveContinuitySettings
+	{
+		/// <summary>
+		/// Distance traveled in one timestep, as a fraction of the body's size, above which the body switches from discrete to passive handling.
+		/// </summary>
+		float PassiveTravelRatio;
+		/// <summary>
+		/// Distance traveled in one timestep, as a fraction of the body's size, above which the body is swept.
+		/// </summary>
+		float ContinuousTravelRatio;
+		/// <summary>
+		/// Minimum sweep timestep as a fraction of the time the body takes to travel its own size. Smaller values catch briefer collisions at higher sweep cost.
+		/// </summary>
+		float MinimumSweepTimestepScale;
+		/// <summary>
+		/// Sweep convergence threshold as a fraction of the time the body takes to travel its own size. Smaller values refine the time of impact further at higher sweep cost.
+		/// </summary>
+		float SweepConvergenceThresholdScale;
+	};
+
+	/// <summary>
+	/// Reports the choices made by adaptive continuity and the sweep work done in the last timestep.
+	/// </summary>
+	struct AdaptiveContinuityStatistics
+	{
+		/// <summary>
+		/// Number of bodies whose continuity is chosen adaptively.
+		/// </summary>
+		int32_t TrackedBodyCount;
+		/// <summary>
+		/// Number of awake tracked bodies set to discrete handling in the last timestep.
+		/// </summary>
+		int32_t DiscreteCount;
+		/// <summary>
+		/// Number of awake tracked bodies set to passive handling in the last timestep.
+		/// </summary>
+		int32_t PassiveCount;
+		/// <summary>
+		/// Number of awake tracked bodies set to continuous handling in the last timestep.
+		/// </summary>
+		int32_t ContinuousCount;
+		/// <summary>
+		/// Number of pairs admitted to the narrow phase in the last timestep where at least one collidable used continuous handling, tracked or not.
+		/// Each such pair is eligible for a sweep test, so this is an upper bound on the sweeps run.
+		/// </summary>
+		int32_t SweepPairCount;
+	};
 }
\ No newline at end of file
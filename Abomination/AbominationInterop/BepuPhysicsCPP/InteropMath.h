@@ -52,6 +52,29 @@ namespace Bepu
 			return Quaternion{ 0, 0, 0, 1 };
 		}
 	};
+	/// <summary>
+	/// Integer coordinate of a cell in a grid.
+	/// </summary>
+	struct Int3
+	{
+		int32_t X;
+		int32_t Y;
+		int32_t Z;
+
+		Int3()
+		{
+			X = 0;
+			Y = 0;
+			Z = 0;
+		}
+
+		Int3(int32_t x, int32_t y, int32_t z)
+		{
+			X = x;
+			Y = y;
+			Z = z;
+		}
+	};
 
 
 	struct Vector128F
@@ -13,36 +13,30 @@ struct NarrowPhaseSettings
 //If you had multiple simulations, you could index settings by the simulationHandle.Index. //TODO: That's not exposed yet!
 NarrowPhaseSettings narrowPhaseSettings;
 
-bool AllowContactGeneration(SimulationHandle simulationHandle, int32_t workerIndex, CollidableReference a, CollidableReference b, float* speculativeMargin)
+//Only the hooks declared here get filled in. The child pair hooks would just return true, so they're left out and the simulation skips them without crossing the interop boundary.
+struct DemoNarrowPhaseCallbacks : NarrowPhaseCallbacksBase<DemoNarrowPhaseCallbacks>
 {
-	//While the engine won't even try creating pairs between statics at all, it will ask about kinematic-kinematic pairs.
-	//Those pairs cannot emit constraints since both involved bodies have infinite inertia. Since most of the demos don't need
-	//to collect information about kinematic-kinematic pairs, we'll require that at least one of the bodies needs to be dynamic.
-	return a.GetMobility() == CollidableMobility::Dynamic || b.GetMobility() == CollidableMobility::Dynamic;
-}
-
-bool AllowContactGenerationBetweenChildren(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB)
-{
-	return true;
-}
-
-//On the C# side, these two functions are one generic function, but it got split up due to the interop barrier.
-bool ConfigureConvexContactManifold(SimulationHandle, int32_t workerIndex, CollidablePair collidablePair, ConvexContactManifold* contactManifold, PairMaterialProperties* materialProperties)
-{
-	*materialProperties = narrowPhaseSettings.MaterialProperties;
-	return true;
-}
+	static bool AllowContactGeneration(SimulationHandle simulationHandle, int32_t workerIndex, CollidableReference a, CollidableReference b, float* speculativeMargin)
+	{
+		//While the engine won't even try creating pairs between statics at all, it will ask about kinematic-kinematic pairs.
+		//Those pairs cannot emit constraints since both involved bodies have infinite inertia. Since most of the demos don't need
+		//to collect information about kinematic-kinematic pairs, we'll require that at least one of the bodies needs to be dynamic.
+		return a.GetMobility() == CollidableMobility::Dynamic || b.GetMobility() == CollidableMobility::Dynamic;
+	}
 
-bool ConfigureNonconvexContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, NonconvexContactManifold* contactManifold, PairMaterialProperties* materialProperties)
-{
-	*materialProperties = narrowPhaseSettings.MaterialProperties;
-	return true;
-}
+	//On the C# side, these two functions are one generic function, but it got split up due to the interop barrier.
+	static bool ConfigureConvexContactManifold(SimulationHandle, int32_t workerIndex, CollidablePair collidablePair, ConvexContactManifold* contactManifold, PairMaterialProperties* materialProperties)
+	{
+		*materialProperties = narrowPhaseSettings.MaterialProperties;
+		return true;
+	}
 
-bool ConfigureChildContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB, ConvexContactManifold* contactManifold)
-{
-	return true;
-}
+	static bool ConfigureNonconvexContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, NonconvexContactManifold* contactManifold, PairMaterialProperties* materialProperties)
+	{
+		*materialProperties = narrowPhaseSettings.MaterialProperties;
+		return true;
+	}
+};
 
 //POSE INTEGRATION
 struct PoseIntegrationSettings
@@ -93,12 +87,7 @@ int main()
 	threadCount = threadCount > 4 ? threadCount - 2 : threadCount;
 	ThreadDispatcherHandle threadDispatcher = CreateThreadDispatcher(threadCount);
 
-	NarrowPhaseCallbacks narrowPhaseCallbacks = {};
-	narrowPhaseCallbacks.AllowContactGenerationFunction = &AllowContactGeneration;
-	narrowPhaseCallbacks.AllowContactGenerationBetweenChildrenFunction = &AllowContactGenerationBetweenChildren;
-	narrowPhaseCallbacks.ConfigureConvexContactManifoldFunction = &ConfigureConvexContactManifold;
-	narrowPhaseCallbacks.ConfigureNonconvexContactManifoldFunction = &ConfigureNonconvexContactManifold;
-	narrowPhaseCallbacks.ConfigureChildContactManifoldFunction = &ConfigureChildContactManifold;
+	NarrowPhaseCallbacks narrowPhaseCallbacks = DemoNarrowPhaseCallbacks::Create();
 
 	narrowPhaseSettings.MaterialProperties = PairMaterialProperties(1, 2, SpringSettings(30, 1));
 
@@ -32,7 +32,7 @@ namespace Bepu
 		/// <summary>
 		/// How the pose integrator should handle angular velocity integration.
 		/// </summary>
-		AngularIntegrationMode AngularIntegrationMode;
+		Bepu::AngularIntegrationMode AngularIntegrationMode;
 		/// <summary>
 		/// Whether the integrator should use only one step for unconstrained bodies when using a substepping solver.
 		/// If true, unconstrained bodies use a single step of length equal to the dt provided to <see cref="Simulation.Timestep"/>. 
@@ -18,7 +18,10 @@ namespace Bepu
 		ConvexHull = 5,
 		Compound = 6,
 		BigCompound = 7,
-		Mesh = 8
+		Mesh = 8,
+		CompressedMesh = 9,
+		Heightfield = 10,
+		VoxelGrid = 11
 	};
 
 	struct Sphere
@@ -140,6 +143,25 @@ namespace Bepu
 		Vector256F Offset;
 	};
 
+	/// <summary>
+	/// Range of points within a shared point buffer that defines one convex hull.
+	/// </summary>
+	struct PointSetRange
+	{
+		/// <summary>
+		/// Index of the first point of the set in the shared point buffer.
+		/// </summary>
+		int32_t Start;
+		/// <summary>
+		/// Number of points in the set.
+		/// </summary>
+		int32_t Count;
+		/// <summary>
+		/// Mass used to compute the hull's inertia.
+		/// </summary>
+		float Mass;
+	};
+
 	struct ConvexHull
 	{
 		/// <summary>
@@ -198,7 +220,7 @@ namespace Bepu
 		/// <summary>
 		/// Acceleration structure for the compound children.
 		/// </summary>
-		Tree Tree;
+		Bepu::Tree Tree;
 		/// <summary>
 		/// Buffer of children within this compound.
 		/// </summary>
@@ -210,7 +232,7 @@ namespace Bepu
 		/// <summary>
 		/// Acceleration structure of the mesh.
 		/// </summary>
-		Tree Tree;
+		Bepu::Tree Tree;
 		/// <summary>
 		/// Buffer of triangles composing the mesh. Triangles will only collide with tests which see the triangle as wound clockwise in right handed coordinates or counterclockwise in left handed coordinates.
 		/// </summary>
@@ -226,4 +248,335 @@ namespace Bepu
 			InverseScale.Z = scale.Z != 0 ? 1.0f / scale.Z : std::numeric_limits<float>::max();
 		}
 	};
+
+	/// <summary>
+	/// Vertex position quantized to 16 bits per axis within a compressed mesh's bounds.
+	/// </summary>
+	struct QuantizedVertex
+	{
+		uint16_t X;
+		uint16_t Y;
+		uint16_t Z;
+	};
+
+	/// <summary>
+	/// Child of a compressed mesh tree node with bounds quantized to the mesh's vertex grid.
+	/// </summary>
+	struct QuantizedNodeChild
+	{
+		QuantizedVertex Min;
+		QuantizedVertex Max;
+		/// <summary>
+		/// Index of the child node, or -1 - triangleIndex for leaves.
+		/// </summary>
+		int32_t Index;
+	};
+
+	/// <summary>
+	/// 2-wide compressed mesh tree node.
+	/// </summary>
+	struct QuantizedNode
+	{
+		QuantizedNodeChild A;
+		QuantizedNodeChild B;
+	};
+
+	/// <summary>
+	/// Triangle mesh storing shared vertices quantized to 16 bits per axis, 16 or 32 bit index triplets, and a tree with quantized child bounds.
+	/// Triangles are decoded on demand during collision and ray tests.
+	/// </summary>
+	struct CompressedMesh
+	{
+		/// <summary>
+		/// Nodes of the mesh's acceleration structure.
+		/// </summary>
+		Buffer<QuantizedNode> Nodes;
+		/// <summary>
+		/// Quantized vertices shared by the mesh's triangles.
+		/// </summary>
+		Buffer<QuantizedVertex> Vertices;
+		/// <summary>
+		/// Three vertex indices per triangle, each IndexSize bytes wide.
+		/// </summary>
+		ByteBuffer Indices;
+		/// <summary>
+		/// Number of triangles in the mesh.
+		/// </summary>
+		int32_t TriangleCount;
+		/// <summary>
+		/// Size of each vertex index in bytes. 2 when the mesh has at most 65536 vertices, 4 otherwise.
+		/// </summary>
+		int32_t IndexSize;
+		/// <summary>
+		/// Unscaled local position of the quantization grid's origin.
+		/// </summary>
+		Vector3 Origin;
+		/// <summary>
+		/// Unscaled local size of one quantization step along each axis.
+		/// </summary>
+		Vector3 QuantizationStep;
+		Vector3 Scale;
+		Vector3 InverseScale;
+
+		/// <summary>
+		/// Gets the unscaled local position of a vertex.
+		/// </summary>
+		Vector3 DecodeVertex(int32_t vertexIndex)
+		{
+			QuantizedVertex& vertex = Vertices[vertexIndex];
+			return Vector3(Origin.X + vertex.X * QuantizationStep.X, Origin.Y + vertex.Y * QuantizationStep.Y, Origin.Z + vertex.Z * QuantizationStep.Z);
+		}
+
+		/// <summary>
+		/// Gets the vertex indices of a triangle.
+		/// </summary>
+		void GetTriangleIndices(int32_t triangleIndex, int32_t* a, int32_t* b, int32_t* c)
+		{
+			if (IndexSize == 2)
+			{
+				uint16_t* indices = (uint16_t*)Indices.Memory + triangleIndex * 3;
+				*a = indices[0]; *b = indices[1]; *c = indices[2];
+			}
+			else
+			{
+				int32_t* indices = (int32_t*)Indices.Memory + triangleIndex * 3;
+				*a = indices[0]; *b = indices[1]; *c = indices[2];
+			}
+		}
+	};
+
+	/// <summary>
+	/// Storage format of heightfield samples.
+	/// </summary>
+	enum struct HeightfieldSampleFormat : int32_t
+	{
+		/// <summary>
+		/// 32 bit floating point samples.
+		/// </summary>
+		Float32 = 0,
+		/// <summary>
+		/// 16 bit unsigned integer samples.
+		/// </summary>
+		UInt16 = 1
+	};
+
+	/// <summary>
+	/// Regular grid of height samples in the local XZ plane, exposed to collision detection as two triangles per cell.
+	/// </summary>
+	/// <remarks>Sample (x, z) sits at local position (x * CellSizeX, HeightOffset + sample * HeightScale, z * CellSizeZ).
+	/// Cell (x, z) spans samples x to x + 1 and z to z + 1, and its triangles are children 2 * (z * (SampleCountX - 1) + x) and that plus one.
+	/// Triangles face +Y and, like mesh triangles, only collide from that side.</remarks>
+	struct Heightfield
+	{
+		/// <summary>
+		/// Bit set in CellFlags for cells with no surface.
+		/// </summary>
+		static const uint8_t HoleFlag = 1;
+		/// <summary>
+		/// Number of bits that a cell's material is shifted by within CellFlags.
+		/// </summary>
+		static const int32_t MaterialShift = 1;
+
+		/// <summary>
+		/// Height samples, row by row along X. Each sample is 4 bytes for Float32 samples and 2 bytes for UInt16 samples.
+		/// </summary>
+		ByteBuffer Samples;
+		/// <summary>
+		/// One byte per cell, row by row along X. Bit 0 marks a hole and the remaining bits hold a material index. Empty if the heightfield has no holes or materials.
+		/// </summary>
+		ByteBuffer CellFlags;
+		/// <summary>
+		/// Number of samples along the local X axis.
+		/// </summary>
+		int32_t SampleCountX;
+		/// <summary>
+		/// Number of samples along the local Z axis.
+		/// </summary>
+		int32_t SampleCountZ;
+		/// <summary>
+		/// Storage format of the samples.
+		/// </summary>
+		HeightfieldSampleFormat SampleFormat;
+		/// <summary>
+		/// Distance between samples along the local X axis.
+		/// </summary>
+		float CellSizeX;
+		/// <summary>
+		/// Distance between samples along the local Z axis.
+		/// </summary>
+		float CellSizeZ;
+		/// <summary>
+		/// Multiplier applied to stored samples to get local heights.
+		/// </summary>
+		float HeightScale;
+		/// <summary>
+		/// Offset added to scaled samples to get local heights.
+		/// </summary>
+		float HeightOffset;
+		/// <summary>
+		/// Lowest local height of any sample.
+		/// </summary>
+		float MinimumHeight;
+		/// <summary>
+		/// Highest local height of any sample.
+		/// </summary>
+		float MaximumHeight;
+
+		/// <summary>
+		/// Gets the local height of a sample.
+		/// </summary>
+		float GetHeight(int32_t x, int32_t z)
+		{
+			int32_t sampleIndex = z * SampleCountX + x;
+			float sample = SampleFormat == HeightfieldSampleFormat::Float32 ? ((float*)Samples.Memory)[sampleIndex] : ((uint16_t*)Samples.Memory)[sampleIndex];
+			return HeightOffset + sample * HeightScale;
+		}
+
+		/// <summary>
+		/// Gets the material index of the cell containing a child triangle, or 0 if the heightfield has no cell flags.
+		/// </summary>
+		int32_t GetMaterial(int32_t childIndex)
+		{
+			return CellFlags.Length > 0 ? CellFlags.Memory[childIndex >> 1] >> MaterialShift : 0;
+		}
+	};
+
+	/// <summary>
+	/// Occupancy of an 8x8x8 block of voxels within a VoxelGrid. Voxel (x, y, z) within the brick is bit y * 8 + x of Occupancy[z].
+	/// </summary>
+	struct VoxelBrick
+	{
+		/// <summary>
+		/// One 64 bit slice of occupancy bits per local Z coordinate.
+		/// </summary>
+		uint64_t Occupancy[8];
+		/// <summary>
+		/// Index of the brick cell in VoxelGrid::BrickIndices that refers to this brick.
+		/// </summary>
+		int32_t BrickCellIndex;
+	};
+
+	/// <summary>
+	/// Sparse grid of uniformly sized cubic voxels, exposed to collision detection as the triangles of the faces between occupied and empty voxels.
+	/// </summary>
+	/// <remarks>Voxel (x, y, z) spans local positions (x, y, z) * VoxelSize to (x + 1, y + 1, z + 1) * VoxelSize.
+	/// Face f of voxel v is made of children v * 12 + f * 2 and that plus one, where v = (z * SizeY + y) * SizeX + x and faces are ordered -X, +X, -Y, +Y, -Z, +Z.
+	/// Faces shared by two occupied voxels are never reported, so contact generation sees one closed surface with no internal edges.</remarks>
+	struct VoxelGrid
+	{
+		/// <summary>
+		/// Number of voxels along each axis of a brick.
+		/// </summary>
+		static const int32_t BrickSize = 8;
+		/// <summary>
+		/// Number of triangle children reserved for each voxel.
+		/// </summary>
+		static const int32_t ChildrenPerVoxel = 12;
+
+		/// <summary>
+		/// Index into Bricks for each brick cell of the grid, row by row along X and then Y, or -1 for brick cells with no occupied voxels.
+		/// </summary>
+		Buffer<int32_t> BrickIndices;
+		/// <summary>
+		/// Storage for bricks with at least one occupied voxel. Only the first BrickCount slots are in use.
+		/// </summary>
+		Buffer<VoxelBrick> Bricks;
+		/// <summary>
+		/// Number of bricks in use.
+		/// </summary>
+		int32_t BrickCount;
+		/// <summary>
+		/// Number of voxels along the local X axis.
+		/// </summary>
+		int32_t SizeX;
+		/// <summary>
+		/// Number of voxels along the local Y axis.
+		/// </summary>
+		int32_t SizeY;
+		/// <summary>
+		/// Number of voxels along the local Z axis.
+		/// </summary>
+		int32_t SizeZ;
+		/// <summary>
+		/// Number of brick cells along the local X axis.
+		/// </summary>
+		int32_t BrickCountX;
+		/// <summary>
+		/// Number of brick cells along the local Y axis.
+		/// </summary>
+		int32_t BrickCountY;
+		/// <summary>
+		/// Number of brick cells along the local Z axis.
+		/// </summary>
+		int32_t BrickCountZ;
+		/// <summary>
+		/// Edge length of each voxel.
+		/// </summary>
+		float VoxelSize;
+
+		/// <summary>
+		/// Checks whether a voxel is occupied. Coordinates outside the grid are treated as empty.
+		/// </summary>
+		bool IsOccupied(int32_t x, int32_t y, int32_t z)
+		{
+			if ((uint32_t)x >= (uint32_t)SizeX || (uint32_t)y >= (uint32_t)SizeY || (uint32_t)z >= (uint32_t)SizeZ)
+				return false;
+			int32_t brickIndex = BrickIndices.Memory[((z >> 3) * BrickCountY + (y >> 3)) * BrickCountX + (x >> 3)];
+			if (brickIndex < 0)
+				return false;
+			return ((Bricks.Memory[brickIndex].Occupancy[z & 7] >> (((y & 7) << 3) | (x & 7))) & 1) != 0;
+		}
+	};
+
+	/// <summary>
+	/// Strategy used to build a mesh's acceleration structure.
+	/// </summary>
+	enum struct MeshBuildMode : int32_t
+	{
+		/// <summary>
+		/// Top-down build choosing splits with a binned surface area heuristic. Slower to build, faster to query.
+		/// </summary>
+		BinnedSAH = 0,
+		/// <summary>
+		/// Builds the tree by splitting triangles sorted along a Morton curve. Much faster to build, somewhat slower to query.
+		/// </summary>
+		Morton = 1
+	};
+
+	/// <summary>
+	/// Options for building a mesh's acceleration structure.
+	/// </summary>
+	struct MeshBuildOptions
+	{
+		/// <summary>
+		/// Strategy used to build the tree.
+		/// </summary>
+		MeshBuildMode Mode;
+		/// <summary>
+		/// Number of bins considered per node by the binned SAH build. Values below 2 use the default of 16. Ignored by Morton builds.
+		/// </summary>
+		int32_t BinCount;
+
+		MeshBuildOptions() : Mode(MeshBuildMode::BinnedSAH), BinCount(16) {}
+		MeshBuildOptions(MeshBuildMode mode, int32_t binCount = 16) : Mode(mode), BinCount(binCount) {}
+	};
+
+	/// <summary>
+	/// Shape stored in or loaded from a shape asset. Which member is valid depends on ShapeType.
+	/// </summary>
+	struct ShapeAsset
+	{
+		/// <summary>
+		/// Type of the shape held by the asset. One of ShapeTypes::Mesh, ShapeTypes::ConvexHull or ShapeTypes::BigCompound.
+		/// </summary>
+		ShapeTypes ShapeType;
+		union
+		{
+			Bepu::Mesh Mesh;
+			Bepu::ConvexHull ConvexHull;
+			Bepu::BigCompound BigCompound;
+		};
+
+		ShapeAsset() : ShapeType(ShapeTypes::Mesh), Mesh() {}
+	};
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "Handles.h"
 #include "Continuity.h"
 #include "InteropMath.h"
+#include "Utilities.h"
+#include "Shapes.h"
 
 namespace Bepu
 {
@@ -119,4 +121,38 @@ namespace Bepu
 		/// </summary>
 		int32_t BroadPhaseIndex;
 	};
+
+	/// <summary>
+	/// Group of statics prepared ahead of time so that it can be attached to or detached from a simulation in a handful of operations.
+	/// </summary>
+	/// <remarks>Statics with convex shapes become children of a single big compound whose acceleration structure is built when the chunk is created, so attaching them costs one broad phase insertion regardless of their number.
+	/// Compound children keep the relative order of the convex descriptions that produced them, so contact callbacks can map a child index back to its source description.
+	/// Statics with nonconvex shapes cannot be compound children and are added individually on attach.</remarks>
+	struct StaticChunk
+	{
+		/// <summary>
+		/// Compound holding every convex static in the chunk, posed in world space. Has no children if the chunk has no convex statics.
+		/// </summary>
+		BigCompound Compound;
+		/// <summary>
+		/// Statics with nonconvex shapes, added individually on attach.
+		/// </summary>
+		Buffer<StaticDescription> LooseStatics;
+		/// <summary>
+		/// Handles of the loose statics while the chunk is attached.
+		/// </summary>
+		Buffer<StaticHandle> LooseStaticHandles;
+		/// <summary>
+		/// Shape index of the chunk's compound while the chunk is attached.
+		/// </summary>
+		TypedIndex CompoundShape;
+		/// <summary>
+		/// Handle of the static holding the chunk's compound while the chunk is attached.
+		/// </summary>
+		StaticHandle CompoundStatic;
+		/// <summary>
+		/// Nonzero while the chunk is attached to a simulation.
+		/// </summary>
+		int32_t Attached;
+	};
 }
\ No newline at end of file
@@ -94,4 +94,58 @@ namespace Bepu
 		/// </summary>
 		int LeafCount;
 	};
+
+	/// <summary>
+	/// Describes the shape and quality of a bounding volume tree.
+	/// </summary>
+	struct TreeStatistics
+	{
+		/// <summary>
+		/// Number of nodes in the tree.
+		/// </summary>
+		int32_t NodeCount;
+		/// <summary>
+		/// Number of leaves in the tree.
+		/// </summary>
+		int32_t LeafCount;
+		/// <summary>
+		/// Number of nodes on the longest path from the root to a leaf.
+		/// </summary>
+		int32_t MaximumDepth;
+		/// <summary>
+		/// Surface area heuristic cost of the tree: the summed surface area of every child bounding box divided by the surface area of the root bounds.
+		/// Lower is better. Roughly proportional to the number of nodes a random query visits.
+		/// </summary>
+		float CostMetric;
+	};
+
+	/// <summary>
+	/// Describes the shape and quality of the broad phase's trees.
+	/// </summary>
+	struct BroadPhaseStatistics
+	{
+		/// <summary>
+		/// Statistics of the tree holding active bodies.
+		/// </summary>
+		TreeStatistics ActiveTree;
+		/// <summary>
+		/// Statistics of the tree holding statics and sleeping bodies.
+		/// </summary>
+		TreeStatistics StaticTree;
+	};
+
+	/// <summary>
+	/// Extra refinement applied to the broad phase's trees at the end of every timestep, on top of the engine's own incremental refinement.
+	/// </summary>
+	struct BroadPhaseRefinementBudget
+	{
+		/// <summary>
+		/// Scale of the extra refinement applied to the active tree each step. 1 matches the size of the engine's own per-step refinement; 0 adds nothing.
+		/// </summary>
+		float ActiveTreeRefinementScale;
+		/// <summary>
+		/// Scale of the extra refinement applied to the static tree each step. 1 matches the size of the engine's own per-step refinement; 0 adds nothing.
+		/// </summary>
+		float StaticTreeRefinementScale;
+	};
 }
\ No newline at end of file
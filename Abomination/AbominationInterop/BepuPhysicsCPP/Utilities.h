@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <assert.h>
 
 namespace Bepu
 {
@@ -79,6 +80,112 @@ namespace Bepu
 	};
 
 
+	/// <summary>
+	/// Snapshot of a buffer pool's memory usage and allocation activity.
+	/// </summary>
+	struct BufferPoolStatistics
+	{
+		/// <summary>
+		/// Number of power pools tracked in the per-power arrays. Index i corresponds to slots of size 2^i bytes.
+		/// </summary>
+		static const int32_t PowerCount = 32;
+
+		/// <summary>
+		/// Total number of bytes allocated from native memory by the pool, whether or not any slot in it is currently in use.
+		/// </summary>
+		uint64_t ReservedBytes;
+		/// <summary>
+		/// Highest observed value of ReservedBytes since the last reset.
+		/// </summary>
+		uint64_t PeakReservedBytes;
+		/// <summary>
+		/// Number of slot bytes currently held by outstanding buffers taken through the interop allocation functions.
+		/// </summary>
+		uint64_t BytesInUse;
+		/// <summary>
+		/// Highest observed value of BytesInUse since the last reset.
+		/// </summary>
+		uint64_t PeakBytesInUse;
+		/// <summary>
+		/// Number of buffers taken through the interop allocation functions since the last reset.
+		/// </summary>
+		uint64_t AllocationCount;
+		/// <summary>
+		/// Number of resizes requested through the interop resize functions since the last reset.
+		/// </summary>
+		uint64_t ResizeCount;
+		/// <summary>
+		/// Number of buffers returned through the interop deallocation functions since the last reset.
+		/// </summary>
+		uint64_t DeallocationCount;
+		/// <summary>
+		/// Minimum size of individual block allocations made by the pool.
+		/// </summary>
+		int32_t MinimumBlockAllocationSize;
+		/// <summary>
+		/// Number of outstanding buffers with a recorded allocation tag. Zero unless allocation tagging is enabled.
+		/// </summary>
+		int32_t TaggedAllocationCount;
+		/// <summary>
+		/// Number of bytes allocated from native memory for each power pool.
+		/// </summary>
+		uint64_t ReservedBytesPerPower[PowerCount];
+		/// <summary>
+		/// Number of outstanding slots in each power pool taken through the interop allocation functions.
+		/// </summary>
+		int32_t SlotsInUsePerPower[PowerCount];
+	};
+
+	/// <summary>
+	/// Describes an outstanding buffer recorded while allocation tagging is enabled.
+	/// </summary>
+	struct TaggedBufferAllocation
+	{
+		/// <summary>
+		/// Id of the outstanding buffer.
+		/// </summary>
+		int32_t BufferId;
+		/// <summary>
+		/// Size of the slot backing the buffer in bytes.
+		/// </summary>
+		int32_t SlotSizeInBytes;
+		/// <summary>
+		/// Tag that was active when the buffer was allocated.
+		/// </summary>
+		int32_t Tag;
+		/// <summary>
+		/// Value of the pool's allocation counter when the buffer was allocated. Lower values are older.
+		/// </summary>
+		int32_t AllocationIndex;
+	};
+
+	/// <summary>
+	/// Describes how a buffer pool should be created.
+	/// </summary>
+	struct BufferPoolOptions
+	{
+		/// <summary>
+		/// Minimum size of individual block allocations. Must be a power of 2.
+		/// </summary>
+		int32_t MinimumBlockAllocationSize;
+		/// <summary>
+		/// Number of suballocations to preallocate reference space for.
+		/// </summary>
+		int32_t ExpectedUsedSlotCountPerPool;
+		/// <summary>
+		/// Maximum number of bytes the pool may reserve in response to interop allocations. Zero means unlimited.
+		/// </summary>
+		uint64_t MaximumReservedBytes;
+		/// <summary>
+		/// Number of bytes to preallocate for each power pool. Index i corresponds to slots of size 2^i bytes. Powers above 30 are ignored.
+		/// </summary>
+		int32_t PreallocatedBytesPerPower[BufferPoolStatistics::PowerCount];
+
+		BufferPoolOptions() : MinimumBlockAllocationSize(131072), ExpectedUsedSlotCountPerPool(16), MaximumReservedBytes(0), PreallocatedBytesPerPower{}
+		{
+		}
+	};
+
 	template<typename T>
 	struct QuickList
 	{
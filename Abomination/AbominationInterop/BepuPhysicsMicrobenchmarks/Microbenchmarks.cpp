@@ -0,0 +1,646 @@
+#include "BepuPhysics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Bepu;
+
+//Measures what crossing the interop boundary costs: direct entrypoint calls, pose integration callbacks, and narrow phase callbacks.
+//Usage: BepuPhysicsMicrobenchmarks [--iterations N] [--steps N] [--warmup N] [--threads 1,2,4] [--output path]
+//Each measurement is repeated at every thread count so lookups through the simulation handle are also measured under contention.
+
+using Clock = std::chrono::steady_clock;
+
+double GetNanoseconds(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+template<typename T>
+Buffer<T> AsBuffer(std::vector<T>& values)
+{
+	return Buffer<T>{ values.data(), (int32_t)values.size(), -1 };
+}
+
+//Hooks count their invocations per worker so the per call cost can be derived from whole step timings. Counters sit on separate cache lines.
+struct alignas(64) WorkerCounter
+{
+	int64_t Count;
+};
+const int maximumWorkerCount = 256;
+WorkerCounter hookCallCounts[maximumWorkerCount];
+
+void CountHookCall(int32_t workerIndex, int64_t count = 1)
+{
+	if (workerIndex >= 0 && workerIndex < maximumWorkerCount)
+		hookCallCounts[workerIndex].Count += count;
+}
+
+int64_t SumHookCalls()
+{
+	int64_t sum = 0;
+	for (auto& counter : hookCallCounts)
+		sum += counter.Count;
+	return sum;
+}
+
+void ResetHookCalls()
+{
+	for (auto& counter : hookCallCounts)
+		counter.Count = 0;
+}
+
+//Each hook reproduces what the managed defaults do when the hook is null, so the only difference from the baseline is the transition and the count.
+const PairMaterialProperties defaultMaterial(1, 2, SpringSettings(30, 1));
+
+bool AllowContactGeneration(SimulationHandle simulationHandle, int32_t workerIndex, CollidableReference a, CollidableReference b, float* speculativeMargin)
+{
+	CountHookCall(workerIndex);
+	return a.GetMobility() == CollidableMobility::Dynamic || b.GetMobility() == CollidableMobility::Dynamic;
+}
+
+bool AllowContactGenerationBetweenChildren(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB)
+{
+	CountHookCall(workerIndex);
+	return true;
+}
+
+bool ConfigureConvexContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, ConvexContactManifold* contactManifold, PairMaterialProperties* materialProperties)
+{
+	CountHookCall(workerIndex);
+	*materialProperties = defaultMaterial;
+	return true;
+}
+
+bool ConfigureNonconvexContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, NonconvexContactManifold* contactManifold, PairMaterialProperties* materialProperties)
+{
+	CountHookCall(workerIndex);
+	*materialProperties = defaultMaterial;
+	return true;
+}
+
+bool ConfigureChildContactManifold(SimulationHandle simulationHandle, int32_t workerIndex, CollidablePair collidablePair, int32_t childIndexA, int32_t childIndexB, ConvexContactManifold* contactManifold)
+{
+	CountHookCall(workerIndex);
+	return true;
+}
+
+void ConfigureContactManifolds(SimulationHandle simulationHandle, int32_t workerIndex, int32_t count, CollidablePair* collidablePairs, const ConvexContactManifold* const* convexManifolds, const NonconvexContactManifold* const* nonconvexManifolds, PairMaterialProperties* materialProperties, uint8_t* accept)
+{
+	//Counted per pair rather than per call so the cost lines up with the per pair hooks.
+	CountHookCall(workerIndex, count);
+	for (int i = 0; i < count; ++i)
+	{
+		materialProperties[i] = defaultMaterial;
+		accept[i] = 1;
+	}
+}
+
+struct PoseIntegrationSettings
+{
+	float GravityDt;
+	float DampingDt;
+};
+
+PoseIntegrationSettings poseIntegrationSettings;
+
+void PrepareForIntegration(SimulationHandle simulation, float dt)
+{
+	poseIntegrationSettings.GravityDt = -10.0f * dt;
+	poseIntegrationSettings.DampingDt = 0.999f;
+}
+
+void IntegrateVelocityScalar(SimulationHandle simulation, int32_t bodyIndex, Vector3 position, Quaternion orientation, BodyInertia localInertia, int32_t workerIndex, float dt, BodyVelocity* velocity)
+{
+	velocity->Linear.X *= poseIntegrationSettings.DampingDt;
+	velocity->Linear.Y = (velocity->Linear.Y + poseIntegrationSettings.GravityDt) * poseIntegrationSettings.DampingDt;
+	velocity->Linear.Z *= poseIntegrationSettings.DampingDt;
+	velocity->Angular.X *= poseIntegrationSettings.DampingDt;
+	velocity->Angular.Y *= poseIntegrationSettings.DampingDt;
+	velocity->Angular.Z *= poseIntegrationSettings.DampingDt;
+}
+
+//Does the same work as IntegrateVelocityScalar for a whole bundle. Velocity bundles are six lane arrays in a row: linear X, Y, Z, then angular X, Y, Z.
+template<int LaneCount>
+void IntegrateBundle(const int32_t* integrationMask, float* velocity)
+{
+	for (int lane = 0; lane < LaneCount; ++lane)
+	{
+		if (integrationMask[lane] == 0)
+			continue;
+		velocity[LaneCount + lane] += poseIntegrationSettings.GravityDt;
+		for (int component = 0; component < 6; ++component)
+			velocity[component * LaneCount + lane] *= poseIntegrationSettings.DampingDt;
+	}
+}
+
+void IntegrateVelocitySIMD128(SimulationHandle simulation, Vector128I bodyIndices, Vector3SIMD128* positions, QuaternionSIMD128* orientations, BodyInertiaSIMD128* localInertias, Vector128I integrationMask, int32_t workerIndex, Vector128F dt, BodyVelocitySIMD128* bodyVelocities)
+{
+	IntegrateBundle<4>(&integrationMask.V0, (float*)bodyVelocities);
+}
+
+void IntegrateVelocitySIMD256(SimulationHandle simulation, Vector256I bodyIndices, Vector3SIMD256* positions, QuaternionSIMD256* orientations, BodyInertiaSIMD256* localInertias, Vector256I integrationMask, int32_t workerIndex, Vector256F dt, BodyVelocitySIMD256* bodyVelocities)
+{
+	IntegrateBundle<8>(&integrationMask.V0, (float*)bodyVelocities);
+}
+
+PoseIntegratorCallbacks CreatePoseIntegratorCallbacks(bool useScalarCallback)
+{
+	PoseIntegratorCallbacks callbacks = {};
+	callbacks.AngularIntegrationMode = AngularIntegrationMode::Nonconserving;
+	callbacks.AllowSubstepsForUnconstrainedBodies = false;
+	callbacks.IntegrateVelocityForKinematics = false;
+	callbacks.UseScalarCallback = useScalarCallback;
+	callbacks.PrepareForIntegration = &PrepareForIntegration;
+	callbacks.IntegrateVelocityScalar = &IntegrateVelocityScalar;
+	callbacks.IntegrateVelocitySIMD128 = &IntegrateVelocitySIMD128;
+	callbacks.IntegrateVelocitySIMD256 = &IntegrateVelocitySIMD256;
+	return callbacks;
+}
+
+struct MicrobenchmarkOptions
+{
+	int32_t IterationCount = 1 << 20;
+	int32_t StepCount = 128;
+	int32_t WarmupStepCount = 16;
+	std::vector<int32_t> ThreadCounts;
+	std::string OutputPath;
+};
+
+/// <summary>
+/// A simulation with its own pool, so that each thread in a mutating benchmark can work without sharing engine state.
+/// </summary>
+struct BodyScene
+{
+	BufferPoolHandle Pool;
+	SimulationHandle Simulation;
+	TypedIndex BoxShape;
+	BodyInertia BoxInertia;
+	std::vector<BodyHandle> Bodies;
+};
+
+const int32_t sceneBodyCount = 4096;
+
+BodyDescription CreateBoxDescription(const BodyScene& scene, Vector3 position)
+{
+	//A negative sleep threshold keeps the bodies in the active set, so every call below takes the same path.
+	return BodyDescription::CreateDynamic(RigidPose(position), scene.BoxInertia, CollidableDescription(scene.BoxShape, 0.1f), BodyActivityDescription(-1));
+}
+
+BodyScene CreateBodyScene()
+{
+	BodyScene scene;
+	scene.Pool = CreateBufferPool();
+	scene.Simulation = CreateSimulation(scene.Pool, NarrowPhaseCallbacks{}, CreatePoseIntegratorCallbacks(false), SolveDescription(1, 1), SimulationAllocationSizes(sceneBodyCount * 2));
+	Box box(1, 1, 1);
+	scene.BoxShape = AddBox(scene.Simulation, box);
+	scene.BoxInertia = ComputeBoxInertia(box, 1);
+	scene.Bodies.resize(sceneBodyCount);
+	for (int i = 0; i < sceneBodyCount; ++i)
+		scene.Bodies[i] = AddBody(scene.Simulation, CreateBoxDescription(scene, Vector3((i % 64) * 2.0f, 0, (i / 64) * 2.0f)));
+	return scene;
+}
+
+void DestroyBodyScene(BodyScene& scene)
+{
+	DestroySimulation(scene.Simulation);
+	DestroyBufferPool(scene.Pool);
+}
+
+/// <summary>
+/// Per call cost of one entrypoint at one thread count.
+/// </summary>
+struct EntrypointResult
+{
+	const char* Name;
+	int32_t ThreadCount;
+	bool SharedSimulation;
+	int64_t CallsPerThread;
+	double NanosecondsPerCall;
+	double CallsPerSecond;
+};
+
+//Keeps the results of read-only calls observable so the loops can't be trimmed.
+std::atomic<uint64_t> sink;
+
+//A plain native call through a function pointer; the floor that the entrypoint numbers are compared against.
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+BodyDynamics* NativeLookup(BodyDynamics* table, BodyHandle handle)
+{
+	return table + (handle.Value & 63);
+}
+BodyDynamics* (*volatile nativeLookup)(BodyDynamics*, BodyHandle) = &NativeLookup;
+
+enum struct EntrypointBenchmark
+{
+	NativeCall,
+	GetBodyDynamics,
+	GetBodyCollidable,
+	ApplyBodyDescription,
+	AddRemoveBody,
+};
+
+void RunEntrypointLoop(EntrypointBenchmark benchmark, BodyScene& scene, int32_t iterationCount)
+{
+	auto handleMask = sceneBodyCount - 1;
+	uint64_t localSink = 0;
+	switch (benchmark)
+	{
+	case EntrypointBenchmark::NativeCall:
+	{
+		BodyDynamics table[64];
+		for (int i = 0; i < iterationCount; ++i)
+			localSink += (uint64_t)nativeLookup(table, scene.Bodies[i & handleMask]);
+		break;
+	}
+	case EntrypointBenchmark::GetBodyDynamics:
+		for (int i = 0; i < iterationCount; ++i)
+			localSink += (uint64_t)GetBodyDynamics(scene.Simulation, scene.Bodies[i & handleMask]);
+		break;
+	case EntrypointBenchmark::GetBodyCollidable:
+		for (int i = 0; i < iterationCount; ++i)
+			localSink += (uint64_t)GetBodyCollidable(scene.Simulation, scene.Bodies[i & handleMask]);
+		break;
+	case EntrypointBenchmark::ApplyBodyDescription:
+	{
+		//Same shape, same activity; only the pose changes, so the body stays put in the active set and the broad phase.
+		auto description = CreateBoxDescription(scene, Vector3());
+		for (int i = 0; i < iterationCount; ++i)
+		{
+			auto bodyIndex = i & handleMask;
+			description.Pose.Position = Vector3((bodyIndex % 64) * 2.0f, (i & 1) * 0.01f, (bodyIndex / 64) * 2.0f);
+			ApplyBodyDescription(scene.Simulation, scene.Bodies[bodyIndex], description);
+		}
+		break;
+	}
+	case EntrypointBenchmark::AddRemoveBody:
+	{
+		auto description = CreateBoxDescription(scene, Vector3(0, 10, 0));
+		for (int i = 0; i < iterationCount; ++i)
+			RemoveBody(scene.Simulation, AddBody(scene.Simulation, description));
+		break;
+	}
+	}
+	sink += localSink;
+}
+
+EntrypointResult RunEntrypointBenchmark(const char* name, EntrypointBenchmark benchmark, bool mutates, int32_t threadCount, std::vector<BodyScene>& scenes, int32_t iterationCount)
+{
+	//Churn needs a call for each of the add and the remove, so it's reported per add/remove pair; the other loops make one call per iteration.
+	std::vector<double> threadNanoseconds(threadCount);
+	std::atomic<int32_t> readyCount(0);
+	std::atomic<bool> go(false);
+	auto worker = [&](int threadIndex)
+	{
+		//Read-only calls all go through the same simulation to contend on the same directory slot; mutating calls need a simulation per thread.
+		auto& scene = mutates ? scenes[threadIndex] : scenes[0];
+		++readyCount;
+		while (!go.load(std::memory_order_acquire)) {}
+		auto start = Clock::now();
+		RunEntrypointLoop(benchmark, scene, iterationCount);
+		threadNanoseconds[threadIndex] = GetNanoseconds(start, Clock::now());
+	};
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; ++i)
+		threads.emplace_back(worker, i);
+	while (readyCount.load() < threadCount) {}
+	go.store(true, std::memory_order_release);
+	for (auto& thread : threads)
+		thread.join();
+
+	EntrypointResult result;
+	result.Name = name;
+	result.ThreadCount = threadCount;
+	result.SharedSimulation = !mutates;
+	result.CallsPerThread = iterationCount;
+	double sum = 0, slowest = 0;
+	for (auto nanoseconds : threadNanoseconds)
+	{
+		sum += nanoseconds;
+		slowest = std::max(slowest, nanoseconds);
+	}
+	result.NanosecondsPerCall = sum / ((double)threadCount * iterationCount);
+	result.CallsPerSecond = slowest > 0 ? (double)threadCount * iterationCount * 1e9 / slowest : 0;
+	return result;
+}
+
+/// <summary>
+/// Step time of a scene that does little besides velocity integration, in one callback mode at one thread count.
+/// </summary>
+/// <remarks>The engine requires a velocity integration callback, so there is no callback-free baseline to subtract. Per bundle and per body figures divide the whole step,
+/// including the engine's own integration and scheduling work; compare modes against each other rather than reading them as callback cost alone.</remarks>
+struct IntegrationResult
+{
+	const char* Mode;
+	bool Available;
+	int32_t ThreadCount;
+	int32_t BodyCount;
+	int32_t BundleCount;
+	double StepMilliseconds;
+	double StepNanosecondsPerBundle;
+	double StepNanosecondsPerBody;
+};
+
+IntegrationResult RunIntegrationBenchmark(const char* mode, bool useScalarCallback, int32_t threadCount, const MicrobenchmarkOptions& options)
+{
+	const int32_t bodyCount = 1 << 16;
+	auto laneCount = GetSIMDWidth() == SIMD256 ? 8 : 4;
+	IntegrationResult result = {};
+	result.Mode = mode;
+	result.Available = true;
+	result.ThreadCount = threadCount;
+	result.BodyCount = bodyCount;
+	result.BundleCount = (bodyCount + laneCount - 1) / laneCount;
+
+	//Shapeless, unconstrained bodies skip collision detection and the solver, so integration dominates the step.
+	auto pool = CreateBufferPool();
+	auto dispatcher = CreateThreadDispatcher(threadCount);
+	auto simulation = CreateSimulation(pool, NarrowPhaseCallbacks{}, CreatePoseIntegratorCallbacks(useScalarCallback), SolveDescription(1, 1), SimulationAllocationSizes(bodyCount));
+	BodyInertia inertia = { Symmetric3x3 { 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f }, 1.0f, 0 };
+	for (int i = 0; i < bodyCount; ++i)
+		AddBody(simulation, BodyDescription::CreateDynamic(RigidPose(Vector3((float)i, 0, 0)), inertia, CollidableDescription(TypedIndex()), BodyActivityDescription(-1)));
+	for (int i = 0; i < options.WarmupStepCount; ++i)
+		Timestep(simulation, 1.0f / 60.0f, dispatcher);
+	auto start = Clock::now();
+	for (int i = 0; i < options.StepCount; ++i)
+		Timestep(simulation, 1.0f / 60.0f, dispatcher);
+	auto nanosecondsPerStep = GetNanoseconds(start, Clock::now()) / options.StepCount;
+	result.StepMilliseconds = nanosecondsPerStep * 1e-6;
+	result.StepNanosecondsPerBundle = nanosecondsPerStep / result.BundleCount;
+	result.StepNanosecondsPerBody = nanosecondsPerStep / bodyCount;
+	DestroySimulation(simulation);
+	DestroyThreadDispatcher(dispatcher);
+	DestroyBufferPool(pool);
+	return result;
+}
+
+/// <summary>
+/// Narrow phase timing with one set of hooks installed, compared against the managed defaults.
+/// </summary>
+struct HookResult
+{
+	const char* Hooks;
+	int32_t ThreadCount;
+	double StepMilliseconds;
+	double CallsPerStep;
+	double NanosecondsPerCallOverBaseline;
+};
+
+struct HookConfiguration
+{
+	const char* Name;
+	NarrowPhaseCallbacks Callbacks;
+};
+
+std::vector<HookConfiguration> CreateHookConfigurations()
+{
+	std::vector<HookConfiguration> configurations;
+	NarrowPhaseCallbacks callbacks = {};
+	configurations.push_back({ "none", callbacks });
+	callbacks = {};
+	callbacks.AllowContactGenerationFunction = &AllowContactGeneration;
+	configurations.push_back({ "AllowContactGeneration", callbacks });
+	callbacks = {};
+	callbacks.AllowContactGenerationBetweenChildrenFunction = &AllowContactGenerationBetweenChildren;
+	configurations.push_back({ "AllowContactGenerationBetweenChildren", callbacks });
+	callbacks = {};
+	callbacks.ConfigureConvexContactManifoldFunction = &ConfigureConvexContactManifold;
+	configurations.push_back({ "ConfigureConvexContactManifold", callbacks });
+	callbacks = {};
+	callbacks.ConfigureNonconvexContactManifoldFunction = &ConfigureNonconvexContactManifold;
+	configurations.push_back({ "ConfigureNonconvexContactManifold", callbacks });
+	callbacks = {};
+	callbacks.ConfigureChildContactManifoldFunction = &ConfigureChildContactManifold;
+	configurations.push_back({ "ConfigureChildContactManifold", callbacks });
+	callbacks = {};
+	callbacks.ConfigureContactManifoldsFunction = &ConfigureContactManifolds;
+	configurations.push_back({ "ConfigureContactManifolds", callbacks });
+	return configurations;
+}
+
+//Rows of resting boxes produce convex pairs; rows of two-box compounds produce nonconvex pairs and exercise the child hooks.
+void PopulateContactScene(SimulationHandle simulation, BufferPoolHandle pool)
+{
+	AddStatic(simulation, StaticDescription::Create(RigidPose(Vector3(0, -0.5f, 0)), AddBox(simulation, Box(400, 1, 400))));
+	Box box(1, 1, 1);
+	auto boxShape = AddBox(simulation, box);
+	auto boxInertia = ComputeBoxInertia(box, 1);
+
+	auto childBytes = Allocate(pool, 2 * (int32_t)sizeof(CompoundChild));
+	Buffer<CompoundChild> children{ (CompoundChild*)childBytes.Memory, 2, childBytes.Id };
+	children[0] = CompoundChild{ Quaternion::GetIdentity(), Vector3(-0.5f, 0, 0), boxShape };
+	children[1] = CompoundChild{ Quaternion::GetIdentity(), Vector3(0.5f, 0, 0), boxShape };
+	std::vector<float> childMasses = { 1, 1 };
+	auto compoundInertia = ComputeCompoundInertia(simulation, children, AsBuffer(childMasses));
+	auto compoundShape = AddCompound(simulation, Compound{ children });
+
+	//Bodies touch their neighbors along X, so every body has pairs with the ground and with up to two neighbors.
+	const int rowCount = 32;
+	const int bodiesPerRow = 32;
+	for (int row = 0; row < rowCount; ++row)
+	{
+		auto useCompound = (row & 1) != 0;
+		auto shape = useCompound ? compoundShape : boxShape;
+		auto inertia = useCompound ? compoundInertia : boxInertia;
+		auto spacing = useCompound ? 2.0f : 1.0f;
+		for (int i = 0; i < bodiesPerRow; ++i)
+		{
+			Vector3 position((i - bodiesPerRow * 0.5f) * spacing, 0.5f, (row - rowCount * 0.5f) * 2.0f);
+			AddBody(simulation, BodyDescription::CreateDynamic(RigidPose(position), inertia, CollidableDescription(shape, 0.1f), BodyActivityDescription(-1)));
+		}
+	}
+}
+
+HookResult RunHookBenchmark(const HookConfiguration& configuration, int32_t threadCount, double baselineStepMilliseconds, const MicrobenchmarkOptions& options)
+{
+	HookResult result = {};
+	result.Hooks = configuration.Name;
+	result.ThreadCount = threadCount;
+	auto pool = CreateBufferPool();
+	auto dispatcher = CreateThreadDispatcher(threadCount);
+	auto simulation = CreateSimulation(pool, configuration.Callbacks, CreatePoseIntegratorCallbacks(false), SolveDescription(4, 1), SimulationAllocationSizes());
+	PopulateContactScene(simulation, pool);
+	for (int i = 0; i < options.WarmupStepCount; ++i)
+		Timestep(simulation, 1.0f / 60.0f, dispatcher);
+	ResetHookCalls();
+	auto start = Clock::now();
+	for (int i = 0; i < options.StepCount; ++i)
+		Timestep(simulation, 1.0f / 60.0f, dispatcher);
+	auto nanosecondsPerStep = GetNanoseconds(start, Clock::now()) / options.StepCount;
+	result.StepMilliseconds = nanosecondsPerStep * 1e-6;
+	result.CallsPerStep = (double)SumHookCalls() / options.StepCount;
+	result.NanosecondsPerCallOverBaseline = result.CallsPerStep > 0 && baselineStepMilliseconds > 0 ? (result.StepMilliseconds - baselineStepMilliseconds) * 1e6 / result.CallsPerStep : 0;
+	DestroySimulation(simulation);
+	DestroyThreadDispatcher(dispatcher);
+	DestroyBufferPool(pool);
+	return result;
+}
+
+void WriteJson(std::ostream& stream, const MicrobenchmarkOptions& options,
+	const std::vector<EntrypointResult>& entrypoints, const std::vector<IntegrationResult>& integration, const std::vector<HookResult>& hooks)
+{
+	const char* simdWidths[] = { "SIMD128", "SIMD256", "SIMD512" };
+	stream.precision(6);
+	stream << std::fixed;
+	stream << "{\n";
+	stream << "\t\"simdWidth\": \"" << simdWidths[GetSIMDWidth()] << "\",\n";
+	stream << "\t\"platformThreadCount\": " << GetPlatformThreadCount() << ",\n";
+	stream << "\t\"iterationCount\": " << options.IterationCount << ",\n";
+	stream << "\t\"stepCount\": " << options.StepCount << ",\n";
+	stream << "\t\"warmupStepCount\": " << options.WarmupStepCount << ",\n";
+	stream << "\t\"entrypoints\": [";
+	for (size_t i = 0; i < entrypoints.size(); ++i)
+	{
+		auto& result = entrypoints[i];
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "\t\t{ \"name\": \"" << result.Name << "\", \"threadCount\": " << result.ThreadCount << ", \"sharedSimulation\": " << (result.SharedSimulation ? "true" : "false") <<
+			", \"callsPerThread\": " << result.CallsPerThread << ", \"nanosecondsPerCall\": " << result.NanosecondsPerCall << ", \"callsPerSecond\": " << result.CallsPerSecond << " }";
+	}
+	stream << "\n\t],\n";
+	stream << "\t\"integration\": [";
+	for (size_t i = 0; i < integration.size(); ++i)
+	{
+		auto& result = integration[i];
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "\t\t{ \"mode\": \"" << result.Mode << "\", \"available\": " << (result.Available ? "true" : "false") << ", \"threadCount\": " << result.ThreadCount;
+		if (result.Available)
+		{
+			stream << ", \"bodyCount\": " << result.BodyCount << ", \"bundleCount\": " << result.BundleCount << ", \"stepMilliseconds\": " << result.StepMilliseconds <<
+				", \"stepNanosecondsPerBundle\": " << result.StepNanosecondsPerBundle << ", \"stepNanosecondsPerBody\": " << result.StepNanosecondsPerBody;
+		}
+		stream << " }";
+	}
+	stream << "\n\t],\n";
+	stream << "\t\"narrowPhaseHooks\": [";
+	for (size_t i = 0; i < hooks.size(); ++i)
+	{
+		auto& result = hooks[i];
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "\t\t{ \"hooks\": \"" << result.Hooks << "\", \"threadCount\": " << result.ThreadCount << ", \"stepMilliseconds\": " << result.StepMilliseconds <<
+			", \"callsPerStep\": " << result.CallsPerStep << ", \"nanosecondsPerCallOverBaseline\": " << result.NanosecondsPerCallOverBaseline << " }";
+	}
+	stream << "\n\t]\n}\n";
+}
+
+bool ParseArguments(int argc, char** argv, MicrobenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (argument == "--iterations" && hasValue)
+			options.IterationCount = std::atoi(argv[++i]);
+		else if (argument == "--steps" && hasValue)
+			options.StepCount = std::atoi(argv[++i]);
+		else if (argument == "--warmup" && hasValue)
+			options.WarmupStepCount = std::atoi(argv[++i]);
+		else if (argument == "--output" && hasValue)
+			options.OutputPath = argv[++i];
+		else if (argument == "--threads" && hasValue)
+		{
+			std::string list = argv[++i];
+			size_t start = 0;
+			while (start < list.size())
+			{
+				auto end = list.find(',', start);
+				if (end == std::string::npos)
+					end = list.size();
+				auto threadCount = std::atoi(list.substr(start, end - start).c_str());
+				if (threadCount > 0)
+					options.ThreadCounts.push_back(threadCount);
+				start = end + 1;
+			}
+		}
+		else
+		{
+			std::cerr << "Unrecognized argument: " << argument << "\n";
+			return false;
+		}
+	}
+	return options.IterationCount > 0 && options.StepCount > 0 && options.WarmupStepCount >= 0;
+}
+
+int main(int argc, char** argv)
+{
+	MicrobenchmarkOptions options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		std::cerr << "Usage: BepuPhysicsMicrobenchmarks [--iterations N] [--steps N] [--warmup N] [--threads 1,2,4] [--output path]\n";
+		return 1;
+	}
+
+	Initialize();
+	if (options.ThreadCounts.empty())
+	{
+		auto platformThreadCount = GetPlatformThreadCount();
+		for (int threadCount = 1; threadCount < platformThreadCount; threadCount *= 2)
+			options.ThreadCounts.push_back(threadCount);
+		options.ThreadCounts.push_back(platformThreadCount);
+	}
+	auto maximumThreadCount = *std::max_element(options.ThreadCounts.begin(), options.ThreadCounts.end());
+
+	//Progress goes to stderr so stdout stays valid JSON.
+	std::cerr << "entrypoints\n";
+	std::vector<BodyScene> scenes;
+	for (int i = 0; i < maximumThreadCount; ++i)
+		scenes.push_back(CreateBodyScene());
+	std::vector<EntrypointResult> entrypoints;
+	for (auto threadCount : options.ThreadCounts)
+	{
+		entrypoints.push_back(RunEntrypointBenchmark("NativeCall", EntrypointBenchmark::NativeCall, false, threadCount, scenes, options.IterationCount));
+		entrypoints.push_back(RunEntrypointBenchmark("GetBodyDynamics", EntrypointBenchmark::GetBodyDynamics, false, threadCount, scenes, options.IterationCount));
+		entrypoints.push_back(RunEntrypointBenchmark("GetBodyCollidable", EntrypointBenchmark::GetBodyCollidable, false, threadCount, scenes, options.IterationCount));
+		entrypoints.push_back(RunEntrypointBenchmark("ApplyBodyDescription", EntrypointBenchmark::ApplyBodyDescription, true, threadCount, scenes, options.IterationCount));
+		//Churn is much more expensive per iteration than a lookup; scale it down to keep the run short.
+		entrypoints.push_back(RunEntrypointBenchmark("AddBody+RemoveBody", EntrypointBenchmark::AddRemoveBody, true, threadCount, scenes, std::max(1, options.IterationCount / 16)));
+	}
+	for (auto& scene : scenes)
+		DestroyBodyScene(scene);
+
+	std::cerr << "integration\n";
+	//The engine picks the vectorized callback matching its own SIMD width, so only one of the two widths can be measured on a given machine.
+	auto simd256 = GetSIMDWidth() == SIMD256;
+	std::vector<IntegrationResult> integration;
+	for (auto threadCount : options.ThreadCounts)
+	{
+		integration.push_back(RunIntegrationBenchmark("IntegrateVelocityScalar", true, threadCount, options));
+		integration.push_back(RunIntegrationBenchmark(simd256 ? "IntegrateVelocitySIMD256" : "IntegrateVelocitySIMD128", false, threadCount, options));
+		IntegrationResult unavailable = {};
+		unavailable.Mode = simd256 ? "IntegrateVelocitySIMD128" : "IntegrateVelocitySIMD256";
+		unavailable.ThreadCount = threadCount;
+		integration.push_back(unavailable);
+	}
+
+	std::cerr << "narrow phase hooks\n";
+	auto configurations = CreateHookConfigurations();
+	std::vector<HookResult> hooks;
+	for (auto threadCount : options.ThreadCounts)
+	{
+		//The first configuration installs no hooks, so it is the managed-only baseline for the rest.
+		auto baseline = RunHookBenchmark(configurations[0], threadCount, 0, options);
+		hooks.push_back(baseline);
+		for (size_t i = 1; i < configurations.size(); ++i)
+			hooks.push_back(RunHookBenchmark(configurations[i], threadCount, baseline.StepMilliseconds, options));
+	}
+
+	if (options.OutputPath.empty())
+	{
+		WriteJson(std::cout, options, entrypoints, integration, hooks);
+	}
+	else
+	{
+		std::ofstream file(options.OutputPath);
+		WriteJson(file, options, entrypoints, integration, hooks);
+	}
+	Destroy();
+	return 0;
+}
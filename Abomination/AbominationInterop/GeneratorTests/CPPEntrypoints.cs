@@ -128,6 +128,7 @@ public static class CPPEntrypoints
         Dictionary<string, List<string>> functionComments = new();
         AccumulateFunctionDocumentation(entrypointsDirectory + "Entrypoints.cs", functionComments);
         AccumulateFunctionDocumentation(entrypointsDirectory + "Entrypoints_Shapes.cs", functionComments);
+        AccumulateFunctionDocumentation(entrypointsDirectory + "Entrypoints_Constraints.cs", functionComments);
 
         var methods = typeof(Entrypoints).GetMethods();
 
@@ -0,0 +1,66 @@
+﻿using AbominationInterop;
+using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuUtilities.Memory;
+using System.Numerics;
+
+namespace HeadlessTests24.InteropStyle;
+
+/// <summary>
+/// Headless checks for the interop layer's adaptive velocity iteration scheduler.
+/// </summary>
+static class AdaptiveVelocityIterationTests
+{
+    /// <summary>
+    /// Lets a box stack settle and checks that the scheduler backs off from the maximum iteration count once it's resting.
+    /// </summary>
+    public static void TestSettledStackLowersIterations()
+    {
+        var pool = new BufferPool();
+        const int maximumIterationCount = 8;
+        var simulation = Simulation.Create(pool, new DemoNarrowPhaseCallbacks(new(30, 1)), new DemoPoseIntegratorCallbacks(new Vector3(0, -10, 0)), new SolveDescription(maximumIterationCount, 1));
+        simulation.Statics.Add(new StaticDescription(new Vector3(0, -0.5f, 0), simulation.Shapes.Add(new Box(20, 1, 20))));
+        var box = new Box(1, 1, 1);
+        var boxShape = simulation.Shapes.Add(box);
+        var boxInertia = box.ComputeInertia(1);
+        for (int i = 0; i < 5; ++i)
+        {
+            //A negative sleep threshold keeps the stack awake; a sleeping stack would look settled no matter what the scheduler measured.
+            simulation.Bodies.Add(BodyDescription.CreateDynamic(new Vector3(0, 0.5f + i, 0), boxInertia, boxShape, -1f));
+        }
+        var scheduler = new AdaptiveVelocityIterationScheduler(simulation, new AdaptiveVelocityIterationSettings
+        {
+            MinimumIterationCount = 1,
+            MaximumIterationCount = maximumIterationCount,
+            SettledVelocityChange = 0.01f,
+            StressedVelocityChange = 0.1f,
+            IterationIncrease = 2,
+        });
+
+        //Give the stack a few seconds to come to rest, then look at what the scheduler chose over the last second.
+        const int settleStepCount = 240;
+        const int measuredStepCount = 60;
+        for (int i = 0; i < settleStepCount; ++i)
+        {
+            simulation.Timestep(1 / 60f);
+        }
+        var totalBeforeMeasurement = scheduler.State.TotalIterationCount;
+        for (int i = 0; i < measuredStepCount; ++i)
+        {
+            simulation.Timestep(1 / 60f);
+        }
+        var averageIterationCount = (scheduler.State.TotalIterationCount - totalBeforeMeasurement) / (double)measuredStepCount;
+        if (averageIterationCount > maximumIterationCount / 2)
+            throw new Exception($"Settled stack averaged {averageIterationCount} velocity iterations per solve; expected the scheduler to back off from {maximumIterationCount}. Last velocity change: {scheduler.State.LastVelocityChange}.");
+
+        scheduler.Dispose();
+        simulation.Dispose();
+        pool.Clear();
+    }
+
+    public static void Run()
+    {
+        TestSettledStackLowersIterations();
+        Console.WriteLine("Adaptive velocity iteration tests passed.");
+    }
+}
@@ -0,0 +1,128 @@
+﻿using AbominationInterop;
+using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.Trees;
+using BepuUtilities.Memory;
+using System.Numerics;
+
+namespace HeadlessTests24.InteropStyle;
+
+/// <summary>
+/// Headless checks that the interop layer's custom shapes collide from the side they document.
+/// </summary>
+static class InteropShapeTests
+{
+    struct ClosestHitHandler : IRayHitHandler
+    {
+        public float T;
+        public Vector3 Normal;
+
+        public bool AllowTest(CollidableReference collidable) => true;
+        public bool AllowTest(CollidableReference collidable, int childIndex) => true;
+        public void OnRayHit(in RayData ray, ref float maximumT, float t, Vector3 normal, CollidableReference collidable, int childIndex)
+        {
+            if (t < T)
+            {
+                T = t;
+                Normal = normal;
+                maximumT = t;
+            }
+        }
+    }
+
+    static Simulation CreateSimulation(BufferPool pool)
+    {
+        var simulation = Simulation.Create(pool, new DemoNarrowPhaseCallbacks(new(30, 1)), new DemoPoseIntegratorCallbacks(new Vector3(0, -10, 0)), new SolveDescription(8, 1));
+        CustomShapes.Register(simulation.NarrowPhase.CollisionTaskRegistry, simulation.NarrowPhase.SweepTaskRegistry);
+        return simulation;
+    }
+
+    /// <summary>
+    /// Casts a ray and checks that it hits a surface facing back toward the ray at the expected distance.
+    /// </summary>
+    static void CheckRay(Simulation simulation, Vector3 origin, Vector3 direction, float expectedT, string shapeName)
+    {
+        var handler = new ClosestHitHandler { T = float.MaxValue };
+        simulation.RayCast(origin, direction, 100, ref handler);
+        if (handler.T == float.MaxValue)
+            throw new Exception($"Ray from {origin} along {direction} missed the {shapeName}.");
+        if (MathF.Abs(handler.T - expectedT) > 1e-3f || Vector3.Dot(handler.Normal, direction) >= 0)
+            throw new Exception($"Ray from {origin} along {direction} hit the {shapeName} at t = {handler.T} with normal {handler.Normal}; expected t = {expectedT} on a face pointing back at the ray.");
+    }
+
+    /// <summary>
+    /// Drops a sphere from above the given point and checks that it comes to rest on a surface at the expected height rather than falling through.
+    /// </summary>
+    static void CheckDroppedSphere(Simulation simulation, Vector3 start, float expectedHeight, string shapeName)
+    {
+        const float radius = 0.5f;
+        var sphere = new Sphere(radius);
+        var handle = simulation.Bodies.Add(BodyDescription.CreateDynamic(start, sphere.ComputeInertia(1), simulation.Shapes.Add(sphere), 0.01f));
+        for (int i = 0; i < 180; ++i)
+        {
+            simulation.Timestep(1 / 60f);
+        }
+        var restingHeight = simulation.Bodies[handle].Pose.Position.Y - radius;
+        if (MathF.Abs(restingHeight - expectedHeight) > 0.05f)
+            throw new Exception($"Sphere dropped on the {shapeName} ended with its bottom at {restingHeight}; expected it to rest at {expectedHeight}.");
+    }
+
+    public static void TestHeightfield()
+    {
+        var pool = new BufferPool();
+        var simulation = CreateSimulation(pool);
+        const int sampleCount = 8;
+        const float height = 1;
+        pool.Take<float>(sampleCount * sampleCount, out var samples);
+        for (int i = 0; i < samples.Length; ++i)
+            samples[i] = height;
+        var heightfield = Heightfield.Create(samples.As<byte>(), default, sampleCount, sampleCount, HeightfieldSampleFormat.Float32, 1, 1, 1, 0, pool);
+        pool.Return(ref samples);
+        simulation.Statics.Add(new StaticDescription(new Vector3(-0.5f * (sampleCount - 1), 0, -0.5f * (sampleCount - 1)), simulation.Shapes.Add(heightfield)));
+
+        //Aim off the cell diagonals so that both triangles of a cell get exercised.
+        CheckRay(simulation, new Vector3(0.3f, 10, 0.1f), new Vector3(0, -1, 0), 10 - height, "heightfield");
+        CheckRay(simulation, new Vector3(0.1f, 10, 0.3f), new Vector3(0, -1, 0), 10 - height, "heightfield");
+        CheckDroppedSphere(simulation, new Vector3(0.2f, height + 3, 0.6f), height, "heightfield");
+
+        simulation.Dispose();
+        pool.Clear();
+    }
+
+    public static void TestVoxelGrid()
+    {
+        var pool = new BufferPool();
+        var simulation = CreateSimulation(pool);
+        //A single layer slab of voxels; its top faces sit at the voxel size and its sides at the edges of the grid.
+        const int size = 8;
+        const float voxelSize = 0.5f;
+        pool.Take<Int3>(size * size, out var occupied);
+        for (int z = 0; z < size; ++z)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                occupied[z * size + x] = new Int3 { X = x, Y = 0, Z = z };
+            }
+        }
+        var voxelGrid = VoxelGrid.Create(size, 2, size, voxelSize, occupied, pool);
+        pool.Return(ref occupied);
+        const float halfExtent = 0.5f * size * voxelSize;
+        simulation.Statics.Add(new StaticDescription(new Vector3(-halfExtent, 0, -halfExtent), simulation.Shapes.Add(voxelGrid)));
+
+        CheckRay(simulation, new Vector3(0.1f, 10, 0.3f), new Vector3(0, -1, 0), 10 - voxelSize, "voxel grid");
+        CheckRay(simulation, new Vector3(0.3f, 10, 0.1f), new Vector3(0, -1, 0), 10 - voxelSize, "voxel grid");
+        CheckRay(simulation, new Vector3(-10, 0.2f, 0.3f), new Vector3(1, 0, 0), 10 - halfExtent, "voxel grid");
+        CheckRay(simulation, new Vector3(0.3f, 0.2f, 10), new Vector3(0, 0, -1), 10 - halfExtent, "voxel grid");
+        CheckDroppedSphere(simulation, new Vector3(0.2f, voxelSize + 3, 0.6f), voxelSize, "voxel grid");
+
+        simulation.Dispose();
+        pool.Clear();
+    }
+
+    public static void Run()
+    {
+        TestHeightfield();
+        TestVoxelGrid();
+        Console.WriteLine("Interop shape tests passed.");
+    }
+}
@@ -0,0 +1,103 @@
+﻿using AbominationInterop;
+using BepuPhysics;
+using BepuPhysics.Collidables;
+using BepuPhysics.CollisionDetection;
+using BepuPhysics.Constraints;
+using BepuUtilities.Memory;
+using System.Numerics;
+
+namespace HeadlessTests24.InteropStyle;
+
+/// <summary>
+/// Headless checks that sensor overlaps follow the shapes rather than their bounding boxes.
+/// </summary>
+static class SensorTests
+{
+    //Routes sensor pairs into the tracker the same way the interop narrow phase callbacks do; everything else behaves like the demo callbacks.
+    struct SensorNarrowPhaseCallbacks : INarrowPhaseCallbacks
+    {
+        public SensorTracker Sensors;
+
+        public void Initialize(Simulation simulation) { }
+
+        public bool AllowContactGeneration(int workerIndex, CollidableReference a, CollidableReference b, ref float speculativeMargin)
+        {
+            if (Sensors.IsSensorPair(a, b))
+            {
+                speculativeMargin = 0;
+                return true;
+            }
+            return a.Mobility == CollidableMobility.Dynamic || b.Mobility == CollidableMobility.Dynamic;
+        }
+
+        public bool AllowContactGeneration(int workerIndex, CollidablePair pair, int childIndexA, int childIndexB) => true;
+
+        public bool ConfigureContactManifold<TManifold>(int workerIndex, CollidablePair pair, ref TManifold manifold, out PairMaterialProperties pairMaterial) where TManifold : unmanaged, IContactManifold<TManifold>
+        {
+            if (Sensors.IsSensorPair(pair.A, pair.B))
+            {
+                Sensors.RecordOverlap(workerIndex, pair, ref manifold);
+                pairMaterial = default;
+                return false;
+            }
+            pairMaterial = new PairMaterialProperties(1, 2, new SpringSettings(30, 1));
+            return true;
+        }
+
+        public bool ConfigureContactManifold(int workerIndex, CollidablePair pair, int childIndexA, int childIndexB, ref ConvexContactManifold manifold) => true;
+
+        public void Dispose() { }
+    }
+
+    static void CheckOverlaps(SensorTracker sensors, StaticHandle sensor, BodyHandle other, SensorOverlapState? expectedState, string situation)
+    {
+        var overlaps = sensors.Overlaps;
+        if (expectedState == null)
+        {
+            if (overlaps.Length != 0)
+                throw new Exception($"Sensor reported {overlaps.Length} overlaps when {situation}; expected none.");
+            return;
+        }
+        if (overlaps.Length != 1 || overlaps[0].Sensor.StaticHandle != sensor || overlaps[0].Other.BodyHandle != other || overlaps[0].State != expectedState.Value)
+            throw new Exception($"Sensor reported {overlaps.Length} overlaps when {situation}; expected one {expectedState.Value} overlap with the sphere.");
+    }
+
+    /// <summary>
+    /// Moves a sphere past the corner of a box sensor and checks that overlap starts only when the shapes actually touch.
+    /// </summary>
+    public static void TestCornerOverlap()
+    {
+        var pool = new BufferPool();
+        var sensors = new SensorTracker();
+        var simulation = Simulation.Create(pool, new SensorNarrowPhaseCallbacks { Sensors = sensors }, new DemoPoseIntegratorCallbacks(new Vector3()), new SolveDescription(8, 1));
+        sensors.Attach(simulation);
+        var sensor = simulation.Statics.Add(new StaticDescription(new Vector3(), simulation.Shapes.Add(new Box(2, 2, 2))));
+        sensors.SetSensor(sensor, true);
+        //The box's corner is at (1, 1, 1). At (1.4, 1.4, 1.4) the sphere's bounds overlap the box's bounds, but the sphere is about 0.69 away from the corner.
+        var sphere = simulation.Bodies.Add(BodyDescription.CreateKinematic(new Vector3(1.4f), simulation.Shapes.Add(new Sphere(0.5f)), -1f));
+
+        simulation.Timestep(1 / 60f);
+        CheckOverlaps(sensors, sensor, sphere, null, "only the bounding boxes overlapped");
+
+        simulation.Bodies[sphere].Pose.Position = new Vector3(1.2f);
+        simulation.Timestep(1 / 60f);
+        CheckOverlaps(sensors, sensor, sphere, SensorOverlapState.Entered, "the sphere moved onto the corner");
+
+        simulation.Timestep(1 / 60f);
+        CheckOverlaps(sensors, sensor, sphere, SensorOverlapState.Stayed, "the sphere stayed on the corner");
+
+        simulation.Bodies[sphere].Pose.Position = new Vector3(1.4f);
+        simulation.Timestep(1 / 60f);
+        CheckOverlaps(sensors, sensor, sphere, SensorOverlapState.Exited, "the sphere moved back off the corner");
+
+        sensors.Dispose();
+        simulation.Dispose();
+        pool.Clear();
+    }
+
+    public static void Run()
+    {
+        TestCornerOverlap();
+        Console.WriteLine("Sensor tests passed.");
+    }
+}
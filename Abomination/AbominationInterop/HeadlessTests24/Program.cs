@@ -2,6 +2,7 @@
 using HeadlessTests24.DemoStyle.Dancers;
 using HeadlessTests24.DemoStyle.Sponsors;
 using HeadlessTests24.DemoStyle.Tanks;
+using HeadlessTests24.InteropStyle;
 using HeadlessTests24.StreamerStyle;
 using HeadlessTests24.StreamerStyle.Actions;
 using HeadlessTests24.StreamerStyle.Scenes;
@@ -14,6 +15,11 @@ Console.WriteLine($"SSE42: {Sse42.IsSupported}");
 Console.WriteLine($"AVX: {Avx.IsSupported}");
 Console.WriteLine($"AVX2: {Avx2.IsSupported}");
 
+//These are quick correctness checks rather than benchmarks; failures throw before any timing starts.
+InteropShapeTests.Run();
+AdaptiveVelocityIterationTests.Run();
+SensorTests.Run();
+
 List<int> threadCounts = new List<int>();
 const string threadCountsPath = "threadCounts.txt";
 try